@@ -0,0 +1,344 @@
+// 无界面解码性能测试
+// 不创建任何窗口，直接驱动FFmpegStream解码，输出JSON格式的测试结果，
+// 用于在CI/服务器上比较不同构建的解封装/解码吞吐量
+//
+// 用法: DecodeBenchmark [--realtime] [--max-seconds N] [--io mmap|readahead|ffmpeg]
+//                       [--latency S] [--sender-clock] [--output result.json] file...
+//
+// 直播地址（udp://、srt://等）总是按实时速度取帧，并与播放器一样由LatencyController控制延迟，
+// 结果中的latency一项给出延迟统计；配合LiveSender可在本机回环测试
+
+#include "media/DecodeScheduler.h"
+#include "media/FFmpegStream.h"
+#include "media/LatencyController.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QThread>
+#include <algorithm>
+#include <cstdio>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+struct ResourceUsage {
+    double cpuSeconds{0.0};
+    qint64 peakRssKb{0};
+};
+
+ResourceUsage currentUsage() {
+    ResourceUsage usage;
+#ifdef Q_OS_WIN
+    FILETIME creation, exit, kernel, user;
+    if (GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user)) {
+        auto toSeconds = [](const FILETIME &ft) {
+            ULARGE_INTEGER value;
+            value.LowPart = ft.dwLowDateTime;
+            value.HighPart = ft.dwHighDateTime;
+            return double(value.QuadPart) / 1e7;  // 100ns单位
+        };
+        usage.cpuSeconds = toSeconds(kernel) + toSeconds(user);
+    }
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        usage.peakRssKb = qint64(counters.PeakWorkingSetSize / 1024);
+    }
+#else
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) == 0) {
+        usage.cpuSeconds = ru.ru_utime.tv_sec + ru.ru_utime.tv_usec / 1e6 + ru.ru_stime.tv_sec +
+                           ru.ru_stime.tv_usec / 1e6;
+#ifdef Q_OS_MACOS
+        usage.peakRssKb = ru.ru_maxrss / 1024;  // macOS单位为字节
+#else
+        usage.peakRssKb = ru.ru_maxrss;
+#endif
+    }
+#endif
+    return usage;
+}
+
+// 队列占用采样
+struct Occupancy {
+    qint64 samples{0};
+    qint64 total{0};
+    int max{0};
+
+    void add(int value) {
+        ++samples;
+        total += value;
+        max = std::max(max, value);
+    }
+
+    QJsonObject toJson() const {
+        return QJsonObject{{"avg", samples ? double(total) / samples : 0.0}, {"max", max}};
+    }
+};
+
+QJsonObject stageToJson(const PipelineTask::StepStats &stats) {
+    uint64_t busySteps = stats.steps - stats.idleSteps;
+    return QJsonObject{
+        {"steps", qint64(stats.steps)},
+        {"idle_steps", qint64(stats.idleSteps)},
+        {"total_ms", stats.totalMs},
+        {"avg_ms", busySteps ? stats.totalMs / busySteps : 0.0},
+        {"max_ms", stats.maxMs},
+    };
+}
+
+struct BenchOptions {
+    bool realtime{false};
+    double maxSeconds{0.0};  // 0表示解码到文件末尾
+    double latencyTarget{LatencyController::DEFAULT_TARGET};
+    bool senderClock{false};  // 按推流端墙上时钟测量端到端延迟
+};
+
+QJsonObject runFile(const QString &filePath, const BenchOptions &options) {
+    QJsonObject result{{"file", filePath}};
+
+    ResourceUsage usageBefore = currentUsage();
+    QElapsedTimer wallTimer;
+    wallTimer.start();
+
+    FFmpegStream stream;
+    if (!stream.loadVideo(filePath)) {
+        result["error"] = "无法打开文件";
+        return result;
+    }
+    double openMs = wallTimer.nsecsElapsed() / 1e6;
+    stream.play();
+
+    // 直播按播放速度取帧，速度由延迟控制调整；时间戳按最近一次调整时的锚点换算
+    bool live = stream.isLive();
+    bool paced = options.realtime || live;
+    LatencyController latency(options.latencyTarget);
+    double rate = 1.0;
+    double anchorPts = -1.0;
+    double anchorMs = 0.0;
+
+    qint64 videoFrames = 0;
+    qint64 audioFrames = 0;
+    qint64 stalls = 0;
+    double firstVideoPts = -1.0;
+    double lastVideoPts = 0.0;
+    double lastAudioPts = 0.0;
+    Occupancy videoFrameQueue, audioFrameQueue, videoPacketQueue, audioPacketQueue, readAhead;
+    PipelineStats stats;
+
+    QElapsedTimer decodeTimer;
+    decodeTimer.start();
+
+    while (!stream.atEnd()) {
+        stats = stream.getPipelineStats();
+        videoFrameQueue.add(stats.videoFrames);
+        audioFrameQueue.add(stats.audioFrames);
+        videoPacketQueue.add(stats.videoPackets);
+        audioPacketQueue.add(stats.audioPackets);
+        readAhead.add(stats.io.readAheadQueued);
+
+        // 只在队列中有帧时取帧，避免在一个队列上阻塞而另一个队列已满
+        bool progressed = false;
+        if (stats.videoFrames > 0) {
+            double pts = 0.0;
+            if (AVFrame *frame = stream.getNextVideoFrame(&pts)) {
+                av_frame_free(&frame);
+                ++videoFrames;
+                progressed = true;
+                if (firstVideoPts < 0) firstVideoPts = pts;
+                lastVideoPts = pts;
+
+                // 实时模式：按时间戳节奏取帧，模拟播放
+                if (paced) {
+                    double nowMs = decodeTimer.nsecsElapsed() / 1e6;
+                    if (anchorPts < 0) {
+                        anchorPts = pts;
+                        anchorMs = nowMs;
+                    }
+                    double due = anchorMs + (pts - anchorPts) * 1000.0 / rate;
+                    if (due > nowMs) QThread::usleep((unsigned long)((due - nowMs) * 1000));
+                }
+
+                if (live) {
+                    double measured = options.senderClock
+                                          ? LatencyController::senderClockLatency(pts)
+                                          : stream.liveEdgePts() - pts;
+                    LatencyController::Decision decision = latency.update(measured);
+                    if (decision.dropToLive) {
+                        stream.dropFramesBefore(stream.liveEdgePts() - latency.target());
+                    }
+                    if (decision.dropToLive || decision.rate != rate) {
+                        rate = decision.rate;
+                        anchorPts = -1.0;
+                    }
+                }
+            }
+        }
+        if (stats.audioFrames > 0) {
+            double pts = 0.0;
+            if (AVFrame *frame = stream.getNextAudioFrame(&pts)) {
+                av_frame_free(&frame);
+                ++audioFrames;
+                progressed = true;
+                lastAudioPts = pts;
+            }
+        }
+
+        if (!progressed) {
+            // 消费者等待解码：流水线跟不上的次数
+            ++stalls;
+            QThread::usleep(500);
+        }
+
+        // 处理解码任务投递回来的信号（错误/结束通知）
+        QCoreApplication::processEvents();
+
+        double mediaSeconds = std::max(lastVideoPts - std::max(firstVideoPts, 0.0), lastAudioPts);
+        if (options.maxSeconds > 0 && mediaSeconds >= options.maxSeconds) break;
+    }
+
+    stats = stream.getPipelineStats();
+    double decodeSeconds = decodeTimer.nsecsElapsed() / 1e9;
+    double mediaSeconds = std::max(lastVideoPts - std::max(firstVideoPts, 0.0), lastAudioPts);
+    ResourceUsage usageAfter = currentUsage();
+    double cpuSeconds = usageAfter.cpuSeconds - usageBefore.cpuSeconds;
+    double wallSeconds = wallTimer.nsecsElapsed() / 1e9;
+
+    result["open_ms"] = openMs;
+    result["wall_seconds"] = wallSeconds;
+    result["decode_seconds"] = decodeSeconds;
+    result["media_seconds"] = mediaSeconds;
+    result["speed"] = decodeSeconds > 0 ? mediaSeconds / decodeSeconds : 0.0;
+    result["video_frames"] = videoFrames;
+    result["audio_frames"] = audioFrames;
+    result["fps"] = decodeSeconds > 0 ? videoFrames / decodeSeconds : 0.0;
+    result["cpu_seconds"] = cpuSeconds;
+    result["cpu_utilization"] = wallSeconds > 0 ? cpuSeconds / wallSeconds : 0.0;
+    result["stalls"] = stalls;
+    result["queues"] = QJsonObject{
+        {"video_frames", videoFrameQueue.toJson()},
+        {"audio_frames", audioFrameQueue.toJson()},
+        {"video_packets", videoPacketQueue.toJson()},
+        {"audio_packets", audioPacketQueue.toJson()},
+        {"read_ahead_blocks", readAhead.toJson()},
+    };
+    result["stages"] = QJsonObject{
+        {"demux", stageToJson(stats.demux)},
+        {"video_decode", stageToJson(stats.videoDecode)},
+        {"audio_decode", stageToJson(stats.audioDecode)},
+    };
+    if (live) {
+        LatencyController::Stats latencyStats = latency.stats();
+        result["latency"] = QJsonObject{
+            {"clock", options.senderClock ? "sender" : "buffer"},
+            {"target", latency.target()},
+            {"avg", latencyStats.updates ? latencyStats.sumLatency / latencyStats.updates : 0.0},
+            {"max", latencyStats.maxLatency},
+            {"final", latencyStats.latency},
+            {"rate", latencyStats.rate},
+            {"drops", latencyStats.drops},
+        };
+    }
+    result["io"] = QJsonObject{
+        {"backend", QString::fromLatin1(stats.io.backend)},
+        {"read_ahead_depth", stats.io.readAheadDepth},
+        {"bytes_read", qint64(stats.io.bytesRead)},
+        {"waits", qint64(stats.io.waits)},
+        {"wait_ms", stats.io.waitMs},
+        {"max_wait_ms", stats.io.maxWaitMs},
+    };
+    return result;
+}
+
+// 测试期间关闭调试输出，只保留警告和错误，避免影响计时
+void quietMessageHandler(QtMsgType type, const QMessageLogContext &, const QString &message) {
+    if (type != QtDebugMsg && type != QtInfoMsg) {
+        fprintf(stderr, "%s\n", qPrintable(message));
+    }
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("DecodeBenchmark");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("无界面解码性能测试，结果以JSON输出");
+    parser.addHelpOption();
+    parser.addPositionalArgument("files", "要测试的媒体文件", "file...");
+    QCommandLineOption realtimeOption("realtime", "按实时速度取帧（默认尽可能快）");
+    QCommandLineOption maxSecondsOption("max-seconds", "每个文件最多解码的媒体时长（秒）",
+                                        "seconds", "0");
+    QCommandLineOption outputOption({"o", "output"}, "结果写入文件（默认标准输出）", "path");
+    QCommandLineOption verboseOption("verbose", "保留调试输出");
+    QCommandLineOption ioOption("io", "输入方式：mmap、readahead或ffmpeg（默认自动选择）",
+                                "backend");
+    QCommandLineOption latencyOption("latency", "直播目标延迟（秒）", "seconds",
+                                     QString::number(LatencyController::DEFAULT_TARGET));
+    QCommandLineOption senderClockOption(
+        "sender-clock", "直播时间戳为推流端墙上时钟（LiveSender），测量端到端延迟");
+    parser.addOptions({realtimeOption, maxSecondsOption, outputOption, verboseOption, ioOption,
+                       latencyOption, senderClockOption});
+    parser.process(app);
+
+    if (parser.isSet(ioOption)) {
+        qputenv("PLAYER_IO", parser.value(ioOption).toLatin1());
+    }
+
+    const QStringList files = parser.positionalArguments();
+    if (files.isEmpty()) {
+        parser.showHelp(1);
+    }
+
+    if (!parser.isSet(verboseOption)) {
+        qInstallMessageHandler(quietMessageHandler);
+    }
+
+    BenchOptions options;
+    options.realtime = parser.isSet(realtimeOption);
+    options.maxSeconds = parser.value(maxSecondsOption).toDouble();
+    options.latencyTarget = parser.value(latencyOption).toDouble();
+    options.senderClock = parser.isSet(senderClockOption);
+
+    QJsonArray results;
+    for (const QString &file : files) {
+        results.append(runFile(file, options));
+    }
+
+    QJsonObject report{
+        {"mode", options.realtime ? "realtime" : "max"},
+        {"workers", DecodeScheduler::instance().workerCount()},
+        {"ffmpeg", QString::fromLatin1(av_version_info())},
+        {"qt", QString::fromLatin1(qVersion())},
+        {"peak_rss_kb", currentUsage().peakRssKb},
+        {"files", results},
+    };
+
+    QByteArray json = QJsonDocument(report).toJson(QJsonDocument::Indented);
+    if (parser.isSet(outputOption)) {
+        QFile output(parser.value(outputOption));
+        if (!output.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            fprintf(stderr, "无法写入结果文件: %s\n", qPrintable(output.fileName()));
+            return 1;
+        }
+        output.write(json);
+    } else {
+        fwrite(json.constData(), 1, size_t(json.size()), stdout);
+    }
+
+    // 任一文件失败时返回非零，便于CI检测
+    for (const QJsonValue &value : results) {
+        if (value.toObject().contains("error")) return 2;
+    }
+    return 0;
+}
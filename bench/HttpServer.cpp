@@ -0,0 +1,66 @@
+// 本机HTTP文件服务器（测试工具）
+// 代替CDN/源站提供目录下的文件，支持Range请求并返回ETag/Last-Modified，
+// 用于在本机测试HTTP分块预取、磁盘缓存及其校验（修改文件后ETag随之改变，播放端丢弃旧缓存）：
+//
+//   HttpServer --generate &                         （在临时目录生成合成素材clip.mp4）
+//   DecodeBenchmark http://127.0.0.1:18080/clip.mp4  （第二次运行时命中缓存）
+//
+// 用法: HttpServer [--port N] [--latency 毫秒] [--rate KB/s] [--generate] [--quiet] [目录]
+
+#include "LocalHttpServer.h"
+#include "SyntheticMedia.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QTemporaryDir>
+#include <cstdio>
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("HttpServer");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("本机HTTP文件服务器，用于测试HTTP输入和缓存");
+    parser.addHelpOption();
+    parser.addPositionalArgument("dir", "提供的目录（默认为当前目录）", "[dir]");
+    QCommandLineOption portOption("port", "起始端口，被占用时依次尝试后续端口", "port", "18080");
+    QCommandLineOption latencyOption("latency", "每个响应前的延迟（毫秒）", "ms", "0");
+    QCommandLineOption rateOption("rate", "每个连接的限速（KB/s，0为不限速）", "kbps", "0");
+    QCommandLineOption generateOption("generate", "在临时目录生成合成素材clip.mp4并提供该目录");
+    QCommandLineOption quietOption("quiet", "不输出请求日志");
+    parser.addOptions({portOption, latencyOption, rateOption, generateOption, quietOption});
+    parser.process(app);
+
+    QString root = parser.positionalArguments().value(0, QDir::currentPath());
+    QTemporaryDir tempDir;
+    if (parser.isSet(generateOption)) {
+        if (!tempDir.isValid()) {
+            fprintf(stderr, "无法创建临时目录\n");
+            return 1;
+        }
+        SyntheticMediaSpec spec;
+        spec.duration = 30.0;
+        spec.width = 1280;
+        spec.height = 720;
+        spec.videoBitrate = 4000000;
+        QString error;
+        if (!SyntheticMedia::generate(spec, tempDir.filePath("clip.mp4"), &error)) {
+            fprintf(stderr, "生成素材失败: %s\n", qPrintable(error));
+            return 1;
+        }
+        root = tempDir.path();
+    }
+
+    LocalHttpServer server;
+    server.setLatency(parser.value(latencyOption).toInt());
+    server.setRateLimit(parser.value(rateOption).toLongLong() * 1024);
+    server.setVerbose(!parser.isSet(quietOption));
+
+    QString error;
+    if (!server.start(root, parser.value(portOption).toInt(), &error)) {
+        fprintf(stderr, "%s\n", qPrintable(error));
+        return 2;
+    }
+    fprintf(stderr, "提供 %s: %s\n", qPrintable(root), qPrintable(server.url(QString())));
+    return app.exec();
+}
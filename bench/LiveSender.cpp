@@ -0,0 +1,64 @@
+// 直播推流测试工具
+// 按实时速度生成合成音视频（与PerfSuite相同的画面和声音），以MPEG-TS推送到udp/srt等地址。
+// 时间戳为推流时刻的墙上时钟，本机回环测试时播放端可据此测量端到端延迟：
+//
+//   LiveSender udp://127.0.0.1:1234?pkt_size=1316 &
+//   PLAYER_LIVE_CLOCK=sender MultimediaPlayer            （文件 → 打开网络地址）
+//   DecodeBenchmark --sender-clock --max-seconds 30 udp://127.0.0.1:1234
+//
+// 用法: LiveSender [--duration 秒] [--size WxH] [--fps N] [--gop N] [--format mpegts] url
+
+#include "SyntheticMedia.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <cstdio>
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("LiveSender");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("按实时速度推送合成音视频，用于测试直播模式");
+    parser.addHelpOption();
+    parser.addPositionalArgument("url", "推流地址，如 udp://127.0.0.1:1234?pkt_size=1316");
+    QCommandLineOption durationOption("duration", "推流时长（秒）", "seconds", "600");
+    QCommandLineOption sizeOption("size", "画面尺寸", "WxH", "1280x720");
+    QCommandLineOption fpsOption("fps", "帧率", "fps", "30");
+    QCommandLineOption gopOption("gop", "关键帧间隔（帧），决定播放端的起播等待", "frames", "30");
+    QCommandLineOption formatOption("format", "封装格式", "name", "mpegts");
+    parser.addOptions({durationOption, sizeOption, fpsOption, gopOption, formatOption});
+    parser.process(app);
+
+    const QStringList args = parser.positionalArguments();
+    if (args.size() != 1) {
+        parser.showHelp(1);
+    }
+
+    SyntheticMediaSpec spec;
+    spec.container = parser.value(formatOption);
+    spec.duration = parser.value(durationOption).toDouble();
+    spec.fps = parser.value(fpsOption).toInt();
+    spec.gopSize = parser.value(gopOption).toInt();
+    spec.videoBitrate = 4000000;
+    spec.realtime = true;
+
+    const QStringList size = parser.value(sizeOption).split('x');
+    if (size.size() == 2) {
+        spec.width = size[0].toInt();
+        spec.height = size[1].toInt();
+    }
+    if (spec.fps <= 0 || spec.width <= 0 || spec.height <= 0) {
+        fprintf(stderr, "无效的帧率或画面尺寸\n");
+        return 1;
+    }
+
+    fprintf(stderr, "推流 %s: %dx%d %dfps，%.0f 秒\n", qPrintable(args[0]), spec.width,
+            spec.height, spec.fps, spec.duration);
+
+    QString error;
+    if (!SyntheticMedia::generate(spec, args[0], &error)) {
+        fprintf(stderr, "推流失败: %s\n", qPrintable(error));
+        return 2;
+    }
+    return 0;
+}
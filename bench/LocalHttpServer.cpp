@@ -0,0 +1,227 @@
+#include "LocalHttpServer.h"
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QLocale>
+#include <QThread>
+#include <QUrl>
+#include <algorithm>
+#include <cstdio>
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavformat/avio.h>
+}
+
+namespace {
+
+constexpr int MAX_HEADER_BYTES = 16 * 1024;
+constexpr int BODY_BLOCK = 64 * 1024;
+
+QByteArray contentType(const QString &path) {
+    const QString suffix = QFileInfo(path).suffix().toLower();
+    if (suffix == "m3u8") return "application/vnd.apple.mpegurl";
+    if (suffix == "mpd") return "application/dash+xml";
+    if (suffix == "ts") return "video/mp2t";
+    if (suffix == "mp4" || suffix == "m4s") return "video/mp4";
+    if (suffix == "mkv") return "video/x-matroska";
+    return "application/octet-stream";
+}
+
+// "bytes=a-b"、"bytes=a-"或"bytes=-n"，解析为[begin, end)；不支持多段
+bool parseRange(const QByteArray &value, qint64 size, qint64 *begin, qint64 *end) {
+    if (!value.startsWith("bytes=") || value.contains(',')) return false;
+    const QByteArray spec = value.mid(6).trimmed();
+    const int dash = spec.indexOf('-');
+    if (dash < 0) return false;
+    const QByteArray first = spec.left(dash);
+    const QByteArray last = spec.mid(dash + 1);
+    bool ok = true;
+    if (first.isEmpty()) {
+        qint64 suffix = last.toLongLong(&ok);
+        if (!ok || suffix <= 0) return false;
+        *begin = std::max<qint64>(0, size - suffix);
+        *end = size;
+    } else {
+        *begin = first.toLongLong(&ok);
+        if (!ok) return false;
+        *end = last.isEmpty() ? size : std::min(last.toLongLong(&ok) + 1, size);
+        if (!ok) return false;
+    }
+    return *begin < *end && *begin < size;
+}
+
+void writeText(AVIOContext *client, const QByteArray &text) {
+    avio_write(client, reinterpret_cast<const unsigned char *>(text.constData()), text.size());
+}
+
+}  // namespace
+
+LocalHttpServer::LocalHttpServer() { m_pool.setMaxThreadCount(1 + MAX_CONNECTIONS); }
+
+LocalHttpServer::~LocalHttpServer() { stop(); }
+
+bool LocalHttpServer::start(const QString &rootDir, int port, QString *error) {
+    avformat_network_init();
+    m_root = QDir(rootDir).absolutePath();
+    m_stopped = false;
+
+    // listen=2：只绑定端口，由avio_accept逐个接受连接
+    AVIOInterruptCB interrupt{&LocalHttpServer::interruptCallback, this};
+    for (int candidate = port; candidate < port + 20; ++candidate) {
+        const QByteArray address = "tcp://127.0.0.1:" + QByteArray::number(candidate) + "?listen=2";
+        if (avio_open2(&m_server, address.constData(), AVIO_FLAG_READ_WRITE, &interrupt,
+                       nullptr) >= 0) {
+            m_port = candidate;
+            m_pool.start([this] { acceptLoop(); });
+            return true;
+        }
+    }
+    if (error) *error = QString("无法在端口%1~%2上监听").arg(port).arg(port + 19);
+    return false;
+}
+
+void LocalHttpServer::stop() {
+    if (!m_server) return;
+    // 中断正在等待的accept和各连接的读写
+    m_stopped = true;
+    m_pool.waitForDone();
+    avio_closep(&m_server);
+}
+
+QString LocalHttpServer::url(const QString &relativePath) const {
+    return QString("http://127.0.0.1:%1/%2").arg(m_port).arg(relativePath);
+}
+
+int LocalHttpServer::interruptCallback(void *opaque) {
+    return static_cast<LocalHttpServer *>(opaque)->m_stopped.load() ? 1 : 0;
+}
+
+void LocalHttpServer::acceptLoop() {
+    while (!m_stopped) {
+        AVIOContext *client = nullptr;
+        if (avio_accept(m_server, &client) < 0) {
+            if (!m_stopped) QThread::msleep(10);
+            continue;
+        }
+        int ret;
+        while ((ret = avio_handshake(client)) > 0) {
+        }
+        if (ret < 0) {
+            avio_closep(&client);
+            continue;
+        }
+        m_pool.start([this, client] { serve(client); });
+    }
+}
+
+void LocalHttpServer::serve(AVIOContext *client) {
+    // 读取请求头（忽略请求正文）
+    QByteArray header;
+    unsigned char buffer[4096];
+    while (!header.contains("\r\n\r\n") && header.size() < MAX_HEADER_BYTES) {
+        int n = avio_read_partial(client, buffer, sizeof(buffer));
+        if (n <= 0) break;
+        header.append(reinterpret_cast<const char *>(buffer), n);
+    }
+    const QList<QByteArray> lines = header.left(header.indexOf("\r\n\r\n")).split('\n');
+    const QList<QByteArray> requestLine = lines.value(0).trimmed().split(' ');
+    if (requestLine.size() < 2) {
+        avio_closep(&client);
+        return;
+    }
+    const QByteArray method = requestLine[0];
+    QByteArray target = requestLine[1];
+    if (target.contains('?')) target = target.left(target.indexOf('?'));
+
+    QByteArray range;
+    for (const QByteArray &line : lines) {
+        const int colon = line.indexOf(':');
+        if (colon > 0 && line.left(colon).trimmed().toLower() == "range") {
+            range = line.mid(colon + 1).trimmed();
+        }
+    }
+    m_requests.fetch_add(1, std::memory_order_relaxed);
+
+    // 只提供根目录之内的文件
+    const QString path = QDir::cleanPath(m_root + '/' + QUrl::fromPercentEncoding(target));
+    const QFileInfo info(path);
+    const bool inRoot = path.startsWith(m_root + '/');
+
+    int status = 200;
+    QByteArray reason = "OK";
+    QByteArray headers;
+    qint64 begin = 0;
+    qint64 end = 0;
+    QFile file(path);
+    if (method != "GET" && method != "HEAD") {
+        status = 405;
+        reason = "Method Not Allowed";
+    } else if (!inRoot || !info.isFile() || !file.open(QIODevice::ReadOnly)) {
+        status = 404;
+        reason = "Not Found";
+    } else {
+        const qint64 size = info.size();
+        const QDateTime modified = info.lastModified().toUTC();
+        end = size;
+        headers += "Accept-Ranges: bytes\r\n";
+        headers += "Content-Type: " + contentType(path) + "\r\n";
+        headers += QByteArray("ETag: \"") + QByteArray::number(modified.toMSecsSinceEpoch(), 16) +
+                   '-' + QByteArray::number(size, 16) + "\"\r\n";
+        headers += "Last-Modified: " +
+                   QLocale::c().toString(modified, "ddd, dd MMM yyyy hh:mm:ss 'GMT'").toLatin1() +
+                   "\r\n";
+        if (!range.isEmpty()) {
+            if (parseRange(range, size, &begin, &end)) {
+                status = 206;
+                reason = "Partial Content";
+                headers += "Content-Range: bytes " + QByteArray::number(begin) + '-' +
+                           QByteArray::number(end - 1) + '/' + QByteArray::number(size) + "\r\n";
+            } else {
+                status = 416;
+                reason = "Range Not Satisfiable";
+                headers += "Content-Range: bytes */" + QByteArray::number(size) + "\r\n";
+                begin = end = 0;
+            }
+        }
+    }
+
+    if (m_verbose) {
+        fprintf(stderr, "%s %s %d %s\n", method.constData(), target.constData(), status,
+                range.constData());
+    }
+
+    const int latency = m_latencyMs.load();
+    if (latency > 0) QThread::msleep(unsigned(latency));
+
+    writeText(client, "HTTP/1.1 " + QByteArray::number(status) + ' ' + reason + "\r\n" + headers +
+                          "Content-Length: " + QByteArray::number(end - begin) +
+                          "\r\nConnection: close\r\n\r\n");
+
+    // 正文按块写出，限速时按已发送字节数控制节奏
+    if (method == "GET" && end > begin && file.seek(begin)) {
+        QElapsedTimer timer;
+        timer.start();
+        qint64 sent = 0;
+        QByteArray block;
+        while (begin + sent < end && !m_stopped) {
+            block = file.read(std::min<qint64>(BODY_BLOCK, end - begin - sent));
+            if (block.isEmpty()) break;
+            writeText(client, block);
+            avio_flush(client);
+            if (client->error < 0) break;
+            sent += block.size();
+            m_bytesSent.fetch_add(block.size(), std::memory_order_relaxed);
+
+            const qint64 rate = m_rateLimit.load();
+            if (rate > 0) {
+                const qint64 dueMs = sent * 1000 / rate;
+                if (dueMs > timer.elapsed()) QThread::msleep(unsigned(dueMs - timer.elapsed()));
+            }
+        }
+    }
+    avio_flush(client);
+    avio_closep(&client);
+}
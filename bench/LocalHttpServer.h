@@ -0,0 +1,56 @@
+#pragma once
+
+#include <QString>
+#include <QThreadPool>
+#include <atomic>
+#include <cstdint>
+
+struct AVIOContext;
+
+// 本机HTTP文件服务器，测试时代替CDN/源站：提供目录下的文件，支持GET/HEAD和单段Range请求，
+// 响应带Content-Length、Accept-Ranges、ETag（由修改时间和长度生成）和Last-Modified，
+// 每个请求处理完即关闭连接。只依赖FFmpeg的tcp协议（监听模式），不需要QtNetwork
+class LocalHttpServer {
+public:
+    LocalHttpServer();
+    ~LocalHttpServer();
+
+    LocalHttpServer(const LocalHttpServer &) = delete;
+    LocalHttpServer &operator=(const LocalHttpServer &) = delete;
+
+    // 在127.0.0.1上从port起依次尝试监听，失败时返回false并写入错误信息
+    bool start(const QString &rootDir, int port = 18080, QString *error = nullptr);
+    void stop();
+
+    int port() const { return m_port; }
+    // 目录中文件的地址，如 url("clip.mp4") -> http://127.0.0.1:18080/clip.mp4
+    QString url(const QString &relativePath) const;
+
+    // 每个响应前的延迟（模拟网络往返）和正文限速（字节/秒，0为不限速）
+    void setLatency(int ms) { m_latencyMs = ms; }
+    void setRateLimit(int64_t bytesPerSecond) { m_rateLimit = bytesPerSecond; }
+    // 每个请求在stderr输出一行日志
+    void setVerbose(bool verbose) { m_verbose = verbose; }
+
+    int64_t requests() const { return m_requests.load(std::memory_order_relaxed); }
+    int64_t bytesSent() const { return m_bytesSent.load(std::memory_order_relaxed); }
+
+private:
+    void acceptLoop();
+    void serve(AVIOContext *client);
+    static int interruptCallback(void *opaque);
+
+    QString m_root;
+    int m_port{0};
+    AVIOContext *m_server{nullptr};
+    QThreadPool m_pool;  // 一个线程等待连接，其余处理请求
+
+    std::atomic<bool> m_stopped{false};
+    std::atomic<int> m_latencyMs{0};
+    std::atomic<int64_t> m_rateLimit{0};
+    std::atomic<bool> m_verbose{false};
+    std::atomic<int64_t> m_requests{0};
+    std::atomic<int64_t> m_bytesSent{0};
+
+    static constexpr int MAX_CONNECTIONS = 16;
+};
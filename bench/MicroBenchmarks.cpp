@@ -0,0 +1,525 @@
+// 热路径微基准测试（Google Benchmark）
+// 覆盖解封装/解码队列、AudioBuffer读写、音频重采样、纹理上传和像素格式转换，
+// 包括多线程生产者/消费者竞争和不同帧尺寸
+//
+// 用法: MicroBenchmarks [--benchmark_filter=Queue] [--benchmark_format=json] ...
+// 纹理上传需要OpenGL：没有显示器时自动使用offscreen平台，无法创建上下文时跳过
+
+#include "media/AudioBuffer.h"
+#include "media/AudioProcessor.h"
+#include "media/AudioResampler.h"
+#include "media/FFmpegStream.h"
+#include "media/LoudnessMeter.h"
+#include "media/MediaQueue.h"
+#include "media/TimeStretcher.h"
+#include <QGuiApplication>
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QOpenGLFunctions>
+#include <atomic>
+#include <benchmark/benchmark.h>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+extern "C" {
+#include <libavutil/channel_layout.h>
+#include <libavutil/frame.h>
+#include <libavutil/pixdesc.h>
+#include <libswscale/swscale.h>
+}
+
+namespace {
+
+// 与DemuxThread/VideoDecoder中的队列容量一致
+constexpr size_t PACKET_QUEUE_CAPACITY = 50;
+constexpr size_t FRAME_QUEUE_CAPACITY = 30;
+
+// ---------------------------------------------------------------------------
+// 队列
+
+// 单线程：连续写入batch个数据包再全部取出（解封装领先解码时的典型模式）
+void BM_PacketQueue_PushPop(benchmark::State &state) {
+    const int batch = int(state.range(0));
+    MediaQueue<PacketData> queue(PACKET_QUEUE_CAPACITY);
+    std::unique_ptr<PacketData> item;
+
+    for (auto _ : state) {
+        for (int i = 0; i < batch; ++i) {
+            auto packet = std::make_unique<PacketData>();
+            queue.tryPush(packet);
+        }
+        for (int i = 0; i < batch; ++i) {
+            queue.tryPop(item);
+        }
+        benchmark::DoNotOptimize(item.get());
+    }
+    state.SetItemsProcessed(state.iterations() * batch);
+}
+BENCHMARK(BM_PacketQueue_PushPop)->Arg(1)->Arg(8)->Arg(50);
+
+// 多线程竞争：偶数线程生产、奇数线程消费，队列满/空时让出CPU（对应调度器的Idle）
+// 各线程迭代次数相同，生产与消费总数相等，测试结束时队列为空
+void BM_PacketQueue_Contention(benchmark::State &state) {
+    static MediaQueue<PacketData> queue(PACKET_QUEUE_CAPACITY);
+    const bool producer = state.thread_index() % 2 == 0;
+    std::unique_ptr<PacketData> item;
+
+    for (auto _ : state) {
+        if (producer) {
+            auto packet = std::make_unique<PacketData>();
+            while (!queue.tryPush(packet)) {
+                std::this_thread::yield();
+            }
+        } else {
+            while (!queue.tryPop(item)) {
+                std::this_thread::yield();
+            }
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_PacketQueue_Contention)->Threads(2)->Threads(4)->Threads(8)->UseRealTime();
+
+// 帧队列的阻塞等待（waitPop）：消费者在队列为空时等待生产者唤醒
+void BM_FrameQueue_WaitPop(benchmark::State &state) {
+    static MediaQueue<FrameData> queue(FRAME_QUEUE_CAPACITY);
+    const bool producer = state.thread_index() % 2 == 0;
+    std::unique_ptr<FrameData> item;
+
+    for (auto _ : state) {
+        if (producer) {
+            // 解码器在队列满时暂停，这里用让出CPU模拟
+            while (queue.isFull()) {
+                std::this_thread::yield();
+            }
+            queue.forcePush(std::make_unique<FrameData>());
+        } else {
+            while (!queue.waitPop(item, 100)) {
+            }
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_FrameQueue_WaitPop)->Threads(2)->Threads(4)->UseRealTime();
+
+// ---------------------------------------------------------------------------
+// AudioBuffer
+
+// 单线程：写入一个解码帧大小的数据块，按音频设备的周期大小读完
+void BM_AudioBuffer_WriteRead(benchmark::State &state) {
+    const int chunkBytes = int(state.range(0));
+    const int readBytes = int(state.range(1));
+    AudioBuffer buffer;
+    QByteArray chunk(chunkBytes, '\0');
+    std::vector<char> output(readBytes);
+
+    for (auto _ : state) {
+        buffer.writeData(chunk);
+        qint64 remaining = chunkBytes;
+        while (remaining > 0) {
+            qint64 n = buffer.read(output.data(), qMin<qint64>(readBytes, remaining));
+            if (n <= 0) break;
+            remaining -= n;
+        }
+        benchmark::DoNotOptimize(output.data());
+    }
+    state.SetBytesProcessed(state.iterations() * chunkBytes);
+}
+BENCHMARK(BM_AudioBuffer_WriteRead)
+    ->Args({1024 * 4, 4096})   // 1024样本立体声S16
+    ->Args({4096 * 4, 4096})   // 大帧
+    ->Args({1152 * 4, 1764})   // MP3帧，10ms@44.1kHz读取
+    ->Args({256 * 4, 16384});  // 小帧，大块读取
+
+// 两个线程：解码线程写入、音频线程读取，写入方领先不超过64KB
+void BM_AudioBuffer_Contention(benchmark::State &state) {
+    static AudioBuffer buffer;
+    static std::atomic<qint64> outstanding{0};
+    constexpr qint64 MAX_OUTSTANDING = 64 * 1024;
+    const int chunkBytes = int(state.range(0));
+    const bool writer = state.thread_index() == 0;
+    QByteArray chunk(chunkBytes, '\0');
+    std::vector<char> output(chunkBytes);
+
+    for (auto _ : state) {
+        if (writer) {
+            while (outstanding.load(std::memory_order_acquire) > MAX_OUTSTANDING) {
+                std::this_thread::yield();
+            }
+            buffer.writeData(chunk);
+            outstanding.fetch_add(chunkBytes, std::memory_order_release);
+        } else {
+            // 读够一个数据块（写入总量与读取总量相等，不会永久等待）
+            qint64 remaining = chunkBytes;
+            while (remaining > 0) {
+                qint64 n = buffer.read(output.data(), remaining);
+                if (n > 0) {
+                    remaining -= n;
+                    outstanding.fetch_sub(n, std::memory_order_release);
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * chunkBytes);
+}
+BENCHMARK(BM_AudioBuffer_Contention)->Arg(1024 * 4)->Arg(4096 * 4)->Threads(2)->UseRealTime();
+
+// ---------------------------------------------------------------------------
+// 音频重采样（AudioPlayer的convert路径）
+
+enum ResampleCase { FormatOnly, Resample, Downmix };
+
+constexpr double TWO_PI = 6.283185307179586;
+
+// 按声道数设置默认布局：FFmpeg 5.1起为AVChannelLayout，之前为channel_layout/channels
+void setDefaultLayout(AVFrame *frame, int channels) {
+#if LIBAVUTIL_VERSION_INT >= AV_VERSION_INT(57, 24, 100)
+    av_channel_layout_default(&frame->ch_layout, channels);
+#else
+    frame->channel_layout = av_get_default_channel_layout(channels);
+    frame->channels = channels;
+#endif
+}
+
+void BM_AudioResampler_Convert(benchmark::State &state) {
+    const int samples = int(state.range(0));
+    const auto resampleCase = ResampleCase(state.range(1));
+
+    int inChannels = resampleCase == Downmix ? 6 : 2;
+    int inRate = resampleCase == Resample ? 44100 : 48000;
+
+    AudioResampler resampler;
+    if (!resampler.open(AudioResampler::defaultLayout(inChannels), inChannels,
+                        AV_SAMPLE_FMT_FLTP, inRate, 2, 48000)) {
+        state.SkipWithError("无法创建重采样器");
+        return;
+    }
+
+    // 解码器常见的平面浮点输出，填充正弦波
+    AVFrame *frame = av_frame_alloc();
+    frame->format = AV_SAMPLE_FMT_FLTP;
+    setDefaultLayout(frame, inChannels);
+    frame->sample_rate = inRate;
+    frame->nb_samples = samples;
+    if (av_frame_get_buffer(frame, 0) < 0) {
+        av_frame_free(&frame);
+        state.SkipWithError("无法分配音频帧");
+        return;
+    }
+    for (int ch = 0; ch < inChannels; ++ch) {
+        float *data = reinterpret_cast<float *>(frame->extended_data[ch]);
+        for (int i = 0; i < samples; ++i) {
+            data[i] = 0.5f * float(std::sin(TWO_PI * 440.0 * i / inRate));
+        }
+    }
+
+    int64_t outputBytes = 0;
+    for (auto _ : state) {
+        QByteArray pcm = resampler.convert(frame);
+        outputBytes += pcm.size();
+        benchmark::DoNotOptimize(pcm.constData());
+    }
+
+    av_frame_free(&frame);
+    state.SetItemsProcessed(state.iterations() * samples);
+    state.SetBytesProcessed(outputBytes);
+}
+BENCHMARK(BM_AudioResampler_Convert)
+    ->ArgNames({"samples", "case"})
+    ->ArgsProduct({{256, 1024, 4096}, {FormatOnly, Resample, Downmix}});
+
+// 变速不变调（重采样之后的float立体声），速度 = range(1) / 100
+void BM_TimeStretcher_Process(benchmark::State &state) {
+    const int samples = int(state.range(0));
+    const double rate = state.range(1) / 100.0;
+
+    QByteArray pcm(samples * 2 * int(sizeof(float)), Qt::Uninitialized);
+    float *data = reinterpret_cast<float *>(pcm.data());
+    for (int i = 0; i < samples; ++i) {
+        data[2 * i] = data[2 * i + 1] = 0.5f * float(std::sin(TWO_PI * 440.0 * i / 48000));
+    }
+
+    TimeStretcher stretcher(2, 48000);
+    stretcher.setRate(rate);
+    int64_t outputBytes = 0;
+    for (auto _ : state) {
+        QByteArray output = stretcher.process(pcm);
+        outputBytes += output.size();
+        benchmark::DoNotOptimize(output.constData());
+    }
+
+    state.SetItemsProcessed(state.iterations() * samples);
+    state.SetBytesProcessed(outputBytes);
+}
+BENCHMARK(BM_TimeStretcher_Process)
+    ->ArgNames({"samples", "rate"})
+    ->ArgsProduct({{1024, 4096}, {50, 150, 300}});
+
+// 设备输出路径：直接转换为S16，与转换为float后经AudioProcessor（音量、抖动）转换为S16对比
+enum OutputPath { DirectS16, FloatProcessor };
+
+void BM_AudioOutput_Path(benchmark::State &state) {
+    const int samples = int(state.range(0));
+    const auto path = OutputPath(state.range(1));
+
+    AudioResampler resampler;
+    AVSampleFormat outFormat = path == DirectS16 ? AV_SAMPLE_FMT_S16 : AV_SAMPLE_FMT_FLT;
+    if (!resampler.open(AudioResampler::defaultLayout(2), 2, AV_SAMPLE_FMT_FLTP, 48000, 2, 48000,
+                        outFormat)) {
+        state.SkipWithError("无法创建重采样器");
+        return;
+    }
+    AudioProcessor processor(2, 48000);
+    processor.setGain(0.8f);
+
+    AVFrame *frame = av_frame_alloc();
+    frame->format = AV_SAMPLE_FMT_FLTP;
+    setDefaultLayout(frame, 2);
+    frame->sample_rate = 48000;
+    frame->nb_samples = samples;
+    if (av_frame_get_buffer(frame, 0) < 0) {
+        av_frame_free(&frame);
+        state.SkipWithError("无法分配音频帧");
+        return;
+    }
+    for (int ch = 0; ch < 2; ++ch) {
+        float *data = reinterpret_cast<float *>(frame->extended_data[ch]);
+        for (int i = 0; i < samples; ++i) {
+            data[i] = 0.5f * float(std::sin(TWO_PI * 440.0 * i / 48000));
+        }
+    }
+
+    for (auto _ : state) {
+        QByteArray pcm = resampler.convert(frame);
+        if (path == FloatProcessor) {
+            pcm = processor.process(pcm);
+        }
+        benchmark::DoNotOptimize(pcm.constData());
+    }
+
+    av_frame_free(&frame);
+    state.SetItemsProcessed(state.iterations() * samples);
+}
+BENCHMARK(BM_AudioOutput_Path)
+    ->ArgNames({"samples", "path"})
+    ->ArgsProduct({{256, 1024, 4096}, {DirectS16, FloatProcessor}});
+
+// AudioProcessor内核：音量斜坡、交叉淡化和抖动转换，对比AVX2与基础内核（SSE2，ARM上为NEON）
+enum ProcessorKernel { KernelSse2, KernelAvx2 };
+
+void BM_AudioProcessor_Kernels(benchmark::State &state) {
+    const int samples = int(state.range(0));
+    const bool avx2 = state.range(1) == KernelAvx2;
+    if (avx2 && !AudioProcessor::avx2Supported()) {
+        state.SkipWithError("CPU不支持AVX2");
+        return;
+    }
+    AudioProcessor::setAvx2Enabled(avx2);
+
+    std::vector<float> input(size_t(samples) * 2);
+    for (size_t i = 0; i < input.size(); ++i) {
+        input[i] = 0.5f * float(std::sin(TWO_PI * 440.0 * double(i / 2) / 48000));
+    }
+    std::vector<float> work(input.size());
+    std::vector<int16_t> output(input.size());
+    AudioProcessor processor(2, 48000);
+
+    for (auto _ : state) {
+        std::memcpy(work.data(), input.data(), work.size() * sizeof(float));
+        AudioProcessor::applyGain(work.data(), int(work.size()), 0.5f, 0.8f);
+        AudioProcessor::mix(work.data(), input.data(), int(work.size()), 1.0f, 0.0f);
+        processor.toS16(work.data(), int(work.size()), output.data());
+        benchmark::DoNotOptimize(output.data());
+    }
+
+    AudioProcessor::setAvx2Enabled(true);
+    state.SetItemsProcessed(state.iterations() * samples);
+}
+BENCHMARK(BM_AudioProcessor_Kernels)
+    ->ArgNames({"samples", "avx2"})
+    ->ArgsProduct({{256, 1024, 4096}, {KernelSse2, KernelAvx2}});
+
+// R128响度测量（K加权滤波、子块能量和门限直方图），输入为交错float
+void BM_LoudnessMeter_Process(benchmark::State &state) {
+    const int samples = int(state.range(0));
+    const int channels = int(state.range(1));
+
+    std::vector<float> pcm(size_t(samples) * size_t(channels));
+    for (int i = 0; i < samples; ++i) {
+        for (int c = 0; c < channels; ++c) {
+            pcm[size_t(i * channels + c)] = 0.5f * float(std::sin(TWO_PI * 440.0 * i / 48000));
+        }
+    }
+
+    LoudnessMeter meter(channels, 48000);
+    for (auto _ : state) {
+        meter.process(pcm.data(), samples);
+    }
+    benchmark::DoNotOptimize(meter.integrated());
+
+    state.SetItemsProcessed(state.iterations() * samples);
+}
+BENCHMARK(BM_LoudnessMeter_Process)
+    ->ArgNames({"samples", "channels"})
+    ->ArgsProduct({{1024, 4096}, {2, 6}});
+
+// ---------------------------------------------------------------------------
+// 视频帧
+
+AVFrame *allocVideoFrame(int width, int height, AVPixelFormat format, int align) {
+    AVFrame *frame = av_frame_alloc();
+    frame->format = format;
+    frame->width = width;
+    frame->height = height;
+    if (av_frame_get_buffer(frame, align) < 0) {
+        av_frame_free(&frame);
+        return nullptr;
+    }
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(format);
+    for (int plane = 0; plane < AV_NUM_DATA_POINTERS && frame->data[plane]; ++plane) {
+        if ((desc->flags & AV_PIX_FMT_FLAG_PAL) && plane == 1) {
+            memset(frame->data[plane], 0x80, AVPALETTE_SIZE);
+            continue;
+        }
+        bool chroma = (plane == 1 || plane == 2) && !(desc->flags & AV_PIX_FMT_FLAG_RGB);
+        int rows = chroma ? AV_CEIL_RSHIFT(height, desc->log2_chroma_h) : height;
+        memset(frame->data[plane], 0x80, size_t(frame->linesize[plane]) * rows);
+    }
+    return frame;
+}
+
+// CPU侧格式转换（OpenGLFrameRenderer::convertToRGBA，用于GL不能直接显示的格式）
+void BM_ConvertToRGBA(benchmark::State &state) {
+    const int width = int(state.range(0));
+    const int height = int(state.range(1));
+    const auto srcFormat = AVPixelFormat(state.range(2));
+
+    AVFrame *src = allocVideoFrame(width, height, srcFormat, 0);
+    AVFrame *dst = allocVideoFrame(width, height, AV_PIX_FMT_RGBA, 0);
+    SwsContext *sws = sws_getContext(width, height, srcFormat, width, height, AV_PIX_FMT_RGBA,
+                                     SWS_BILINEAR, nullptr, nullptr, nullptr);
+    if (!src || !dst || !sws) {
+        state.SkipWithError("无法创建转换上下文");
+    } else {
+        for (auto _ : state) {
+            sws_scale(sws, src->data, src->linesize, 0, height, dst->data, dst->linesize);
+            benchmark::ClobberMemory();
+        }
+        state.SetBytesProcessed(state.iterations() * int64_t(width) * height * 4);
+    }
+
+    sws_freeContext(sws);
+    av_frame_free(&src);
+    av_frame_free(&dst);
+}
+BENCHMARK(BM_ConvertToRGBA)
+    ->ArgNames({"w", "h", "fmt"})
+    ->Args({640, 480, AV_PIX_FMT_PAL8})
+    ->Args({1280, 720, AV_PIX_FMT_YUV444P})
+    ->Args({1920, 1080, AV_PIX_FMT_YUV444P})
+    ->Args({1920, 1080, AV_PIX_FMT_RGB48LE})
+    ->Unit(benchmark::kMicrosecond);
+
+// 离屏OpenGL上下文，在main()中QGuiApplication创建后初始化
+struct GLEnvironment {
+    QOffscreenSurface surface;
+    QOpenGLContext context;
+    bool ok{false};
+};
+GLEnvironment *g_gl = nullptr;
+
+// YUV420P三个平面的纹理上传，与OpenGLFrameRenderer::updateYUVTextures相同
+// padded=1时行宽大于图像宽度，走GL_UNPACK_ROW_LENGTH路径
+void BM_TextureUpload_YUV420P(benchmark::State &state) {
+    if (!g_gl || !g_gl->ok) {
+        state.SkipWithError("没有可用的OpenGL上下文");
+        return;
+    }
+
+    const int width = int(state.range(0));
+    const int height = int(state.range(1));
+    const bool padded = state.range(2) != 0;
+
+    AVFrame *frame = allocVideoFrame(width + (padded ? 32 : 0), height, AV_PIX_FMT_YUV420P, 1);
+    if (!frame) {
+        state.SkipWithError("无法分配视频帧");
+        return;
+    }
+    frame->width = width;
+
+    g_gl->context.makeCurrent(&g_gl->surface);
+    QOpenGLFunctions *gl = g_gl->context.functions();
+
+    GLuint textures[3];
+    gl->glGenTextures(3, textures);
+    gl->glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    const int chromaWidth = (width + 1) / 2;
+    const int chromaHeight = (height + 1) / 2;
+    const int widths[3] = {width, chromaWidth, chromaWidth};
+    const int heights[3] = {height, chromaHeight, chromaHeight};
+
+    for (auto _ : state) {
+        for (int plane = 0; plane < 3; ++plane) {
+            gl->glBindTexture(GL_TEXTURE_2D, textures[plane]);
+            if (frame->linesize[plane] != widths[plane]) {
+                gl->glPixelStorei(GL_UNPACK_ROW_LENGTH, frame->linesize[plane]);
+            }
+            gl->glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, widths[plane], heights[plane], 0, GL_RED,
+                             GL_UNSIGNED_BYTE, frame->data[plane]);
+            gl->glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+        }
+        // 等待驱动完成拷贝，否则只测到了命令提交
+        gl->glFinish();
+    }
+
+    gl->glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    gl->glBindTexture(GL_TEXTURE_2D, 0);
+    gl->glDeleteTextures(3, textures);
+    g_gl->context.doneCurrent();
+    av_frame_free(&frame);
+
+    state.SetBytesProcessed(state.iterations() * int64_t(width) * height * 3 / 2);
+}
+BENCHMARK(BM_TextureUpload_YUV420P)
+    ->ArgNames({"w", "h", "padded"})
+    ->ArgsProduct({{640}, {480}, {0, 1}})
+    ->ArgsProduct({{1280}, {720}, {0, 1}})
+    ->ArgsProduct({{1920}, {1080}, {0, 1}})
+    ->ArgsProduct({{3840}, {2160}, {0, 1}})
+    ->Unit(benchmark::kMicrosecond)
+    ->UseRealTime();
+
+}  // namespace
+
+int main(int argc, char **argv) {
+#ifdef Q_OS_LINUX
+    // 无显示器的CI/服务器上使用offscreen平台
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM") && !qEnvironmentVariableIsSet("DISPLAY") &&
+        !qEnvironmentVariableIsSet("WAYLAND_DISPLAY")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+#endif
+    QGuiApplication app(argc, argv);
+
+    GLEnvironment gl;
+    gl.surface.create();
+    gl.ok = gl.context.create() && gl.context.makeCurrent(&gl.surface);
+    if (gl.ok) {
+        gl.context.doneCurrent();
+    }
+    g_gl = &gl;
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
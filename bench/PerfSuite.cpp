@@ -0,0 +1,649 @@
+// 基于合成素材的性能测试套件
+// 在临时目录中按不同编码参数生成测试文件，测量FFmpegMediaDetector探测耗时、
+// FFmpegStream打开/首帧/跳转延迟、解码吞吐量以及音视频同步误差，结果以JSON输出。
+// adaptive_hls一项生成三档HLS码率阶梯，经本机HTTP服务器按自适应流播放
+//
+// 用法: PerfSuite [--duration 秒] [--filter 名称] [--keep] [--output result.json]
+
+#include "LocalHttpServer.h"
+#include "SyntheticMedia.h"
+#include "media/AdaptiveSession.h"
+#include "media/AudioResampler.h"
+#include "media/FFmpegMediaDetector.h"
+#include "media/FFmpegStream.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QThread>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+extern "C" {
+#include <libavutil/pixdesc.h>
+}
+
+namespace {
+
+constexpr int FRAME_TIMEOUT_MS = 5000;
+// 自适应流按该倍速消费帧：不限速时缓冲始终为空，码率控制不会升档
+constexpr double ADAPTIVE_SPEED = 4.0;
+
+double elapsedMs(const QElapsedTimer &timer) { return timer.nsecsElapsed() / 1e6; }
+
+QJsonObject summarize(std::vector<double> values) {
+    if (values.empty()) return QJsonObject{{"count", 0}};
+    std::sort(values.begin(), values.end());
+    double sum = 0.0;
+    for (double value : values) sum += value;
+    return QJsonObject{
+        {"count", int(values.size())},
+        {"avg", sum / values.size()},
+        {"median", values[values.size() / 2]},
+        {"max", values.back()},
+    };
+}
+
+// 读取一个样本，返回[-1, 1]
+double readSample(const AVFrame *frame, int channel, int index) {
+    AVSampleFormat format = AVSampleFormat(frame->format);
+    bool planar = av_sample_fmt_is_planar(format);
+    const uint8_t *data = planar ? frame->extended_data[channel] : frame->extended_data[0];
+    int offset = planar ? index : index * AudioResampler::channelCount(frame) + channel;
+
+    switch (av_get_packed_sample_fmt(format)) {
+    case AV_SAMPLE_FMT_U8: return (data[offset] - 128) / 128.0;
+    case AV_SAMPLE_FMT_S16: return reinterpret_cast<const int16_t *>(data)[offset] / 32768.0;
+    case AV_SAMPLE_FMT_S32:
+        return reinterpret_cast<const int32_t *>(data)[offset] / 2147483648.0;
+    case AV_SAMPLE_FMT_FLT: return reinterpret_cast<const float *>(data)[offset];
+    case AV_SAMPLE_FMT_DBL: return reinterpret_cast<const double *>(data)[offset];
+    default: return 0.0;
+    }
+}
+
+// 画面闪白检测：抽样计算亮度平面均值
+bool isFlashFrame(const AVFrame *frame) {
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(AVPixelFormat(frame->format));
+    if (!desc || (desc->flags & AV_PIX_FMT_FLAG_RGB) || frame->width <= 0) return false;
+
+    int64_t sum = 0;
+    int64_t count = 0;
+    for (int y = 0; y < frame->height; y += 8) {
+        const uint8_t *row = frame->data[0] + y * frame->linesize[0];
+        for (int x = 0; x < frame->width; x += 8) {
+            sum += row[x];
+            ++count;
+        }
+    }
+    return count > 0 && sum / count > 200;
+}
+
+// 等待下一帧视频，超时返回nullptr
+AVFrame *waitVideoFrame(FFmpegStream &stream, double *pts) {
+    QElapsedTimer timer;
+    timer.start();
+    while (timer.elapsed() < FRAME_TIMEOUT_MS) {
+        if (AVFrame *frame = stream.getNextVideoFrame(pts)) return frame;
+        if (stream.atEnd()) break;
+        QThread::usleep(200);
+        QCoreApplication::processEvents();
+    }
+    return nullptr;
+}
+
+// 三档HLS码率阶梯：各档GOP相同，分片边界对齐；主清单按码率从低到高列出各档
+bool writeHlsLadder(const QString &dir, double duration, QString *error) {
+    struct Rung {
+        int width;
+        int height;
+        int64_t bitrate;
+    };
+    const Rung ladder[] = {{426, 240, 400000}, {640, 360, 1000000}, {1280, 720, 2500000}};
+
+    QString master;
+    QTextStream out(&master);
+    out << "#EXTM3U\n#EXT-X-VERSION:3\n";
+    for (int i = 0; i < int(std::size(ladder)); ++i) {
+        SyntheticMediaSpec spec;
+        spec.container = "m3u8";
+        spec.duration = duration;
+        spec.width = ladder[i].width;
+        spec.height = ladder[i].height;
+        spec.gopSize = 2 * spec.fps;  // 2秒分片
+        spec.videoBitrate = ladder[i].bitrate;
+
+        const QString name = QString("r%1").arg(i);
+        if (!QDir().mkpath(QDir(dir).filePath(name)) ||
+            !SyntheticMedia::generate(spec, QDir(dir).filePath(name + "/index.m3u8"), error)) {
+            return false;
+        }
+        out << "#EXT-X-STREAM-INF:BANDWIDTH=" << spec.videoBitrate + spec.audioBitrate
+            << ",RESOLUTION=" << spec.width << 'x' << spec.height << '\n'
+            << name << "/index.m3u8\n";
+    }
+    out.flush();
+
+    QFile file(QDir(dir).filePath("master.m3u8"));
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) ||
+        file.write(master.toUtf8()) < 0) {
+        if (error) *error = "无法写入主清单";
+        return false;
+    }
+    return true;
+}
+
+// 与VideoWidget::openAdaptiveRun相同：一段run由一个FFmpegStream解封装
+std::unique_ptr<FFmpegStream> openRun(const std::shared_ptr<AdaptiveSession> &session,
+                                      int rendition, int segment) {
+    auto stream = std::make_unique<FFmpegStream>();
+    if (!stream->open(session->runName(rendition, segment),
+                      session->createIO(rendition, segment))) {
+        return nullptr;
+    }
+    stream->start();
+    return stream;
+}
+
+class PerfSuite {
+public:
+    explicit PerfSuite(const QString &workDir) : m_workDir(workDir) {}
+
+    QJsonObject run(const SyntheticMediaSpec &spec);
+    QJsonObject runAdaptive(double duration);
+
+private:
+    QJsonObject measureDetector(const QString &filePath, const SyntheticMediaSpec &spec);
+    QJsonObject measureOpen(const QString &filePath, const SyntheticMediaSpec &spec);
+    QJsonObject measureSeek(const QString &filePath, const SyntheticMediaSpec &spec);
+    QJsonObject measureThroughput(const QString &filePath, const SyntheticMediaSpec &spec);
+    QJsonObject measureAdaptivePlayback(const std::shared_ptr<AdaptiveSession> &session);
+    QJsonObject measureAdaptiveSeek(const std::shared_ptr<AdaptiveSession> &session);
+
+    QString m_workDir;
+};
+
+QJsonObject PerfSuite::run(const SyntheticMediaSpec &spec) {
+    QString filePath = QDir(m_workDir).filePath(spec.name() + "." + spec.container);
+    QJsonObject result{{"name", spec.name()}, {"container", spec.container}};
+
+    QElapsedTimer timer;
+    timer.start();
+    QString error;
+    if (!SyntheticMedia::generate(spec, filePath, &error)) {
+        result["error"] = QString("生成素材失败: %1").arg(error);
+        return result;
+    }
+    result["generate_ms"] = elapsedMs(timer);
+    result["file_size"] = QFileInfo(filePath).size();
+
+    result["detector"] = measureDetector(filePath, spec);
+    result["open"] = measureOpen(filePath, spec);
+    if (!result["open"].toObject().contains("error")) {
+        if (spec.videoCodec != AV_CODEC_ID_NONE) {
+            result["seek"] = measureSeek(filePath, spec);
+        }
+        result["throughput"] = measureThroughput(filePath, spec);
+    }
+    return result;
+}
+
+QJsonObject PerfSuite::measureDetector(const QString &filePath, const SyntheticMediaSpec &spec) {
+    QElapsedTimer timer;
+    timer.start();
+    MediaType type = FFmpegMediaDetector::detectMediaType(filePath);
+    double ms = elapsedMs(timer);
+
+    MediaType expected = spec.videoCodec != AV_CODEC_ID_NONE ? Video : Audio;
+    return QJsonObject{
+        {"ms", ms},
+        {"type", FFmpegMediaDetector::mediaTypeToString(type)},
+        {"correct", type == expected},
+    };
+}
+
+QJsonObject PerfSuite::measureOpen(const QString &filePath, const SyntheticMediaSpec &spec) {
+    FFmpegStream stream;
+
+    QElapsedTimer timer;
+    timer.start();
+    if (!stream.open(filePath)) {
+        return QJsonObject{{"error", "无法打开文件"}, {"ms", elapsedMs(timer)}};
+    }
+    double openMs = elapsedMs(timer);
+    stream.start();
+
+    // 首帧延迟：从开始打开到拿到第一帧
+    double pts = 0.0;
+    AVFrame *frame = nullptr;
+    if (spec.videoCodec != AV_CODEC_ID_NONE) {
+        frame = waitVideoFrame(stream, &pts);
+    } else {
+        while (!frame && timer.elapsed() < FRAME_TIMEOUT_MS && !stream.atEnd()) {
+            frame = stream.getNextAudioFrame(&pts);
+            if (!frame) QThread::usleep(200);
+        }
+    }
+    double firstFrameMs = elapsedMs(timer);
+    bool gotFrame = frame != nullptr;
+    if (frame) av_frame_free(&frame);
+
+    QJsonObject result{{"open_ms", openMs}, {"first_frame_ms", firstFrameMs}};
+    if (!gotFrame) result["error"] = "未能解码出第一帧";
+    return result;
+}
+
+QJsonObject PerfSuite::measureSeek(const QString &filePath, const SyntheticMediaSpec &spec) {
+    FFmpegStream stream;
+    if (!stream.loadVideo(filePath)) return QJsonObject{{"error", "无法打开文件"}};
+
+    // 往返跳转，避免目标附近的帧恰好已在队列中
+    const double fractions[] = {0.8, 0.2, 0.6, 0.4, 0.9, 0.1};
+    double gopSeconds = double(spec.gopSize) / spec.fps;
+    double frameSeconds = 1.0 / spec.fps;
+
+    std::vector<double> latencies;
+    std::vector<double> errors;
+    int failures = 0;
+    for (double fraction : fractions) {
+        double target = spec.duration * fraction;
+
+        QElapsedTimer timer;
+        timer.start();
+        stream.seek(target);
+
+        // 向后跳转落在目标前的关键帧上，丢弃跳转前残留在队列中的帧
+        bool found = false;
+        while (timer.elapsed() < FRAME_TIMEOUT_MS) {
+            double pts = 0.0;
+            AVFrame *frame = waitVideoFrame(stream, &pts);
+            if (!frame) break;
+            av_frame_free(&frame);
+            if (pts >= target - gopSeconds - frameSeconds && pts <= target + 0.5) {
+                latencies.push_back(elapsedMs(timer));
+                errors.push_back(std::abs(pts - target) * 1000.0);
+                found = true;
+                break;
+            }
+        }
+        if (!found) ++failures;
+    }
+
+    return QJsonObject{
+        {"latency_ms", summarize(latencies)},
+        {"position_error_ms", summarize(errors)},
+        {"failures", failures},
+    };
+}
+
+QJsonObject PerfSuite::measureThroughput(const QString &filePath,
+                                         const SyntheticMediaSpec &spec) {
+    FFmpegStream stream;
+    if (!stream.loadVideo(filePath)) return QJsonObject{{"error", "无法打开文件"}};
+    stream.play();
+
+    std::vector<double> videoMarks;
+    std::vector<double> audioMarks;
+    double lastBeep = -1e9;
+    qint64 videoFrames = 0;
+    qint64 audioFrames = 0;
+
+    QElapsedTimer timer;
+    timer.start();
+    while (!stream.atEnd() && timer.elapsed() < FRAME_TIMEOUT_MS * 20) {
+        bool progressed = false;
+
+        if (stream.getVideoFramesInCache() > 0) {
+            double pts = 0.0;
+            if (AVFrame *frame = stream.getNextVideoFrame(&pts)) {
+                if (isFlashFrame(frame)) videoMarks.push_back(pts);
+                av_frame_free(&frame);
+                ++videoFrames;
+                progressed = true;
+            }
+        }
+
+        if (stream.getAudioFramesInCache() > 0) {
+            double pts = 0.0;
+            if (AVFrame *frame = stream.getNextAudioFrame(&pts)) {
+                // 蜂鸣起点：高电平样本，且距上一次蜂鸣足够远
+                for (int i = 0; i < frame->nb_samples; ++i) {
+                    double time = pts + double(i) / frame->sample_rate;
+                    if (time - lastBeep > 0.2 && std::abs(readSample(frame, 0, i)) > 0.4) {
+                        audioMarks.push_back(time);
+                        lastBeep = time;
+                    }
+                }
+                av_frame_free(&frame);
+                ++audioFrames;
+                progressed = true;
+            }
+        }
+
+        if (!progressed) QThread::usleep(200);
+        QCoreApplication::processEvents();
+    }
+    double seconds = timer.nsecsElapsed() / 1e9;
+
+    QJsonObject result{
+        {"seconds", seconds},
+        {"video_frames", videoFrames},
+        {"audio_frames", audioFrames},
+        {"fps", seconds > 0 ? videoFrames / seconds : 0.0},
+        {"speed", seconds > 0 ? spec.duration / seconds : 0.0},
+        {"completed", stream.atEnd()},
+    };
+
+    // 音视频同步：每个闪白帧与最近的蜂鸣配对
+    if (!videoMarks.empty() && !audioMarks.empty()) {
+        std::vector<double> offsets;
+        for (double videoMark : videoMarks) {
+            auto nearest = std::min_element(
+                audioMarks.begin(), audioMarks.end(), [videoMark](double a, double b) {
+                    return std::abs(a - videoMark) < std::abs(b - videoMark);
+                });
+            double offset = *nearest - videoMark;
+            if (std::abs(offset) < spec.syncMarkInterval / 2) offsets.push_back(offset * 1000.0);
+        }
+
+        double mean = 0.0;
+        double maxAbs = 0.0;
+        for (double offset : offsets) {
+            mean += offset;
+            maxAbs = std::max(maxAbs, std::abs(offset));
+        }
+        if (!offsets.empty()) mean /= offsets.size();
+
+        result["av_sync"] = QJsonObject{
+            {"marks", int(offsets.size())},
+            {"mean_offset_ms", mean},
+            {"max_abs_offset_ms", maxAbs},
+            {"expected_offset_ms", spec.audioOffset * 1000.0},
+            {"error_ms", mean - spec.audioOffset * 1000.0},
+        };
+    }
+    return result;
+}
+
+QJsonObject PerfSuite::runAdaptive(double duration) {
+    const QString dir = QDir(m_workDir).filePath("adaptive_hls");
+    QJsonObject result{{"name", "adaptive_hls"}, {"container", "m3u8"}};
+
+    // 升档需要20秒以上的缓冲，时长太短时只会停留在最低档
+    duration = std::max(duration, 40.0);
+    QElapsedTimer timer;
+    timer.start();
+    QString error;
+    if (!writeHlsLadder(dir, duration, &error)) {
+        result["error"] = QString("生成码率阶梯失败: %1").arg(error);
+        return result;
+    }
+    result["generate_ms"] = elapsedMs(timer);
+
+    LocalHttpServer server;
+    if (!server.start(dir, 18080, &error)) {
+        result["error"] = error;
+        return result;
+    }
+
+    // 清单解析：主清单和各档位的媒体清单
+    timer.restart();
+    std::shared_ptr<AdaptiveSession> session =
+        AdaptiveSession::open(server.url("master.m3u8"), &error);
+    if (!session) {
+        result["error"] = QString("打开清单失败: %1").arg(error);
+        return result;
+    }
+    result["manifest_ms"] = elapsedMs(timer);
+    result["renditions"] = int(session->manifest().renditions.size());
+    result["segments"] = session->segmentCount();
+
+    result["playback"] = measureAdaptivePlayback(session);
+    result["seek"] = measureAdaptiveSeek(session);
+    result["http"] = QJsonObject{
+        {"requests", qint64(server.requests())},
+        {"bytes", qint64(server.bytesSent())},
+    };
+    return result;
+}
+
+QJsonObject PerfSuite::measureAdaptivePlayback(const std::shared_ptr<AdaptiveSession> &session) {
+    QElapsedTimer timer;
+    timer.start();
+    int rendition = session->restartAt(0);
+    int segment = 0;
+    std::unique_ptr<FFmpegStream> stream = openRun(session, rendition, segment);
+    if (!stream) return QJsonObject{{"error", "无法打开第一段run"}};
+
+    // 与VideoWidget相同：码率控制为后续分片选定其他档位时提前打开下一段run，
+    // 当前run读完后切换；切换间隙为切换时刻到下一段run第一帧的时间
+    std::unique_ptr<FFmpegStream> next;
+    int nextRendition = 0;
+    int nextSegment = 0;
+    QJsonArray runs{QJsonObject{{"rendition", rendition}, {"segment", segment}}};
+    std::vector<double> gaps;
+    QElapsedTimer gapTimer;
+    bool inGap = false;
+    double firstFrameMs = -1.0;
+    double firstPts = 0.0;
+    qint64 videoFrames = 0;
+
+    const double limitMs = session->duration() * 1000.0 / ADAPTIVE_SPEED + FRAME_TIMEOUT_MS * 4;
+    while (elapsedMs(timer) < limitMs) {
+        if (!next && session->findSwitch(rendition, segment, &nextRendition, &nextSegment)) {
+            next = openRun(session, nextRendition, nextSegment);
+            if (!next) return QJsonObject{{"error", "无法打开下一段run"}};
+        }
+
+        bool progressed = false;
+        double pts = 0.0;
+        if (AVFrame *frame = stream->getNextVideoFrame(&pts)) {
+            av_frame_free(&frame);
+            ++videoFrames;
+            progressed = true;
+            if (firstFrameMs < 0) {
+                firstFrameMs = elapsedMs(timer);
+                firstPts = pts;
+            }
+            const double aheadMs =
+                firstFrameMs + (pts - firstPts) * 1000.0 / ADAPTIVE_SPEED - elapsedMs(timer);
+            if (aheadMs > 0) QThread::usleep(unsigned(aheadMs * 1000));
+            if (inGap) {
+                gaps.push_back(elapsedMs(gapTimer));
+                inGap = false;
+            }
+        }
+        if (AVFrame *frame = stream->getNextAudioFrame(&pts)) {
+            av_frame_free(&frame);
+            progressed = true;
+        }
+
+        if (stream->atEnd()) {
+            if (!next) break;
+            stream = std::move(next);
+            rendition = nextRendition;
+            segment = nextSegment;
+            runs.append(QJsonObject{{"rendition", rendition}, {"segment", segment}});
+            gapTimer.start();
+            inGap = true;
+            continue;
+        }
+        if (!progressed) QThread::usleep(200);
+    }
+
+    AdaptiveSession::Stats stats = session->stats();
+    return QJsonObject{
+        {"seconds", timer.nsecsElapsed() / 1e9},
+        {"first_frame_ms", firstFrameMs},
+        {"video_frames", videoFrames},
+        {"runs", runs},
+        {"switches", stats.switches},
+        {"switch_gap_ms", summarize(gaps)},
+        {"throughput_bps", stats.throughputBps},
+        {"completed", stream->atEnd() && !next},
+    };
+}
+
+QJsonObject PerfSuite::measureAdaptiveSeek(const std::shared_ptr<AdaptiveSession> &session) {
+    // 与VideoWidget::openSeekRun相同：丢弃已下载的分片，从目标分片重新下载并打开新的run；
+    // 旧的run在新run出帧后才释放
+    const double fractions[] = {0.75, 0.25, 0.5};
+    std::unique_ptr<FFmpegStream> current;
+    std::vector<double> latencies;
+    int failures = 0;
+    for (double fraction : fractions) {
+        QElapsedTimer timer;
+        timer.start();
+        const int segment = session->segmentAt(session->duration() * fraction);
+        const int rendition = session->restartAt(segment);
+        std::unique_ptr<FFmpegStream> stream = openRun(session, rendition, segment);
+
+        double pts = 0.0;
+        AVFrame *frame = stream ? waitVideoFrame(*stream, &pts) : nullptr;
+        if (!frame) {
+            ++failures;
+            continue;
+        }
+        av_frame_free(&frame);
+        latencies.push_back(elapsedMs(timer));
+        current = std::move(stream);
+    }
+
+    return QJsonObject{
+        {"latency_ms", summarize(latencies)},
+        {"failures", failures},
+    };
+}
+
+// 默认测试矩阵：分辨率/GOP/声道/封装/索引损坏
+std::vector<SyntheticMediaSpec> defaultSpecs(double duration) {
+    std::vector<SyntheticMediaSpec> specs;
+    SyntheticMediaSpec base;
+    base.duration = duration;
+
+    specs.push_back(base);
+
+    SyntheticMediaSpec longGop = base;
+    longGop.container = "mkv";
+    longGop.width = 1280;
+    longGop.height = 720;
+    longGop.gopSize = 250;
+    longGop.videoBitrate = 4000000;
+    specs.push_back(longGop);
+
+    SyntheticMediaSpec fullHd = base;
+    fullHd.width = 1920;
+    fullHd.height = 1080;
+    fullHd.gopSize = 12;
+    fullHd.videoBitrate = 8000000;
+    specs.push_back(fullHd);
+
+    SyntheticMediaSpec surround = base;
+    surround.container = "mkv";
+    surround.channels = 6;
+    surround.audioBitrate = 384000;
+    specs.push_back(surround);
+
+    SyntheticMediaSpec offset = base;
+    offset.audioOffset = 0.1;
+    specs.push_back(offset);
+
+    SyntheticMediaSpec videoOnly = base;
+    videoOnly.audioCodec = AV_CODEC_ID_NONE;
+    specs.push_back(videoOnly);
+
+    SyntheticMediaSpec audioOnly = base;
+    audioOnly.container = "mkv";
+    audioOnly.videoCodec = AV_CODEC_ID_NONE;
+    specs.push_back(audioOnly);
+
+    for (const char *container : {"mkv", "mp4"}) {
+        SyntheticMediaSpec noIndex = base;
+        noIndex.container = container;
+        noIndex.indexDamage = SyntheticMediaSpec::IndexDamage::NoIndex;
+        specs.push_back(noIndex);
+
+        SyntheticMediaSpec truncated = base;
+        truncated.container = container;
+        truncated.indexDamage = SyntheticMediaSpec::IndexDamage::Truncated;
+        specs.push_back(truncated);
+    }
+    return specs;
+}
+
+void quietMessageHandler(QtMsgType type, const QMessageLogContext &, const QString &message) {
+    if (type != QtDebugMsg && type != QtInfoMsg) {
+        fprintf(stderr, "%s\n", qPrintable(message));
+    }
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("PerfSuite");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("基于合成素材的打开/跳转/解码/音视频同步性能测试");
+    parser.addHelpOption();
+    QCommandLineOption durationOption("duration", "每个素材的时长（秒）", "seconds", "5");
+    QCommandLineOption filterOption("filter", "只运行名称包含该字符串的素材", "text");
+    QCommandLineOption keepOption("keep", "保留生成的素材目录");
+    QCommandLineOption outputOption({"o", "output"}, "结果写入文件（默认标准输出）", "path");
+    QCommandLineOption verboseOption("verbose", "保留调试输出");
+    parser.addOptions({durationOption, filterOption, keepOption, outputOption, verboseOption});
+    parser.process(app);
+
+    if (!parser.isSet(verboseOption)) {
+        qInstallMessageHandler(quietMessageHandler);
+    }
+
+    QTemporaryDir workDir;
+    if (!workDir.isValid()) {
+        fprintf(stderr, "无法创建临时目录\n");
+        return 1;
+    }
+    workDir.setAutoRemove(!parser.isSet(keepOption));
+
+    PerfSuite suite(workDir.path());
+    QJsonArray results;
+    QString filter = parser.value(filterOption);
+    for (const SyntheticMediaSpec &spec : defaultSpecs(parser.value(durationOption).toDouble())) {
+        if (!filter.isEmpty() && !spec.name().contains(filter)) continue;
+        fprintf(stderr, "%s.%s\n", qPrintable(spec.name()), qPrintable(spec.container));
+        results.append(suite.run(spec));
+    }
+    if (filter.isEmpty() || QString("adaptive_hls").contains(filter)) {
+        fprintf(stderr, "adaptive_hls\n");
+        results.append(suite.runAdaptive(parser.value(durationOption).toDouble()));
+    }
+
+    QJsonObject report{
+        {"ffmpeg", QString::fromLatin1(av_version_info())},
+        {"work_dir", parser.isSet(keepOption) ? workDir.path() : QString()},
+        {"cases", results},
+    };
+
+    QByteArray json = QJsonDocument(report).toJson(QJsonDocument::Indented);
+    if (parser.isSet(outputOption)) {
+        QFile output(parser.value(outputOption));
+        if (!output.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            fprintf(stderr, "无法写入结果文件: %s\n", qPrintable(output.fileName()));
+            return 1;
+        }
+        output.write(json);
+    } else {
+        fwrite(json.constData(), 1, size_t(json.size()), stdout);
+    }
+    return 0;
+}
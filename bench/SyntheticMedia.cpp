@@ -0,0 +1,452 @@
+#include "SyntheticMedia.h"
+#include "media/AudioResampler.h"
+#include "media/LatencyController.h"
+#include <QFile>
+#include <QStringList>
+#include <cmath>
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavutil/channel_layout.h>
+#include <libavutil/imgutils.h>
+#include <libavutil/time.h>
+#include <libswscale/swscale.h>
+}
+
+namespace {
+
+constexpr double PI = 3.14159265358979323846;
+
+// 蜂鸣持续时间（秒）
+constexpr double BEEP_DURATION = 0.05;
+
+QString errorString(int errnum) {
+    char buffer[AV_ERROR_MAX_STRING_SIZE] = {0};
+    av_strerror(errnum, buffer, sizeof(buffer));
+    return QString::fromUtf8(buffer);
+}
+
+// 按任意采样格式写入一个样本
+void writeSample(AVFrame *frame, int channel, int index, double value) {
+    AVSampleFormat format = AVSampleFormat(frame->format);
+    bool planar = av_sample_fmt_is_planar(format);
+    uint8_t *data = planar ? frame->extended_data[channel] : frame->extended_data[0];
+    int offset = planar ? index : index * AudioResampler::channelCount(frame) + channel;
+
+    switch (av_get_packed_sample_fmt(format)) {
+    case AV_SAMPLE_FMT_U8: data[offset] = uint8_t(128 + value * 127); break;
+    case AV_SAMPLE_FMT_S16:
+        reinterpret_cast<int16_t *>(data)[offset] = int16_t(value * 32767);
+        break;
+    case AV_SAMPLE_FMT_S32:
+        reinterpret_cast<int32_t *>(data)[offset] = int32_t(value * 2147483647.0);
+        break;
+    case AV_SAMPLE_FMT_FLT: reinterpret_cast<float *>(data)[offset] = float(value); break;
+    case AV_SAMPLE_FMT_DBL: reinterpret_cast<double *>(data)[offset] = value; break;
+    default: break;
+    }
+}
+
+struct OutputStream {
+    AVStream *stream{nullptr};
+    AVCodecContext *codec{nullptr};
+    AVFrame *frame{nullptr};
+    AVFrame *sourceFrame{nullptr};  // YUV420P源画面，编码器像素格式不同时经sws转换
+    SwsContext *swsContext{nullptr};
+    int64_t nextPts{0};
+    int64_t endPts{0};
+
+    bool finished() const { return !codec || nextPts >= endPts; }
+
+    ~OutputStream() {
+        if (swsContext) sws_freeContext(swsContext);
+        if (sourceFrame) av_frame_free(&sourceFrame);
+        if (frame) av_frame_free(&frame);
+        if (codec) avcodec_free_context(&codec);
+    }
+};
+
+class SyntheticWriter {
+public:
+    explicit SyntheticWriter(const SyntheticMediaSpec &spec) : m_spec(spec) {}
+    ~SyntheticWriter();
+
+    bool write(const QString &filePath);
+    QString error() const { return m_error; }
+
+private:
+    bool fail(const QString &message, int errnum = 0);
+    bool addVideoStream();
+    bool addAudioStream();
+    bool openOutput(const QString &filePath);
+    bool writeVideoFrame();
+    bool writeAudioFrame();
+    void waitUntil(int64_t pts, AVRational timeBase) const;
+    bool encode(OutputStream &output, AVFrame *frame);
+    bool isSyncFrame(int64_t frameIndex) const;
+    void fillPicture(AVFrame *frame, int64_t frameIndex) const;
+    double sampleValue(int64_t sampleIndex) const;
+
+    const SyntheticMediaSpec &m_spec;
+    AVFormatContext *m_formatContext{nullptr};
+    AVPacket *m_packet{nullptr};
+    OutputStream m_video;
+    OutputStream m_audio;
+    QString m_error;
+    int64_t m_startTime{0};  // 实时输出的起始时刻（av_gettime_relative）
+};
+
+SyntheticWriter::~SyntheticWriter() {
+    // 编码器上下文由OutputStream释放，流由格式上下文释放
+    if (m_packet) av_packet_free(&m_packet);
+    if (m_formatContext) {
+        if (m_formatContext->pb && !(m_formatContext->oformat->flags & AVFMT_NOFILE)) {
+            avio_closep(&m_formatContext->pb);
+        }
+        avformat_free_context(m_formatContext);
+    }
+}
+
+bool SyntheticWriter::fail(const QString &message, int errnum) {
+    m_error = errnum ? QString("%1: %2").arg(message, errorString(errnum)) : message;
+    return false;
+}
+
+bool SyntheticWriter::write(const QString &filePath) {
+    QByteArray path = filePath.toUtf8();
+    QByteArray formatName = m_spec.container.toUtf8();
+    bool isUrl = filePath.contains("://");
+    avformat_alloc_output_context2(&m_formatContext, nullptr,
+                                   isUrl ? formatName.constData() : nullptr, path.constData());
+    if (!m_formatContext) {
+        return fail(QString("不支持的封装格式: %1").arg(m_spec.container));
+    }
+
+    m_packet = av_packet_alloc();
+    if (!m_packet) return fail("分配数据包失败");
+
+    if (m_spec.videoCodec != AV_CODEC_ID_NONE && !addVideoStream()) return false;
+    if (m_spec.audioCodec != AV_CODEC_ID_NONE && !addAudioStream()) return false;
+    if (!m_video.codec && !m_audio.codec) return fail("没有任何音视频流");
+
+    if (!openOutput(filePath)) return false;
+
+    // 按时间戳交错写入音视频帧
+    while (!m_video.finished() || !m_audio.finished()) {
+        bool videoFirst =
+            !m_video.finished() &&
+            (m_audio.finished() || av_compare_ts(m_video.nextPts, m_video.codec->time_base,
+                                                 m_audio.nextPts, m_audio.codec->time_base) <= 0);
+        if (m_spec.realtime) {
+            OutputStream &next = videoFirst ? m_video : m_audio;
+            waitUntil(next.nextPts, next.codec->time_base);
+        }
+        if (videoFirst ? !writeVideoFrame() : !writeAudioFrame()) return false;
+    }
+
+    // 取出编码器中缓存的数据包
+    if (m_video.codec && !encode(m_video, nullptr)) return false;
+    if (m_audio.codec && !encode(m_audio, nullptr)) return false;
+
+    int ret = av_write_trailer(m_formatContext);
+    if (ret < 0) return fail("写入文件尾失败", ret);
+    return true;
+}
+
+bool SyntheticWriter::addVideoStream() {
+    const AVCodec *codec = avcodec_find_encoder(m_spec.videoCodec);
+    if (!codec) {
+        return fail(QString("找不到视频编码器: %1").arg(avcodec_get_name(m_spec.videoCodec)));
+    }
+
+    m_video.stream = avformat_new_stream(m_formatContext, nullptr);
+    m_video.codec = avcodec_alloc_context3(codec);
+    if (!m_video.stream || !m_video.codec) return fail("创建视频流失败");
+
+    AVCodecContext *c = m_video.codec;
+    c->width = m_spec.width;
+    c->height = m_spec.height;
+    c->time_base = AVRational{1, m_spec.fps};
+    c->framerate = AVRational{m_spec.fps, 1};
+    c->gop_size = m_spec.gopSize;
+    c->bit_rate = m_spec.videoBitrate;
+
+    // 优先使用YUV420P，编码器不支持时取其首选格式
+    c->pix_fmt = codec->pix_fmts ? codec->pix_fmts[0] : AV_PIX_FMT_YUV420P;
+    for (const AVPixelFormat *format = codec->pix_fmts; format && *format != AV_PIX_FMT_NONE;
+         ++format) {
+        if (*format == AV_PIX_FMT_YUV420P) {
+            c->pix_fmt = AV_PIX_FMT_YUV420P;
+            break;
+        }
+    }
+
+    if (m_formatContext->oformat->flags & AVFMT_GLOBALHEADER) {
+        c->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+    }
+
+    int ret = avcodec_open2(c, codec, nullptr);
+    if (ret < 0) return fail("打开视频编码器失败", ret);
+
+    ret = avcodec_parameters_from_context(m_video.stream->codecpar, c);
+    if (ret < 0) return fail("复制视频编码参数失败", ret);
+    m_video.stream->time_base = c->time_base;
+    m_video.endPts = int64_t(std::ceil(m_spec.duration * m_spec.fps));
+
+    m_video.frame = av_frame_alloc();
+    if (!m_video.frame) return fail("分配视频帧失败");
+    m_video.frame->format = c->pix_fmt;
+    m_video.frame->width = c->width;
+    m_video.frame->height = c->height;
+    ret = av_frame_get_buffer(m_video.frame, 0);
+    if (ret < 0) return fail("分配视频帧缓冲失败", ret);
+
+    if (c->pix_fmt != AV_PIX_FMT_YUV420P) {
+        m_video.sourceFrame = av_frame_alloc();
+        if (!m_video.sourceFrame) return fail("分配视频帧失败");
+        m_video.sourceFrame->format = AV_PIX_FMT_YUV420P;
+        m_video.sourceFrame->width = c->width;
+        m_video.sourceFrame->height = c->height;
+        ret = av_frame_get_buffer(m_video.sourceFrame, 0);
+        if (ret < 0) return fail("分配视频帧缓冲失败", ret);
+
+        m_video.swsContext =
+            sws_getContext(c->width, c->height, AV_PIX_FMT_YUV420P, c->width, c->height,
+                           c->pix_fmt, SWS_BICUBIC, nullptr, nullptr, nullptr);
+        if (!m_video.swsContext) return fail("创建像素格式转换失败");
+    }
+    return true;
+}
+
+bool SyntheticWriter::addAudioStream() {
+    const AVCodec *codec = avcodec_find_encoder(m_spec.audioCodec);
+    if (!codec) {
+        return fail(QString("找不到音频编码器: %1").arg(avcodec_get_name(m_spec.audioCodec)));
+    }
+
+    m_audio.stream = avformat_new_stream(m_formatContext, nullptr);
+    m_audio.codec = avcodec_alloc_context3(codec);
+    if (!m_audio.stream || !m_audio.codec) return fail("创建音频流失败");
+
+    // FFmpeg 5.1起声道布局为AVChannelLayout，之前的版本设置channel_layout/channels
+    AVCodecContext *c = m_audio.codec;
+    c->sample_fmt = codec->sample_fmts ? codec->sample_fmts[0] : AV_SAMPLE_FMT_S16;
+    c->sample_rate = m_spec.sampleRate;
+#if LIBAVUTIL_VERSION_INT >= AV_VERSION_INT(57, 24, 100)
+    av_channel_layout_default(&c->ch_layout, m_spec.channels);
+#else
+    c->channels = m_spec.channels;
+    c->channel_layout = av_get_default_channel_layout(m_spec.channels);
+#endif
+    c->bit_rate = m_spec.audioBitrate;
+    c->time_base = AVRational{1, m_spec.sampleRate};
+
+    if (m_formatContext->oformat->flags & AVFMT_GLOBALHEADER) {
+        c->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+    }
+
+    int ret = avcodec_open2(c, codec, nullptr);
+    if (ret < 0) return fail("打开音频编码器失败", ret);
+
+    ret = avcodec_parameters_from_context(m_audio.stream->codecpar, c);
+    if (ret < 0) return fail("复制音频编码参数失败", ret);
+    m_audio.stream->time_base = c->time_base;
+    m_audio.endPts = int64_t(std::ceil(m_spec.duration * m_spec.sampleRate));
+
+    m_audio.frame = av_frame_alloc();
+    if (!m_audio.frame) return fail("分配音频帧失败");
+    m_audio.frame->format = c->sample_fmt;
+#if LIBAVUTIL_VERSION_INT >= AV_VERSION_INT(57, 24, 100)
+    ret = av_channel_layout_copy(&m_audio.frame->ch_layout, &c->ch_layout);
+    if (ret < 0) return fail("复制声道布局失败", ret);
+#else
+    m_audio.frame->channel_layout = c->channel_layout;
+    m_audio.frame->channels = c->channels;
+#endif
+    m_audio.frame->sample_rate = c->sample_rate;
+    m_audio.frame->nb_samples =
+        (codec->capabilities & AV_CODEC_CAP_VARIABLE_FRAME_SIZE) ? 1024 : c->frame_size;
+    ret = av_frame_get_buffer(m_audio.frame, 0);
+    if (ret < 0) return fail("分配音频帧缓冲失败", ret);
+    return true;
+}
+
+bool SyntheticWriter::openOutput(const QString &filePath) {
+    int ret = 0;
+    if (!(m_formatContext->oformat->flags & AVFMT_NOFILE)) {
+        ret = avio_open(&m_formatContext->pb, filePath.toUtf8().constData(), AVIO_FLAG_WRITE);
+        if (ret < 0) return fail("创建输出文件失败", ret);
+    }
+
+    AVDictionary *options = nullptr;
+    if (m_spec.indexDamage == SyntheticMediaSpec::IndexDamage::NoIndex) {
+        // 复用器按流式输出处理，不回写索引和时长
+        m_formatContext->pb->seekable = 0;
+        if (m_spec.container == "mp4" || m_spec.container == "mov") {
+            av_dict_set(&options, "movflags", "frag_keyframe+empty_moov", 0);
+        }
+    }
+
+    if (m_spec.container == "m3u8") {
+        // HLS点播：每个GOP一个分片，全部分片写入媒体清单；分片与清单在同一目录
+        const double gopSeconds = double(m_spec.gopSize) / m_spec.fps;
+        av_dict_set(&options, "hls_time", QByteArray::number(gopSeconds).constData(), 0);
+        av_dict_set(&options, "hls_list_size", "0", 0);
+        av_dict_set(&options, "hls_playlist_type", "vod", 0);
+    }
+
+    if (m_spec.realtime) {
+        // 所有时间戳整体偏移到当前墙上时钟，播放端据此计算端到端延迟
+        m_formatContext->output_ts_offset = LatencyController::senderClockOffset();
+        m_startTime = av_gettime_relative();
+    }
+
+    ret = avformat_write_header(m_formatContext, &options);
+    av_dict_free(&options);
+    if (ret < 0) return fail("写入文件头失败", ret);
+    return true;
+}
+
+void SyntheticWriter::waitUntil(int64_t pts, AVRational timeBase) const {
+    int64_t due = m_startTime + av_rescale_q(pts, timeBase, AVRational{1, 1000000});
+    int64_t wait = due - av_gettime_relative();
+    if (wait > 0) av_usleep(unsigned(wait));
+}
+
+bool SyntheticWriter::isSyncFrame(int64_t frameIndex) const {
+    int64_t interval = std::llround(m_spec.syncMarkInterval * m_spec.fps);
+    return interval > 0 && frameIndex % interval == 0;
+}
+
+void SyntheticWriter::fillPicture(AVFrame *frame, int64_t frameIndex) const {
+    bool flash = isSyncFrame(frameIndex);
+
+    // 亮度为斜向移动的渐变，同步帧整帧闪白
+    for (int y = 0; y < frame->height; ++y) {
+        uint8_t *row = frame->data[0] + y * frame->linesize[0];
+        for (int x = 0; x < frame->width; ++x) {
+            row[x] = flash ? 235 : uint8_t(16 + (x + y * 2 + frameIndex * 3) % 160);
+        }
+    }
+
+    // 色度缓慢变化
+    for (int y = 0; y < frame->height / 2; ++y) {
+        uint8_t *u = frame->data[1] + y * frame->linesize[1];
+        uint8_t *v = frame->data[2] + y * frame->linesize[2];
+        for (int x = 0; x < frame->width / 2; ++x) {
+            u[x] = flash ? 128 : uint8_t(128 + (y + frameIndex) % 64 - 32);
+            v[x] = flash ? 128 : uint8_t(128 + (x + frameIndex * 2) % 64 - 32);
+        }
+    }
+}
+
+bool SyntheticWriter::writeVideoFrame() {
+    AVFrame *frame = m_video.frame;
+    int ret = av_frame_make_writable(frame);
+    if (ret < 0) return fail("视频帧不可写", ret);
+
+    if (m_video.swsContext) {
+        ret = av_frame_make_writable(m_video.sourceFrame);
+        if (ret < 0) return fail("视频帧不可写", ret);
+        fillPicture(m_video.sourceFrame, m_video.nextPts);
+        sws_scale(m_video.swsContext, m_video.sourceFrame->data, m_video.sourceFrame->linesize,
+                  0, frame->height, frame->data, frame->linesize);
+    } else {
+        fillPicture(frame, m_video.nextPts);
+    }
+
+    frame->pts = m_video.nextPts++;
+    return encode(m_video, frame);
+}
+
+double SyntheticWriter::sampleValue(int64_t sampleIndex) const {
+    double t = double(sampleIndex) / m_spec.sampleRate;
+
+    // 蜂鸣与画面闪白对齐，audioOffset为人为偏移
+    double markTime = t - m_spec.audioOffset;
+    if (markTime >= 0 && m_spec.syncMarkInterval > 0 &&
+        std::fmod(markTime, m_spec.syncMarkInterval) < BEEP_DURATION) {
+        return 0.8 * std::sin(2 * PI * 1000.0 * t);
+    }
+    return 0.05 * std::sin(2 * PI * 220.0 * t);
+}
+
+bool SyntheticWriter::writeAudioFrame() {
+    AVFrame *frame = m_audio.frame;
+    int ret = av_frame_make_writable(frame);
+    if (ret < 0) return fail("音频帧不可写", ret);
+
+    const int channels = AudioResampler::channelCount(frame);
+    for (int i = 0; i < frame->nb_samples; ++i) {
+        double value = sampleValue(m_audio.nextPts + i);
+        for (int channel = 0; channel < channels; ++channel) {
+            writeSample(frame, channel, i, value);
+        }
+    }
+
+    frame->pts = m_audio.nextPts;
+    m_audio.nextPts += frame->nb_samples;
+    return encode(m_audio, frame);
+}
+
+bool SyntheticWriter::encode(OutputStream &output, AVFrame *frame) {
+    int ret = avcodec_send_frame(output.codec, frame);
+    if (ret < 0) return fail("发送帧到编码器失败", ret);
+
+    while (true) {
+        ret = avcodec_receive_packet(output.codec, m_packet);
+        if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) return true;
+        if (ret < 0) return fail("编码失败", ret);
+
+        av_packet_rescale_ts(m_packet, output.codec->time_base, output.stream->time_base);
+        m_packet->stream_index = output.stream->index;
+        ret = av_interleaved_write_frame(m_formatContext, m_packet);
+        if (ret < 0) return fail("写入数据包失败", ret);
+    }
+}
+
+}  // namespace
+
+QString SyntheticMediaSpec::name() const {
+    QStringList parts;
+    if (videoCodec != AV_CODEC_ID_NONE) {
+        parts << QString("%1_%2x%3_%4fps_gop%5")
+                     .arg(avcodec_get_name(videoCodec))
+                     .arg(width)
+                     .arg(height)
+                     .arg(fps)
+                     .arg(gopSize);
+    }
+    if (audioCodec != AV_CODEC_ID_NONE) {
+        parts << QString("%1_%2ch").arg(avcodec_get_name(audioCodec)).arg(channels);
+    }
+    if (audioOffset != 0.0) {
+        parts << QString("offset%1ms").arg(qRound(audioOffset * 1000));
+    }
+    switch (indexDamage) {
+    case IndexDamage::NoIndex: parts << "noindex"; break;
+    case IndexDamage::Truncated: parts << "truncated"; break;
+    default: break;
+    }
+    return parts.join('_');
+}
+
+bool SyntheticMedia::generate(const SyntheticMediaSpec &spec, const QString &filePath,
+                              QString *error) {
+    {
+        SyntheticWriter writer(spec);
+        if (!writer.write(filePath)) {
+            if (error) *error = writer.error();
+            return false;
+        }
+    }
+
+    if (spec.indexDamage == SyntheticMediaSpec::IndexDamage::Truncated) {
+        QFile file(filePath);
+        if (!file.resize(file.size() * 9 / 10)) {
+            if (error) *error = QString("截断文件失败: %1").arg(file.errorString());
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <QString>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+
+// 合成测试素材描述
+// 视频为运动渐变画面，音频为低电平正弦波；每隔syncMarkInterval秒画面闪白一帧、
+// 同时音频出现一段高电平蜂鸣，用于测量音视频同步误差
+struct SyntheticMediaSpec {
+    // 索引损坏方式
+    enum class IndexDamage {
+        None,
+        NoIndex,   // 按不可寻址输出写入：mkv没有Cues，mp4为无全局索引的分片格式
+        Truncated  // 写入后截掉文件尾部10%（mp4会丢失moov）
+    };
+
+    // 扩展名，决定封装格式（m3u8为按GOP分片的HLS点播）；输出为URL时作为封装格式名
+    QString container{"mp4"};
+    double duration{5.0};  // 秒
+
+    AVCodecID videoCodec{AV_CODEC_ID_MPEG4};  // AV_CODEC_ID_NONE表示无视频
+    int width{640};
+    int height{360};
+    int fps{25};
+    int gopSize{25};
+    int64_t videoBitrate{1000000};
+
+    AVCodecID audioCodec{AV_CODEC_ID_AAC};  // AV_CODEC_ID_NONE表示无音频
+    int sampleRate{48000};
+    int channels{2};
+    int64_t audioBitrate{128000};
+
+    double syncMarkInterval{1.0};  // 同步标记间隔（秒）
+    double audioOffset{0.0};       // 人为的音频偏移（秒），用于验证同步测量本身
+
+    IndexDamage indexDamage{IndexDamage::None};
+
+    // 按实时速度输出（直播推流），时间戳为推流时刻的墙上时钟（见LatencyController）
+    bool realtime{false};
+
+    // 用于文件名和测试报告的简短描述
+    QString name() const;
+};
+
+class SyntheticMedia {
+public:
+    // 按描述生成测试文件（或推流到URL），失败时返回false并写入错误信息
+    static bool generate(const SyntheticMediaSpec &spec, const QString &filePath,
+                         QString *error = nullptr);
+};
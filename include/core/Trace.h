@@ -0,0 +1,74 @@
+#pragma once
+
+#include <QString>
+#include <atomic>
+#include <cstdint>
+
+// 轻量级性能跟踪
+// 每个线程把事件写入自己的无锁环形缓冲区，按需导出为Chrome trace_event JSON
+// （chrome://tracing 或 https://ui.perfetto.dev 打开）。
+// 未启用时TRACE_SCOPE只有一次原子读；定义PLAYER_DISABLE_TRACE可在编译期完全去除。
+class Trace {
+public:
+    // 名称和分类必须是字符串字面量（只保存指针）
+    struct Event {
+        const char *name{nullptr};
+        const char *category{nullptr};
+        int64_t startNs{0};
+        int64_t durationNs{0};
+    };
+
+    static void setEnabled(bool enabled);
+    static bool isEnabled() { return s_enabled.load(std::memory_order_relaxed); }
+
+    // 进程内单调时钟（纳秒）
+    static int64_t now();
+
+    // 记录一个完整事件到当前线程的缓冲区
+    static void record(const char *name, const char *category, int64_t startNs,
+                       int64_t durationNs);
+
+    // 导出所有线程缓冲区中的事件
+    static bool writeChromeTrace(const QString &filePath);
+
+    // 丢弃已记录的事件
+    static void clear();
+
+private:
+    static std::atomic<bool> s_enabled;
+};
+
+// 作用域事件：构造时记录开始时间，析构时写入缓冲区
+class TraceScope {
+public:
+    TraceScope(const char *name, const char *category) {
+        if (Trace::isEnabled()) {
+            m_name = name;
+            m_category = category;
+            m_startNs = Trace::now();
+        }
+    }
+
+    ~TraceScope() {
+        if (m_name) {
+            Trace::record(m_name, m_category, m_startNs, Trace::now() - m_startNs);
+        }
+    }
+
+    TraceScope(const TraceScope &) = delete;
+    TraceScope &operator=(const TraceScope &) = delete;
+
+private:
+    const char *m_name{nullptr};
+    const char *m_category{nullptr};
+    int64_t m_startNs{0};
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+#ifdef PLAYER_DISABLE_TRACE
+#define TRACE_SCOPE(name, category)
+#else
+#define TRACE_SCOPE(name, category) TraceScope TRACE_CONCAT(traceScope_, __LINE__)(name, category)
+#endif
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+#include <atomic>
+#include <cstdint>
+
+// 分段流（HLS/DASH点播）中的一个分片
+struct AdaptiveSegment {
+    QString url;
+    double start{0.0};  // 在节目中的起始时间（秒）
+    double duration{0.0};
+    int64_t offset{0};   // 字节范围（EXT-X-BYTERANGE / mediaRange）
+    int64_t length{-1};  // -1表示整个资源
+};
+
+// 一个码率档位
+struct AdaptiveRendition {
+    QString id;
+    int64_t bandwidth{0};  // bit/s
+    int width{0};
+    int height{0};
+    QString codecs;
+
+    // fMP4的初始化分片，TS流为空
+    QString initUrl;
+    int64_t initOffset{0};
+    int64_t initLength{-1};
+
+    QVector<AdaptiveSegment> segments;
+};
+
+// 解析后的清单
+// 各档位的分片按相同的时间点切分（ABR码率阶梯的常规做法），切换只发生在分片边界。
+// 目前只支持点播：HLS需要EXT-X-ENDLIST，DASH只取第一个Period中的视频（或混合）AdaptationSet，
+// 独立的音频轨道和加密流不支持
+struct AdaptiveManifest {
+    enum class Type { Hls, Dash };
+
+    Type type{Type::Hls};
+    QString url;
+    double duration{0.0};
+    QVector<AdaptiveRendition> renditions;  // 按码率从低到高排列
+
+    int segmentCount() const { return renditions.isEmpty() ? 0 : renditions[0].segments.size(); }
+
+    // 按扩展名判断（.m3u8/.mpd，忽略查询参数）
+    static bool isManifestUrl(const QString &url);
+
+    // 读取并解析清单（HLS主清单会继续读取各档位的媒体清单）
+    static bool load(const QString &url, AdaptiveManifest *manifest, QString *error);
+
+    // 读取本地文件或URL（FFmpeg支持的任意协议），length为-1时读到末尾
+    static bool fetch(const QString &url, int64_t offset, int64_t length, QByteArray *data,
+                      const std::atomic<bool> *abort = nullptr);
+
+    // 相对地址按清单地址解析，本地路径返回本地路径
+    static QString resolveUrl(const QString &base, const QString &reference);
+};
@@ -0,0 +1,132 @@
+#pragma once
+
+#include "media/AdaptiveManifest.h"
+#include "media/MediaIO.h"
+#include <QHash>
+#include <QMutex>
+#include <QThreadPool>
+#include <QWaitCondition>
+#include <atomic>
+#include <map>
+#include <memory>
+
+// 自适应流播放会话（HLS/DASH点播）
+// 工作线程池按顺序下载播放位置之后的分片，每个分片在提交下载时由码率控制选定档位：
+// 缓冲不足时降到吞吐量能承受的档位，缓冲充足且吞吐量有余量时逐级升档。
+// 同一档位的连续分片组成一段"run"，由一个FFmpegStream（AdaptiveIO）解封装；
+// 档位变化处当前run结束（EOF），下一段run由VideoWidget提前在后台打开，按播放列表的方式无缝切换
+class AdaptiveSession : public std::enable_shared_from_this<AdaptiveSession> {
+public:
+    struct Stats {
+        int rendition{0};            // 最近选定的档位
+        int switches{0};             // 档位切换次数
+        double bufferSeconds{0.0};   // 已下载未读取的时长
+        double throughputBps{0.0};   // 下载吞吐量估计（bit/s）
+        int downloading{0};
+    };
+
+    ~AdaptiveSession();
+
+    static std::shared_ptr<AdaptiveSession> open(const QString &url, QString *error);
+
+    const AdaptiveManifest &manifest() const { return m_manifest; }
+    double duration() const { return m_manifest.duration; }
+    int segmentCount() const { return m_manifest.segmentCount(); }
+    int segmentAt(double seconds) const;
+
+    // 从firstSegment开始读取rendition档位的连续分片，遇到其他档位的分片时结束
+    std::unique_ptr<MediaIO> createIO(int rendition, int firstSegment);
+    QString runName(int rendition, int firstSegment) const;
+
+    // fromSegment之后第一个已选定为其他档位的分片（下一段run的起点）
+    bool findSwitch(int rendition, int fromSegment, int *nextRendition, int *segment) const;
+
+    // 跳转：丢弃已下载的分片，从segment重新下载，返回该位置使用的档位
+    int restartAt(int segment);
+
+    Stats stats() const;
+    void abort();
+
+private:
+    friend class AdaptiveIO;
+
+    enum class SegmentStatus { Ready, OtherRendition, Failed, Aborted };
+
+    struct Entry {
+        int rendition{0};
+        QByteArray data;
+        bool done{false};
+        bool failed{false};
+        int attempts{0};
+    };
+
+    AdaptiveSession() = default;
+
+    // 等待分片下载完成；分片属于其他档位时立即返回OtherRendition
+    SegmentStatus waitSegment(int index, int rendition, QByteArray *data,
+                              const std::atomic<bool> &aborted);
+    QByteArray initSegment(int rendition);
+    void setReaderPosition(const void *reader, int segment);
+    void removeReader(const void *reader);
+
+    // 以下方法需持有m_mutex
+    void pump();
+    int chooseRendition(double bufferSeconds);
+    double bufferedSeconds(bool completedOnly) const;
+    int firstNeededSegment() const;
+
+    void download(int index, int rendition, int epoch);
+
+    static constexpr double LOW_BUFFER_SECONDS = 8.0;    // 低于此值时降档
+    static constexpr double HIGH_BUFFER_SECONDS = 20.0;  // 高于此值时允许升档
+    static constexpr double MAX_BUFFER_SECONDS = 30.0;   // 最多提前下载的时长
+    static constexpr int MAX_PARALLEL_DOWNLOADS = 2;
+    static constexpr int MAX_ATTEMPTS = 3;
+
+    AdaptiveManifest m_manifest;
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_segmentReady;
+    std::map<int, Entry> m_segments;        // 已选定档位（下载中或已完成）的分片
+    std::map<const void *, int> m_readers;  // 各AdaptiveIO当前读取的分片
+    QHash<int, QByteArray> m_initSegments;
+    int m_nextDownload{0};
+    int m_downloading{0};
+    int m_rendition{0};
+    int m_lastSwitchSegment{0};
+    int m_switches{0};
+    double m_throughputBps{0.0};
+    int m_epoch{0};  // 跳转后使旧的下载结果失效
+
+    std::atomic<bool> m_aborted{false};
+    QThreadPool m_pool;
+};
+
+// 一段run的输入：可选的初始化分片 + 同一档位的连续分片
+class AdaptiveIO : public MediaIO {
+public:
+    AdaptiveIO(std::shared_ptr<AdaptiveSession> session, int rendition, int firstSegment);
+    ~AdaptiveIO() override;
+
+    int read(uint8_t *buffer, int size) override;
+    int64_t seek(int64_t offset) override;
+    int64_t position() const override { return m_position; }
+    int64_t size() const override { return -1; }
+    Stats stats() const override;
+    void abort() override { m_aborted = true; }
+
+private:
+    std::shared_ptr<AdaptiveSession> m_session;
+    const int m_rendition;
+    int m_nextSegment;
+    bool m_initRead{false};
+    QByteArray m_current;
+    int m_currentOffset{0};
+    int64_t m_position{0};
+
+    std::atomic<bool> m_aborted{false};
+    std::atomic<int64_t> m_bytesRead{0};
+    std::atomic<int64_t> m_waits{0};
+    std::atomic<int64_t> m_waitNs{0};
+    std::atomic<int64_t> m_maxWaitNs{0};
+};
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QMutex>
+#include <queue>
+
+// 解码线程写入、音频设备拉取的PCM缓冲区
+class AudioBuffer : public QIODevice {
+    Q_OBJECT
+
+public:
+    explicit AudioBuffer(QObject *parent = nullptr);
+
+    void writeData(const QByteArray &data);
+    void clear();
+    // 取出队首最多maxBytes字节尚未播放的数据（-1为全部），其余数据保留
+    QByteArray take(qint64 maxBytes = -1);
+    bool isEmpty() const;
+    qint64 bufferedBytes() const;
+
+protected:
+    qint64 readData(char *data, qint64 maxlen) override;
+    qint64 writeData(const char *data, qint64 len) override;
+
+private:
+    std::queue<QByteArray> m_bufferQueue;
+    mutable QMutex m_mutex;
+    QByteArray m_currentBuffer;
+    int m_currentPos;
+    qint64 m_bufferedBytes{0};
+};
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// 多声道下混为立体声（音频设备不支持原声道数时使用）
+// 输入为平面浮点（声道按FFmpeg声道掩码的位序排列），输出为交错的S16或float立体声。
+// 系数按ITU-R BS.775：中置和环绕衰减3dB后分别加到左右，LFE不参与下混；
+// 每一路按系数之和归一化，全部声道满幅时也不会削波
+class AudioDownmix {
+public:
+    explicit AudioDownmix(uint64_t layout);
+
+    int inputChannels() const { return int(m_left.size()); }
+
+    void process(const float *const *planes, int samples, int16_t *output) const;
+    void process(const float *const *planes, int samples, float *output) const;
+
+private:
+    std::vector<float> m_left;   // 每个输入声道到左声道的系数
+    std::vector<float> m_right;  // 每个输入声道到右声道的系数
+};
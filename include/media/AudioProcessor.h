@@ -0,0 +1,69 @@
+#pragma once
+
+#include <QByteArray>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+// 重采样之后的浮点处理级：音量、跳转时的交叉淡化、恢复播放时的渐入，
+// 最后加TPDF抖动转换为S16（音频设备格式）
+// 样本为交错的float，斜坡按样本而不是按帧推进，声道间的差异可以忽略
+class AudioProcessor {
+public:
+    AudioProcessor(int channels, int sampleRate);
+
+    // 音量（0~1），变化时在下一段数据内线性过渡，避免阶跃带来的咔嗒声
+    void setGain(float gain);
+    float gain() const { return m_volume; }
+
+    // 响度归一化增益（线性），与音量相乘，同样在下一段内过渡
+    void setNormalization(float gain);
+    float normalization() const { return m_normalization; }
+
+    // 下一段输出与tail（切换前尚未播放的S16数据，最多fadeBytes()字节）交叉淡化；
+    // tail为空时下一段从静音渐入
+    void crossfadeFrom(const QByteArray &tail);
+    int fadeBytes() const { return m_fadeSamples * int(sizeof(int16_t)); }
+
+    // 交错float → 增益、淡化 → 抖动后的交错S16
+    QByteArray process(const QByteArray &input);
+
+    // 已转换为S16的数据（暂停后缓冲区中剩余的部分）开头渐入
+    QByteArray fadeIn(const QByteArray &pcm);
+    // 已转换为S16的数据（暂停前设备即将播放的开头，最多fadeBytes()字节）整段渐出到静音
+    QByteArray fadeOut(const QByteArray &pcm);
+
+    void reset();
+
+    // SIMD内核：x86上CPU支持时用AVX2（运行时检测），否则SSE2；ARM上为NEON，其余为标量实现。
+    // 增益从start线性变化到end
+    static void applyGain(float *samples, int count, float start, float end);
+    // dst += src * gain，增益从start线性变化到end
+    static void mix(float *dst, const float *src, int count, float start, float end);
+    static void fromS16(const int16_t *input, int count, float *output);
+    // 加TPDF抖动（±1 LSB三角分布）后取整并饱和
+    void toS16(const float *input, int count, int16_t *output);
+
+    // AVX2内核默认在CPU支持时启用；关闭后使用SSE2内核（基准测试对比用）
+    static bool avx2Supported();
+    static bool avx2Enabled() { return s_avx2.load(std::memory_order_relaxed); }
+    static void setAvx2Enabled(bool enabled);
+
+private:
+    static constexpr int FADE_MS = 5;
+    static constexpr int DITHER_LANES = 8;
+
+    const int m_fadeSamples;   // 淡化长度（样本数，含全部声道）
+    float m_gain{1.0f};        // 已应用到输出的增益
+    float m_targetGain{1.0f};  // 音量 × 归一化增益
+    float m_volume{1.0f};
+    float m_normalization{1.0f};
+
+    std::vector<float> m_tail;  // 正在淡出的旧数据
+    size_t m_tailPos{0};
+    std::vector<float> m_work;  // 处理缓冲区，避免每段重新分配
+
+    uint32_t m_dither[DITHER_LANES];  // 每个SIMD通道的xorshift32状态
+
+    static std::atomic<bool> s_avx2;
+};
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "media/AudioDownmix.h"
+#include <QByteArray>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libswresample/swresample.h>
+}
+
+// 把解码输出的任意格式音频转换为交错的S16 PCM（音频设备格式），
+// 或交错的float（播放器的浮点处理级，见AudioProcessor）
+// 不依赖QAudioSink，可单独用于性能测试
+class AudioResampler {
+public:
+    AudioResampler() = default;
+    ~AudioResampler();
+
+    AudioResampler(const AudioResampler &) = delete;
+    AudioResampler &operator=(const AudioResampler &) = delete;
+
+    // 输出为S16或FLT（交错）。输出声道数与输入相同时保持原声道布局，不做声道混合；
+    // 多声道输出为立体声时由AudioDownmix下混，其余情况由swresample混合
+    bool open(int64_t inLayout, int inChannels, AVSampleFormat inFormat, int inSampleRate,
+              int outChannels, int outSampleRate, AVSampleFormat outFormat = AV_SAMPLE_FMT_S16);
+    bool open(AVCodecContext *codecContext, int outChannels, int outSampleRate,
+              AVSampleFormat outFormat = AV_SAMPLE_FMT_S16);
+    void close();
+    bool isOpen() const { return m_swrContext != nullptr; }
+
+    // 转换一帧，输入为nullptr时取出内部缓存的尾部样本
+    QByteArray convert(const uint8_t **input, int inputSamples);
+    QByteArray convert(const AVFrame *frame) {
+        return convert((const uint8_t **)frame->extended_data, frame->nb_samples);
+    }
+    QByteArray flush() { return convert(nullptr, 0); }
+
+    int outputChannels() const { return m_outChannels; }
+
+    // 解码器的声道布局（FFmpeg声道掩码，未标注时按声道数取默认布局）和声道数，
+    // FFmpeg 5.1起读取AVChannelLayout，之前的版本读取channel_layout/channels
+    static uint64_t channelLayout(const AVCodecContext *codecContext);
+    static int channelCount(const AVCodecContext *codecContext);
+    static int channelCount(const AVFrame *frame);
+    // 按声道数取默认声道掩码（非标准布局时为0）
+    static uint64_t defaultLayout(int channels);
+
+    // 播放速度微调（直播延迟控制），通过增减输出样本实现，音调随之略有变化；
+    // 只适合1.0附近的小幅调整
+    void setSpeed(double speed) { m_speed = speed; }
+    double speed() const { return m_speed; }
+
+private:
+    QByteArray convertDownmix(const uint8_t **input, int inputSamples, int outSamples);
+
+    SwrContext *m_swrContext{nullptr};
+    std::unique_ptr<AudioDownmix> m_downmix;  // 多声道下混为立体声时使用
+    std::vector<float> m_downmixBuffer;       // swresample输出的平面浮点样本
+    std::vector<float *> m_downmixPlanes;
+    int m_outChannels{0};
+    AVSampleFormat m_outFormat{AV_SAMPLE_FMT_S16};
+    int m_inSampleRate{0};
+    int m_outSampleRate{0};
+    double m_speed{1.0};
+    bool m_compensating{false};
+};
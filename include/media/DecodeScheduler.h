@@ -0,0 +1,114 @@
+#pragma once
+
+#include <QMutex>
+#include <QThread>
+#include <QWaitCondition>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+// 流水线任务（解封装/视频解码/音频解码/字幕解码）
+// 每次step()只处理一小段工作（一个数据包），不得阻塞，
+// 没有可做的工作时返回Idle，由调度器挂起直到被唤醒
+class PipelineTask {
+public:
+    enum class Stage { Demux, VideoDecode, AudioDecode, SubtitleDecode };
+    enum class StepResult {
+        Progress,  // 完成了一些工作，可立即再次调度
+        Idle,      // 输入为空或输出已满，等待唤醒
+        Finished   // 任务结束（文件末尾或出错）
+    };
+
+    explicit PipelineTask(Stage stage) : m_stage(stage) {}
+    virtual ~PipelineTask() = default;
+
+    virtual StepResult step() = 0;
+
+    Stage stage() const { return m_stage; }
+
+    // 前台流（当前标签页）的任务优先调度
+    void setForeground(bool foreground) { m_foreground = foreground; }
+    bool isForeground() const { return m_foreground; }
+
+    // 优先级：前台 > 后台；同一类中 音频 > 解封装 > 视频
+    int priority() const;
+
+    // 单步耗时统计，由调度器在每次step()后记录
+    struct StepStats {
+        uint64_t steps{0};      // 总执行次数
+        uint64_t idleSteps{0};  // 返回Idle的次数（输入为空或输出已满）
+        double totalMs{0.0};
+        double maxMs{0.0};
+    };
+    StepStats stepStats() const;
+
+private:
+    friend class DecodeScheduler;
+
+    void recordStep(std::chrono::nanoseconds elapsed, StepResult result);
+
+    enum class State { Detached, Queued, Running, Parked, Finished };
+
+    const Stage m_stage;
+    std::atomic<bool> m_foreground{true};
+
+    // 以下成员由调度器互斥锁保护
+    State m_state{State::Detached};
+    bool m_wakePending{false};
+    bool m_detachRequested{false};
+    uint64_t m_sequence{0};
+    std::chrono::steady_clock::time_point m_retryAt;
+
+    // 同一时刻只有一个工作线程执行该任务，统计只有一个写者
+    std::atomic<uint64_t> m_steps{0};
+    std::atomic<uint64_t> m_idleSteps{0};
+    std::atomic<int64_t> m_totalNs{0};
+    std::atomic<int64_t> m_maxNs{0};
+};
+
+// 进程级解码调度器
+// 固定数量（CPU核心数）的工作线程执行所有打开流的流水线任务，
+// 线程数不随打开文件数增长
+class DecodeScheduler {
+public:
+    static DecodeScheduler &instance();
+
+    // 加入调度
+    void attach(PipelineTask *task);
+
+    // 移出调度，如任务正在执行则等待本次step结束
+    void detach(PipelineTask *task);
+
+    // 任务的输入或输出状态发生变化（有新数据包/队列有空位）
+    void wake(PipelineTask *task);
+
+    int workerCount() const { return int(m_workers.size()); }
+
+private:
+    DecodeScheduler();
+    ~DecodeScheduler();
+
+    DecodeScheduler(const DecodeScheduler &) = delete;
+    DecodeScheduler &operator=(const DecodeScheduler &) = delete;
+
+    void workerLoop();
+    void enqueueLocked(PipelineTask *task);
+    void removeLocked(PipelineTask *task);
+    PipelineTask *takeNextLocked();
+    void promoteParkedLocked(std::chrono::steady_clock::time_point now);
+
+    std::vector<QThread *> m_workers;
+
+    QMutex m_mutex;
+    QWaitCondition m_workAvailable;
+    QWaitCondition m_taskIdle;
+
+    std::vector<PipelineTask *> m_ready;
+    std::vector<PipelineTask *> m_parked;
+    uint64_t m_nextSequence{0};
+    bool m_shutdown{false};
+
+    // 挂起任务的兜底重试间隔，防止遗漏唤醒导致任务饿死
+    static constexpr std::chrono::milliseconds PARK_RETRY{10};
+};
@@ -75,6 +75,10 @@ public:
     static bool isImageCodec(AVCodecID codecId);
     static bool isSubtitleCodec(AVCodecID codecId);
 
+    // 🎞️ 动图检测（GIF/APNG/WebP 且包含多帧）
+    static bool isAnimatedImageCodec(AVCodecID codecId);
+    static bool isAnimatedImage(const QString &filePath);
+
     // 🛠️ 工具方法
     static QString mediaTypeToString(MediaType type);
     static QString codecIdToString(AVCodecID codecId);
@@ -1,5 +1,9 @@
 #pragma once
 
+#include "media/DecodeScheduler.h"
+#include "media/MediaIO.h"
+#include "media/MediaQueue.h"
+#include <QElapsedTimer>
 #include <QMutex>
 #include <QQueue>
 #include <QString>
@@ -8,7 +12,9 @@
 #include <QWaitCondition>
 #include <atomic>
 #include <deque>
+#include <limits>
 #include <memory>
+#include <vector>
 
 extern "C" {
 #include <libavcodec/avcodec.h>
@@ -22,6 +28,7 @@ extern "C" {
 class DemuxThread;
 class VideoDecoder;
 class AudioDecoder;
+class SubtitleDecoder;
 class FrameCache;
 
 // 帧数据结构
@@ -64,8 +71,14 @@ struct FrameData {
 
 // 数据包结构
 struct PacketData {
+    // packet为空时是发给解码器的标记：循环结束（pts为下一遍的起点），
+    // 或倒放一段的开始（输出[pts, segmentEnd)的帧）/结束
+    enum class Marker { Loop, SegmentStart, SegmentEnd };
+
     AVPacket *packet{nullptr};
     double pts{0.0};
+    Marker marker{Marker::Loop};
+    double segmentEnd{0.0};
 
     PacketData() = default;
     PacketData(AVPacket *p, double time = 0.0) : packet(p), pts(time) {}
@@ -79,6 +92,8 @@ struct PacketData {
     PacketData(PacketData &&other) noexcept {
         packet = other.packet;
         pts = other.pts;
+        marker = other.marker;
+        segmentEnd = other.segmentEnd;
         other.packet = nullptr;
     }
 
@@ -87,6 +102,8 @@ struct PacketData {
             if (packet) av_packet_free(&packet);
             packet = other.packet;
             pts = other.pts;
+            marker = other.marker;
+            segmentEnd = other.segmentEnd;
             other.packet = nullptr;
         }
         return *this;
@@ -97,6 +114,64 @@ struct PacketData {
     PacketData &operator=(const PacketData &) = delete;
 };
 
+// 字幕事件，在[start, end)内显示。文本字幕已去除ASS样式标签；
+// 位图字幕转换为RGBA（非预乘），坐标以canvasWidth x canvasHeight的画布为准
+struct SubtitleData {
+    struct Bitmap {
+        int x{0};
+        int y{0};
+        int width{0};
+        int height{0};
+        QByteArray rgba;
+    };
+
+    double start{0.0};
+    double end{0.0};
+    QString text;
+    std::vector<Bitmap> bitmaps;
+    int canvasWidth{0};
+    int canvasHeight{0};
+};
+
+// 已解码的字幕事件：字幕解码任务写入，显示端查询（线程安全）。
+// 流水线重建（跳转、挂起恢复、A-B循环重放）后保留，重新解码到的同一事件不重复添加
+class SubtitleTrack {
+public:
+    void add(std::shared_ptr<SubtitleData> subtitle);
+    // 未给出结束时间的事件（位图字幕常见）在下一个事件开始时结束
+    void closeOpen(double pts);
+    std::shared_ptr<const SubtitleData> at(double pts) const;
+    void clear();
+
+private:
+    // 事件的end只在锁内读写，其余字段加入后不再修改
+    mutable QMutex m_mutex;
+    std::vector<std::shared_ptr<SubtitleData>> m_subtitles;  // 按开始时间排序
+    mutable double m_lastQueryPts{0.0};
+
+    static const int MAX_SUBTITLES = 64;
+};
+
+// 文件中的一条音频/视频/字幕流
+struct TrackInfo {
+    int streamIndex{-1};
+    QString language;  // 元数据中的语言代码（如chi、eng），未标注时为空
+    QString title;
+    QString codec;
+};
+
+// 解码流水线运行状态（用于性能测试）
+struct PipelineStats {
+    PipelineTask::StepStats demux;
+    PipelineTask::StepStats videoDecode;
+    PipelineTask::StepStats audioDecode;
+    int videoPackets{0};  // 数据包队列占用
+    int audioPackets{0};
+    int videoFrames{0};  // 帧队列占用
+    int audioFrames{0};
+    MediaIO::Stats io;
+};
+
 class FFmpegStream : public QObject {
     Q_OBJECT
 
@@ -106,6 +181,14 @@ public:
 
     bool loadVideo(const QString &filePath);
 
+    // loadVideo拆分为两步：open只探测并打开解码器，可在后台线程调用（用于预加载）；
+    // start需在对象所属线程调用，启动解码流水线
+    bool open(const QString &filePath);
+    // 从自定义输入打开（自适应流的分片），name用于格式探测和日志
+    bool open(const QString &name, std::unique_ptr<MediaIO> io);
+    void start();
+    QString filePath() const { return m_filePath; }
+
     AVFrame *getNextVideoFrame(double *pts = nullptr);
 
     AVFrame *getNextAudioFrame(double *pts = nullptr);
@@ -118,6 +201,7 @@ public:
     int getHeight() const { return m_height; }
     bool hasVideo() const { return m_hasVideo; }
     bool hasAudio() const { return m_hasAudio; }
+    bool hasSubtitles() const { return m_hasSubtitle; }
 
     AVCodecContext *getAudioCodecContext() const;
 
@@ -126,12 +210,100 @@ public:
     void stop();
     void seek(double seconds);
     bool isPlaying() const { return m_isPlaying; }
+    bool isLoaded() const { return m_isLoaded; }
+
+    // 所有帧均已解码并被取走
+    bool isVideoFinished() const;
+    bool isAudioFinished() const;
+    bool atEnd() const;
+
+    // 挂起：停止解码任务并释放队列，保留解码器和恢复点；
+    // 恢复：从恢复点之前的关键帧重新解码
+    void suspend();
+    void resume();
+    bool isSuspended() const { return m_isSuspended; }
+
+    // 前台流的解码任务在共享线程池中优先调度
+    void setForeground(bool foreground);
+    bool isForeground() const { return m_foreground; }
+
+    // 循环播放（动图），短循环的解码帧缓存在内存中重复播放
+    void setLoopPlayback(bool loop);
+    bool isLoopPlayback() const { return m_loopPlayback; }
+    void setLoopCacheLimit(qint64 bytes);
+
+    // A-B循环：[a, b)区间重复播放。第一遍播放时缓存区间内的视频帧和音频帧，
+    // 总大小不超过预算则之后直接重放，不再读取和解码；超出预算时解封装读到b后跳回a之前的关键帧，
+    // 跳转在解封装和解码队列的提前量内完成，播放到b时a处的帧已经解码好。
+    // 返回的时间戳按循环次数累加，音视频时钟在回绕处连续。区间过短或不可用时返回false
+    bool setABLoop(double a, double b);
+    void clearABLoop();
+    bool hasABLoop() const { return m_abLoopEnd > m_abLoopStart; }
+    double abLoopStart() const { return m_abLoopStart; }
+    double abLoopEnd() const { return m_abLoopEnd; }
+    void setABLoopCacheLimit(qint64 bytes);
+
+    // 最近取出的帧在文件中的时间戳（不含A-B循环的累加）
+    double position() const { return m_hasVideo ? m_lastVideoPts : m_lastAudioPts; }
+
+    // pts（文件中的时间戳）时刻应显示的字幕，没有时返回空。字幕在解码任务中解码，
+    // 同一事件始终返回同一对象，显示端按指针判断字幕是否变化
+    std::shared_ptr<const SubtitleData> subtitleAt(double pts) const;
+
+    // 轨道选择：type为AVMEDIA_TYPE_VIDEO/AUDIO/SUBTITLE，streamIndex取自tracks()。
+    // 新解码器打开成功后才替换旧的（失败时保持原轨道），丢弃旧流已排队的数据包和帧，
+    // 从当前位置之前的关键帧重建流水线；不重新打开文件，也不重新探测流信息
+    std::vector<TrackInfo> tracks(AVMediaType type) const;
+    int currentTrack(AVMediaType type) const;
+    bool selectTrack(AVMediaType type, int streamIndex);
 
     void setMaxVideoFrames(int maxFrames) { m_maxVideoFrames = maxFrames; }
     void setMaxAudioFrames(int maxFrames) { m_maxAudioFrames = maxFrames; }
     int getVideoFramesInCache() const;
     int getAudioFramesInCache() const;
 
+    // 各阶段耗时与队列占用，流水线重建后统计重新开始
+    PipelineStats getPipelineStats() const;
+
+    // 直播输入（见LatencyController::isLiveUrl）：缩短探测、低延迟解码、浅队列，
+    // 延迟由播放端的LatencyController控制
+    bool isLive() const { return m_live; }
+    // 最新读到的数据包时间戳，即直播点
+    double liveEdgePts() const;
+    // 丢弃时间戳早于pts的已解码帧（直播追帧），返回丢弃的视频帧数
+    int dropFramesBefore(double pts);
+
+    // 变速播放：画面落后于音频时钟时只丢视频帧；高倍速时跳过非参考帧（B帧）的解码，
+    // 使解码开销不随速度线性增长
+    int dropVideoFramesBefore(double pts);
+    void setSkipNonReference(bool skip);
+
+    // 快进/快退（trick play）：speed为倍速，负数为快退，0退出并从当前画面位置恢复正常解码。
+    // 解封装按目标时间跳到关键帧，只读取关键帧数据包，解码器只解关键帧，不解码音频，
+    // I/O和解码量与显示的帧数成正比，与文件长度无关
+    void setTrickPlay(double speed);
+    double trickSpeed() const { return m_trickSpeed; }
+    bool isTrickPlay() const { return m_trickSpeed != 0.0; }
+    // 下一个待显示视频帧的时间戳（不取出），快进/快退时按时间戳安排显示
+    bool peekVideoPts(double *pts) const;
+
+    // 倒放：从当前画面位置起逐段向前，每段跳到之前的关键帧、正向解码整个GOP后倒序输出。
+    // 显示一段的同时在解码任务中解码更早的一段；正在显示和正在解码的两段共用内存预算，
+    // GOP超出预算时分成几段从同一关键帧重复解码。不解码音频
+    void setReversePlayback(bool reverse);
+    bool isReversePlayback() const { return m_reverse; }
+    void setReverseCacheLimit(qint64 bytes) { m_reverseCacheLimit = bytes; }
+
+    // 逐帧后退：下一次getNextVideoFrame返回当前画面的上一帧。最近显示过的帧缓存在内存中，
+    // 逐帧前进时取帧队列中的下一帧，两个方向在缓存范围内都不需要解码；
+    // 后退未命中时从上一帧所在GOP的关键帧重新解码，返回false并进入等待状态（isStepPending），
+    // 由调用方定时调用pollStepBackward取出已解码的帧填充缓存，回到当前画面时返回true。
+    // 没有上一帧时返回false；跳转和重建流水线会取消等待
+    bool stepBackward();
+    bool isStepPending() const { return m_stepPending; }
+    bool pollStepBackward();
+    void setStepCacheLimit(qint64 bytes);
+
 signals:
     void loadFinished(bool success);
     void endOfStream();
@@ -151,33 +323,95 @@ private:
     int m_height{0};
     bool m_hasVideo{false};
     bool m_hasAudio{false};
+    bool m_hasSubtitle{false};
     std::atomic<bool> m_isPlaying{false};
     std::atomic<bool> m_isLoaded{false};
+    bool m_isSuspended{false};
+    bool m_foreground{true};
+    bool m_live{false};
+    bool m_skipNonReference{false};
+    double m_trickSpeed{0.0};
+    bool m_reverse{false};
+    qint64 m_reverseCacheLimit{512 * 1024 * 1024};  // 默认512MB
+
+    // 最近取出的帧时间戳，用作挂起后的恢复点
+    double m_lastVideoPts{0.0};
+    double m_lastAudioPts{0.0};
+    double m_resumePts{0.0};
+
+    // 逐帧后退未命中时的异步填充
+    bool m_stepPending{false};
+    double m_stepTarget{0.0};  // 取到此时间戳之后的帧即已回到当前画面
+    int m_stepDecoded{0};
+    QElapsedTimer m_stepTimer;
 
     // FFmpeg上下文
+    std::unique_ptr<MediaIO> m_io;  // 自定义输入，为空时使用FFmpeg默认I/O
+    std::atomic<bool> m_abortRequested{false};  // 中断阻塞在网络读取中的FFmpeg调用
     AVFormatContext *m_formatContext{nullptr};
     int m_videoStreamIndex{-1};
     int m_audioStreamIndex{-1};
+    int m_subtitleStreamIndex{-1};
+    AVCodecContext *m_videoCodecContext{nullptr};
     AVCodecContext *m_audioCodecContext{nullptr};
+    AVCodecContext *m_subtitleCodecContext{nullptr};
 
     // 缓存控制
     int m_maxVideoFrames{30};   // 最多缓存30个视频帧
     int m_maxAudioFrames{100};  // 最多缓存100个音频帧
 
-    // ============== 内部工作线程 ==============
+    // 循环播放
+    bool m_loopPlayback{false};
+    qint64 m_loopCacheLimit{64 * 1024 * 1024};  // 默认64MB
+    double m_abLoopStart{0.0};
+    double m_abLoopEnd{0.0};
+    qint64 m_abLoopCacheLimit{512 * 1024 * 1024};  // 默认512MB
+
+    // 直播模式的队列深度：解码帧队列只需覆盖解码抖动，积压的数据越少延迟越低
+    static constexpr int LIVE_VIDEO_PACKETS = 25;
+    static constexpr int LIVE_AUDIO_PACKETS = 50;
+    static constexpr int LIVE_VIDEO_FRAMES = 4;
+    static constexpr int LIVE_AUDIO_FRAMES = 8;
+
+    // 快进/快退每秒显示的关键帧数，决定相邻两次跳转的时间间隔（speed / TRICK_FRAME_RATE秒）；
+    // 队列只保留少量关键帧，跳转读取按显示进度进行
+    static constexpr double TRICK_FRAME_RATE = 12.0;
+    static constexpr int TRICK_PACKETS = 2;
+    static constexpr int TRICK_FRAMES = 3;
+
+    // 逐帧后退未命中时等待GOP解码的最长时间，超时后按已填充的缓存后退
+    static constexpr int STEP_REFILL_TIMEOUT_MS = 3000;
+
+    static constexpr double MIN_AB_LOOP = 0.5;  // A-B循环的最短区间（秒）
+
+    // ============== 内部流水线任务（在DecodeScheduler中运行） ==============
     std::unique_ptr<DemuxThread> m_demuxThread;
     std::unique_ptr<VideoDecoder> m_videoDecoder;
     std::unique_ptr<AudioDecoder> m_audioDecoder;
+    std::unique_ptr<SubtitleDecoder> m_subtitleDecoder;
     std::unique_ptr<FrameCache> m_frameCache;
+    SubtitleTrack m_subtitles;
 
     // ============== 内部方法 ==============
+    static int interruptCallback(void *opaque);
+    void restartPipeline(double startPts, bool fromKeyframe = false);
+    int videoFrameBytes() const;
+    double loopOffset(int loops) const;
+    int reverseWindowFrames() const;
     void cleanup();
     bool initializeStreams();
-    void startThreads();
-    void stopThreads();
+    void openCodecs();
+    AVCodecContext *openCodec(int streamIndex) const;
+    void flushCodecs();
+    // seekFirst：先跳转到startPts（重建已有流水线时必须跳转，解封装位置停留在预读处或文件末尾）
+    // fromKeyframe：保留起点之前的关键帧开始的全部视频帧（逐帧后退填充缓存）
+    void startPipeline(double startPts, bool seekFirst, bool fromKeyframe = false);
+    void stopPipeline();
+    std::vector<PipelineTask *> pipelineTasks() const;
 };
 
-class DemuxThread : public QThread {
+// 解封装任务（历史上是独立线程，现作为DecodeScheduler的任务运行）
+class DemuxThread : public QObject, public PipelineTask {
     Q_OBJECT
 
 public:
@@ -185,49 +419,111 @@ public:
     ~DemuxThread();
 
     void setFormatContext(AVFormatContext *ctx, int videoIndex, int audioIndex);
+    void setConsumers(PipelineTask *video, PipelineTask *audio);
+    // 字幕流的数据包放入单独的队列，streamIndex为-1时丢弃
+    void setSubtitleStream(int streamIndex, PipelineTask *consumer);
     void requestStop();
     void seek(double seconds);
-
-    // 队列访问接口
+    void setLoopPlayback(bool loop) { m_loopPlayback = loop; }
+    // A-B循环：读到B之后的数据包时跳回A之前的关键帧
+    void setLoopRange(double start, double end);
+    void setQueueLimits(int videoPackets, int audioPackets);
+    // 快进/快退：从startPts开始，每次跳到目标时间附近的关键帧，目标每次前进step秒（负数后退）
+    void setTrickPlay(double startPts, double step);
+    void setTrickStep(double step) { m_trickStep = step; }
+    // 倒放：第一段输出endPts之前的帧，每段最多windowFrames帧
+    void setReversePlayback(double endPts, int windowFrames);
+
+    // 队列访问接口（非阻塞）
     bool getVideoPacket(std::unique_ptr<PacketData> &packet);
     bool getAudioPacket(std::unique_ptr<PacketData> &packet);
+    bool getSubtitlePacket(std::unique_ptr<PacketData> &packet);
 
     bool isVideoQueueFull() const;
     bool isAudioQueueFull() const;
+    int videoPacketCount() const;
+    int audioPacketCount() const;
+
+    // 已读到文件末尾（或读取出错），不会再有新的数据包
+    bool reachedEnd() const { return m_reachedEnd; }
+
+    // 已读取的最大时间戳（秒）
+    double newestPts() const { return m_newestPts; }
 
-protected:
-    void run() override;
+    StepResult step() override;
 
 signals:
     void finished();
     void errorOccurred(const QString &error);
 
 private:
+    // 回到循环起点（文件开头或A点）并向解码器发送循环标记
+    bool rewindForLoop(double start);
+
+    // 放入对应队列，队列已满时返回false
+    bool pushPacket(std::unique_ptr<PacketData> &packet, int streamIndex);
+
+    // 快进/快退的一步：跳转，或读取一个数据包直到找到关键帧
+    StepResult trickStep(AVPacket *packet);
+    // 倒放的一步：送出已读完的一段，或跳转/读取下一段
+    StepResult reverseStep(AVPacket *packet);
+    StepResult completeSegment();
+    StepResult finishReading(int ret);
+
     FFmpegStream *m_parent;
     AVFormatContext *m_formatContext{nullptr};
     int m_videoStreamIndex{-1};
     int m_audioStreamIndex{-1};
+    int m_subtitleStreamIndex{-1};
+    PipelineTask *m_videoConsumer{nullptr};
+    PipelineTask *m_audioConsumer{nullptr};
+    PipelineTask *m_subtitleConsumer{nullptr};
 
     std::atomic<bool> m_stopRequested{false};
     std::atomic<bool> m_seekRequested{false};
     std::atomic<double> m_seekTime{0.0};
-
-    // 数据包队列
-    std::deque<std::unique_ptr<PacketData>> m_videoPacketQueue;
-    std::deque<std::unique_ptr<PacketData>> m_audioPacketQueue;
-
-    // 队列保护
-    mutable QMutex m_videoMutex;
-    mutable QMutex m_audioMutex;
-    QWaitCondition m_videoCondition;
-    QWaitCondition m_audioCondition;
+    std::atomic<bool> m_loopPlayback{false};
+    std::atomic<bool> m_reachedEnd{false};
+    std::atomic<double> m_newestPts{0.0};
+    double m_loopStart{0.0};
+    double m_loopEnd{0.0};
+
+    // 快进/快退状态（只在解封装任务中访问，步长可随时调整）
+    std::atomic<double> m_trickStep{0.0};
+    double m_trickTarget{0.0};
+    double m_lastKeyPts{0.0};
+    bool m_hasLastKey{false};
+    bool m_trickSought{false};  // 已跳转到目标，正在寻找关键帧
+    int m_trickRetries{0};      // 连续跳回同一关键帧的次数
+
+    // 倒放状态（只在解封装任务中访问）
+    bool m_reverse{false};
+    int m_reverseWindow{0};
+    double m_reverseEnd{0.0};    // 下一段的终点（不含）
+    bool m_reverseSought{false};
+    bool m_reverseHasKey{false};
+    bool m_segmentReady{false};  // 一段已读完，等待送出
+    double m_segmentStart{0.0};
+    double m_segmentEnd{0.0};
+    std::vector<std::unique_ptr<PacketData>> m_segmentPackets;
+
+    // 读取用数据包，以及因目标队列已满而暂存的数据包
+    AVPacket *m_readPacket{nullptr};
+    std::unique_ptr<PacketData> m_pendingPacket;
+    int m_pendingStreamIndex{-1};
 
     // 队列限制
     static const int MAX_VIDEO_PACKETS = 50;
     static const int MAX_AUDIO_PACKETS = 200;
+    static const int MAX_SUBTITLE_PACKETS = 64;
+
+    // 数据包队列
+    MediaQueue<PacketData> m_videoPacketQueue{MAX_VIDEO_PACKETS};
+    MediaQueue<PacketData> m_audioPacketQueue{MAX_AUDIO_PACKETS};
+    MediaQueue<PacketData> m_subtitlePacketQueue{MAX_SUBTITLE_PACKETS};
 };
 
-class VideoDecoder : public QThread {
+class VideoDecoder : public QObject, public PipelineTask {
     Q_OBJECT
 
 public:
@@ -236,33 +532,64 @@ public:
 
     void setCodecContext(AVCodecContext *ctx);
     void setDemuxThread(DemuxThread *demux);
+    void setDiscardBefore(double pts) { m_discardBefore = pts; }
+    // 丢弃时间戳不早于pts的帧（A-B循环的B点）
+    void setDiscardAfter(double pts) { m_discardAfter = pts; }
+    void setMaxFrames(int maxFrames) { m_frameQueue.setCapacity(size_t(maxFrames)); }
+    void setSkipNonReference(bool skip) { m_skipNonReference = skip; }
+    // 快进/快退：只解码关键帧，每个数据包单独解码并立即输出
+    void setKeyframesOnly(bool keyframesOnly) { m_keyframesOnly = keyframesOnly; }
+    // 倒放：按分段标记收集一段的帧，上一段显示完后倒序放入队列
+    void setReverse(bool reverse) { m_reverse = reverse; }
     void requestStop();
 
     bool getFrame(std::unique_ptr<FrameData> &frame);
+    bool peekPts(double *pts) const;
     bool isFrameQueueFull() const;
+    int queuedFrames() const;
+    int dropFramesBefore(double pts);
+
+    // 文件末尾的帧已全部送入队列
+    bool isFinished() const { return m_finished; }
 
-protected:
-    void run() override;
+    StepResult step() override;
 
 signals:
     void errorOccurred(const QString &error);
 
 private:
+    // 从解码器取出所有可用帧放入队列
+    void receiveFrames(double fallbackPts);
+    void pushFrame(std::unique_ptr<FrameData> frameData);
+    void flushReverseFrames();
+
     FFmpegStream *m_parent;
     AVCodecContext *m_codecContext{nullptr};
     DemuxThread *m_demuxThread{nullptr};
+    AVFrame *m_frame{nullptr};
 
     std::atomic<bool> m_stopRequested{false};
-
-    // 帧队列
-    std::deque<std::unique_ptr<FrameData>> m_frameQueue;
-    mutable QMutex m_frameMutex;
-    QWaitCondition m_frameCondition;
+    std::atomic<bool> m_finished{false};
+    std::atomic<double> m_discardBefore{0.0};
+    std::atomic<double> m_discardAfter{std::numeric_limits<double>::infinity()};
+    std::atomic<bool> m_skipNonReference{false};  // 在解码任务中应用到skip_frame
+    bool m_keyframesOnly{false};
+
+    // 倒放：当前段窗口内已解码的帧
+    bool m_reverse{false};
+    bool m_reverseReady{false};  // 一段已解码完成，等待上一段显示完
+    double m_windowStart{0.0};
+    double m_windowEnd{0.0};
+    std::vector<std::unique_ptr<FrameData>> m_reverseFrames;
+    double m_lastPacketPts{0.0};
 
     static const int MAX_FRAMES = 30;
+
+    // 帧队列（解码输出不受容量限制，容量只用于判断是否暂停解码）
+    MediaQueue<FrameData> m_frameQueue{MAX_FRAMES};
 };
 
-class AudioDecoder : public QThread {
+class AudioDecoder : public QObject, public PipelineTask {
     Q_OBJECT
 
 public:
@@ -271,31 +598,75 @@ public:
 
     void setCodecContext(AVCodecContext *ctx);
     void setDemuxThread(DemuxThread *demux);
+    void setDiscardBefore(double pts) { m_discardBefore = pts; }
+    void setDiscardAfter(double pts) { m_discardAfter = pts; }
+    void setMaxFrames(int maxFrames) { m_frameQueue.setCapacity(size_t(maxFrames)); }
     void requestStop();
 
     bool getFrame(std::unique_ptr<FrameData> &frame);
     bool isFrameQueueFull() const;
+    int queuedFrames() const;
+    int dropFramesBefore(double pts);
+
+    // 文件末尾的帧已全部送入队列
+    bool isFinished() const { return m_finished; }
 
-protected:
-    void run() override;
+    StepResult step() override;
 
 signals:
     void errorOccurred(const QString &error);
 
 private:
+    // 从解码器取出所有可用帧放入队列
+    void receiveFrames(double fallbackPts);
+
     FFmpegStream *m_parent;
     AVCodecContext *m_codecContext{nullptr};
     DemuxThread *m_demuxThread{nullptr};
     SwrContext *m_swrContext{nullptr};
+    AVFrame *m_frame{nullptr};
 
     std::atomic<bool> m_stopRequested{false};
-
-    // 帧队列
-    std::deque<std::unique_ptr<FrameData>> m_frameQueue;
-    mutable QMutex m_frameMutex;
-    QWaitCondition m_frameCondition;
+    std::atomic<bool> m_finished{false};
+    std::atomic<double> m_discardBefore{0.0};
+    std::atomic<double> m_discardAfter{std::numeric_limits<double>::infinity()};
+    double m_lastPacketPts{0.0};
 
     static const int MAX_FRAMES = 100;
+
+    // 帧队列（解码输出不受容量限制，容量只用于判断是否暂停解码）
+    MediaQueue<FrameData> m_frameQueue{MAX_FRAMES};
+};
+
+// 字幕解码任务：文本和位图字幕都在此转换为SubtitleData，显示端只需绘制
+class SubtitleDecoder : public QObject, public PipelineTask {
+    Q_OBJECT
+
+public:
+    explicit SubtitleDecoder(FFmpegStream *parent);
+    ~SubtitleDecoder();
+
+    void setCodecContext(AVCodecContext *ctx);
+    void setDemuxThread(DemuxThread *demux);
+    void setTrack(SubtitleTrack *track) { m_track = track; }
+    // 位图坐标的默认画布（解码器未给出尺寸时使用视频尺寸）
+    void setCanvasSize(int width, int height);
+    void requestStop();
+
+    StepResult step() override;
+
+private:
+    void decodePacket(const PacketData &packetData);
+    static QString assToText(const char *ass);
+
+    FFmpegStream *m_parent;
+    AVCodecContext *m_codecContext{nullptr};
+    DemuxThread *m_demuxThread{nullptr};
+    SubtitleTrack *m_track{nullptr};
+    int m_canvasWidth{0};
+    int m_canvasHeight{0};
+
+    std::atomic<bool> m_stopRequested{false};
 };
 
 class FrameCache : public QObject {
@@ -313,9 +684,59 @@ public:
     int getVideoFrameCount() const;
     int getAudioFrameCount() const;
 
+    // 循环缓存：第一遍播放时记录视频帧和音频帧，总大小不超过上限则之后直接重放
+    void setLoopCacheEnabled(bool enabled);
+    void setLoopCacheLimit(qint64 bytes) { m_loopCacheLimit = bytes; }
+    bool isReplayingLoop() const { return m_loopState == LoopState::Replaying; }
+    bool seekLoop(double seconds);
+    // 已取出的帧经过的循环次数
+    int videoLoops() const { return m_videoLoop.loops; }
+    int audioLoops() const { return m_audioLoop.loops; }
+
+    // 逐帧缓存：最近取出的视频帧（引用计数克隆），总大小不超过上限。
+    // stepBack后按顺序重新取出缓存中的帧，取完后再从解码队列取帧
+    void setStepCacheEnabled(bool enabled);
+    void setStepCacheLimit(qint64 bytes) { m_stepCacheLimit = bytes; }
+    bool stepBack();
+    void clearStepFrames();
+
     void clear();
 
 private:
+    enum class LoopState {
+        Disabled,   // 未开启循环缓存
+        Recording,  // 第一遍播放，记录解码帧
+        Replaying,  // 从缓存重放，不再解码
+        Streaming   // 超出内存上限，每次循环重新解码
+    };
+
+    // 视频和音频各自的循环记录。先到达循环结束标记的一路继续从解码队列取第二遍的帧，
+    // 只记录取到的位置，两路都记录完整后一起切换为重放，切换处不跳帧
+    struct LoopTrack {
+        std::vector<std::unique_ptr<FrameData>> frames;
+        size_t index{0};       // 重放位置
+        bool complete{false};  // 第一遍已记录完整
+        int loops{0};
+    };
+
+    void recordLoopFrame(LoopTrack &track, const AVFrame *frame, double pts);
+    void finishLoopPass(LoopTrack &track);
+    AVFrame *nextLoopFrame(LoopTrack &track, double *pts);
+    void clearLoopFrames();
+    void recordStepFrame(const AVFrame *frame, double pts);
+
     VideoDecoder *m_videoDecoder{nullptr};
     AudioDecoder *m_audioDecoder{nullptr};
+
+    LoopState m_loopState{LoopState::Disabled};
+    LoopTrack m_videoLoop;
+    LoopTrack m_audioLoop;
+    qint64 m_loopCacheBytes{0};
+    qint64 m_loopCacheLimit{64 * 1024 * 1024};  // 默认64MB
+
+    bool m_stepCacheEnabled{false};
+    std::deque<std::unique_ptr<FrameData>> m_stepFrames;
+    size_t m_stepIndex{0};  // 下一次取出的位置，等于size时从解码队列取帧
+    qint64 m_stepCacheBytes{0};
+    qint64 m_stepCacheLimit{32 * 1024 * 1024};  // 默认32MB（1080p约10帧），正常播放时同样记录
 };
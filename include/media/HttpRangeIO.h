@@ -0,0 +1,73 @@
+#pragma once
+
+#include "media/MediaIO.h"
+#include <QFile>
+#include <QMutex>
+#include <QThreadPool>
+#include <QWaitCondition>
+#include <atomic>
+#include <vector>
+
+// HTTP(S)分块输入：按固定大小的块发送Range请求，多个连接并行预取播放位置之后的块，
+// 取回的块写入稀疏的磁盘缓存文件，跳转或再次播放时命中缓存的块不再请求网络。
+// 服务器不支持Range请求或不返回长度时不使用（回退到FFmpeg默认的http协议）。
+// 每取回一个块就原子地重写块索引；打开时按最近使用时间淘汰超出CACHE_LIMIT的缓存。
+// 索引中记录服务器返回的ETag/Last-Modified，与本次打开时不同则丢弃已缓存的块
+class HttpRangeIO : public MediaIO {
+public:
+    ~HttpRangeIO() override;
+
+    static std::unique_ptr<HttpRangeIO> open(const QString &url);
+
+    int read(uint8_t *buffer, int size) override;
+    int64_t seek(int64_t offset) override;
+    int64_t position() const override { return m_position; }
+    int64_t size() const override { return m_size; }
+    Stats stats() const override;
+    void abort() override;
+
+    static constexpr int64_t CHUNK_SIZE = 1024 * 1024;
+    static constexpr int PREFETCH_CHUNKS = 4;  // 当前块之后预取的块数
+    static constexpr int CONNECTIONS = 3;      // 并行连接数
+    static constexpr int64_t CACHE_LIMIT = 2048LL * 1024 * 1024;  // 磁盘缓存总量（已缓存的块）
+
+private:
+    enum ChunkState : uint8_t { Missing, Fetching, Cached, Failed };
+
+    HttpRangeIO() = default;
+
+    bool openCache();
+    void saveIndex();
+    // 删除孤立的文件，并按最近使用时间淘汰超出CACHE_LIMIT的缓存（正在使用的除外）
+    static void pruneCache(const QString &cacheDir);
+    // 请求[first, first + count)中尚未缓存的块
+    void schedule(int first, int count);
+    void fetchChunk(int index);
+    static int interruptCallback(void *opaque);
+
+    QString m_url;
+    QByteArray m_validator;  // "ETag\nLast-Modified"，服务器都不提供时为空
+    int64_t m_size{0};
+    int64_t m_position{0};
+    int m_chunkCount{0};
+
+    QFile m_cacheFile;
+    QString m_cacheKey;
+    QString m_indexPath;
+    QMutex m_fileMutex;
+    QMutex m_indexMutex;  // 多个下载线程完成时串行写索引
+
+    mutable QMutex m_mutex;  // 保护块状态
+    QWaitCondition m_chunkReady;
+    std::vector<ChunkState> m_chunks;
+    std::vector<uint8_t> m_failures;
+    QThreadPool m_pool;
+
+    std::atomic<bool> m_aborted{false};
+    std::atomic<int> m_wantedChunk{0};  // 解封装当前所在的块，超出预取范围的请求会被放弃
+    std::atomic<int> m_inFlight{0};
+    std::atomic<int64_t> m_bytesRead{0};
+    std::atomic<int64_t> m_waits{0};
+    std::atomic<int64_t> m_waitNs{0};
+    std::atomic<int64_t> m_maxWaitNs{0};
+};
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <QString>
+#include <cstdint>
+
+// 直播延迟控制
+// 每次显示一帧时输入当前测得的延迟，输出播放速度：延迟略高于目标时小幅加速追赶，
+// 低于目标较多时略微减速以积累缓冲抵抗网络抖动；延迟远超目标（暂停、卡顿后）时直接丢帧追到直播点。
+// 只依赖测量值，不关心测量方式：
+//   - 缓冲延迟：最新解封装的时间戳 - 正在显示的时间戳（播放器内部积压，默认）
+//   - 端到端延迟：推流端按墙上时钟打时间戳时（同一主机回环或时钟已同步），见senderClockLatency
+class LatencyController {
+public:
+    struct Decision {
+        double rate{1.0};         // 播放速度
+        bool dropToLive{false};   // 丢弃积压的帧，直接追到直播点
+    };
+
+    struct Stats {
+        double latency{0.0};  // 平滑后的延迟（秒）
+        double rate{1.0};
+        int drops{0};         // 追帧次数
+        int64_t updates{0};
+        double sumLatency{0.0};
+        double maxLatency{0.0};
+    };
+
+    explicit LatencyController(double targetSeconds = DEFAULT_TARGET) : m_target(targetSeconds) {}
+
+    void setTarget(double seconds) { m_target = seconds; }
+    double target() const { return m_target; }
+
+    Decision update(double latencySeconds);
+    void reset();
+
+    Stats stats() const { return m_stats; }
+
+    // 直播地址（udp/rtp/srt/rist/rtsp/rtmp）
+    static bool isLiveUrl(const QString &url);
+
+    // 时间戳为推流时刻的墙上时钟（90kHz，按MPEG-TS的33位回绕）时，返回从推流到现在经过的时间
+    static double senderClockLatency(double ptsSeconds);
+    // 推流端使用：当前墙上时钟对应的时间戳偏移（微秒，用作复用器的output_ts_offset）
+    static int64_t senderClockOffset();
+
+    static constexpr double DEFAULT_TARGET = 0.3;
+
+private:
+    static constexpr double SMOOTHING = 0.1;          // 每次更新的平滑系数
+    static constexpr double SPEEDUP_THRESHOLD = 0.05;  // 超过目标多少开始加速
+    static constexpr double SLOWDOWN_THRESHOLD = 0.1;  // 低于目标多少开始减速
+    static constexpr double DROP_THRESHOLD = 1.0;      // 超过目标多少直接丢帧
+    static constexpr double MAX_SPEEDUP = 0.08;        // 最大加速8%
+    static constexpr double SLOWDOWN = 0.03;
+
+    double m_target;
+    double m_smoothed{-1.0};  // 小于0表示尚无测量值
+    double m_rate{1.0};
+    Stats m_stats;
+};
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// EBU R128 / ITU-R BS.1770响度测量，随播放增量计算，不需要预扫描
+// 输入为交错的float（重采样后的设备声道数和采样率）。K加权的两级双二阶滤波按声道两两
+// 打包为double向量（SSE2/AArch64 NEON）。每100ms为一个子块：瞬时响度取最近4个子块
+// （400ms），短期响度取最近30个子块（3s）；综合响度对每个400ms块（75%重叠）做
+// -70 LUFS绝对门限和-10 LU相对门限，块能量按0.1 LU分桶累加，内存占用与时长无关
+class LoudnessMeter {
+public:
+    LoudnessMeter(int channels, int sampleRate);
+
+    void process(const float *samples, int frames);
+    void reset();
+
+    // LUFS，数据不足时为负无穷
+    double momentary() const;
+    double shortTerm() const;
+    double integrated() const;
+
+    // 采样峰值（线性，满幅为1）
+    float peak() const { return m_peak; }
+    // 已测量的时长（秒）
+    double measuredSeconds() const { return double(m_frames) / m_sampleRate; }
+
+private:
+    static constexpr int MOMENTARY_BLOCKS = 4;   // 400ms
+    static constexpr int SHORT_TERM_BLOCKS = 30;  // 3s
+    static constexpr double HISTOGRAM_MIN = -70.0;
+    static constexpr double HISTOGRAM_MAX = 30.0;
+    static constexpr int HISTOGRAM_BINS = 1000;  // 每桶0.1 LU
+
+    // 一个声道对的滤波器状态：两级直接II型转置结构，每级两个延迟
+    struct PairState {
+        double z[4][2]{};
+    };
+
+    void filterPair(const float *samples, int frames, int pair);
+    void finishSubBlock();
+    double recentEnergy(int blocks) const;
+
+    const int m_channels;
+    const int m_sampleRate;
+    const int m_subBlockFrames;  // 100ms
+    const int m_pairs;           // (声道数 + 1) / 2
+
+    // 预滤波（高频搁架）和RLB高通的系数，a0已归一化
+    double m_shelfB[3];
+    double m_shelfA[2];
+    double m_highpassB[3];
+    double m_highpassA[2];
+
+    std::vector<double> m_weights;      // 每个声道的加权（环绕1.41，LFE不计入）
+    std::vector<PairState> m_state;
+    std::vector<double> m_energy;       // 当前子块每个声道的平方和
+    int m_subBlockPos{0};               // 当前子块已累计的帧数
+
+    std::vector<double> m_recent;       // 最近SHORT_TERM_BLOCKS个子块的均方（环形）
+    int m_recentPos{0};
+    int m_recentCount{0};
+
+    std::vector<double> m_binEnergy;    // 每个响度桶中400ms块的均方之和
+    std::vector<uint32_t> m_binCount;
+    int64_t m_frames{0};
+    float m_peak{0.0f};
+};
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "media/MediaIO.h"
+#include <QFile>
+#include <atomic>
+
+// 内存映射的本地文件输入
+// 读取只是从映射区拷贝，命中页缓存时没有系统调用；
+// 按播放位置和跳转目标向内核提示预读窗口（madvise WILLNEED）
+// 注意：播放期间文件被截断时访问映射区会产生SIGBUS，与其他mmap读取器相同
+class MappedFileIO : public MediaIO {
+public:
+    ~MappedFileIO() override;
+
+    // 映射失败（文件为空、地址空间不足等）时返回nullptr
+    static std::unique_ptr<MappedFileIO> open(const QString &path);
+
+    int read(uint8_t *buffer, int size) override;
+    int64_t seek(int64_t offset) override;
+    int64_t position() const override { return m_position; }
+    int64_t size() const override { return m_size; }
+    Stats stats() const override;
+
+protected:
+    int bufferSize() const override { return 256 * 1024; }
+
+private:
+    MappedFileIO() = default;
+
+    // 提示内核预读[offset, offset + WINDOW)
+    void adviseWindow(int64_t offset);
+
+    static constexpr int64_t WINDOW = 8 * 1024 * 1024;
+
+    QFile m_file;
+    const uint8_t *m_data{nullptr};
+    int64_t m_size{0};
+    int64_t m_position{0};
+    int64_t m_adviseBegin{0};  // 已提示预读的范围
+    int64_t m_adviseEnd{0};
+    std::atomic<int64_t> m_bytesRead{0};
+};
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <QString>
+#include <cstdint>
+#include <memory>
+
+extern "C" {
+#include <libavformat/avio.h>
+}
+
+// 自定义输入（替代FFmpeg默认的文件/网络I/O）
+// 子类实现同步的read/seek，基类负责创建AVIOContext并转发回调。
+// read/seek只会在解封装所在线程调用，无需加锁
+class MediaIO {
+public:
+    virtual ~MediaIO();
+
+    MediaIO(const MediaIO &) = delete;
+    MediaIO &operator=(const MediaIO &) = delete;
+
+    // 返回读取的字节数，文件末尾返回AVERROR_EOF，出错返回其他负值
+    virtual int read(uint8_t *buffer, int size) = 0;
+    // 跳转到绝对位置，返回新位置，失败返回负值
+    virtual int64_t seek(int64_t offset) = 0;
+    virtual int64_t position() const = 0;
+    // 未知时返回-1
+    virtual int64_t size() const = 0;
+
+    // I/O统计，可在其他线程读取
+    struct Stats {
+        const char *backend{"ffmpeg"};
+        int readAheadDepth{0};   // 预读块数上限
+        int readAheadQueued{0};  // 已提交但尚未读取的块
+        int64_t bytesRead{0};
+        int64_t waits{0};  // 需要等待I/O完成的读取次数
+        double waitMs{0.0};
+        double maxWaitMs{0.0};
+    };
+    virtual Stats stats() const { return Stats(); }
+
+    // 让阻塞中的read尽快返回（关闭文件前调用，之后的读取均失败）
+    virtual void abort() {}
+
+    // 供AVFormatContext::pb使用（需设置AVFMT_FLAG_CUSTOM_IO），由MediaIO释放
+    AVIOContext *avioContext();
+
+    // 根据路径选择合适的实现，返回nullptr表示使用FFmpeg默认I/O
+    // 本地磁盘默认内存映射，网络文件系统默认异步预读，HTTP(S)使用分块缓存；
+    // 环境变量PLAYER_IO=mmap|readahead|ffmpeg可强制指定本地文件的输入方式（ffmpeg对URL同样有效）
+    static std::unique_ptr<MediaIO> create(const QString &path);
+
+protected:
+    MediaIO() = default;
+
+    // AVIOContext内部缓冲区大小
+    virtual int bufferSize() const { return 64 * 1024; }
+
+private:
+    static int readCallback(void *opaque, uint8_t *buffer, int size);
+    static int64_t seekCallback(void *opaque, int64_t offset, int whence);
+
+    AVIOContext *m_avioContext{nullptr};
+};
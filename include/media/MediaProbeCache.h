@@ -0,0 +1,19 @@
+#pragma once
+
+#include <QString>
+
+// 播放时测得的音频响度（见LoudnessMeter）
+struct LoudnessInfo {
+    double integrated = 0.0;  // 综合响度（LUFS）
+    float peak = 0.0f;        // 采样峰值（线性）
+    double seconds = 0.0;     // 测量覆盖的时长
+};
+
+// 按文件缓存播放过程中探测到的信息，下次打开同一文件时直接使用，无需预扫描
+// 以路径和流索引为键，文件大小或修改时间变化时失效；只缓存本地文件。
+// 首次访问时从缓存目录的probe.dat读入（丢弃源文件已不存在的条目），更新时整体原子重写
+class MediaProbeCache {
+public:
+    static bool loudness(const QString &filePath, int streamIndex, LoudnessInfo *info);
+    static void storeLoudness(const QString &filePath, int streamIndex, const LoudnessInfo &info);
+};
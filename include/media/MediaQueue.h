@@ -0,0 +1,111 @@
+#pragma once
+
+#include <QMutex>
+#include <QWaitCondition>
+#include <deque>
+#include <memory>
+
+// 线程安全的有界队列，用于解封装数据包队列和解码帧队列
+// 生产者使用tryPush（队列满时返回false，由调度器挂起后重试），
+// 循环/结束标记等必须送达的项使用forcePush
+template <typename T>
+class MediaQueue {
+public:
+    explicit MediaQueue(size_t capacity) : m_capacity(capacity) {}
+
+    MediaQueue(const MediaQueue &) = delete;
+    MediaQueue &operator=(const MediaQueue &) = delete;
+
+    // 队列已满时返回false，item保持不变
+    bool tryPush(std::unique_ptr<T> &item) {
+        QMutexLocker locker(&m_mutex);
+        if (m_items.size() >= m_capacity) return false;
+        m_items.push_back(std::move(item));
+        m_notEmpty.wakeOne();
+        return true;
+    }
+
+    // 不检查容量
+    void forcePush(std::unique_ptr<T> item) {
+        QMutexLocker locker(&m_mutex);
+        m_items.push_back(std::move(item));
+        m_notEmpty.wakeOne();
+    }
+
+    bool tryPop(std::unique_ptr<T> &item) {
+        QMutexLocker locker(&m_mutex);
+        return popLocked(item);
+    }
+
+    // 队列为空时最多等待timeoutMs毫秒
+    bool waitPop(std::unique_ptr<T> &item, unsigned long timeoutMs) {
+        QMutexLocker locker(&m_mutex);
+        if (m_items.empty() && timeoutMs > 0) {
+            m_notEmpty.wait(&m_mutex, timeoutMs);
+        }
+        return popLocked(item);
+    }
+
+    // 从队首丢弃满足条件的项，返回丢弃数量（直播追赶时丢弃过期的帧）
+    template <typename Pred>
+    int dropFront(Pred pred) {
+        QMutexLocker locker(&m_mutex);
+        int dropped = 0;
+        while (!m_items.empty() && pred(*m_items.front())) {
+            m_items.pop_front();
+            ++dropped;
+        }
+        return dropped;
+    }
+
+    // 在锁内查看队首项（不取出），队列为空时返回false
+    template <typename Func>
+    bool peekFront(Func func) const {
+        QMutexLocker locker(&m_mutex);
+        if (m_items.empty()) return false;
+        func(*m_items.front());
+        return true;
+    }
+
+    // 唤醒所有等待者（停止时）
+    void wakeAll() { m_notEmpty.wakeAll(); }
+
+    void clear() {
+        QMutexLocker locker(&m_mutex);
+        m_items.clear();
+    }
+
+    int size() const {
+        QMutexLocker locker(&m_mutex);
+        return int(m_items.size());
+    }
+
+    bool isFull() const {
+        QMutexLocker locker(&m_mutex);
+        return m_items.size() >= m_capacity;
+    }
+
+    size_t capacity() const {
+        QMutexLocker locker(&m_mutex);
+        return m_capacity;
+    }
+
+    // 只影响之后的tryPush，已在队列中的项不受影响
+    void setCapacity(size_t capacity) {
+        QMutexLocker locker(&m_mutex);
+        m_capacity = capacity;
+    }
+
+private:
+    bool popLocked(std::unique_ptr<T> &item) {
+        if (m_items.empty()) return false;
+        item = std::move(m_items.front());
+        m_items.pop_front();
+        return true;
+    }
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_notEmpty;
+    std::deque<std::unique_ptr<T>> m_items;
+    size_t m_capacity;
+};
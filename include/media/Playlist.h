@@ -0,0 +1,48 @@
+#pragma once
+
+#include <QObject>
+#include <QStringList>
+
+// 播放列表
+// 只维护文件列表和当前位置，打开/预加载由VideoWidget负责
+class Playlist : public QObject {
+    Q_OBJECT
+
+public:
+    explicit Playlist(QObject *parent = nullptr) : QObject(parent) {}
+
+    void setItems(const QStringList &items);
+    void append(const QString &filePath);
+    void removeAt(int index);
+    void clear();
+
+    QStringList items() const { return m_items; }
+    int count() const { return int(m_items.size()); }
+    bool isEmpty() const { return m_items.isEmpty(); }
+
+    int currentIndex() const { return m_currentIndex; }
+    QString currentItem() const { return itemAt(m_currentIndex); }
+    void setCurrentIndex(int index);
+
+    // 下一项的索引，没有下一项时返回-1
+    int nextIndex() const;
+    QString nextItem() const { return itemAt(nextIndex()); }
+
+    // 切换到下一项，没有下一项时返回false
+    bool advance();
+
+    // 列表播放完后从头开始
+    void setRepeat(bool repeat) { m_repeat = repeat; }
+    bool isRepeat() const { return m_repeat; }
+
+signals:
+    void currentIndexChanged(int index);
+    void itemsChanged();
+
+private:
+    QString itemAt(int index) const;
+
+    QStringList m_items;
+    int m_currentIndex{-1};
+    bool m_repeat{false};
+};
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "media/MediaIO.h"
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <vector>
+
+// 异步预读输入：在当前读取位置之后保持若干个大块读请求在途，
+// 解封装读取时大多直接命中已完成的块，冷缓存/机械硬盘/NFS上不再每次读取都阻塞。
+// 有liburing（HAVE_LIBURING）且内核支持时使用io_uring，否则由线程池执行pread
+class ReadAheadIO : public MediaIO {
+public:
+    // 一个预读块，data在读取完成前由后端写入
+    struct Block {
+        int64_t offset{0};
+        std::vector<uint8_t> data;
+        int result{0};  // 读取的字节数，失败时为负的错误码
+        bool done{false};
+    };
+
+    // 读请求的执行方式（io_uring或线程池pread）
+    class Backend {
+    public:
+        virtual ~Backend() = default;
+        virtual const char *name() const = 0;
+        virtual bool submit(const std::shared_ptr<Block> &block) = 0;
+        // 阻塞直到block完成
+        virtual void wait(const std::shared_ptr<Block> &block) = 0;
+        virtual bool isDone(const std::shared_ptr<Block> &block) = 0;
+    };
+
+    ~ReadAheadIO() override;
+
+    // 无法打开文件时返回nullptr（仅支持POSIX）
+    static std::unique_ptr<ReadAheadIO> open(const QString &path, int depth = DEFAULT_DEPTH,
+                                             int blockSize = DEFAULT_BLOCK_SIZE);
+
+    int read(uint8_t *buffer, int size) override;
+    int64_t seek(int64_t offset) override;
+    int64_t position() const override { return m_position; }
+    int64_t size() const override { return m_size; }
+    Stats stats() const override;
+
+    static constexpr int DEFAULT_DEPTH = 8;
+    static constexpr int DEFAULT_BLOCK_SIZE = 1024 * 1024;
+
+private:
+    ReadAheadIO() = default;
+
+    // 丢弃已读过的块，从当前位置补齐预读窗口
+    void fillWindow();
+    void clearWindow();
+
+    int m_fd{-1};
+    int64_t m_size{0};
+    int64_t m_position{0};
+    int m_depth{DEFAULT_DEPTH};
+    int m_blockSize{DEFAULT_BLOCK_SIZE};
+    std::unique_ptr<Backend> m_backend;
+    std::deque<std::shared_ptr<Block>> m_window;  // 按偏移连续排列
+    std::vector<std::shared_ptr<Block>> m_spareBlocks;
+
+    std::atomic<int> m_queued{0};
+    std::atomic<int64_t> m_bytesRead{0};
+    std::atomic<int64_t> m_waits{0};
+    std::atomic<int64_t> m_waitNs{0};
+    std::atomic<int64_t> m_maxWaitNs{0};
+};
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <QByteArray>
+#include <vector>
+
+// WSOLA变速不变调
+// 输入输出均为交错的float PCM（重采样后的浮点处理格式）。每次输出半个窗口长度的样本，
+// 分析位置按速度前进，并在名义位置附近搜索与上一段自然延续最相似的片段，
+// 用汉宁窗重叠相加，避免直接变速带来的音调变化和拼接处的相位跳变。
+// 速度为1.0且没有未输出的数据时直接透传
+class TimeStretcher {
+public:
+    TimeStretcher(int channels, int sampleRate);
+
+    void setRate(double rate);
+    double rate() const { return m_rate; }
+
+    QByteArray process(const QByteArray &input);
+
+    // 丢弃未输出的数据（跳转/清空缓冲时）
+    void reset();
+
+    // 已输入但尚未体现在输出中的媒体时长（秒），用于计算音频时钟
+    double pendingSeconds() const;
+
+    static constexpr double MIN_RATE = 0.5;
+    static constexpr double MAX_RATE = 3.0;
+
+private:
+    // 从当前状态回到透传：输出上一段尾部之后的全部输入
+    QByteArray drain();
+    void appendInput(const QByteArray &input);
+    int findBestOffset(int nominal) const;
+    void discardConsumed();
+    QByteArray toBytes(const float *samples, int frames) const;
+
+    const int m_channels;
+    const int m_sampleRate;
+    const int m_overlap;  // 半窗长（帧），即每次输出的帧数
+    const int m_window;   // 窗长 = 2 * m_overlap
+    const int m_search;   // 搜索范围 ±m_search 帧
+
+    double m_rate{1.0};
+    bool m_active{false};   // 正在变速（有未输出的数据）
+    bool m_started{false};  // 已输出第一段
+
+    std::vector<float> m_input;  // 交错的待处理输入
+    std::vector<float> m_mono;   // 单声道混合，用于相似度搜索
+    std::vector<float> m_hann;   // 周期汉宁窗，50%重叠相加恒为1
+    std::vector<float> m_tail;   // 上一段后半窗加窗后的样本，与下一段前半窗相加
+    double m_nominal{0.0};       // 下一段的名义起点（m_input中的帧位置）
+    int m_previous{0};           // 上一段实际选中的起点
+};
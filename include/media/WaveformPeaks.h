@@ -0,0 +1,62 @@
+#pragma once
+
+#include <QFile>
+#include <QString>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// 一个桶内全部声道样本的最小值、最大值和均方根（满幅为32767）
+struct PeakBucket {
+    int16_t min;
+    int16_t max;
+    int16_t rms;
+};
+
+// 音频波形的峰值文件
+// generate在工作线程中以最快速度解码音频流（其余流在解封装时丢弃，不重采样，只转换为
+// 交错float），第0级每桶BASE_FRAMES帧，之后每级合并LEVEL_FACTOR个桶，直到不足
+// MIN_BUCKETS个桶。结果写入缓存目录的peaks/<路径哈希>.peaks：定长文件头和级别表之后
+// 是各级的PeakBucket数组，按源文件大小和修改时间校验。open直接内存映射，无需解码
+class WaveformPeaks {
+public:
+    ~WaveformPeaks();
+
+    // 缓存中有与源文件匹配的峰值文件时映射并返回，否则返回nullptr
+    static std::unique_ptr<WaveformPeaks> open(const QString &mediaPath);
+
+    // 解码mediaPath的默认音频流并写入峰值文件，阻塞直到完成。cancel置位时尽快返回false；
+    // progress在解码过程中以0~1的进度调用（工作线程）
+    static bool generate(const QString &mediaPath, const std::atomic<bool> *cancel = nullptr,
+                         const std::function<void(double)> &progress = {});
+
+    int sampleRate() const { return m_sampleRate; }
+    double duration() const { return double(m_frames) / m_sampleRate; }
+
+    int levelCount() const { return int(m_levels.size()); }
+    int64_t framesPerBucket(int level) const { return m_levels[size_t(level)].framesPerBucket; }
+    int64_t bucketCount(int level) const { return m_levels[size_t(level)].count; }
+    const PeakBucket *buckets(int level) const { return m_levels[size_t(level)].data; }
+
+    static constexpr int BASE_FRAMES = 256;
+    static constexpr int LEVEL_FACTOR = 4;
+    static constexpr int MIN_BUCKETS = 256;
+
+private:
+    WaveformPeaks() = default;
+
+    static QString peakPath(const QString &mediaPath);
+
+    struct Level {
+        const PeakBucket *data;
+        int64_t count;
+        int64_t framesPerBucket;
+    };
+
+    QFile m_file;
+    int m_sampleRate{1};
+    int64_t m_frames{0};
+    std::vector<Level> m_levels;
+};
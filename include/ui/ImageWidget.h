@@ -1,11 +1,47 @@
 #pragma once
 
+#include <QPixmap>
+#include <QStringList>
 #include <QWidget>
 
+class ImagePrefetchCache;
+
 class ImageWidget : public QWidget {
 public:
     static ImageWidget *createImageWidget(QWidget *parent = nullptr);
 
-    explicit ImageWidget(QWidget *parent) : QWidget(parent) {}
-    virtual void loadImage(const QString &filePath) = 0;
-};
\ No newline at end of file
+    explicit ImageWidget(QWidget *parent);
+
+    // 打开图片，并以其所在目录作为浏览列表
+    void loadImage(const QString &filePath);
+
+    // 目录浏览
+    void showNextImage();
+    void showPreviousImage();
+    QString currentImage() const;
+
+    // 预取缓存设置
+    void setCacheMemoryLimit(qint64 bytes);
+    void setPrefetchRadius(int radius) { m_prefetchRadius = qMax(0, radius); }
+
+protected:
+    void keyPressEvent(QKeyEvent *event) override;
+
+    // 由子类负责显示已解码的图片
+    virtual void setPixmap(const QPixmap &pixmap) = 0;
+
+    // 当前图片无法解码时显示错误信息
+    virtual void showError(const QString &message) = 0;
+
+private:
+    void scanFolder(const QString &filePath);
+    void showImageAt(int index);
+    void prefetchNeighbors();
+    void onImageReady(const QString &filePath);
+    void onImageFailed(const QString &filePath);
+
+    ImagePrefetchCache *m_cache{nullptr};
+    QStringList m_files;
+    int m_currentIndex{-1};
+    int m_prefetchRadius{2};
+};
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <QtCore/QFileInfo>
+#include <QtGui/QActionGroup>
 #include <QtGui/QCloseEvent>
 #include <QtWidgets/QFileDialog>
 #include <QtWidgets/QMainWindow>
@@ -24,16 +25,33 @@ protected:
 
 private slots:
     void openFile();
+    void openUrl();
     void showAbout();
+    void exportTrace();
     void closeTab(int index);
+    void onCurrentTabChanged(int index);
+    void setPlaybackRate(double rate);
+    // direction: 1快进，-1快退，0恢复正常播放
+    void stepTrickPlay(int direction);
+    // direction: 1下一帧，-1上一帧
+    void stepFrame(int direction);
+    void cycleABLoop();
+    void selectTrack(int mediaType, int streamIndex);
 
 private:
     // 私有方法
     void setupUI();
     void setupMenus();
+    void openPlaylist(const QStringList &fileNames);
+    // 打开轨道菜单时按当前标签页的文件列出该类型（AVMediaType）的流
+    void updateTrackMenu(QMenu *menu, int mediaType);
 
     // UI组件
     QTabWidget *m_centralWidget;
+    QActionGroup *m_speedGroup{nullptr};
+
+    static constexpr double MIN_TRICK_SPEED = 8.0;
+    static constexpr double MAX_TRICK_SPEED = 64.0;
 
     // 状态
     bool m_isFullscreen;
@@ -1,11 +1,19 @@
 #pragma once
 
 #include "media/FFmpegStream.h"
+#include "media/LatencyController.h"
+#include <QElapsedTimer>
+#include <QStringList>
+#include <QThreadPool>
 #include <QTimer>
 #include <QWidget>
+#include <memory>
 
 // 前向声明
+class AdaptiveSession;
 class AudioPlayer;
+class Playlist;
+class WaveformWidget;
 
 class VideoWidget : public QWidget {
     Q_OBJECT
@@ -14,26 +22,78 @@ public:
     static VideoWidget *createVideoWidget(QWidget *parent = nullptr);
 
     explicit VideoWidget(QWidget *parent = nullptr)
-        : QWidget(parent), m_playTimer(this), m_audioTimer(this) {
+        : QWidget(parent), m_playTimer(this), m_audioTimer(this), m_stepTimer(this) {
         // 设置视频定时器
         m_playTimer.setTimerType(Qt::TimerType::PreciseTimer);
-        connect(&m_playTimer, &QTimer::timeout, this, &VideoWidget::updateFrame);
+        connect(&m_playTimer, &QTimer::timeout, this, &VideoWidget::onPlayTick);
+
+        // 预加载只需一个线程，避免与解码工作线程争抢
+        m_preloadPool.setMaxThreadCount(1);
 
         // 设置音频定时器（更高频率处理音频帧）
         m_audioTimer.setTimerType(Qt::TimerType::PreciseTimer);
         connect(&m_audioTimer, &QTimer::timeout, this, &VideoWidget::updateAudio);
+
+        // 逐帧后退未命中时等待解码填充缓存
+        m_stepTimer.setInterval(STEP_POLL_MS);
+        connect(&m_stepTimer, &QTimer::timeout, this, &VideoWidget::onStepTick);
     }
+    ~VideoWidget() override;
 
+    // .m3u8/.mpd地址按自适应流播放
     void loadVideo(const QString &filePath);
 
-protected:
-    void mousePressEvent(QMouseEvent *event) override {
+    // 按列表顺序播放，当前项播放时预先打开下一项，切换时音视频无间隙
+    void loadPlaylist(const QStringList &files);
+    Playlist *playlist() const { return m_playlist; }
+
+    // 循环播放（用于动图），需在loadVideo之前设置
+    void setLoopPlayback(bool loop) { m_videoStream->setLoopPlayback(loop); }
+
+    // 后台标签页挂起解码以释放线程和内存，切回前台时恢复
+    void setSuspended(bool suspended);
+
+    // 变速播放（0.5~3倍），音调不变；直播的速度由延迟控制决定，不受此设置影响
+    void setPlaybackRate(double rate);
+    double playbackRate() const { return m_rate; }
+
+    // 快进/快退（如±8~64倍）：只显示关键帧，静音；0恢复正常播放。到达结尾或开头时自动恢复
+    void setTrickPlay(double speed);
+    double trickSpeed() const { return m_videoStream->trickSpeed(); }
+
+    // 倒放（按播放速度），静音；到达开头后暂停
+    void setReversePlayback(bool reverse);
+    bool isReversePlayback() const { return m_videoStream->isReversePlayback(); }
+
+    // 逐帧：暂停并显示下一帧（1）或上一帧（-1）
+    void stepFrame(int direction);
+
+    // A-B循环：第一次在当前位置设置A点，第二次设置B点并开始循环，第三次取消
+    void cycleABLoop();
+    bool hasLoopStart() const { return m_loopStart >= 0.0; }
+    bool hasABLoop() const { return m_videoStream->hasABLoop(); }
+    double abLoopStart() const { return m_videoStream->abLoopStart(); }
+    double abLoopEnd() const { return m_videoStream->abLoopEnd(); }
+
+    // 切换音频/视频/字幕轨道，从当前位置继续播放（自适应流不支持）
+    std::vector<TrackInfo> tracks(AVMediaType type) const { return m_videoStream->tracks(type); }
+    int currentTrack(AVMediaType type) const { return m_videoStream->currentTrack(type); }
+    bool selectTrack(AVMediaType type, int streamIndex);
+
+    bool isPlaying() const { return m_isPlaying; }
+    void togglePlayback() {
         m_isPlaying = !m_isPlaying;
         if (m_isPlaying) {
             play();
         } else {
             pause();
         }
+    }
+
+protected:
+    void resizeEvent(QResizeEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override {
+        togglePlayback();
         return QWidget::mousePressEvent(event);
     }
 
@@ -41,6 +101,34 @@ private:
     virtual void showPreview() = 0;
     virtual void updateFrame() = 0;
     void updateAudio();
+    void onPlayTick();
+    void onStepTick();
+
+    // 主时钟：有音频时取音频时钟，否则按墙上时钟乘以播放速度推进
+    double masterClock();
+    double clockRate() const;  // 时钟走速，快退和倒放时为负
+    void resyncClock(double pts);
+    void updateTimerInterval();
+
+    // 直播：按显示的时间戳测量延迟，调整播放速度或丢帧
+    void initializeLiveControl();
+    void updateLatency(double presentedPts);
+
+    // 播放列表
+    void preloadNext();
+    void onNextOpened(int generation, bool ok);
+    // 为预加载的下一项准备音频重采样器和响度归一化
+    void prepareNextAudio();
+    void switchToNext();
+    void discardNext();
+
+    // 自适应流：每段run（同一档位的连续分片）对应一个FFmpegStream，档位切换复用预加载
+    void loadAdaptive(const QString &url);
+    bool openAdaptiveRun(FFmpegStream *stream, int rendition, int segment);
+    void preloadNextRun();
+    // 跳转：在预加载线程中打开目标分片的run，打开前保持上一帧画面，完成后替换当前run
+    void openSeekRun();
+    void onSeekOpened(int generation, bool ok);
 
     // 媒体控制
     void play();
@@ -51,18 +139,65 @@ private:
     // 播放控制
     QTimer m_playTimer;   // 视频帧定时器
     QTimer m_audioTimer;  // 音频帧定时器
+    QTimer m_stepTimer;   // 逐帧后退等待解码
     bool m_isPlaying{false};
+    bool m_resumePlaying{false};  // 挂起前是否在播放
 
     // 显示属性
     Qt::AspectRatioMode m_scaleMode{Qt::KeepAspectRatio};
     float m_zoomFactor{1.0f};
 
 protected:
-    FFmpegStream m_videoStream{};
+    std::unique_ptr<FFmpegStream> m_videoStream{std::make_unique<FFmpegStream>()};
     AudioPlayer *m_audioPlayer{nullptr};
-    double m_currentTime;
-    double m_duration;
+    double m_currentTime{0.0};
+    double m_duration{0.0};
 
 private:
     void initializeAudioPlayer();
+    // 纯音频的本地文件显示波形（覆盖整个区域），其余情况隐藏
+    void updateWaveform();
+
+    // 播放列表与预加载
+    Playlist *m_playlist{nullptr};
+    std::unique_ptr<FFmpegStream> m_nextStream;  // 预加载的下一项
+    int m_nextIndex{-1};                         // 下一项在列表中的位置
+    int m_preloadGeneration{0};                  // 丢弃预加载后使过期的回调失效
+    bool m_nextReady{false};                     // 下一项已打开并开始解码
+    bool m_audioOnNext{false};                   // 音频已先于视频切换到下一项
+
+    // 自适应流
+    std::shared_ptr<AdaptiveSession> m_adaptive;
+    int m_runRendition{0};      // 当前run的档位
+    int m_runSegment{0};        // 从此分片起查找下一段run
+    int m_nextRunRendition{0};  // 预加载的run
+    int m_nextRunSegment{0};
+    std::unique_ptr<FFmpegStream> m_seekStream;  // 跳转中正在打开的run
+    double m_seekTarget{0.0};                    // 最近一次请求的跳转时间
+    int m_seekRendition{0};
+    int m_seekSegment{0};
+    bool m_resumeSeek{false};                    // 挂起时放弃了跳转，恢复后重新发起
+
+    // 直播延迟控制
+    LatencyController m_latency;
+    bool m_senderClock{false};  // 按推流端墙上时钟测量端到端延迟
+    double m_liveRate{1.0};
+
+    // 变速播放与音画同步
+    double m_rate{1.0};
+    QElapsedTimer m_clockTimer;
+    double m_clockBase{0.0};      // m_clockTimer重新计时时的媒体时间
+    bool m_resyncPending{false};  // 跳转、切换、追帧后立即显示下一帧并重新对齐时钟
+    bool m_stepped{false};        // 逐帧后画面与已解码的音频不再对应，继续播放前重新定位
+    double m_loopStart{-1.0};     // 已设置、尚未生效的A点
+
+    WaveformWidget *m_waveform{nullptr};  // 首次打开纯音频文件时创建
+
+    static constexpr double RESYNC_THRESHOLD = 1.0;     // 与时钟相差超过1秒视为不连续
+    static constexpr double SKIP_NONREF_RATE = 1.5;     // 超过此速度跳过非参考帧
+    static constexpr double AUDIO_BUFFER_TARGET = 0.2;  // 送入音频设备的提前量（秒）
+    static constexpr int TRICK_TICK_MS = 20;            // 快进/快退时的检查间隔
+    static constexpr int STEP_POLL_MS = 10;             // 逐帧后退等待解码时的检查间隔
+
+    QThreadPool m_preloadPool;  // 最先析构，等待预加载任务结束
 };
@@ -0,0 +1,174 @@
+#include "core/Trace.h"
+#include <QDebug>
+#include <QFile>
+#include <QMutex>
+#include <QThread>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+std::atomic<bool> Trace::s_enabled{false};
+
+namespace {
+
+// 单生产者环形缓冲区：只有所属线程写入，导出线程只读
+// 写满后覆盖最旧的事件
+class ThreadBuffer {
+public:
+    static constexpr uint64_t CAPACITY = 1 << 16;
+
+    ThreadBuffer(int threadId, const QString &threadName)
+        : m_events(CAPACITY), m_threadId(threadId), m_threadName(threadName) {}
+
+    void push(const Trace::Event &event) {
+        uint64_t head = m_head.load(std::memory_order_relaxed);
+        m_events[head % CAPACITY] = event;
+        m_head.store(head + 1, std::memory_order_release);
+    }
+
+    // 复制当前可见的事件，丢弃复制期间可能被覆盖的部分
+    std::vector<Trace::Event> snapshot() const {
+        uint64_t head = m_head.load(std::memory_order_acquire);
+        uint64_t begin = std::max(m_tail.load(std::memory_order_relaxed),
+                                  head > CAPACITY ? head - CAPACITY : 0);
+
+        std::vector<Trace::Event> events;
+        events.reserve(size_t(head - begin));
+        for (uint64_t i = begin; i < head; ++i) {
+            events.push_back(m_events[i % CAPACITY]);
+        }
+
+        // 生产者可能正在写第headAfter个事件，它与第headAfter - CAPACITY个共用槽位
+        uint64_t headAfter = m_head.load(std::memory_order_acquire);
+        uint64_t firstValid = headAfter + 1 > CAPACITY ? headAfter + 1 - CAPACITY : 0;
+        if (firstValid > begin) {
+            uint64_t overwritten = std::min<uint64_t>(firstValid - begin, events.size());
+            events.erase(events.begin(), events.begin() + overwritten);
+        }
+        return events;
+    }
+
+    void clear() { m_tail.store(m_head.load(std::memory_order_acquire)); }
+
+    int threadId() const { return m_threadId; }
+    QString threadName() const { return m_threadName; }
+
+private:
+    std::vector<Trace::Event> m_events;
+    std::atomic<uint64_t> m_head{0};
+    std::atomic<uint64_t> m_tail{0};  // clear()之后的起点
+    int m_threadId;
+    QString m_threadName;
+};
+
+// 所有线程的缓冲区（线程退出后保留，直到进程结束，导出时仍可读取）
+struct BufferRegistry {
+    QMutex mutex;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+};
+
+BufferRegistry &registry() {
+    static BufferRegistry instance;
+    return instance;
+}
+
+ThreadBuffer &currentBuffer() {
+    thread_local std::shared_ptr<ThreadBuffer> buffer;
+    if (!buffer) {
+        QString name = QThread::currentThread() ? QThread::currentThread()->objectName()
+                                                : QString();
+        BufferRegistry &reg = registry();
+        QMutexLocker locker(&reg.mutex);
+        int threadId = int(reg.buffers.size()) + 1;
+        if (name.isEmpty()) name = QString("Thread-%1").arg(threadId);
+        buffer = std::make_shared<ThreadBuffer>(threadId, name);
+        reg.buffers.push_back(buffer);
+    }
+    return *buffer;
+}
+
+const std::chrono::steady_clock::time_point s_epoch = std::chrono::steady_clock::now();
+
+QByteArray escapeJson(const QString &text) {
+    QByteArray result;
+    for (QChar c : text) {
+        if (c == '"' || c == '\\') {
+            result += '\\';
+            result += char(c.unicode());
+        } else if (c.unicode() < 0x20) {
+            result += ' ';
+        } else {
+            result += QString(c).toUtf8();
+        }
+    }
+    return result;
+}
+
+}  // namespace
+
+void Trace::setEnabled(bool enabled) {
+    s_enabled.store(enabled, std::memory_order_relaxed);
+    qDebug() << "性能跟踪" << (enabled ? "已开启" : "已关闭");
+}
+
+int64_t Trace::now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() -
+                                                                s_epoch)
+        .count();
+}
+
+void Trace::record(const char *name, const char *category, int64_t startNs, int64_t durationNs) {
+    currentBuffer().push(Event{name, category, startNs, durationNs});
+}
+
+bool Trace::writeChromeTrace(const QString &filePath) {
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    {
+        QMutexLocker locker(&registry().mutex);
+        buffers = registry().buffers;
+    }
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qDebug() << "无法写入性能跟踪文件:" << filePath;
+        return false;
+    }
+
+    // Chrome trace_event格式，时间单位为微秒
+    file.write("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    bool first = true;
+    size_t eventCount = 0;
+    for (const auto &buffer : buffers) {
+        QByteArray line = QString("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%1,"
+                                  "\"args\":{\"name\":\"")
+                              .arg(buffer->threadId())
+                              .toUtf8() +
+                          escapeJson(buffer->threadName()) + "\"}}";
+        file.write(first ? line : ",\n" + line);
+        first = false;
+
+        for (const Event &event : buffer->snapshot()) {
+            file.write(QString(",\n{\"name\":\"%1\",\"cat\":\"%2\",\"ph\":\"X\",\"ts\":%3,"
+                               "\"dur\":%4,\"pid\":1,\"tid\":%5}")
+                           .arg(QLatin1String(event.name))
+                           .arg(QLatin1String(event.category))
+                           .arg(event.startNs / 1000.0, 0, 'f', 3)
+                           .arg(event.durationNs / 1000.0, 0, 'f', 3)
+                           .arg(buffer->threadId())
+                           .toUtf8());
+            ++eventCount;
+        }
+    }
+    file.write("\n]}\n");
+
+    qDebug() << "性能跟踪已导出:" << filePath << "事件数:" << eventCount;
+    return true;
+}
+
+void Trace::clear() {
+    QMutexLocker locker(&registry().mutex);
+    for (const auto &buffer : registry().buffers) {
+        buffer->clear();
+    }
+}
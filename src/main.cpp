@@ -7,6 +7,7 @@
 #include <QStyleFactory>
 #include <QTimer>
 
+#include "core/Trace.h"
 #include "ui/MainWindow.h"
 #include <QAction>
 #include <QLabel>
@@ -105,6 +106,14 @@ int main(int argc, char *argv[]) {
         // 初始化FFmpeg
         initializeFFmpeg();
 
+        // PLAYER_TRACE=<文件> 启动时即开始记录性能跟踪，退出时导出
+        QString traceFile = qEnvironmentVariable("PLAYER_TRACE");
+        if (!traceFile.isEmpty()) {
+            Trace::setEnabled(true);
+            QObject::connect(&app, &QCoreApplication::aboutToQuit,
+                             [traceFile]() { Trace::writeChromeTrace(traceFile); });
+        }
+
         // 创建并显示简单主窗口
         MainWindow window;
         window.show();
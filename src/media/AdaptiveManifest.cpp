@@ -0,0 +1,521 @@
+#include "media/AdaptiveManifest.h"
+#include <QDebug>
+#include <QHash>
+#include <QRegularExpression>
+#include <QUrl>
+#include <QXmlStreamReader>
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+extern "C" {
+#include <libavformat/avio.h>
+#include <libavutil/error.h>
+}
+
+namespace {
+
+// ============== HLS ==============
+
+// 解析属性列表：BANDWIDTH=1280000,RESOLUTION=1280x720,CODECS="avc1.4d401f,mp4a.40.2"
+QHash<QString, QString> parseAttributes(const QString &text) {
+    static const QRegularExpression pattern("([A-Z0-9-]+)=(\"[^\"]*\"|[^,]*)");
+    QHash<QString, QString> attributes;
+    auto it = pattern.globalMatch(text);
+    while (it.hasNext()) {
+        auto match = it.next();
+        QString value = match.captured(2);
+        if (value.startsWith('"')) value = value.mid(1, value.size() - 2);
+        attributes.insert(match.captured(1), value);
+    }
+    return attributes;
+}
+
+// BYTERANGE格式为 length[@offset]，省略offset时紧接上一个范围
+void parseByteRange(const QString &text, int64_t previousEnd, int64_t *offset, int64_t *length) {
+    int at = text.indexOf('@');
+    *length = text.left(at).toLongLong();
+    *offset = at >= 0 ? text.mid(at + 1).toLongLong() : previousEnd;
+}
+
+bool parseHlsMediaPlaylist(const QString &url, const QString &text, AdaptiveRendition *rendition,
+                           QString *error) {
+    double start = 0.0;
+    double segmentDuration = 0.0;
+    int64_t rangeOffset = 0;
+    int64_t rangeLength = -1;
+    int64_t previousEnd = 0;
+    bool ended = false;
+
+    const QStringList lines = text.split('\n');
+    for (QString line : lines) {
+        line = line.trimmed();
+        if (line.isEmpty()) continue;
+
+        if (line.startsWith("#EXTINF:")) {
+            segmentDuration = line.mid(8).section(',', 0, 0).toDouble();
+        } else if (line.startsWith("#EXT-X-BYTERANGE:")) {
+            parseByteRange(line.mid(17), previousEnd, &rangeOffset, &rangeLength);
+        } else if (line.startsWith("#EXT-X-MAP:")) {
+            auto attributes = parseAttributes(line.mid(11));
+            rendition->initUrl = AdaptiveManifest::resolveUrl(url, attributes.value("URI"));
+            if (attributes.contains("BYTERANGE")) {
+                parseByteRange(attributes.value("BYTERANGE"), 0, &rendition->initOffset,
+                               &rendition->initLength);
+            }
+        } else if (line.startsWith("#EXT-X-KEY:")) {
+            if (parseAttributes(line.mid(11)).value("METHOD") != "NONE") {
+                *error = "不支持加密的HLS流";
+                return false;
+            }
+        } else if (line.startsWith("#EXT-X-ENDLIST")) {
+            ended = true;
+        } else if (!line.startsWith('#')) {
+            AdaptiveSegment segment;
+            segment.url = AdaptiveManifest::resolveUrl(url, line);
+            segment.start = start;
+            segment.duration = segmentDuration;
+            if (rangeLength >= 0) {
+                segment.offset = rangeOffset;
+                segment.length = rangeLength;
+                previousEnd = rangeOffset + rangeLength;
+            }
+            rendition->segments.append(segment);
+
+            start += segmentDuration;
+            segmentDuration = 0.0;
+            rangeLength = -1;
+        }
+    }
+
+    if (!ended) {
+        *error = "不支持直播HLS（缺少EXT-X-ENDLIST）";
+        return false;
+    }
+    if (rendition->segments.isEmpty()) {
+        *error = "媒体清单中没有分片";
+        return false;
+    }
+    return true;
+}
+
+bool parseHls(const QString &url, const QString &text, AdaptiveManifest *manifest,
+              QString *error) {
+    if (!text.startsWith("#EXTM3U")) {
+        *error = "不是有效的M3U8清单";
+        return false;
+    }
+
+    // 媒体清单：只有一个档位
+    if (!text.contains("#EXT-X-STREAM-INF")) {
+        AdaptiveRendition rendition;
+        if (!parseHlsMediaPlaylist(url, text, &rendition, error)) return false;
+        manifest->renditions.append(rendition);
+        return true;
+    }
+
+    // 主清单：STREAM-INF的下一行是档位的媒体清单地址
+    QHash<QString, QString> pending;
+    bool hasPending = false;
+    const QStringList lines = text.split('\n');
+    for (QString line : lines) {
+        line = line.trimmed();
+        if (line.startsWith("#EXT-X-STREAM-INF:")) {
+            pending = parseAttributes(line.mid(18));
+            hasPending = true;
+        } else if (hasPending && !line.isEmpty() && !line.startsWith('#')) {
+            hasPending = false;
+            QString playlistUrl = AdaptiveManifest::resolveUrl(url, line);
+            QByteArray data;
+            if (!AdaptiveManifest::fetch(playlistUrl, 0, -1, &data)) {
+                qDebug() << "无法读取媒体清单，跳过该档位:" << playlistUrl;
+                continue;
+            }
+
+            AdaptiveRendition rendition;
+            rendition.id = QString::number(manifest->renditions.size());
+            rendition.bandwidth = pending.value("BANDWIDTH").toLongLong();
+            QStringList resolution = pending.value("RESOLUTION").split('x');
+            if (resolution.size() == 2) {
+                rendition.width = resolution[0].toInt();
+                rendition.height = resolution[1].toInt();
+            }
+            rendition.codecs = pending.value("CODECS");
+
+            QString playlistError;
+            if (!parseHlsMediaPlaylist(playlistUrl, QString::fromUtf8(data), &rendition,
+                                       &playlistError)) {
+                qDebug() << "媒体清单解析失败，跳过该档位:" << playlistUrl << playlistError;
+                continue;
+            }
+            manifest->renditions.append(rendition);
+        }
+    }
+
+    if (manifest->renditions.isEmpty()) {
+        *error = "主清单中没有可用的档位";
+        return false;
+    }
+    return true;
+}
+
+// ============== DASH ==============
+
+struct XmlNode {
+    QString name;
+    QHash<QString, QString> attributes;
+    QString text;
+    std::vector<std::unique_ptr<XmlNode>> children;
+
+    const XmlNode *child(const QString &childName) const {
+        for (const auto &node : children) {
+            if (node->name == childName) return node.get();
+        }
+        return nullptr;
+    }
+
+    QString attribute(const QString &key, const QString &fallback = QString()) const {
+        return attributes.value(key, fallback);
+    }
+};
+
+std::unique_ptr<XmlNode> parseXml(const QByteArray &data, QString *error) {
+    QXmlStreamReader reader(data);
+    std::unique_ptr<XmlNode> root;
+    std::vector<XmlNode *> stack;
+
+    while (!reader.atEnd()) {
+        reader.readNext();
+        if (reader.isStartElement()) {
+            auto node = std::make_unique<XmlNode>();
+            node->name = reader.name().toString();
+            for (const auto &attribute : reader.attributes()) {
+                node->attributes.insert(attribute.name().toString(), attribute.value().toString());
+            }
+            XmlNode *raw = node.get();
+            if (stack.empty()) {
+                root = std::move(node);
+            } else {
+                stack.back()->children.push_back(std::move(node));
+            }
+            stack.push_back(raw);
+        } else if (reader.isEndElement()) {
+            if (!stack.empty()) stack.pop_back();
+        } else if (reader.isCharacters() && !stack.empty()) {
+            stack.back()->text += reader.text().toString().trimmed();
+        }
+    }
+
+    if (reader.hasError() || !root) {
+        *error = QString("MPD解析失败: %1").arg(reader.errorString());
+        return nullptr;
+    }
+    return root;
+}
+
+// ISO 8601时长，例如PT1H2M3.5S
+double parseDuration(const QString &text) {
+    static const QRegularExpression pattern(
+        "P(?:(\\d+)D)?(?:T(?:(\\d+)H)?(?:(\\d+)M)?(?:([\\d.]+)S)?)?");
+    auto match = pattern.match(text);
+    if (!match.hasMatch()) return 0.0;
+    return match.captured(1).toDouble() * 86400 + match.captured(2).toDouble() * 3600 +
+           match.captured(3).toDouble() * 60 + match.captured(4).toDouble();
+}
+
+// 替换SegmentTemplate中的$RepresentationID$、$Number%05d$、$Time$、$Bandwidth$
+QString expandTemplate(const QString &pattern, const AdaptiveRendition &rendition, int64_t number,
+                       int64_t time) {
+    static const QRegularExpression identifier("\\$(RepresentationID|Number|Time|Bandwidth)"
+                                               "(?:%0(\\d+)d)?\\$");
+    QString result;
+    int last = 0;
+    auto it = identifier.globalMatch(pattern);
+    while (it.hasNext()) {
+        auto match = it.next();
+        result += pattern.mid(last, match.capturedStart() - last);
+        last = match.capturedEnd();
+
+        const QString name = match.captured(1);
+        if (name == "RepresentationID") {
+            result += rendition.id;
+            continue;
+        }
+        int64_t value = name == "Number" ? number : name == "Time" ? time : rendition.bandwidth;
+        int width = match.captured(2).toInt();
+        result += QString("%1").arg(value, width, 10, QChar('0'));
+    }
+    result += pattern.mid(last);
+    return result.replace("$$", "$");
+}
+
+// mediaRange/range属性，格式为first-last（闭区间）
+void parseRange(const QString &text, int64_t *offset, int64_t *length) {
+    int dash = text.indexOf('-');
+    if (dash < 0) return;
+    *offset = text.left(dash).toLongLong();
+    *length = text.mid(dash + 1).toLongLong() - *offset + 1;
+}
+
+bool isVideoSet(const XmlNode &set) {
+    QString type = set.attribute("contentType") + set.attribute("mimeType");
+    if (type.contains("video")) return true;
+    if (const XmlNode *representation = set.child("Representation")) {
+        return representation->attribute("mimeType").contains("video") ||
+               representation->attribute("width").toInt() > 0;
+    }
+    return false;
+}
+
+bool parseDash(const QString &url, const QByteArray &data, AdaptiveManifest *manifest,
+               QString *error) {
+    std::unique_ptr<XmlNode> mpd = parseXml(data, error);
+    if (!mpd) return false;
+    if (mpd->name != "MPD") {
+        *error = "不是有效的MPD清单";
+        return false;
+    }
+    if (mpd->attribute("type", "static") != "static") {
+        *error = "不支持直播DASH";
+        return false;
+    }
+
+    const XmlNode *period = mpd->child("Period");
+    if (!period) {
+        *error = "MPD中没有Period";
+        return false;
+    }
+
+    double totalDuration = parseDuration(mpd->attribute("mediaPresentationDuration"));
+    if (totalDuration <= 0) totalDuration = parseDuration(period->attribute("duration"));
+
+    // BaseURL逐级解析：MPD -> Period -> AdaptationSet -> Representation
+    QString base = url;
+    for (const XmlNode *level : {mpd.get(), period}) {
+        if (const XmlNode *node = level->child("BaseURL")) {
+            base = AdaptiveManifest::resolveUrl(base, node->text);
+        }
+    }
+
+    // 选择视频AdaptationSet，没有时使用第一个（音视频混合）
+    const XmlNode *adaptationSet = nullptr;
+    for (const auto &node : period->children) {
+        if (node->name != "AdaptationSet") continue;
+        if (!adaptationSet) adaptationSet = node.get();
+        if (isVideoSet(*node)) {
+            adaptationSet = node.get();
+            break;
+        }
+    }
+    if (!adaptationSet) {
+        *error = "MPD中没有AdaptationSet";
+        return false;
+    }
+    if (const XmlNode *node = adaptationSet->child("BaseURL")) {
+        base = AdaptiveManifest::resolveUrl(base, node->text);
+    }
+
+    for (const auto &node : adaptationSet->children) {
+        if (node->name != "Representation") continue;
+        const XmlNode &representation = *node;
+
+        AdaptiveRendition rendition;
+        rendition.id = representation.attribute("id");
+        rendition.bandwidth = representation.attribute("bandwidth").toLongLong();
+        rendition.width = representation.attribute("width").toInt();
+        rendition.height = representation.attribute("height").toInt();
+        rendition.codecs = representation.attribute("codecs", adaptationSet->attribute("codecs"));
+
+        QString representationBase = base;
+        if (const XmlNode *baseNode = representation.child("BaseURL")) {
+            representationBase = AdaptiveManifest::resolveUrl(base, baseNode->text);
+        }
+
+        const XmlNode *segmentTemplate = representation.child("SegmentTemplate");
+        if (!segmentTemplate) segmentTemplate = adaptationSet->child("SegmentTemplate");
+        const XmlNode *segmentList = representation.child("SegmentList");
+
+        if (segmentTemplate) {
+            const double timescale = segmentTemplate->attribute("timescale", "1").toDouble();
+            const int64_t startNumber = segmentTemplate->attribute("startNumber", "1").toLongLong();
+            QString initialization = segmentTemplate->attribute("initialization");
+            if (!initialization.isEmpty()) {
+                rendition.initUrl = AdaptiveManifest::resolveUrl(
+                    representationBase, expandTemplate(initialization, rendition, 0, 0));
+            }
+            const QString media = segmentTemplate->attribute("media");
+
+            auto addSegment = [&](int64_t number, int64_t time, int64_t duration) {
+                AdaptiveSegment segment;
+                segment.url = AdaptiveManifest::resolveUrl(
+                    representationBase, expandTemplate(media, rendition, number, time));
+                segment.start = time / timescale;
+                segment.duration = duration / timescale;
+                rendition.segments.append(segment);
+            };
+
+            if (const XmlNode *timeline = segmentTemplate->child("SegmentTimeline")) {
+                int64_t number = startNumber;
+                int64_t time = 0;
+                const int64_t end = int64_t(totalDuration * timescale);
+                for (const auto &s : timeline->children) {
+                    if (s->name != "S") continue;
+                    if (s->attributes.contains("t")) time = s->attribute("t").toLongLong();
+                    const int64_t d = s->attribute("d").toLongLong();
+                    int64_t repeat = s->attribute("r", "0").toLongLong();
+                    if (d <= 0) continue;
+                    if (repeat < 0) repeat = std::max<int64_t>((end - time + d - 1) / d - 1, 0);
+                    for (int64_t i = 0; i <= repeat; ++i) {
+                        addSegment(number++, time, d);
+                        time += d;
+                    }
+                }
+            } else {
+                const int64_t duration = segmentTemplate->attribute("duration").toLongLong();
+                if (duration <= 0 || totalDuration <= 0) {
+                    *error = "SegmentTemplate缺少duration";
+                    return false;
+                }
+                const int64_t count = int64_t(std::ceil(totalDuration * timescale / duration));
+                for (int64_t i = 0; i < count; ++i) {
+                    addSegment(startNumber + i, i * duration, duration);
+                }
+            }
+        } else if (segmentList) {
+            const double timescale = segmentList->attribute("timescale", "1").toDouble();
+            const double duration = segmentList->attribute("duration").toDouble() / timescale;
+            if (const XmlNode *init = segmentList->child("Initialization")) {
+                rendition.initUrl = AdaptiveManifest::resolveUrl(
+                    representationBase, init->attribute("sourceURL"));
+                parseRange(init->attribute("range"), &rendition.initOffset, &rendition.initLength);
+                if (init->attribute("sourceURL").isEmpty()) rendition.initUrl = representationBase;
+            }
+            double start = 0.0;
+            for (const auto &child : segmentList->children) {
+                if (child->name != "SegmentURL") continue;
+                AdaptiveSegment segment;
+                QString media = child->attribute("media");
+                segment.url = media.isEmpty()
+                                  ? representationBase
+                                  : AdaptiveManifest::resolveUrl(representationBase, media);
+                parseRange(child->attribute("mediaRange"), &segment.offset, &segment.length);
+                segment.start = start;
+                segment.duration = duration;
+                rendition.segments.append(segment);
+                start += duration;
+            }
+        } else {
+            // SegmentBase或单个文件：整个文件作为一个分片
+            AdaptiveSegment segment;
+            segment.url = representationBase;
+            segment.duration = totalDuration;
+            rendition.segments.append(segment);
+        }
+
+        if (!rendition.segments.isEmpty()) {
+            manifest->renditions.append(rendition);
+        }
+    }
+
+    if (manifest->renditions.isEmpty()) {
+        *error = "MPD中没有可用的Representation";
+        return false;
+    }
+    manifest->duration = totalDuration;
+    return true;
+}
+
+}  // namespace
+
+bool AdaptiveManifest::isManifestUrl(const QString &url) {
+    QString path = url.section('?', 0, 0).toLower();
+    return path.endsWith(".m3u8") || path.endsWith(".mpd");
+}
+
+bool AdaptiveManifest::load(const QString &url, AdaptiveManifest *manifest, QString *error) {
+    QByteArray data;
+    if (!fetch(url, 0, -1, &data)) {
+        *error = QString("无法读取清单: %1").arg(url);
+        return false;
+    }
+
+    *manifest = AdaptiveManifest();
+    manifest->url = url;
+
+    bool ok;
+    if (data.trimmed().startsWith("#EXTM3U")) {
+        manifest->type = Type::Hls;
+        ok = parseHls(url, QString::fromUtf8(data), manifest, error);
+    } else {
+        manifest->type = Type::Dash;
+        ok = parseDash(url, data, manifest, error);
+    }
+    if (!ok) return false;
+
+    std::sort(manifest->renditions.begin(), manifest->renditions.end(),
+              [](const AdaptiveRendition &a, const AdaptiveRendition &b) {
+                  return a.bandwidth < b.bandwidth;
+              });
+
+    // 各档位分片数不同时无法在分片边界切换，只保留与最低档位一致的档位
+    const int count = manifest->renditions[0].segments.size();
+    manifest->renditions.erase(
+        std::remove_if(manifest->renditions.begin(), manifest->renditions.end(),
+                       [count](const AdaptiveRendition &r) { return r.segments.size() != count; }),
+        manifest->renditions.end());
+
+    if (manifest->duration <= 0) {
+        const AdaptiveSegment &last = manifest->renditions[0].segments.last();
+        manifest->duration = last.start + last.duration;
+    }
+
+    qDebug() << "自适应流:" << (manifest->type == Type::Hls ? "HLS" : "DASH") << "档位"
+             << manifest->renditions.size() << "分片" << count << "时长" << manifest->duration;
+    return true;
+}
+
+bool AdaptiveManifest::fetch(const QString &url, int64_t offset, int64_t length, QByteArray *data,
+                             const std::atomic<bool> *abort) {
+    AVIOInterruptCB interrupt{
+        [](void *opaque) -> int {
+            auto *flag = static_cast<const std::atomic<bool> *>(opaque);
+            return flag && flag->load() ? 1 : 0;
+        },
+        const_cast<std::atomic<bool> *>(abort)};
+
+    AVIOContext *context = nullptr;
+    if (avio_open2(&context, url.toUtf8().constData(), AVIO_FLAG_READ, &interrupt, nullptr) < 0) {
+        return false;
+    }
+    if (offset > 0 && avio_seek(context, offset, SEEK_SET) < 0) {
+        avio_closep(&context);
+        return false;
+    }
+
+    data->clear();
+    if (length >= 0) data->reserve(int(length));
+    char buffer[64 * 1024];
+    while (length < 0 || data->size() < length) {
+        int toRead = length < 0 ? int(sizeof(buffer))
+                                : int(std::min<int64_t>(sizeof(buffer), length - data->size()));
+        int n = avio_read(context, reinterpret_cast<unsigned char *>(buffer), toRead);
+        if (n == AVERROR_EOF || n == 0) break;
+        if (n < 0) {
+            avio_closep(&context);
+            return false;
+        }
+        data->append(buffer, n);
+    }
+    avio_closep(&context);
+    return length < 0 || data->size() == length;
+}
+
+QString AdaptiveManifest::resolveUrl(const QString &base, const QString &reference) {
+    const QUrl referenceUrl(reference);
+    if (!referenceUrl.isRelative()) return reference;
+
+    QUrl baseUrl = base.contains("://") ? QUrl(base) : QUrl::fromLocalFile(base);
+    QUrl resolved = baseUrl.resolved(referenceUrl);
+    return resolved.isLocalFile() ? resolved.toLocalFile() : resolved.toString();
+}
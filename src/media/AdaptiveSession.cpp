@@ -0,0 +1,338 @@
+#include "media/AdaptiveSession.h"
+#include <QDebug>
+#include <QElapsedTimer>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+extern "C" {
+#include <libavutil/error.h>
+}
+
+AdaptiveSession::~AdaptiveSession() {
+    abort();
+    m_pool.waitForDone();
+}
+
+std::shared_ptr<AdaptiveSession> AdaptiveSession::open(const QString &url, QString *error) {
+    std::shared_ptr<AdaptiveSession> session(new AdaptiveSession());
+    if (!AdaptiveManifest::load(url, &session->m_manifest, error)) {
+        return nullptr;
+    }
+    // 从最低档位起播，首个分片最快到达，之后由码率控制升档；下载从restartAt开始
+    session->m_pool.setMaxThreadCount(MAX_PARALLEL_DOWNLOADS);
+    return session;
+}
+
+int AdaptiveSession::segmentAt(double seconds) const {
+    const auto &segments = m_manifest.renditions[0].segments;
+    for (int i = 0; i < segments.size(); ++i) {
+        if (seconds < segments[i].start + segments[i].duration) return i;
+    }
+    return int(segments.size()) - 1;
+}
+
+std::unique_ptr<MediaIO> AdaptiveSession::createIO(int rendition, int firstSegment) {
+    return std::make_unique<AdaptiveIO>(shared_from_this(), rendition, firstSegment);
+}
+
+QString AdaptiveSession::runName(int rendition, int firstSegment) const {
+    const AdaptiveRendition &r = m_manifest.renditions[rendition];
+    // 地址用于探测格式（按分片扩展名），后缀仅用于日志
+    return QString("%1#rendition=%2x%3@%4,segment=%5")
+        .arg(r.segments[firstSegment].url.section('?', 0, 0))
+        .arg(r.width)
+        .arg(r.height)
+        .arg(r.bandwidth)
+        .arg(firstSegment);
+}
+
+bool AdaptiveSession::findSwitch(int rendition, int fromSegment, int *nextRendition,
+                                 int *segment) const {
+    QMutexLocker locker(&m_mutex);
+    for (auto it = m_segments.lower_bound(fromSegment); it != m_segments.end(); ++it) {
+        if (it->second.rendition != rendition) {
+            *nextRendition = it->second.rendition;
+            *segment = it->first;
+            return true;
+        }
+    }
+    return false;
+}
+
+int AdaptiveSession::restartAt(int segment) {
+    QMutexLocker locker(&m_mutex);
+    segment = std::clamp(segment, 0, segmentCount() - 1);
+    ++m_epoch;
+    m_segments.clear();
+    m_nextDownload = segment;
+    m_lastSwitchSegment = segment;
+    pump();
+    m_segmentReady.wakeAll();
+
+    // pump为起始分片选定的档位（已中止时没有提交下载）
+    auto it = m_segments.find(segment);
+    return it != m_segments.end() ? it->second.rendition : m_rendition;
+}
+
+AdaptiveSession::Stats AdaptiveSession::stats() const {
+    QMutexLocker locker(&m_mutex);
+    Stats stats;
+    stats.rendition = m_rendition;
+    stats.switches = m_switches;
+    stats.bufferSeconds = bufferedSeconds(true);
+    stats.throughputBps = m_throughputBps;
+    stats.downloading = m_downloading;
+    return stats;
+}
+
+void AdaptiveSession::abort() {
+    m_aborted = true;
+    QMutexLocker locker(&m_mutex);
+    m_segmentReady.wakeAll();
+}
+
+AdaptiveSession::SegmentStatus AdaptiveSession::waitSegment(int index, int rendition,
+                                                            QByteArray *data,
+                                                            const std::atomic<bool> &aborted) {
+    QMutexLocker locker(&m_mutex);
+    pump();
+    for (;;) {
+        if (m_aborted || aborted) return SegmentStatus::Aborted;
+
+        auto it = m_segments.find(index);
+        if (it != m_segments.end()) {
+            const Entry &entry = it->second;
+            if (entry.rendition != rendition) return SegmentStatus::OtherRendition;
+            if (entry.failed) return SegmentStatus::Failed;
+            if (entry.done) {
+                *data = entry.data;
+                return SegmentStatus::Ready;
+            }
+        }
+        m_segmentReady.wait(&m_mutex, 100);
+    }
+}
+
+QByteArray AdaptiveSession::initSegment(int rendition) {
+    const AdaptiveRendition &r = m_manifest.renditions[rendition];
+    if (r.initUrl.isEmpty()) return QByteArray();
+
+    {
+        QMutexLocker locker(&m_mutex);
+        auto it = m_initSegments.constFind(rendition);
+        if (it != m_initSegments.constEnd()) return it.value();
+    }
+
+    // 初始化分片很小，直接在读取线程中下载
+    QByteArray data;
+    if (!AdaptiveManifest::fetch(r.initUrl, r.initOffset, r.initLength, &data, &m_aborted)) {
+        qDebug() << "初始化分片下载失败:" << r.initUrl;
+        return QByteArray();
+    }
+    QMutexLocker locker(&m_mutex);
+    m_initSegments.insert(rendition, data);
+    return data;
+}
+
+void AdaptiveSession::setReaderPosition(const void *reader, int segment) {
+    QMutexLocker locker(&m_mutex);
+    m_readers[reader] = segment;
+
+    // 所有读取者都已越过的分片不再需要
+    const int first = firstNeededSegment();
+    m_segments.erase(m_segments.begin(), m_segments.lower_bound(first));
+    pump();
+}
+
+void AdaptiveSession::removeReader(const void *reader) {
+    QMutexLocker locker(&m_mutex);
+    m_readers.erase(reader);
+}
+
+int AdaptiveSession::firstNeededSegment() const {
+    if (m_readers.empty()) {
+        return m_segments.empty() ? m_nextDownload : m_segments.begin()->first;
+    }
+    int first = m_readers.begin()->second;
+    for (const auto &reader : m_readers) {
+        first = std::min(first, reader.second);
+    }
+    return first;
+}
+
+double AdaptiveSession::bufferedSeconds(bool completedOnly) const {
+    const auto &segments = m_manifest.renditions[0].segments;
+    double seconds = 0.0;
+    for (auto it = m_segments.lower_bound(firstNeededSegment()); it != m_segments.end(); ++it) {
+        if (completedOnly && !it->second.done) break;
+        seconds += segments[it->first].duration;
+    }
+    return seconds;
+}
+
+void AdaptiveSession::pump() {
+    if (m_aborted) return;
+
+    while (m_downloading < MAX_PARALLEL_DOWNLOADS && m_nextDownload < segmentCount() &&
+           bufferedSeconds(false) < MAX_BUFFER_SECONDS) {
+        const int index = m_nextDownload++;
+        const int rendition = chooseRendition(bufferedSeconds(true));
+
+        Entry &entry = m_segments[index];
+        entry.rendition = rendition;
+        ++m_downloading;
+        const int epoch = m_epoch;
+        m_pool.start([this, index, rendition, epoch] { download(index, rendition, epoch); });
+    }
+}
+
+int AdaptiveSession::chooseRendition(double bufferSeconds) {
+    const auto &renditions = m_manifest.renditions;
+    const int segment = m_nextDownload - 1;
+    int choice = m_rendition;
+
+    if (m_throughputBps > 0) {
+        if (bufferSeconds < LOW_BUFFER_SECONDS) {
+            // 缓冲不足：降到吞吐量七成以内的最高档位
+            while (choice > 0 && renditions[choice].bandwidth > m_throughputBps * 0.7) {
+                --choice;
+            }
+        } else if (bufferSeconds > HIGH_BUFFER_SECONDS && choice + 1 < renditions.size() &&
+                   segment - m_lastSwitchSegment >= 3 &&
+                   renditions[choice + 1].bandwidth < m_throughputBps * 0.8) {
+            // 缓冲充足且吞吐量有余量：升一档，两次切换之间至少间隔3个分片
+            ++choice;
+        }
+    }
+
+    if (choice != m_rendition) {
+        qDebug() << "自适应码率切换:" << renditions[m_rendition].bandwidth << "->"
+                 << renditions[choice].bandwidth << "缓冲" << bufferSeconds << "秒"
+                 << "吞吐量" << m_throughputBps;
+        m_rendition = choice;
+        m_lastSwitchSegment = segment;
+        ++m_switches;
+    }
+    return choice;
+}
+
+void AdaptiveSession::download(int index, int rendition, int epoch) {
+    const AdaptiveSegment &segment = m_manifest.renditions[rendition].segments[index];
+    QElapsedTimer timer;
+    timer.start();
+    QByteArray data;
+    bool ok = AdaptiveManifest::fetch(segment.url, segment.offset, segment.length, &data,
+                                      &m_aborted);
+    const qint64 elapsedNs = timer.nsecsElapsed();
+
+    QMutexLocker locker(&m_mutex);
+    --m_downloading;
+
+    // 下载期间发生了跳转，结果作废
+    auto it = m_segments.find(index);
+    if (epoch != m_epoch || it == m_segments.end() || it->second.rendition != rendition) {
+        pump();
+        return;
+    }
+
+    Entry &entry = it->second;
+    if (ok && !data.isEmpty()) {
+        entry.data = data;
+        entry.done = true;
+
+        // 吞吐量取指数加权平均，忽略太小的分片（主要是连接延迟）
+        if (elapsedNs > 0 && data.size() > 64 * 1024) {
+            double bps = data.size() * 8.0 / (elapsedNs / 1e9);
+            m_throughputBps = m_throughputBps > 0 ? m_throughputBps * 0.7 + bps * 0.3 : bps;
+        }
+    } else if (!m_aborted) {
+        qDebug() << "分片下载失败:" << segment.url << "第" << entry.attempts + 1 << "次";
+        if (++entry.attempts < MAX_ATTEMPTS) {
+            // 以最低档位重试，档位改变时当前run在此结束，由下一段run接续
+            entry.rendition = 0;
+            ++m_downloading;
+            m_pool.start([this, index, epoch] { download(index, 0, epoch); });
+        } else {
+            entry.failed = true;
+        }
+    }
+
+    m_segmentReady.wakeAll();
+    pump();
+}
+
+// ============== AdaptiveIO ==============
+
+AdaptiveIO::AdaptiveIO(std::shared_ptr<AdaptiveSession> session, int rendition, int firstSegment)
+    : m_session(std::move(session)), m_rendition(rendition), m_nextSegment(firstSegment) {
+    m_session->setReaderPosition(this, firstSegment);
+}
+
+AdaptiveIO::~AdaptiveIO() { m_session->removeReader(this); }
+
+int AdaptiveIO::read(uint8_t *buffer, int size) {
+    while (m_currentOffset >= m_current.size()) {
+        if (!m_initRead) {
+            m_initRead = true;
+            m_current = m_session->initSegment(m_rendition);
+            m_currentOffset = 0;
+            continue;
+        }
+
+        if (m_nextSegment >= m_session->segmentCount()) {
+            return AVERROR_EOF;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        QByteArray data;
+        auto status = m_session->waitSegment(m_nextSegment, m_rendition, &data, m_aborted);
+        int64_t waitNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+        if (waitNs > 1000000) {
+            m_waits.fetch_add(1, std::memory_order_relaxed);
+            m_waitNs.fetch_add(waitNs, std::memory_order_relaxed);
+            if (waitNs > m_maxWaitNs.load(std::memory_order_relaxed)) {
+                m_maxWaitNs.store(waitNs, std::memory_order_relaxed);
+            }
+        }
+
+        switch (status) {
+        case AdaptiveSession::SegmentStatus::Ready: break;
+        case AdaptiveSession::SegmentStatus::OtherRendition: return AVERROR_EOF;  // 本段run结束
+        case AdaptiveSession::SegmentStatus::Failed: return AVERROR(EIO);
+        case AdaptiveSession::SegmentStatus::Aborted: return AVERROR_EXIT;
+        }
+
+        m_session->setReaderPosition(this, m_nextSegment);
+        ++m_nextSegment;
+        m_current = data;
+        m_currentOffset = 0;
+    }
+
+    int bytes = std::min(size, m_current.size() - m_currentOffset);
+    memcpy(buffer, m_current.constData() + m_currentOffset, size_t(bytes));
+    m_currentOffset += bytes;
+    m_position += bytes;
+    m_bytesRead.fetch_add(bytes, std::memory_order_relaxed);
+    return bytes;
+}
+
+int64_t AdaptiveIO::seek(int64_t offset) {
+    // 分片流只能顺序读取，时间跳转由AdaptiveSession::restartAt重新打开
+    return offset == m_position ? m_position : AVERROR(ENOSYS);
+}
+
+MediaIO::Stats AdaptiveIO::stats() const {
+    Stats stats;
+    stats.backend = m_session->manifest().type == AdaptiveManifest::Type::Hls ? "hls" : "dash";
+    AdaptiveSession::Stats session = m_session->stats();
+    stats.readAheadDepth = int(session.bufferSeconds);
+    stats.readAheadQueued = session.downloading;
+    stats.bytesRead = m_bytesRead.load(std::memory_order_relaxed);
+    stats.waits = m_waits.load(std::memory_order_relaxed);
+    stats.waitMs = m_waitNs.load(std::memory_order_relaxed) / 1e6;
+    stats.maxWaitMs = m_maxWaitNs.load(std::memory_order_relaxed) / 1e6;
+    return stats;
+}
@@ -0,0 +1,96 @@
+#include "media/AudioBuffer.h"
+#include "core/Trace.h"
+#include <cstring>
+
+AudioBuffer::AudioBuffer(QObject *parent) : QIODevice(parent), m_currentPos(0) {
+    open(QIODevice::ReadWrite);
+}
+
+void AudioBuffer::writeData(const QByteArray &data) {
+    QMutexLocker locker(&m_mutex);
+    m_bufferQueue.push(data);
+    m_bufferedBytes += data.size();
+}
+
+void AudioBuffer::clear() {
+    QMutexLocker locker(&m_mutex);
+    while (!m_bufferQueue.empty()) {
+        m_bufferQueue.pop();
+    }
+    m_currentBuffer.clear();
+    m_currentPos = 0;
+    m_bufferedBytes = 0;
+}
+
+QByteArray AudioBuffer::take(qint64 maxBytes) {
+    QMutexLocker locker(&m_mutex);
+    if (maxBytes < 0 || maxBytes > m_bufferedBytes) {
+        maxBytes = m_bufferedBytes;
+    }
+
+    QByteArray result;
+    result.reserve(maxBytes);
+    while (result.size() < maxBytes) {
+        if (m_currentPos >= m_currentBuffer.size()) {
+            if (m_bufferQueue.empty()) {
+                break;
+            }
+            m_currentBuffer = m_bufferQueue.front();
+            m_bufferQueue.pop();
+            m_currentPos = 0;
+        }
+        qint64 remainingInBuffer = m_currentBuffer.size() - m_currentPos;
+        qint64 toTake = qMin(maxBytes - result.size(), remainingInBuffer);
+        result.append(m_currentBuffer.constData() + m_currentPos, toTake);
+        m_currentPos += toTake;
+    }
+    m_bufferedBytes -= result.size();
+    return result;
+}
+
+bool AudioBuffer::isEmpty() const {
+    QMutexLocker locker(&m_mutex);
+    return m_bufferQueue.empty() && (m_currentPos >= m_currentBuffer.size());
+}
+
+qint64 AudioBuffer::bufferedBytes() const {
+    QMutexLocker locker(&m_mutex);
+    return m_bufferedBytes;
+}
+
+qint64 AudioBuffer::readData(char *data, qint64 maxlen) {
+    TRACE_SCOPE("AudioBuffer::readData", "audio");
+    QMutexLocker locker(&m_mutex);
+
+    qint64 totalRead = 0;
+
+    while (totalRead < maxlen) {
+        // If current buffer is exhausted, get next one from queue
+        if (m_currentPos >= m_currentBuffer.size()) {
+            if (m_bufferQueue.empty()) {
+                break;  // No more data available
+            }
+            m_currentBuffer = m_bufferQueue.front();
+            m_bufferQueue.pop();
+            m_currentPos = 0;
+        }
+
+        // Calculate how much we can read from current buffer
+        qint64 remainingInBuffer = m_currentBuffer.size() - m_currentPos;
+        qint64 toRead = qMin(maxlen - totalRead, remainingInBuffer);
+
+        // Copy data
+        memcpy(data + totalRead, m_currentBuffer.constData() + m_currentPos, toRead);
+        m_currentPos += toRead;
+        totalRead += toRead;
+    }
+    m_bufferedBytes -= totalRead;
+
+    return totalRead;
+}
+
+qint64 AudioBuffer::writeData(const char *data, qint64 len) {
+    Q_UNUSED(data)
+    Q_UNUSED(len)
+    return 0;  // We handle writing through writeData(const QByteArray&)
+}
@@ -0,0 +1,168 @@
+#include "media/AudioDownmix.h"
+#include <algorithm>
+#include <cmath>
+
+extern "C" {
+#include <libavutil/channel_layout.h>
+}
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define AUDIO_DOWNMIX_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define AUDIO_DOWNMIX_NEON
+#endif
+
+namespace {
+
+constexpr float MINUS_3DB = 0.70710678f;
+constexpr float MINUS_6DB = 0.5f;
+
+// 单个声道到左右两路的系数
+void channelGains(uint64_t channel, float *left, float *right) {
+    *left = 0.0f;
+    *right = 0.0f;
+    switch (channel) {
+    case AV_CH_FRONT_LEFT:
+    case AV_CH_FRONT_LEFT_OF_CENTER:
+    case AV_CH_STEREO_LEFT: *left = 1.0f; break;
+    case AV_CH_FRONT_RIGHT:
+    case AV_CH_FRONT_RIGHT_OF_CENTER:
+    case AV_CH_STEREO_RIGHT: *right = 1.0f; break;
+    case AV_CH_FRONT_CENTER: *left = *right = MINUS_3DB; break;
+    case AV_CH_LOW_FREQUENCY:
+    case AV_CH_LOW_FREQUENCY_2: break;  // 普通音箱重放不了，下混时舍弃
+    case AV_CH_BACK_LEFT:
+    case AV_CH_SIDE_LEFT:
+    case AV_CH_WIDE_LEFT:
+    case AV_CH_TOP_FRONT_LEFT:
+    case AV_CH_TOP_BACK_LEFT: *left = MINUS_3DB; break;
+    case AV_CH_BACK_RIGHT:
+    case AV_CH_SIDE_RIGHT:
+    case AV_CH_WIDE_RIGHT:
+    case AV_CH_TOP_FRONT_RIGHT:
+    case AV_CH_TOP_BACK_RIGHT: *right = MINUS_3DB; break;
+    default: *left = *right = MINUS_6DB; break;  // 后中置、顶部中央等
+    }
+}
+
+inline int16_t toS16(float value) {
+    return int16_t(std::lrint(std::clamp(value * 32768.0f, -32768.0f, 32767.0f)));
+}
+
+}  // namespace
+
+AudioDownmix::AudioDownmix(uint64_t layout) {
+    for (int bit = 0; bit < 64; ++bit) {
+        uint64_t channel = uint64_t(1) << bit;
+        if (!(layout & channel)) continue;
+        float left = 0.0f;
+        float right = 0.0f;
+        channelGains(channel, &left, &right);
+        m_left.push_back(left);
+        m_right.push_back(right);
+    }
+
+    float leftSum = 0.0f;
+    float rightSum = 0.0f;
+    for (size_t c = 0; c < m_left.size(); ++c) {
+        leftSum += m_left[c];
+        rightSum += m_right[c];
+    }
+    float scale = 1.0f / std::max({leftSum, rightSum, 1.0f});
+    for (size_t c = 0; c < m_left.size(); ++c) {
+        m_left[c] *= scale;
+        m_right[c] *= scale;
+    }
+}
+
+void AudioDownmix::process(const float *const *planes, int samples, int16_t *output) const {
+    const int channels = inputChannels();
+    int i = 0;
+#if defined(AUDIO_DOWNMIX_SSE2)
+    // 每次处理4个样本：各声道乘系数累加，饱和转换为S16并交错为L R L R ...
+    const __m128 scale = _mm_set1_ps(32768.0f);
+    const __m128 low = _mm_set1_ps(-32768.0f);
+    const __m128 high = _mm_set1_ps(32767.0f);
+    for (; i + 4 <= samples; i += 4) {
+        __m128 l = _mm_setzero_ps();
+        __m128 r = _mm_setzero_ps();
+        for (int c = 0; c < channels; ++c) {
+            __m128 x = _mm_loadu_ps(planes[c] + i);
+            l = _mm_add_ps(l, _mm_mul_ps(x, _mm_set1_ps(m_left[size_t(c)])));
+            r = _mm_add_ps(r, _mm_mul_ps(x, _mm_set1_ps(m_right[size_t(c)])));
+        }
+        l = _mm_min_ps(_mm_max_ps(_mm_mul_ps(l, scale), low), high);
+        r = _mm_min_ps(_mm_max_ps(_mm_mul_ps(r, scale), low), high);
+        __m128i li = _mm_cvtps_epi32(l);
+        __m128i ri = _mm_cvtps_epi32(r);
+        __m128i pcm = _mm_packs_epi32(_mm_unpacklo_epi32(li, ri), _mm_unpackhi_epi32(li, ri));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(output + 2 * i), pcm);
+    }
+#elif defined(AUDIO_DOWNMIX_NEON)
+    for (; i + 4 <= samples; i += 4) {
+        float32x4_t l = vdupq_n_f32(0.0f);
+        float32x4_t r = vdupq_n_f32(0.0f);
+        for (int c = 0; c < channels; ++c) {
+            float32x4_t x = vld1q_f32(planes[c] + i);
+            l = vmlaq_n_f32(l, x, m_left[size_t(c)]);
+            r = vmlaq_n_f32(r, x, m_right[size_t(c)]);
+        }
+        int16x4x2_t pcm;
+        pcm.val[0] = vqmovn_s32(vcvtq_s32_f32(vmulq_n_f32(l, 32768.0f)));
+        pcm.val[1] = vqmovn_s32(vcvtq_s32_f32(vmulq_n_f32(r, 32768.0f)));
+        vst2_s16(output + 2 * i, pcm);
+    }
+#endif
+    for (; i < samples; ++i) {
+        float l = 0.0f;
+        float r = 0.0f;
+        for (int c = 0; c < channels; ++c) {
+            l += planes[c][i] * m_left[size_t(c)];
+            r += planes[c][i] * m_right[size_t(c)];
+        }
+        output[2 * i] = toS16(l);
+        output[2 * i + 1] = toS16(r);
+    }
+}
+
+void AudioDownmix::process(const float *const *planes, int samples, float *output) const {
+    const int channels = inputChannels();
+    int i = 0;
+#if defined(AUDIO_DOWNMIX_SSE2)
+    for (; i + 4 <= samples; i += 4) {
+        __m128 l = _mm_setzero_ps();
+        __m128 r = _mm_setzero_ps();
+        for (int c = 0; c < channels; ++c) {
+            __m128 x = _mm_loadu_ps(planes[c] + i);
+            l = _mm_add_ps(l, _mm_mul_ps(x, _mm_set1_ps(m_left[size_t(c)])));
+            r = _mm_add_ps(r, _mm_mul_ps(x, _mm_set1_ps(m_right[size_t(c)])));
+        }
+        _mm_storeu_ps(output + 2 * i, _mm_unpacklo_ps(l, r));
+        _mm_storeu_ps(output + 2 * i + 4, _mm_unpackhi_ps(l, r));
+    }
+#elif defined(AUDIO_DOWNMIX_NEON)
+    for (; i + 4 <= samples; i += 4) {
+        float32x4x2_t stereo;
+        stereo.val[0] = vdupq_n_f32(0.0f);
+        stereo.val[1] = vdupq_n_f32(0.0f);
+        for (int c = 0; c < channels; ++c) {
+            float32x4_t x = vld1q_f32(planes[c] + i);
+            stereo.val[0] = vmlaq_n_f32(stereo.val[0], x, m_left[size_t(c)]);
+            stereo.val[1] = vmlaq_n_f32(stereo.val[1], x, m_right[size_t(c)]);
+        }
+        vst2q_f32(output + 2 * i, stereo);
+    }
+#endif
+    for (; i < samples; ++i) {
+        float l = 0.0f;
+        float r = 0.0f;
+        for (int c = 0; c < channels; ++c) {
+            l += planes[c][i] * m_left[size_t(c)];
+            r += planes[c][i] * m_right[size_t(c)];
+        }
+        output[2 * i] = l;
+        output[2 * i + 1] = r;
+    }
+}
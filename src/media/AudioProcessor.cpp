@@ -0,0 +1,384 @@
+#include "media/AudioProcessor.h"
+#include "core/Trace.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define AUDIO_PROCESSOR_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define AUDIO_PROCESSOR_NEON
+#endif
+
+// x86上AVX2内核总是编译（按函数指定指令集，不需要-mavx2），运行时检测CPU支持后使用
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+#include <immintrin.h>
+#define AUDIO_PROCESSOR_AVX2
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#if defined(_MSC_VER) && !defined(__clang__)
+#define AVX2_TARGET
+#else
+#define AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace {
+
+constexpr float S16_SCALE = 32768.0f;
+
+inline uint32_t xorshift(uint32_t &state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+// 随机位的高23位作为尾数，得到[0, 1)均匀分布
+inline float unitNoise(uint32_t bits) {
+    uint32_t value = (bits >> 9) | 0x3f800000u;
+    float result;
+    std::memcpy(&result, &value, sizeof(result));
+    return result - 1.0f;
+}
+
+#if defined(AUDIO_PROCESSOR_SSE2)
+inline __m128i xorshift4(__m128i &state) {
+    state = _mm_xor_si128(state, _mm_slli_epi32(state, 13));
+    state = _mm_xor_si128(state, _mm_srli_epi32(state, 17));
+    state = _mm_xor_si128(state, _mm_slli_epi32(state, 5));
+    return state;
+}
+
+inline __m128 unitNoise4(__m128i bits) {
+    __m128i value = _mm_or_si128(_mm_srli_epi32(bits, 9), _mm_set1_epi32(0x3f800000));
+    return _mm_sub_ps(_mm_castsi128_ps(value), _mm_set1_ps(1.0f));
+}
+#endif
+
+#if defined(AUDIO_PROCESSOR_AVX2)
+bool detectAvx2() {
+#if defined(_MSC_VER)
+    // AVX2需要CPU支持，且操作系统保存YMM寄存器（OSXSAVE + XCR0）
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+    __cpuid(info, 1);
+    const bool osxsave = info[2] & (1 << 27);
+    const bool avx = info[2] & (1 << 28);
+    if (!osxsave || !avx || (_xgetbv(0) & 6) != 6) return false;
+    __cpuidex(info, 7, 0);
+    return info[1] & (1 << 5);
+#else
+    // 可能在静态初始化期间调用，先初始化CPU特性信息
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+// 以下AVX2内核每次处理8个样本，返回已处理的样本数，剩余部分由调用方的SSE2/标量代码处理
+
+AVX2_TARGET inline __m256i xorshift8(__m256i &state) {
+    state = _mm256_xor_si256(state, _mm256_slli_epi32(state, 13));
+    state = _mm256_xor_si256(state, _mm256_srli_epi32(state, 17));
+    state = _mm256_xor_si256(state, _mm256_slli_epi32(state, 5));
+    return state;
+}
+
+AVX2_TARGET inline __m256 unitNoise8(__m256i bits) {
+    __m256i value = _mm256_or_si256(_mm256_srli_epi32(bits, 9), _mm256_set1_epi32(0x3f800000));
+    return _mm256_sub_ps(_mm256_castsi256_ps(value), _mm256_set1_ps(1.0f));
+}
+
+AVX2_TARGET int applyGainAvx2(float *samples, int count, float start, float step) {
+    int i = 0;
+    __m256 gain = _mm256_add_ps(_mm256_set1_ps(start),
+                                _mm256_mul_ps(_mm256_set1_ps(step),
+                                              _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7)));
+    const __m256 advance = _mm256_set1_ps(8 * step);
+    for (; i + 8 <= count; i += 8) {
+        _mm256_storeu_ps(samples + i, _mm256_mul_ps(_mm256_loadu_ps(samples + i), gain));
+        gain = _mm256_add_ps(gain, advance);
+    }
+    return i;
+}
+
+AVX2_TARGET int mixAvx2(float *dst, const float *src, int count, float start, float step) {
+    int i = 0;
+    __m256 gain = _mm256_add_ps(_mm256_set1_ps(start),
+                                _mm256_mul_ps(_mm256_set1_ps(step),
+                                              _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7)));
+    const __m256 advance = _mm256_set1_ps(8 * step);
+    for (; i + 8 <= count; i += 8) {
+        __m256 sum = _mm256_add_ps(_mm256_loadu_ps(dst + i),
+                                   _mm256_mul_ps(_mm256_loadu_ps(src + i), gain));
+        _mm256_storeu_ps(dst + i, sum);
+        gain = _mm256_add_ps(gain, advance);
+    }
+    return i;
+}
+
+AVX2_TARGET int fromS16Avx2(const int16_t *input, int count, float *output) {
+    int i = 0;
+    const __m256 scale = _mm256_set1_ps(1.0f / S16_SCALE);
+    for (; i + 8 <= count; i += 8) {
+        __m128i pcm = _mm_loadu_si128(reinterpret_cast<const __m128i *>(input + i));
+        __m256 value = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(pcm));
+        _mm256_storeu_ps(output + i, _mm256_mul_ps(value, scale));
+    }
+    return i;
+}
+
+AVX2_TARGET int toS16Avx2(const float *input, int count, int16_t *output, uint32_t *dither) {
+    // 每次8个样本：两次均匀噪声之差为三角分布，加到放大后的样本上再取整
+    int i = 0;
+    __m256i state = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(dither));
+    const __m256 scale = _mm256_set1_ps(S16_SCALE);
+    const __m256 low = _mm256_set1_ps(-S16_SCALE);
+    const __m256 high = _mm256_set1_ps(S16_SCALE - 1.0f);
+    for (; i + 8 <= count; i += 8) {
+        __m256 noise = _mm256_sub_ps(unitNoise8(xorshift8(state)), unitNoise8(xorshift8(state)));
+        __m256 value = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(input + i), scale), noise);
+        value = _mm256_min_ps(_mm256_max_ps(value, low), high);
+        __m256i pcm = _mm256_cvtps_epi32(value);
+        __m128i packed =
+            _mm_packs_epi32(_mm256_castsi256_si128(pcm), _mm256_extracti128_si256(pcm, 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(output + i), packed);
+    }
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dither), state);
+    return i;
+}
+#else
+bool detectAvx2() { return false; }
+#endif
+
+}  // namespace
+
+std::atomic<bool> AudioProcessor::s_avx2{detectAvx2()};
+
+bool AudioProcessor::avx2Supported() {
+    static const bool supported = detectAvx2();
+    return supported;
+}
+
+void AudioProcessor::setAvx2Enabled(bool enabled) {
+    s_avx2.store(enabled && avx2Supported(), std::memory_order_relaxed);
+}
+
+AudioProcessor::AudioProcessor(int channels, int sampleRate)
+    : m_fadeSamples(std::max(1, sampleRate * FADE_MS / 1000 * std::max(channels, 1))) {
+    for (int i = 0; i < DITHER_LANES; ++i) {
+        m_dither[i] = 0x9e3779b9u * uint32_t(i + 1);
+    }
+}
+
+void AudioProcessor::setGain(float gain) {
+    m_volume = std::clamp(gain, 0.0f, 1.0f);
+    m_targetGain = m_volume * m_normalization;
+}
+
+void AudioProcessor::setNormalization(float gain) {
+    m_normalization = std::max(gain, 0.0f);
+    m_targetGain = m_volume * m_normalization;
+}
+
+void AudioProcessor::crossfadeFrom(const QByteArray &tail) {
+    // 淡出的旧数据与新数据等长混合；没有旧数据时与静音混合，即从静音渐入
+    m_tail.assign(size_t(m_fadeSamples), 0.0f);
+    int count = std::min(int(tail.size() / int(sizeof(int16_t))), m_fadeSamples);
+    fromS16(reinterpret_cast<const int16_t *>(tail.constData()), count, m_tail.data());
+    m_tailPos = 0;
+}
+
+QByteArray AudioProcessor::process(const QByteArray &input) {
+    TRACE_SCOPE("AudioProcessor::process", "audio");
+
+    const int count = int(input.size() / int(sizeof(float)));
+    m_work.resize(size_t(count));
+    std::memcpy(m_work.data(), input.constData(), size_t(count) * sizeof(float));
+    float *samples = m_work.data();
+
+    // 音量变化在这一段内过渡完成
+    if (m_gain != m_targetGain || m_gain != 1.0f) {
+        applyGain(samples, count, m_gain, m_targetGain);
+        m_gain = m_targetGain;
+    }
+
+    // 交叉淡化：新数据渐入，旧数据渐出
+    if (m_tailPos < m_tail.size()) {
+        int n = std::min(count, int(m_tail.size() - m_tailPos));
+        float total = float(m_tail.size());
+        float from = float(m_tailPos) / total;
+        float to = float(m_tailPos + size_t(n)) / total;
+        applyGain(samples, n, from, to);
+        mix(samples, &m_tail[m_tailPos], n, 1.0f - from, 1.0f - to);
+        m_tailPos += size_t(n);
+        if (m_tailPos >= m_tail.size()) {
+            m_tail.clear();
+            m_tailPos = 0;
+        }
+    }
+
+    QByteArray output(count * int(sizeof(int16_t)), Qt::Uninitialized);
+    toS16(samples, count, reinterpret_cast<int16_t *>(output.data()));
+    return output;
+}
+
+QByteArray AudioProcessor::fadeIn(const QByteArray &pcm) {
+    int count = std::min(int(pcm.size() / int(sizeof(int16_t))), m_fadeSamples);
+    if (count == 0) return pcm;
+
+    QByteArray output = pcm;
+    int16_t *data = reinterpret_cast<int16_t *>(output.data());
+    m_work.resize(size_t(count));
+    fromS16(data, count, m_work.data());
+    applyGain(m_work.data(), count, 0.0f, 1.0f);
+    toS16(m_work.data(), count, data);
+    return output;
+}
+
+QByteArray AudioProcessor::fadeOut(const QByteArray &pcm) {
+    int count = std::min(int(pcm.size() / int(sizeof(int16_t))), m_fadeSamples);
+    if (count == 0) return pcm;
+
+    QByteArray output = pcm.left(count * int(sizeof(int16_t)));
+    int16_t *data = reinterpret_cast<int16_t *>(output.data());
+    m_work.resize(size_t(count));
+    fromS16(data, count, m_work.data());
+    applyGain(m_work.data(), count, 1.0f, 0.0f);
+    toS16(m_work.data(), count, data);
+    return output;
+}
+
+void AudioProcessor::reset() {
+    m_tail.clear();
+    m_tailPos = 0;
+    m_gain = m_targetGain;
+}
+
+void AudioProcessor::applyGain(float *samples, int count, float start, float end) {
+    if (count <= 0) return;
+    const float step = (end - start) / count;
+    int i = 0;
+#if defined(AUDIO_PROCESSOR_AVX2)
+    if (avx2Enabled()) i = applyGainAvx2(samples, count, start, step);
+#endif
+#if defined(AUDIO_PROCESSOR_SSE2)
+    __m128 gain = _mm_add_ps(_mm_set1_ps(start + step * i),
+                             _mm_mul_ps(_mm_set1_ps(step), _mm_setr_ps(0, 1, 2, 3)));
+    const __m128 advance = _mm_set1_ps(4 * step);
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_ps(samples + i, _mm_mul_ps(_mm_loadu_ps(samples + i), gain));
+        gain = _mm_add_ps(gain, advance);
+    }
+#elif defined(AUDIO_PROCESSOR_NEON)
+    const float offsets[4] = {0, 1, 2, 3};
+    float32x4_t gain = vmlaq_n_f32(vdupq_n_f32(start), vld1q_f32(offsets), step);
+    const float32x4_t advance = vdupq_n_f32(4 * step);
+    for (; i + 4 <= count; i += 4) {
+        vst1q_f32(samples + i, vmulq_f32(vld1q_f32(samples + i), gain));
+        gain = vaddq_f32(gain, advance);
+    }
+#endif
+    for (; i < count; ++i) {
+        samples[i] *= start + step * i;
+    }
+}
+
+void AudioProcessor::mix(float *dst, const float *src, int count, float start, float end) {
+    if (count <= 0) return;
+    const float step = (end - start) / count;
+    int i = 0;
+#if defined(AUDIO_PROCESSOR_AVX2)
+    if (avx2Enabled()) i = mixAvx2(dst, src, count, start, step);
+#endif
+#if defined(AUDIO_PROCESSOR_SSE2)
+    __m128 gain = _mm_add_ps(_mm_set1_ps(start + step * i),
+                             _mm_mul_ps(_mm_set1_ps(step), _mm_setr_ps(0, 1, 2, 3)));
+    const __m128 advance = _mm_set1_ps(4 * step);
+    for (; i + 4 <= count; i += 4) {
+        __m128 sum = _mm_add_ps(_mm_loadu_ps(dst + i), _mm_mul_ps(_mm_loadu_ps(src + i), gain));
+        _mm_storeu_ps(dst + i, sum);
+        gain = _mm_add_ps(gain, advance);
+    }
+#elif defined(AUDIO_PROCESSOR_NEON)
+    const float offsets[4] = {0, 1, 2, 3};
+    float32x4_t gain = vmlaq_n_f32(vdupq_n_f32(start), vld1q_f32(offsets), step);
+    const float32x4_t advance = vdupq_n_f32(4 * step);
+    for (; i + 4 <= count; i += 4) {
+        vst1q_f32(dst + i, vmlaq_f32(vld1q_f32(dst + i), vld1q_f32(src + i), gain));
+        gain = vaddq_f32(gain, advance);
+    }
+#endif
+    for (; i < count; ++i) {
+        dst[i] += src[i] * (start + step * i);
+    }
+}
+
+void AudioProcessor::fromS16(const int16_t *input, int count, float *output) {
+    const float scale = 1.0f / S16_SCALE;
+    int i = 0;
+#if defined(AUDIO_PROCESSOR_AVX2)
+    if (avx2Enabled()) i = fromS16Avx2(input, count, output);
+#endif
+#if defined(AUDIO_PROCESSOR_SSE2)
+    const __m128 vscale = _mm_set1_ps(scale);
+    for (; i + 8 <= count; i += 8) {
+        __m128i pcm = _mm_loadu_si128(reinterpret_cast<const __m128i *>(input + i));
+        // 16位扩展为32位：放到高半部分后算术右移保留符号
+        __m128i low = _mm_srai_epi32(_mm_unpacklo_epi16(pcm, pcm), 16);
+        __m128i high = _mm_srai_epi32(_mm_unpackhi_epi16(pcm, pcm), 16);
+        _mm_storeu_ps(output + i, _mm_mul_ps(_mm_cvtepi32_ps(low), vscale));
+        _mm_storeu_ps(output + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(high), vscale));
+    }
+#elif defined(AUDIO_PROCESSOR_NEON)
+    for (; i + 8 <= count; i += 8) {
+        int16x8_t pcm = vld1q_s16(input + i);
+        vst1q_f32(output + i, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(pcm))), scale));
+        vst1q_f32(output + i + 4,
+                  vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(pcm))), scale));
+    }
+#endif
+    for (; i < count; ++i) {
+        output[i] = input[i] * scale;
+    }
+}
+
+void AudioProcessor::toS16(const float *input, int count, int16_t *output) {
+    TRACE_SCOPE("AudioProcessor::toS16", "audio");
+
+    int i = 0;
+#if defined(AUDIO_PROCESSOR_AVX2)
+    if (avx2Enabled()) i = toS16Avx2(input, count, output, m_dither);
+#endif
+#if defined(AUDIO_PROCESSOR_SSE2)
+    // 8个通道的随机数状态与AVX2内核相同，分为两个128位寄存器
+    __m128i state0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(m_dither));
+    __m128i state1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(m_dither + 4));
+    const __m128 scale = _mm_set1_ps(S16_SCALE);
+    const __m128 low = _mm_set1_ps(-S16_SCALE);
+    const __m128 high = _mm_set1_ps(S16_SCALE - 1.0f);
+    for (; i + 8 <= count; i += 8) {
+        __m128 noise0 = _mm_sub_ps(unitNoise4(xorshift4(state0)), unitNoise4(xorshift4(state0)));
+        __m128 noise1 = _mm_sub_ps(unitNoise4(xorshift4(state1)), unitNoise4(xorshift4(state1)));
+        __m128 value0 = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(input + i), scale), noise0);
+        __m128 value1 = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(input + i + 4), scale), noise1);
+        value0 = _mm_min_ps(_mm_max_ps(value0, low), high);
+        value1 = _mm_min_ps(_mm_max_ps(value1, low), high);
+        __m128i packed = _mm_packs_epi32(_mm_cvtps_epi32(value0), _mm_cvtps_epi32(value1));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(output + i), packed);
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(m_dither), state0);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(m_dither + 4), state1);
+#endif
+    // NEON和剩余样本：逐个样本轮流使用各通道的随机数状态
+    for (; i < count; ++i) {
+        uint32_t &state = m_dither[i % DITHER_LANES];
+        float noise = unitNoise(xorshift(state)) - unitNoise(xorshift(state));
+        float value = std::clamp(input[i] * S16_SCALE + noise, -S16_SCALE, S16_SCALE - 1.0f);
+        output[i] = int16_t(std::lrint(value));
+    }
+}
@@ -0,0 +1,220 @@
+#include "media/AudioResampler.h"
+#include <QDebug>
+#include <algorithm>
+
+// FFmpeg 5.1起声道布局改为AVChannelLayout，旧的channel_layout/channels接口已弃用
+#if LIBAVUTIL_VERSION_INT >= AV_VERSION_INT(57, 24, 100)
+#define AUDIO_CHANNEL_LAYOUT_API
+#endif
+
+namespace {
+
+SwrContext *allocContext(uint64_t outLayout, AVSampleFormat outFormat, int outSampleRate,
+                         uint64_t inLayout, AVSampleFormat inFormat, int inSampleRate) {
+#ifdef AUDIO_CHANNEL_LAYOUT_API
+    AVChannelLayout out;
+    AVChannelLayout in;
+    av_channel_layout_from_mask(&out, outLayout);
+    av_channel_layout_from_mask(&in, inLayout);
+    SwrContext *context = nullptr;
+    int ret = swr_alloc_set_opts2(&context, &out, outFormat, outSampleRate,  // 输出
+                                  &in, inFormat, inSampleRate,               // 输入
+                                  0, nullptr);
+    av_channel_layout_uninit(&out);
+    av_channel_layout_uninit(&in);
+    if (ret < 0) swr_free(&context);
+    return context;
+#else
+    return swr_alloc_set_opts(nullptr, int64_t(outLayout), outFormat, outSampleRate,  // 输出
+                              int64_t(inLayout), inFormat, inSampleRate,              // 输入
+                              0, nullptr);
+#endif
+}
+
+}  // namespace
+
+AudioResampler::~AudioResampler() { close(); }
+
+bool AudioResampler::open(int64_t inLayout, int inChannels, AVSampleFormat inFormat,
+                          int inSampleRate, int outChannels, int outSampleRate,
+                          AVSampleFormat outFormat) {
+    close();
+
+    // 部分解码器不填写声道布局，按声道数取默认布局
+    if (inLayout == 0) {
+        inLayout = int64_t(defaultLayout(inChannels));
+    }
+
+    // 声道数相同时输出保持输入布局，swresample只转换采样格式和采样率；
+    // 多声道到立体声只把采样率和格式转换为平面浮点，下混由AudioDownmix完成
+    uint64_t outLayout = uint64_t(inLayout);
+    AVSampleFormat swrFormat = outFormat;
+    if (outChannels == 2 && inChannels > 2) {
+        m_downmix = std::make_unique<AudioDownmix>(uint64_t(inLayout));
+        swrFormat = AV_SAMPLE_FMT_FLTP;
+        // 布局与声道数不符时无法确定各声道的位置，交给swresample
+        if (m_downmix->inputChannels() != inChannels) {
+            m_downmix.reset();
+            swrFormat = outFormat;
+        }
+    }
+    if (!m_downmix && outChannels != inChannels) {
+        outLayout = defaultLayout(outChannels);
+    }
+
+    m_swrContext = allocContext(outLayout, swrFormat, outSampleRate, uint64_t(inLayout), inFormat,
+                                inSampleRate);
+    if (!m_swrContext) {
+        qDebug() << "AudioResampler: Failed to allocate resampler";
+        m_downmix.reset();
+        return false;
+    }
+
+    if (swr_init(m_swrContext) < 0) {
+        qDebug() << "AudioResampler: Failed to initialize resampler";
+        swr_free(&m_swrContext);
+        m_downmix.reset();
+        return false;
+    }
+
+    m_outChannels = outChannels;
+    m_outFormat = outFormat;
+    m_inSampleRate = inSampleRate;
+    m_outSampleRate = outSampleRate;
+    m_compensating = false;
+    return true;
+}
+
+bool AudioResampler::open(AVCodecContext *codecContext, int outChannels, int outSampleRate,
+                          AVSampleFormat outFormat) {
+    if (!codecContext) {
+        return false;
+    }
+    return open(int64_t(channelLayout(codecContext)), channelCount(codecContext),
+                codecContext->sample_fmt, codecContext->sample_rate, outChannels, outSampleRate,
+                outFormat);
+}
+
+uint64_t AudioResampler::defaultLayout(int channels) {
+#ifdef AUDIO_CHANNEL_LAYOUT_API
+    AVChannelLayout layout;
+    av_channel_layout_default(&layout, channels);
+    uint64_t mask = layout.order == AV_CHANNEL_ORDER_NATIVE ? layout.u.mask : 0;
+    av_channel_layout_uninit(&layout);
+    return mask;
+#else
+    return uint64_t(av_get_default_channel_layout(channels));
+#endif
+}
+
+uint64_t AudioResampler::channelLayout(const AVCodecContext *codecContext) {
+#ifdef AUDIO_CHANNEL_LAYOUT_API
+    const AVChannelLayout &layout = codecContext->ch_layout;
+    if (layout.order == AV_CHANNEL_ORDER_NATIVE) return layout.u.mask;
+    return defaultLayout(layout.nb_channels);
+#else
+    if (codecContext->channel_layout) return codecContext->channel_layout;
+    return defaultLayout(codecContext->channels);
+#endif
+}
+
+int AudioResampler::channelCount(const AVCodecContext *codecContext) {
+#ifdef AUDIO_CHANNEL_LAYOUT_API
+    return codecContext->ch_layout.nb_channels;
+#else
+    return codecContext->channels;
+#endif
+}
+
+int AudioResampler::channelCount(const AVFrame *frame) {
+#ifdef AUDIO_CHANNEL_LAYOUT_API
+    return frame->ch_layout.nb_channels;
+#else
+    return frame->channels;
+#endif
+}
+
+void AudioResampler::close() {
+    if (m_swrContext) {
+        swr_free(&m_swrContext);
+    }
+    m_downmix.reset();
+    m_outChannels = 0;
+}
+
+QByteArray AudioResampler::convert(const uint8_t **input, int inputSamples) {
+    if (!m_swrContext) {
+        return QByteArray();
+    }
+
+    // 变速：本次输出按速度比例增减样本数
+    int compensation = 0;
+    if (m_speed != 1.0 && inputSamples > 0) {
+        int expected = int(int64_t(inputSamples) * m_outSampleRate / m_inSampleRate);
+        compensation = int(expected / m_speed) - expected;
+        if (expected > 0 && swr_set_compensation(m_swrContext, compensation, expected) >= 0) {
+            m_compensating = true;
+        } else {
+            compensation = 0;
+        }
+    } else if (m_compensating) {
+        swr_set_compensation(m_swrContext, 0, 0);
+        m_compensating = false;
+    }
+
+    // Calculate output samples
+    int outSamples = swr_get_out_samples(m_swrContext, inputSamples) + std::max(compensation, 0);
+    if (outSamples == 0) {
+        return QByteArray();
+    }
+    if (outSamples < 0) {
+        qDebug() << "AudioResampler: Error getting output samples count";
+        return QByteArray();
+    }
+
+    if (m_downmix) {
+        return convertDownmix(input, inputSamples, outSamples);
+    }
+
+    // 直接转换到结果缓冲区，省去一次中间分配和拷贝
+    int bytesPerSample = m_outChannels * av_get_bytes_per_sample(m_outFormat);
+    QByteArray result(outSamples * bytesPerSample, Qt::Uninitialized);
+    uint8_t *output = reinterpret_cast<uint8_t *>(result.data());
+
+    int converted = swr_convert(m_swrContext, &output, outSamples, input, inputSamples);
+    if (converted < 0) {
+        qDebug() << "AudioResampler: Error converting audio samples";
+        return QByteArray();
+    }
+
+    result.truncate(converted * bytesPerSample);
+    return result;
+}
+
+QByteArray AudioResampler::convertDownmix(const uint8_t **input, int inputSamples,
+                                          int outSamples) {
+    // 转换为平面浮点（声道不变），再按下混矩阵合成立体声
+    const int channels = m_downmix->inputChannels();
+    m_downmixBuffer.resize(size_t(outSamples) * size_t(channels));
+    m_downmixPlanes.resize(size_t(channels));
+    for (int c = 0; c < channels; ++c) {
+        m_downmixPlanes[size_t(c)] = &m_downmixBuffer[size_t(c) * size_t(outSamples)];
+    }
+
+    uint8_t **output = reinterpret_cast<uint8_t **>(m_downmixPlanes.data());
+    int converted = swr_convert(m_swrContext, output, outSamples, input, inputSamples);
+    if (converted < 0) {
+        qDebug() << "AudioResampler: Error converting audio samples";
+        return QByteArray();
+    }
+
+    QByteArray result(converted * 2 * av_get_bytes_per_sample(m_outFormat), Qt::Uninitialized);
+    if (m_outFormat == AV_SAMPLE_FMT_FLT) {
+        m_downmix->process(m_downmixPlanes.data(), converted,
+                           reinterpret_cast<float *>(result.data()));
+    } else {
+        m_downmix->process(m_downmixPlanes.data(), converted,
+                           reinterpret_cast<int16_t *>(result.data()));
+    }
+    return result;
+}
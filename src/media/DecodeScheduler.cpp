@@ -0,0 +1,195 @@
+#include "media/DecodeScheduler.h"
+#include <QDebug>
+#include <algorithm>
+
+int PipelineTask::priority() const {
+    int stagePriority = 0;
+    switch (m_stage) {
+    case Stage::AudioDecode: stagePriority = 2; break;     // 音频断续最容易察觉
+    case Stage::Demux: stagePriority = 1; break;           // 为所有解码器供数据，开销小
+    case Stage::SubtitleDecode: stagePriority = 1; break;  // 数据很少，及时解码避免晚于画面
+    case Stage::VideoDecode: stagePriority = 0; break;
+    }
+    return (m_foreground ? 10 : 0) + stagePriority;
+}
+
+PipelineTask::StepStats PipelineTask::stepStats() const {
+    StepStats stats;
+    stats.steps = m_steps.load(std::memory_order_relaxed);
+    stats.idleSteps = m_idleSteps.load(std::memory_order_relaxed);
+    stats.totalMs = m_totalNs.load(std::memory_order_relaxed) / 1e6;
+    stats.maxMs = m_maxNs.load(std::memory_order_relaxed) / 1e6;
+    return stats;
+}
+
+void PipelineTask::recordStep(std::chrono::nanoseconds elapsed, StepResult result) {
+    int64_t ns = elapsed.count();
+    m_steps.fetch_add(1, std::memory_order_relaxed);
+    if (result == StepResult::Idle) {
+        m_idleSteps.fetch_add(1, std::memory_order_relaxed);
+    }
+    m_totalNs.fetch_add(ns, std::memory_order_relaxed);
+    if (ns > m_maxNs.load(std::memory_order_relaxed)) {
+        m_maxNs.store(ns, std::memory_order_relaxed);
+    }
+}
+
+DecodeScheduler &DecodeScheduler::instance() {
+    static DecodeScheduler scheduler;
+    return scheduler;
+}
+
+DecodeScheduler::DecodeScheduler() {
+    int workerCount = qMax(2, QThread::idealThreadCount());
+    for (int i = 0; i < workerCount; ++i) {
+        QThread *worker = QThread::create([this]() { workerLoop(); });
+        worker->setObjectName(QString("DecodeWorker-%1").arg(i));
+        worker->start();
+        m_workers.push_back(worker);
+    }
+    qDebug() << "解码调度器启动，工作线程数:" << workerCount;
+}
+
+DecodeScheduler::~DecodeScheduler() {
+    {
+        QMutexLocker locker(&m_mutex);
+        m_shutdown = true;
+        m_workAvailable.wakeAll();
+    }
+
+    for (QThread *worker : m_workers) {
+        worker->wait();
+        delete worker;
+    }
+}
+
+void DecodeScheduler::attach(PipelineTask *task) {
+    QMutexLocker locker(&m_mutex);
+    task->m_detachRequested = false;
+    task->m_wakePending = false;
+    enqueueLocked(task);
+}
+
+void DecodeScheduler::detach(PipelineTask *task) {
+    QMutexLocker locker(&m_mutex);
+    if (task->m_state == PipelineTask::State::Detached) return;
+
+    task->m_detachRequested = true;
+    while (task->m_state == PipelineTask::State::Running) {
+        m_taskIdle.wait(&m_mutex);
+    }
+
+    removeLocked(task);
+    task->m_state = PipelineTask::State::Detached;
+}
+
+void DecodeScheduler::wake(PipelineTask *task) {
+    if (!task) return;
+
+    QMutexLocker locker(&m_mutex);
+    switch (task->m_state) {
+    case PipelineTask::State::Parked:
+        removeLocked(task);
+        enqueueLocked(task);
+        break;
+    case PipelineTask::State::Running:
+        // 本次step结束后不挂起，直接重新排队
+        task->m_wakePending = true;
+        break;
+    default: break;
+    }
+}
+
+void DecodeScheduler::workerLoop() {
+    QMutexLocker locker(&m_mutex);
+
+    while (!m_shutdown) {
+        promoteParkedLocked(std::chrono::steady_clock::now());
+
+        PipelineTask *task = takeNextLocked();
+        if (!task) {
+            if (m_parked.empty()) {
+                m_workAvailable.wait(&m_mutex);
+            } else {
+                m_workAvailable.wait(&m_mutex, PARK_RETRY.count());
+            }
+            continue;
+        }
+
+        task->m_state = PipelineTask::State::Running;
+        task->m_wakePending = false;
+
+        locker.unlock();
+        auto stepStart = std::chrono::steady_clock::now();
+        PipelineTask::StepResult result = task->step();
+        task->recordStep(std::chrono::steady_clock::now() - stepStart, result);
+        locker.relock();
+
+        if (task->m_detachRequested) {
+            task->m_state = PipelineTask::State::Detached;
+            m_taskIdle.wakeAll();
+            continue;
+        }
+
+        switch (result) {
+        case PipelineTask::StepResult::Progress: enqueueLocked(task); break;
+        case PipelineTask::StepResult::Idle:
+            if (task->m_wakePending) {
+                enqueueLocked(task);
+            } else {
+                task->m_state = PipelineTask::State::Parked;
+                task->m_retryAt = std::chrono::steady_clock::now() + PARK_RETRY;
+                m_parked.push_back(task);
+            }
+            break;
+        case PipelineTask::StepResult::Finished:
+            task->m_state = PipelineTask::State::Finished;
+            m_taskIdle.wakeAll();
+            break;
+        }
+    }
+}
+
+void DecodeScheduler::enqueueLocked(PipelineTask *task) {
+    task->m_state = PipelineTask::State::Queued;
+    task->m_sequence = m_nextSequence++;
+    m_ready.push_back(task);
+    m_workAvailable.wakeOne();
+}
+
+void DecodeScheduler::removeLocked(PipelineTask *task) {
+    m_ready.erase(std::remove(m_ready.begin(), m_ready.end(), task), m_ready.end());
+    m_parked.erase(std::remove(m_parked.begin(), m_parked.end(), task), m_parked.end());
+}
+
+PipelineTask *DecodeScheduler::takeNextLocked() {
+    if (m_ready.empty()) return nullptr;
+
+    // 优先级最高者先执行，同优先级按入队顺序轮转
+    auto best = m_ready.begin();
+    int bestPriority = (*best)->priority();
+    for (auto it = m_ready.begin() + 1; it != m_ready.end(); ++it) {
+        int priority = (*it)->priority();
+        if (priority > bestPriority ||
+            (priority == bestPriority && (*it)->m_sequence < (*best)->m_sequence)) {
+            best = it;
+            bestPriority = priority;
+        }
+    }
+
+    PipelineTask *task = *best;
+    m_ready.erase(best);
+    return task;
+}
+
+void DecodeScheduler::promoteParkedLocked(std::chrono::steady_clock::time_point now) {
+    for (auto it = m_parked.begin(); it != m_parked.end();) {
+        if ((*it)->m_retryAt <= now) {
+            PipelineTask *task = *it;
+            it = m_parked.erase(it);
+            enqueueLocked(task);
+        } else {
+            ++it;
+        }
+    }
+}
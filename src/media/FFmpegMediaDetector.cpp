@@ -237,6 +237,58 @@ bool FFmpegMediaDetector::isImageCodec(AVCodecID codecId) {
     }
 }
 
+// 🎞️ 可能包含多帧的图片编解码器
+bool FFmpegMediaDetector::isAnimatedImageCodec(AVCodecID codecId) {
+    switch (codecId) {
+    case AV_CODEC_ID_GIF:   // GIF
+    case AV_CODEC_ID_APNG:  // 动画PNG
+    case AV_CODEC_ID_WEBP:  // WebP（动画WebP需要解码器支持ANIM块）
+        return true;
+    default: return false;
+    }
+}
+
+// 🎞️ 判断图片文件是否为动图：读取图片流的数据包，超过一帧即为动图
+bool FFmpegMediaDetector::isAnimatedImage(const QString &filePath) {
+    AVFormatContext *formatContext = nullptr;
+    if (avformat_open_input(&formatContext, filePath.toUtf8().constData(), nullptr, nullptr) !=
+        0) {
+        return false;
+    }
+
+    bool animated = false;
+    if (avformat_find_stream_info(formatContext, nullptr) >= 0) {
+        int streamIndex =
+            av_find_best_stream(formatContext, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+        if (streamIndex >= 0 &&
+            isAnimatedImageCodec(formatContext->streams[streamIndex]->codecpar->codec_id)) {
+            AVStream *stream = formatContext->streams[streamIndex];
+            if (stream->nb_frames > 1) {
+                animated = true;
+            } else {
+                // 容器未记录帧数时只需读到第二个数据包
+                AVPacket *packet = av_packet_alloc();
+                int frameCount = 0;
+                while (frameCount < 2 && av_read_frame(formatContext, packet) >= 0) {
+                    if (packet->stream_index == streamIndex) {
+                        ++frameCount;
+                    }
+                    av_packet_unref(packet);
+                }
+                av_packet_free(&packet);
+                animated = frameCount >= 2;
+            }
+        }
+    }
+
+    if (s_debugEnabled) {
+        qDebug() << "动图检测:" << filePath << "->" << (animated ? "动图" : "静态图片");
+    }
+
+    avformat_close_input(&formatContext);
+    return animated;
+}
+
 // 🎬 判断是否为视频编解码器
 bool FFmpegMediaDetector::isVideoCodec(AVCodecID codecId) {
     switch (codecId) {
@@ -1,6 +1,15 @@
 #include "media/FFmpegStream.h"
-#include <QApplication>
+#include "core/Trace.h"
+#include "media/AudioResampler.h"
+#include "media/LatencyController.h"
 #include <QDebug>
+#include <QElapsedTimer>
+#include <algorithm>
+#include <cmath>
+
+extern "C" {
+#include <libavutil/imgutils.h>
+}
 
 FFmpegStream::FFmpegStream(QObject *parent) : QObject(parent) {
     m_frameCache = std::make_unique<FrameCache>(this);
@@ -9,13 +18,59 @@ FFmpegStream::FFmpegStream(QObject *parent) : QObject(parent) {
 FFmpegStream::~FFmpegStream() { cleanup(); }
 
 bool FFmpegStream::loadVideo(const QString &filePath) {
+    if (!open(filePath)) {
+        return false;
+    }
+    start();
+    return true;
+}
+
+bool FFmpegStream::open(const QString &filePath) {
+    cleanup();
+
+    // 本地文件使用自定义I/O（内存映射），其他情况使用FFmpeg默认I/O
+    return open(filePath, MediaIO::create(filePath));
+}
+
+bool FFmpegStream::open(const QString &filePath, std::unique_ptr<MediaIO> io) {
     cleanup();
 
     m_filePath = filePath;
-    const char *filePathStr = filePath.toUtf8().constData();
+    m_live = LatencyController::isLiveUrl(filePath);
+    QByteArray filePathUtf8 = filePath.toUtf8();
+
+    m_formatContext = avformat_alloc_context();
+    if (!m_formatContext) {
+        emit errorOccurred("分配格式上下文失败");
+        return false;
+    }
+    m_formatContext->interrupt_callback = {&FFmpegStream::interruptCallback, this};
+
+    m_io = std::move(io);
+    if (m_io) {
+        if (AVIOContext *avio = m_io->avioContext()) {
+            m_formatContext->pb = avio;
+            m_formatContext->flags |= AVFMT_FLAG_CUSTOM_IO;
+        } else {
+            m_io.reset();
+        }
+    }
+
+    AVDictionary *options = nullptr;
+    if (m_live) {
+        // 直播：只探测很少的数据即开始播放（codec参数足够打开解码器即可），
+        // 解封装不做额外缓冲，网络读取超时后结束而不是无限等待
+        av_dict_set(&options, "fflags", "nobuffer", 0);
+        av_dict_set(&options, "probesize", "32768", 0);
+        av_dict_set(&options, "analyzeduration", "500000", 0);
+        av_dict_set(&options, "fpsprobesize", "0", 0);
+        av_dict_set(&options, "rw_timeout", "5000000", 0);
+        av_dict_set(&options, "overrun_nonfatal", "1", 0);  // udp接收缓冲溢出时丢包而不是报错
+    }
 
-    // 打开文件
-    int ret = avformat_open_input(&m_formatContext, filePathStr, nullptr, nullptr);
+    // 打开文件（失败时avformat_open_input会释放m_formatContext）
+    int ret = avformat_open_input(&m_formatContext, filePathUtf8.constData(), nullptr, &options);
+    av_dict_free(&options);
     if (ret != 0) {
         qDebug() << "打开视频文件失败：" << filePath << "错误码：" << ret;
         emit errorOccurred(QString("无法打开文件: %1").arg(filePath));
@@ -36,6 +91,9 @@ bool FFmpegStream::loadVideo(const QString &filePath) {
         return false;
     }
 
+    // 打开解码器（解码器生命周期与文件一致，挂起/恢复时不重新打开）
+    openCodecs();
+
     // 获取基本信息
     if (m_formatContext->duration != AV_NOPTS_VALUE) {
         m_duration = double(m_formatContext->duration) / AV_TIME_BASE;
@@ -50,27 +108,60 @@ bool FFmpegStream::loadVideo(const QString &filePath) {
     }
     qDebug() << "包含视频:" << m_hasVideo;
     qDebug() << "包含音频:" << m_hasAudio;
+    qDebug() << "包含字幕:" << m_hasSubtitle;
+    if (m_live) {
+        qDebug() << "直播模式，探测耗时按" << m_formatContext->probesize << "字节限制";
+    }
+    return true;
+}
+
+void FFmpegStream::start() {
+    if (!m_formatContext) return;
 
-    // 启动工作线程
-    startThreads();
+    // 启动解码流水线，从文件开头读取
+    startPipeline(0.0, false);
 
     m_isLoaded = true;
     emit loadFinished(true);
-    return true;
 }
 
 AVFrame *FFmpegStream::getNextVideoFrame(double *pts) {
     if (!m_isLoaded || !m_hasVideo || !m_frameCache) {
         return nullptr;
     }
-    return m_frameCache->getNextVideoFrame(pts);
+
+    double framePts = 0.0;
+    AVFrame *frame = m_frameCache->getNextVideoFrame(&framePts);
+    if (frame) {
+        m_lastVideoPts = framePts;
+        if (pts) *pts = framePts + loopOffset(m_frameCache->videoLoops());
+    }
+
+    // 整个循环已缓存，后续不再需要解码
+    if (m_frameCache->isReplayingLoop() && m_demuxThread) {
+        qDebug() << "循环帧已全部缓存，停止解码任务";
+        stopPipeline();
+    }
+    return frame;
 }
 
 AVFrame *FFmpegStream::getNextAudioFrame(double *pts) {
     if (!m_isLoaded || !m_hasAudio || !m_frameCache) {
         return nullptr;
     }
-    return m_frameCache->getNextAudioFrame(pts);
+
+    double framePts = 0.0;
+    AVFrame *frame = m_frameCache->getNextAudioFrame(&framePts);
+    if (frame) {
+        m_lastAudioPts = framePts;
+        if (pts) *pts = framePts + loopOffset(m_frameCache->audioLoops());
+    }
+
+    if (m_frameCache->isReplayingLoop() && m_demuxThread) {
+        qDebug() << "循环帧已全部缓存，停止解码任务";
+        stopPipeline();
+    }
+    return frame;
 }
 
 AVFrame *FFmpegStream::getPreviewImage() { return getNextVideoFrame(); }
@@ -84,12 +175,137 @@ void FFmpegStream::pause() { m_isPlaying = false; }
 
 void FFmpegStream::stop() {
     m_isPlaying = false;
-    stopThreads();
+    stopPipeline();
+}
+
+void FFmpegStream::suspend() {
+    if (!m_isLoaded || m_isSuspended) return;
+
+    m_isSuspended = true;
+    m_isPlaying = false;
+    m_resumePts = m_hasVideo ? m_lastVideoPts : m_lastAudioPts;
+
+    // 循环缓存重放时已没有解码任务，缓存本身很小，保留即可
+    if (m_frameCache && m_frameCache->isReplayingLoop()) return;
+
+    // 销毁解码任务，数据包和帧队列随之释放
+    stopPipeline();
+
+    // 丢弃解码器内部的参考帧，恢复时从关键帧重新开始
+    flushCodecs();
+
+    qDebug() << "挂起解码:" << m_filePath << "恢复点:" << m_resumePts << "秒";
+}
+
+void FFmpegStream::resume() {
+    if (!m_isLoaded || !m_isSuspended) return;
+
+    m_isSuspended = false;
+    if (m_frameCache && m_frameCache->isReplayingLoop()) return;
+
+    // 从恢复点之前的关键帧开始解封装，解码器丢弃恢复点之前的帧，
+    // 因此最多只需解码一个GOP即可回到挂起位置
+    startPipeline(m_resumePts, true);
+
+    qDebug() << "恢复解码:" << m_filePath << "从" << m_resumePts << "秒";
 }
 
 void FFmpegStream::seek(double seconds) {
-    if (!m_isLoaded || !m_demuxThread) return;
-    m_demuxThread->seek(seconds);
+    if (!m_isLoaded) return;
+    // A-B循环中按区间取模（时间戳按循环次数累加）
+    if (hasABLoop()) {
+        double length = m_abLoopEnd - m_abLoopStart;
+        seconds = m_abLoopStart + std::fmod(std::max(seconds - m_abLoopStart, 0.0), length);
+    }
+    m_stepPending = false;
+    if (m_frameCache && m_frameCache->seekLoop(seconds)) return;
+    if (!m_demuxThread) return;
+
+    // 只跳转解封装时，解码帧队列和解码器内部仍留有跳转前的帧（音频约2秒）。
+    // 重建流水线：清空队列、冲刷解码器，并丢弃目标之前的帧；
+    // 解封装已到文件末尾、快进/快退和倒放同样从新位置重新开始
+    restartPipeline(seconds);
+}
+
+bool FFmpegStream::isVideoFinished() const {
+    // 流水线未运行（未加载/已停止/循环重放）时不视为结束
+    if (!m_isLoaded || !m_demuxThread) return false;
+    return !m_videoDecoder || (m_videoDecoder->isFinished() && m_videoDecoder->queuedFrames() == 0);
+}
+
+bool FFmpegStream::isAudioFinished() const {
+    if (!m_isLoaded || !m_demuxThread) return false;
+    return !m_audioDecoder || (m_audioDecoder->isFinished() && m_audioDecoder->queuedFrames() == 0);
+}
+
+bool FFmpegStream::atEnd() const { return isVideoFinished() && isAudioFinished(); }
+
+void FFmpegStream::setLoopPlayback(bool loop) {
+    m_loopPlayback = loop;
+    if (m_demuxThread) {
+        m_demuxThread->setLoopPlayback(loop);
+    }
+    if (m_frameCache) {
+        m_frameCache->setLoopCacheEnabled(loop);
+    }
+}
+
+void FFmpegStream::setStepCacheLimit(qint64 bytes) {
+    if (m_frameCache) {
+        m_frameCache->setStepCacheLimit(bytes);
+    }
+}
+
+void FFmpegStream::setLoopCacheLimit(qint64 bytes) {
+    m_loopCacheLimit = bytes;
+    if (m_frameCache && !hasABLoop()) {
+        m_frameCache->setLoopCacheLimit(bytes);
+    }
+}
+
+bool FFmpegStream::setABLoop(double a, double b) {
+    if (!m_isLoaded || m_live || m_loopPlayback || m_isSuspended) return false;
+    a = std::max(a, 0.0);
+    if (m_duration > 0.0) b = std::min(b, m_duration);
+    if (b - a < MIN_AB_LOOP) return false;
+
+    m_trickSpeed = 0.0;
+    m_reverse = false;
+    m_abLoopStart = a;
+    m_abLoopEnd = b;
+    m_frameCache->setLoopCacheLimit(m_abLoopCacheLimit);
+    m_frameCache->setLoopCacheEnabled(true);
+
+    // 从A开始第一遍，缓存记录完整的区间
+    restartPipeline(a);
+    qDebug() << "A-B循环:" << a << "-" << b << "秒";
+    return true;
+}
+
+void FFmpegStream::clearABLoop() {
+    if (!hasABLoop()) return;
+
+    double current = position();
+    m_abLoopStart = 0.0;
+    m_abLoopEnd = 0.0;
+    m_frameCache->setLoopCacheLimit(m_loopCacheLimit);
+    m_frameCache->setLoopCacheEnabled(false);
+
+    // 挂起中由resume从恢复点重建
+    if (m_isSuspended) return;
+    restartPipeline(current);
+    qDebug() << "取消A-B循环，位置:" << current << "秒";
+}
+
+void FFmpegStream::setABLoopCacheLimit(qint64 bytes) {
+    m_abLoopCacheLimit = bytes;
+    if (m_frameCache && hasABLoop()) {
+        m_frameCache->setLoopCacheLimit(bytes);
+    }
+}
+
+double FFmpegStream::loopOffset(int loops) const {
+    return hasABLoop() ? loops * (m_abLoopEnd - m_abLoopStart) : 0.0;
 }
 
 int FFmpegStream::getVideoFramesInCache() const {
@@ -100,35 +316,210 @@ int FFmpegStream::getAudioFramesInCache() const {
     return m_frameCache ? m_frameCache->getAudioFrameCount() : 0;
 }
 
+PipelineStats FFmpegStream::getPipelineStats() const {
+    PipelineStats stats;
+    if (m_demuxThread) {
+        stats.demux = m_demuxThread->stepStats();
+        stats.videoPackets = m_demuxThread->videoPacketCount();
+        stats.audioPackets = m_demuxThread->audioPacketCount();
+    }
+    if (m_videoDecoder) stats.videoDecode = m_videoDecoder->stepStats();
+    if (m_audioDecoder) stats.audioDecode = m_audioDecoder->stepStats();
+    stats.videoFrames = getVideoFramesInCache();
+    stats.audioFrames = getAudioFramesInCache();
+    if (m_io) stats.io = m_io->stats();
+    return stats;
+}
+
+double FFmpegStream::liveEdgePts() const {
+    return m_demuxThread ? m_demuxThread->newestPts() : 0.0;
+}
+
+int FFmpegStream::dropFramesBefore(double pts) {
+    int dropped = 0;
+    if (m_videoDecoder) dropped = m_videoDecoder->dropFramesBefore(pts);
+    if (m_audioDecoder) m_audioDecoder->dropFramesBefore(pts);
+    return dropped;
+}
+
+int FFmpegStream::dropVideoFramesBefore(double pts) {
+    // 队列中的帧是文件中的时间戳，不含A-B循环的累加
+    if (!m_videoDecoder) return 0;
+    return m_videoDecoder->dropFramesBefore(pts - loopOffset(m_frameCache->videoLoops()));
+}
+
+void FFmpegStream::setSkipNonReference(bool skip) {
+    m_skipNonReference = skip;
+    if (m_videoDecoder) {
+        m_videoDecoder->setSkipNonReference(skip);
+    }
+}
+
+void FFmpegStream::setTrickPlay(double speed) {
+    if (!m_isLoaded || !m_hasVideo || m_live || m_loopPlayback || hasABLoop() ||
+        speed == m_trickSpeed) {
+        return;
+    }
+
+    // 同方向只调整跳转步长；进入、退出或换向时从当前画面位置重建流水线
+    bool sameDirection = (speed > 0 && m_trickSpeed > 0) || (speed < 0 && m_trickSpeed < 0);
+    m_trickSpeed = speed;
+    if (speed != 0.0) m_reverse = false;
+    if (sameDirection && m_demuxThread) {
+        m_demuxThread->setTrickStep(speed / TRICK_FRAME_RATE);
+        return;
+    }
+
+    // 挂起中由resume按新模式重建
+    if (m_isSuspended) return;
+
+    restartPipeline(m_lastVideoPts);
+    qDebug() << (speed == 0.0 ? QString("恢复正常播放") : QString("快进/快退 %1x").arg(speed))
+             << "位置:" << m_lastVideoPts << "秒";
+}
+
+void FFmpegStream::setReversePlayback(bool reverse) {
+    if (!m_isLoaded || !m_hasVideo || m_live || m_loopPlayback || hasABLoop() ||
+        reverse == m_reverse) {
+        return;
+    }
+
+    m_reverse = reverse;
+    m_trickSpeed = 0.0;
+    if (m_isSuspended) return;
+
+    restartPipeline(m_lastVideoPts);
+    qDebug() << (reverse ? "倒放" : "恢复正向播放") << "位置:" << m_lastVideoPts << "秒"
+             << "每段最多" << reverseWindowFrames() << "帧";
+}
+
+bool FFmpegStream::stepBackward() {
+    if (!m_isLoaded || !m_hasVideo || m_live || m_isSuspended || !m_frameCache) return false;
+    if (m_frameCache->stepBack()) return true;
+    if (m_frameCache->isReplayingLoop() || m_trickSpeed != 0.0 || m_reverse || hasABLoop()) {
+        return false;
+    }
+
+    // 未命中：从上一帧之前的关键帧重新解码到当前画面，途经的帧都进入缓存。
+    // 解码一个GOP可能需要较长时间，由pollStepBackward在GUI定时器中逐步取帧
+    double current = m_lastVideoPts;
+    double frameDuration = m_fps > 0 ? 1.0 / m_fps : 1.0 / 30;
+    restartPipeline(std::max(0.0, current - frameDuration), true);
+    m_stepPending = true;
+    m_stepTarget = current - frameDuration / 2;
+    m_stepDecoded = 0;
+    m_stepTimer.start();
+    return false;
+}
+
+bool FFmpegStream::pollStepBackward() {
+    if (!m_stepPending) return false;
+
+    // 只取已在队列中的帧，不等待解码
+    bool reached = false;
+    double next = 0.0;
+    while (!reached && peekVideoPts(&next)) {
+        double pts = 0.0;
+        AVFrame *frame = m_frameCache->getNextVideoFrame(&pts);
+        if (!frame) break;
+        av_frame_free(&frame);
+        ++m_stepDecoded;
+        reached = pts >= m_stepTarget;
+    }
+    if (!reached && !isVideoFinished() && m_stepTimer.elapsed() < STEP_REFILL_TIMEOUT_MS) {
+        return false;
+    }
+
+    m_stepPending = false;
+    qDebug() << "逐帧缓存未命中，重新解码" << m_stepDecoded << "帧，耗时" << m_stepTimer.elapsed()
+             << "毫秒";
+    return m_frameCache->stepBack();
+}
+
+int FFmpegStream::videoFrameBytes() const {
+    int frameBytes = m_videoCodecContext ? av_image_get_buffer_size(m_videoCodecContext->pix_fmt,
+                                                                    m_width, m_height, 1)
+                                         : 0;
+    if (frameBytes <= 0) frameBytes = m_width * m_height * 3 / 2;
+    return std::max(frameBytes, 1);
+}
+
+int FFmpegStream::reverseWindowFrames() const {
+    // 正在显示的一段和正在解码的一段各占一半预算
+    return int(std::max<qint64>(2, m_reverseCacheLimit / (2 * qint64(videoFrameBytes()))));
+}
+
+void FFmpegStream::restartPipeline(double startPts, bool fromKeyframe) {
+    stopPipeline();
+    flushCodecs();
+    startPipeline(startPts, true, fromKeyframe);
+}
+
+bool FFmpegStream::peekVideoPts(double *pts) const {
+    return m_videoDecoder && m_videoDecoder->peekPts(pts);
+}
+
+int FFmpegStream::interruptCallback(void *opaque) {
+    return static_cast<FFmpegStream *>(opaque)->m_abortRequested ? 1 : 0;
+}
+
 AVCodecContext *FFmpegStream::getAudioCodecContext() const { return m_audioCodecContext; }
 
 void FFmpegStream::cleanup() {
-    stopThreads();
+    // 网络输入可能阻塞在读取中，先中止再停止流水线
+    m_abortRequested = true;
+    if (m_io) m_io->abort();
+    stopPipeline();
 
     if (m_formatContext) {
         avformat_close_input(&m_formatContext);
         m_formatContext = nullptr;
     }
+    // 自定义I/O必须在格式上下文关闭之后释放
+    m_io.reset();
+    m_abortRequested = false;
+
+    if (m_videoCodecContext) {
+        avcodec_free_context(&m_videoCodecContext);
+        m_videoCodecContext = nullptr;
+    }
 
     if (m_audioCodecContext) {
         avcodec_free_context(&m_audioCodecContext);
         m_audioCodecContext = nullptr;
     }
 
+    if (m_subtitleCodecContext) {
+        avcodec_free_context(&m_subtitleCodecContext);
+        m_subtitleCodecContext = nullptr;
+    }
+
     m_videoStreamIndex = -1;
     m_audioStreamIndex = -1;
+    m_subtitleStreamIndex = -1;
     m_hasVideo = false;
     m_hasAudio = false;
+    m_hasSubtitle = false;
     m_isLoaded = false;
     m_isPlaying = false;
+    m_isSuspended = false;
+    m_lastVideoPts = 0.0;
+    m_lastAudioPts = 0.0;
+    m_resumePts = 0.0;
+    m_trickSpeed = 0.0;
+    m_reverse = false;
+    m_abLoopStart = 0.0;
+    m_abLoopEnd = 0.0;
+    m_subtitles.clear();
 
     if (m_frameCache) {
+        m_frameCache->setLoopCacheLimit(m_loopCacheLimit);
         m_frameCache->clear();
     }
 }
 
 bool FFmpegStream::initializeStreams() {
-    // 查找视频和音频流
+    // 查找视频、音频和字幕流（各取第一个）
     for (unsigned int i = 0; i < m_formatContext->nb_streams; ++i) {
         AVStream *stream = m_formatContext->streams[i];
 
@@ -153,76 +544,279 @@ bool FFmpegStream::initializeStreams() {
         } else if (stream->codecpar->codec_type == AVMEDIA_TYPE_AUDIO && m_audioStreamIndex == -1) {
             m_audioStreamIndex = i;
             m_hasAudio = true;
+        } else if (stream->codecpar->codec_type == AVMEDIA_TYPE_SUBTITLE &&
+                   m_subtitleStreamIndex == -1) {
+            m_subtitleStreamIndex = i;
+            m_hasSubtitle = true;
         }
     }
 
     return m_hasVideo || m_hasAudio;
 }
 
-void FFmpegStream::startThreads() {
-    // 创建解封装线程
+void FFmpegStream::openCodecs() {
+    if (m_hasVideo) {
+        m_videoCodecContext = openCodec(m_videoStreamIndex);
+    }
+    if (m_hasAudio) {
+        m_audioCodecContext = openCodec(m_audioStreamIndex);
+    }
+    if (m_hasSubtitle) {
+        m_subtitleCodecContext = openCodec(m_subtitleStreamIndex);
+        m_hasSubtitle = m_subtitleCodecContext != nullptr;
+    }
+}
+
+AVCodecContext *FFmpegStream::openCodec(int streamIndex) const {
+    AVStream *stream = m_formatContext->streams[streamIndex];
+    const AVCodec *codec = avcodec_find_decoder(stream->codecpar->codec_id);
+    if (!codec) {
+        qDebug() << "找不到解码器:" << avcodec_get_name(stream->codecpar->codec_id);
+        return nullptr;
+    }
+
+    AVCodecContext *ctx = avcodec_alloc_context3(codec);
+    avcodec_parameters_to_context(ctx, stream->codecpar);
+    ctx->pkt_timebase = stream->time_base;
+    if (m_live) {
+        // 帧级多线程每个线程都要缓冲一帧，直播只用片级多线程
+        ctx->flags |= AV_CODEC_FLAG_LOW_DELAY;
+        ctx->thread_type = FF_THREAD_SLICE;
+    }
+    if (avcodec_open2(ctx, codec, nullptr) < 0) {
+        qDebug() << "打开解码器失败:" << codec->name;
+        avcodec_free_context(&ctx);
+        return nullptr;
+    }
+    return ctx;
+}
+
+void FFmpegStream::flushCodecs() {
+    if (m_videoCodecContext) avcodec_flush_buffers(m_videoCodecContext);
+    if (m_audioCodecContext) avcodec_flush_buffers(m_audioCodecContext);
+    if (m_subtitleCodecContext) avcodec_flush_buffers(m_subtitleCodecContext);
+}
+
+void FFmpegStream::startPipeline(double startPts, bool seekFirst, bool fromKeyframe) {
+    m_stepPending = false;
+
+    // 创建解封装任务
     m_demuxThread = std::make_unique<DemuxThread>(this);
     m_demuxThread->setFormatContext(m_formatContext, m_videoStreamIndex, m_audioStreamIndex);
+    m_demuxThread->setLoopPlayback(m_loopPlayback);
+    if (hasABLoop()) {
+        m_demuxThread->setLoopRange(m_abLoopStart, m_abLoopEnd);
+    }
+    bool trick = m_trickSpeed != 0.0;
+    if (m_live) {
+        m_demuxThread->setQueueLimits(LIVE_VIDEO_PACKETS, LIVE_AUDIO_PACKETS);
+    }
+    if (trick) {
+        m_demuxThread->setQueueLimits(TRICK_PACKETS, TRICK_PACKETS);
+        m_demuxThread->setTrickPlay(startPts, m_trickSpeed / TRICK_FRAME_RATE);
+    } else if (m_reverse) {
+        m_demuxThread->setReversePlayback(startPts, reverseWindowFrames());
+    } else if (seekFirst) {
+        m_demuxThread->seek(startPts);
+    }
+    connect(m_demuxThread.get(), &DemuxThread::finished, this, &FFmpegStream::onDemuxFinished);
+
+    // 创建解码任务
+    if (m_videoCodecContext) {
+        m_videoDecoder = std::make_unique<VideoDecoder>(this);
+        m_videoDecoder->setCodecContext(m_videoCodecContext);
+        m_videoDecoder->setDemuxThread(m_demuxThread.get());
+        // 快退和倒放的帧早于起点，不能按起点丢弃
+        m_videoDecoder->setDiscardBefore(trick || m_reverse || fromKeyframe ? 0.0 : startPts);
+        if (hasABLoop()) m_videoDecoder->setDiscardAfter(m_abLoopEnd);
+        m_videoDecoder->setSkipNonReference(m_skipNonReference);
+        m_videoDecoder->setKeyframesOnly(trick);
+        m_videoDecoder->setReverse(m_reverse);
+        int maxFrames = m_live ? std::min(m_maxVideoFrames, LIVE_VIDEO_FRAMES) : m_maxVideoFrames;
+        m_videoDecoder->setMaxFrames(trick ? TRICK_FRAMES : maxFrames);
+        connect(m_videoDecoder.get(), &VideoDecoder::errorOccurred, this,
+                &FFmpegStream::onVideoDecodeError);
+    }
 
-    // 创建解码线程
-    if (m_hasVideo) {
-        AVStream *videoStream = m_formatContext->streams[m_videoStreamIndex];
-        const AVCodec *videoCodec = avcodec_find_decoder(videoStream->codecpar->codec_id);
-        if (videoCodec) {
-            AVCodecContext *videoCtx = avcodec_alloc_context3(videoCodec);
-            avcodec_parameters_to_context(videoCtx, videoStream->codecpar);
-            if (avcodec_open2(videoCtx, videoCodec, nullptr) >= 0) {
-                m_videoDecoder = std::make_unique<VideoDecoder>(this);
-                m_videoDecoder->setCodecContext(videoCtx);
-                m_videoDecoder->setDemuxThread(m_demuxThread.get());
-            }
-        }
+    // 快进/快退和倒放时静音，不解码音频
+    if (m_audioCodecContext && !trick && !m_reverse) {
+        m_audioDecoder = std::make_unique<AudioDecoder>(this);
+        m_audioDecoder->setCodecContext(m_audioCodecContext);
+        m_audioDecoder->setDemuxThread(m_demuxThread.get());
+        m_audioDecoder->setDiscardBefore(startPts);
+        if (hasABLoop()) m_audioDecoder->setDiscardAfter(m_abLoopEnd);
+        m_audioDecoder->setMaxFrames(m_live ? std::min(m_maxAudioFrames, LIVE_AUDIO_FRAMES)
+                                            : m_maxAudioFrames);
+        connect(m_audioDecoder.get(), &AudioDecoder::errorOccurred, this,
+                &FFmpegStream::onAudioDecodeError);
     }
 
-    if (m_hasAudio) {
-        AVStream *audioStream = m_formatContext->streams[m_audioStreamIndex];
-        const AVCodec *audioCodec = avcodec_find_decoder(audioStream->codecpar->codec_id);
-        if (audioCodec) {
-            m_audioCodecContext = avcodec_alloc_context3(audioCodec);
-            avcodec_parameters_to_context(m_audioCodecContext, audioStream->codecpar);
-            if (avcodec_open2(m_audioCodecContext, audioCodec, nullptr) >= 0) {
-                m_audioDecoder = std::make_unique<AudioDecoder>(this);
-                m_audioDecoder->setCodecContext(m_audioCodecContext);
-                m_audioDecoder->setDemuxThread(m_demuxThread.get());
-            }
-        }
+    // 快进/快退和倒放的画面不连续，不显示字幕
+    if (m_subtitleCodecContext && !trick && !m_reverse) {
+        m_subtitleDecoder = std::make_unique<SubtitleDecoder>(this);
+        m_subtitleDecoder->setCodecContext(m_subtitleCodecContext);
+        m_subtitleDecoder->setDemuxThread(m_demuxThread.get());
+        m_subtitleDecoder->setTrack(&m_subtitles);
+        m_subtitleDecoder->setCanvasSize(m_width, m_height);
     }
 
-    // 设置帧缓存的解码器引用
+    m_demuxThread->setConsumers(m_videoDecoder.get(), m_audioDecoder.get());
+    m_demuxThread->setSubtitleStream(m_subtitleDecoder ? m_subtitleStreamIndex : -1,
+                                     m_subtitleDecoder.get());
+
+    // 设置帧缓存的解码器引用；快进/快退和倒放的帧不连续，不用于逐帧
     m_frameCache->setDecoders(m_videoDecoder.get(), m_audioDecoder.get());
+    m_frameCache->setStepCacheEnabled(!trick && !m_reverse && !m_live && !hasABLoop());
 
-    // 启动线程
-    if (m_demuxThread) m_demuxThread->start();
-    if (m_videoDecoder) m_videoDecoder->start();
-    if (m_audioDecoder) m_audioDecoder->start();
+    // 交给共享线程池调度
+    DecodeScheduler &scheduler = DecodeScheduler::instance();
+    for (PipelineTask *task : pipelineTasks()) {
+        task->setForeground(m_foreground);
+        scheduler.attach(task);
+    }
 }
 
-void FFmpegStream::stopThreads() {
-    // 请求所有线程停止
-    if (m_demuxThread) {
-        m_demuxThread->requestStop();
-        m_demuxThread->wait(3000);
+void FFmpegStream::stopPipeline() {
+    // 帧缓存不再引用即将销毁的解码器，逐帧缓存随流水线释放
+    if (m_frameCache) {
+        m_frameCache->setDecoders(nullptr, nullptr);
+        m_frameCache->clearStepFrames();
     }
 
-    if (m_videoDecoder) {
-        m_videoDecoder->requestStop();
-        m_videoDecoder->wait(3000);
-    }
+    if (m_demuxThread) m_demuxThread->requestStop();
+    if (m_videoDecoder) m_videoDecoder->requestStop();
+    if (m_audioDecoder) m_audioDecoder->requestStop();
+    if (m_subtitleDecoder) m_subtitleDecoder->requestStop();
 
-    if (m_audioDecoder) {
-        m_audioDecoder->requestStop();
-        m_audioDecoder->wait(3000);
+    // 先全部移出调度再销毁，避免任务唤醒已销毁的其他任务
+    DecodeScheduler &scheduler = DecodeScheduler::instance();
+    for (PipelineTask *task : pipelineTasks()) {
+        scheduler.detach(task);
     }
 
     // 清理
     m_demuxThread.reset();
     m_videoDecoder.reset();
     m_audioDecoder.reset();
+    m_subtitleDecoder.reset();
+}
+
+std::vector<PipelineTask *> FFmpegStream::pipelineTasks() const {
+    std::vector<PipelineTask *> tasks;
+    if (m_demuxThread) tasks.push_back(m_demuxThread.get());
+    if (m_videoDecoder) tasks.push_back(m_videoDecoder.get());
+    if (m_audioDecoder) tasks.push_back(m_audioDecoder.get());
+    if (m_subtitleDecoder) tasks.push_back(m_subtitleDecoder.get());
+    return tasks;
+}
+
+void FFmpegStream::setForeground(bool foreground) {
+    m_foreground = foreground;
+    for (PipelineTask *task : pipelineTasks()) {
+        task->setForeground(foreground);
+    }
+}
+
+std::shared_ptr<const SubtitleData> FFmpegStream::subtitleAt(double pts) const {
+    return m_hasSubtitle ? m_subtitles.at(pts) : nullptr;
+}
+
+std::vector<TrackInfo> FFmpegStream::tracks(AVMediaType type) const {
+    std::vector<TrackInfo> result;
+    if (!m_formatContext) return result;
+
+    for (unsigned int i = 0; i < m_formatContext->nb_streams; ++i) {
+        AVStream *stream = m_formatContext->streams[i];
+        if (stream->codecpar->codec_type != type) continue;
+
+        TrackInfo info;
+        info.streamIndex = int(i);
+        if (AVDictionaryEntry *entry = av_dict_get(stream->metadata, "language", nullptr, 0)) {
+            info.language = QString::fromUtf8(entry->value);
+        }
+        if (AVDictionaryEntry *entry = av_dict_get(stream->metadata, "title", nullptr, 0)) {
+            info.title = QString::fromUtf8(entry->value);
+        }
+        info.codec = avcodec_get_name(stream->codecpar->codec_id);
+        result.push_back(info);
+    }
+    return result;
+}
+
+int FFmpegStream::currentTrack(AVMediaType type) const {
+    switch (type) {
+    case AVMEDIA_TYPE_VIDEO: return m_videoStreamIndex;
+    case AVMEDIA_TYPE_AUDIO: return m_audioStreamIndex;
+    case AVMEDIA_TYPE_SUBTITLE: return m_subtitleCodecContext ? m_subtitleStreamIndex : -1;
+    default: return -1;
+    }
+}
+
+bool FFmpegStream::selectTrack(AVMediaType type, int streamIndex) {
+    if (!m_formatContext || streamIndex < 0 || streamIndex >= int(m_formatContext->nb_streams)) {
+        return false;
+    }
+    AVStream *stream = m_formatContext->streams[streamIndex];
+    if (stream->codecpar->codec_type != type) return false;
+
+    int *currentIndex = nullptr;
+    AVCodecContext **codecContext = nullptr;
+    switch (type) {
+    case AVMEDIA_TYPE_VIDEO:
+        currentIndex = &m_videoStreamIndex;
+        codecContext = &m_videoCodecContext;
+        break;
+    case AVMEDIA_TYPE_AUDIO:
+        currentIndex = &m_audioStreamIndex;
+        codecContext = &m_audioCodecContext;
+        break;
+    case AVMEDIA_TYPE_SUBTITLE:
+        currentIndex = &m_subtitleStreamIndex;
+        codecContext = &m_subtitleCodecContext;
+        break;
+    default: return false;
+    }
+    if (*currentIndex == streamIndex && *codecContext) return true;
+
+    // 编解码参数在打开文件时已探测，直接据此打开新解码器；失败时旧轨道继续播放
+    AVCodecContext *newContext = openCodec(streamIndex);
+    if (!newContext) return false;
+
+    // 销毁流水线，旧流已排队的数据包和帧随之丢弃
+    double current = position();
+    stopPipeline();
+    if (*codecContext) avcodec_free_context(codecContext);
+    *codecContext = newContext;
+    *currentIndex = streamIndex;
+
+    if (type == AVMEDIA_TYPE_VIDEO) {
+        m_width = stream->codecpar->width;
+        m_height = stream->codecpar->height;
+        AVRational frameRate = stream->avg_frame_rate.num > 0 && stream->avg_frame_rate.den > 0
+                                   ? stream->avg_frame_rate
+                                   : stream->r_frame_rate;
+        if (frameRate.num > 0 && frameRate.den > 0) {
+            m_fps = double(frameRate.num) / frameRate.den;
+        }
+    } else if (type == AVMEDIA_TYPE_SUBTITLE) {
+        m_hasSubtitle = true;
+        m_subtitles.clear();
+    }
+
+    // 循环缓存中是旧轨道的帧；记录中途切换无法保证完整，A-B循环改为从数据流重复读取
+    if (type != AVMEDIA_TYPE_SUBTITLE && m_frameCache) {
+        m_frameCache->clear();
+        m_frameCache->seekLoop(current);
+    }
+
+    qDebug() << "切换轨道:" << av_get_media_type_string(type) << "流" << streamIndex << "位置"
+             << current << "秒";
+
+    // 挂起中由resume从恢复点重建
+    if (!m_isLoaded || m_isSuspended) return true;
+    flushCodecs();
+    startPipeline(current, true);
+    return true;
 }
 
 void FFmpegStream::onDemuxFinished() { emit endOfStream(); }
@@ -231,13 +825,18 @@ void FFmpegStream::onVideoDecodeError() { emit errorOccurred("视频解码错误
 
 void FFmpegStream::onAudioDecodeError() { emit errorOccurred("音频解码错误"); }
 
-// ============== DemuxThread 解封装线程实现 ==============
+// ============== DemuxThread 解封装任务实现 ==============
 
-DemuxThread::DemuxThread(FFmpegStream *parent) : QThread(parent), m_parent(parent) {}
+DemuxThread::DemuxThread(FFmpegStream *parent)
+    : QObject(parent), PipelineTask(Stage::Demux), m_parent(parent) {}
 
 DemuxThread::~DemuxThread() {
     requestStop();
-    wait();
+    DecodeScheduler::instance().detach(this);
+
+    if (m_readPacket) {
+        av_packet_free(&m_readPacket);
+    }
 }
 
 void DemuxThread::setFormatContext(AVFormatContext *ctx, int videoIndex, int audioIndex) {
@@ -246,153 +845,418 @@ void DemuxThread::setFormatContext(AVFormatContext *ctx, int videoIndex, int aud
     m_audioStreamIndex = audioIndex;
 }
 
-void DemuxThread::requestStop() {
-    m_stopRequested = true;
+void DemuxThread::setConsumers(PipelineTask *video, PipelineTask *audio) {
+    m_videoConsumer = video;
+    m_audioConsumer = audio;
+}
+
+void DemuxThread::setSubtitleStream(int streamIndex, PipelineTask *consumer) {
+    m_subtitleStreamIndex = streamIndex;
+    m_subtitleConsumer = consumer;
+}
+
+void DemuxThread::requestStop() { m_stopRequested = true; }
 
-    // 唤醒所有等待的线程
-    m_videoCondition.wakeAll();
-    m_audioCondition.wakeAll();
+void DemuxThread::setQueueLimits(int videoPackets, int audioPackets) {
+    m_videoPacketQueue.setCapacity(size_t(videoPackets));
+    m_audioPacketQueue.setCapacity(size_t(audioPackets));
 }
 
 void DemuxThread::seek(double seconds) {
     m_seekTime = seconds;
     m_seekRequested = true;
+    DecodeScheduler::instance().wake(this);
 }
 
-void DemuxThread::run() {
-    if (!m_formatContext) {
-        emit errorOccurred("格式上下文为空");
-        return;
+PipelineTask::StepResult DemuxThread::step() {
+    TRACE_SCOPE("DemuxThread::step", "pipeline");
+
+    if (m_stopRequested) {
+        return StepResult::Finished;
     }
 
-    AVPacket *packet = av_packet_alloc();
-    if (!packet) {
-        emit errorOccurred("分配数据包失败");
-        return;
+    if (!m_formatContext) {
+        emit errorOccurred("格式上下文为空");
+        return StepResult::Finished;
     }
 
-    while (!m_stopRequested) {
-        // 处理跳转请求
-        if (m_seekRequested) {
-            int64_t seekTarget = int64_t(m_seekTime * AV_TIME_BASE);
-            if (av_seek_frame(m_formatContext, -1, seekTarget, AVSEEK_FLAG_BACKWARD) >= 0) {
-                // 清空队列
-                {
-                    QMutexLocker videoLocker(&m_videoMutex);
-                    m_videoPacketQueue.clear();
-                }
-                {
-                    QMutexLocker audioLocker(&m_audioMutex);
-                    m_audioPacketQueue.clear();
-                }
-            }
-            m_seekRequested = false;
+    if (!m_readPacket) {
+        m_readPacket = av_packet_alloc();
+        if (!m_readPacket) {
+            emit errorOccurred("分配数据包失败");
+            return StepResult::Finished;
         }
+    }
 
-        // 检查队列是否已满
-        bool videoFull = (m_videoStreamIndex >= 0) && isVideoQueueFull();
-        bool audioFull = (m_audioStreamIndex >= 0) && isAudioQueueFull();
-
-        if (videoFull && audioFull) {
-            // 两个队列都满了，等待一下
-            QThread::msleep(10);
-            continue;
-        }
+    if (m_trickStep != 0.0) {
+        return trickStep(m_readPacket);
+    }
+    if (m_reverse) {
+        return reverseStep(m_readPacket);
+    }
 
-        // 读取数据包
-        int ret = av_read_frame(m_formatContext, packet);
-        if (ret < 0) {
-            if (ret == AVERROR_EOF) {
-                qDebug() << "解封装完成，到达文件末尾";
-                emit finished();
-            } else {
-                emit errorOccurred(QString("读取数据包失败，错误码: %1").arg(ret));
-            }
-            break;
+    // 处理跳转请求
+    if (m_seekRequested) {
+        int64_t seekTarget = int64_t(m_seekTime * AV_TIME_BASE);
+        if (av_seek_frame(m_formatContext, -1, seekTarget, AVSEEK_FLAG_BACKWARD) >= 0) {
+            // 清空队列
+            m_pendingPacket.reset();
+            m_videoPacketQueue.clear();
+            m_audioPacketQueue.clear();
+            m_subtitlePacketQueue.clear();
         }
+        m_seekRequested = false;
+    }
 
-        // 计算时间戳
-        double pts = 0.0;
-        if (packet->pts != AV_NOPTS_VALUE) {
-            AVStream *stream = m_formatContext->streams[packet->stream_index];
-            pts = packet->pts * av_q2d(stream->time_base);
+    // 上次因队列已满暂存的数据包
+    if (m_pendingPacket) {
+        if (!pushPacket(m_pendingPacket, m_pendingStreamIndex)) {
+            return StepResult::Idle;
         }
+    }
 
-        // 分发数据包
-        if (packet->stream_index == m_videoStreamIndex && !videoFull) {
-            // 视频数据包
-            AVPacket *videoPkt = av_packet_clone(packet);
-            auto packetData = std::make_unique<PacketData>(videoPkt, pts);
-
-            QMutexLocker locker(&m_videoMutex);
-            m_videoPacketQueue.push_back(std::move(packetData));
-            m_videoCondition.wakeOne();
-        } else if (packet->stream_index == m_audioStreamIndex && !audioFull) {
-            // 音频数据包
-            AVPacket *audioPkt = av_packet_clone(packet);
-            auto packetData = std::make_unique<PacketData>(audioPkt, pts);
-
-            QMutexLocker locker(&m_audioMutex);
-            m_audioPacketQueue.push_back(std::move(packetData));
-            m_audioCondition.wakeOne();
-        }
+    // 读取数据包
+    AVPacket *packet = m_readPacket;
+    int ret = av_read_frame(m_formatContext, packet);
+    bool abLoop = m_loopEnd > m_loopStart;
+    if (ret == AVERROR_EOF && (m_loopPlayback || abLoop) &&
+        rewindForLoop(abLoop ? m_loopStart : 0.0)) {
+        return StepResult::Progress;
+    }
+    if (ret < 0) {
+        return finishReading(ret);
+    }
 
+    int streamIndex = packet->stream_index;
+    if (streamIndex != m_videoStreamIndex && streamIndex != m_audioStreamIndex &&
+        streamIndex != m_subtitleStreamIndex) {
         av_packet_unref(packet);
+        return StepResult::Progress;
     }
 
-    av_packet_free(&packet);
-    qDebug() << "解封装线程退出";
-}
-
-bool DemuxThread::getVideoPacket(std::unique_ptr<PacketData> &packet) {
-    QMutexLocker locker(&m_videoMutex);
-
-    while (m_videoPacketQueue.empty() && !m_stopRequested) {
-        m_videoCondition.wait(&m_videoMutex, 100);
+    // 计算时间戳
+    double pts = 0.0;
+    if (packet->pts != AV_NOPTS_VALUE) {
+        AVStream *stream = m_formatContext->streams[streamIndex];
+        pts = packet->pts * av_q2d(stream->time_base);
+        if (pts > m_newestPts) m_newestPts = pts;
     }
 
-    if (!m_videoPacketQueue.empty()) {
-        packet = std::move(m_videoPacketQueue.front());
-        m_videoPacketQueue.pop_front();
-        return true;
+    // A-B循环：解码顺序不晚于显示顺序，视频数据包的解码时间戳到达B时B之前的帧都已读到，
+    // 跳回A；音频和字幕只保留B之前的数据包
+    if (abLoop) {
+        AVStream *stream = m_formatContext->streams[streamIndex];
+        int64_t ts = packet->dts != AV_NOPTS_VALUE ? packet->dts : packet->pts;
+        double time = ts != AV_NOPTS_VALUE ? ts * av_q2d(stream->time_base) : pts;
+        if (time >= m_loopEnd) {
+            av_packet_unref(packet);
+            if (streamIndex == m_videoStreamIndex ||
+                (m_videoStreamIndex < 0 && streamIndex == m_audioStreamIndex)) {
+                if (!rewindForLoop(m_loopStart)) return finishReading(AVERROR_EOF);
+            }
+            return StepResult::Progress;
+        }
     }
 
-    return false;
-}
-
-bool DemuxThread::getAudioPacket(std::unique_ptr<PacketData> &packet) {
-    QMutexLocker locker(&m_audioMutex);
-
-    while (m_audioPacketQueue.empty() && !m_stopRequested) {
-        m_audioCondition.wait(&m_audioMutex, 100);
-    }
+    // 转移数据包引用，读取包可直接复用
+    AVPacket *queuedPacket = av_packet_alloc();
+    av_packet_move_ref(queuedPacket, packet);
+    auto packetData = std::make_unique<PacketData>(queuedPacket, pts);
 
-    if (!m_audioPacketQueue.empty()) {
-        packet = std::move(m_audioPacketQueue.front());
-        m_audioPacketQueue.pop_front();
-        return true;
+    // 目标队列已满时暂存，不丢弃数据包
+    if (!pushPacket(packetData, streamIndex)) {
+        m_pendingPacket = std::move(packetData);
+        m_pendingStreamIndex = streamIndex;
+        return StepResult::Idle;
     }
 
-    return false;
+    return StepResult::Progress;
 }
 
-bool DemuxThread::isVideoQueueFull() const {
-    QMutexLocker locker(&m_videoMutex);
-    return m_videoPacketQueue.size() >= MAX_VIDEO_PACKETS;
+PipelineTask::StepResult DemuxThread::finishReading(int ret) {
+    m_reachedEnd = true;
+    if (ret == AVERROR_EOF) {
+        qDebug() << "解封装完成，到达文件末尾";
+        emit finished();
+    } else {
+        emit errorOccurred(QString("读取数据包失败，错误码: %1").arg(ret));
+    }
+
+    // 通知解码器取出剩余帧
+    DecodeScheduler::instance().wake(m_videoConsumer);
+    DecodeScheduler::instance().wake(m_audioConsumer);
+    DecodeScheduler::instance().wake(m_subtitleConsumer);
+    return StepResult::Finished;
 }
 
-bool DemuxThread::isAudioQueueFull() const {
-    QMutexLocker locker(&m_audioMutex);
-    return m_audioPacketQueue.size() >= MAX_AUDIO_PACKETS;
+void DemuxThread::setTrickPlay(double startPts, double step) {
+    m_trickTarget = startPts;
+    m_trickStep = step;
+    m_hasLastKey = false;
+    m_trickSought = false;
+    m_trickRetries = 0;
 }
 
-// ============== VideoDecoder 视频解码器实现 ==============
+PipelineTask::StepResult DemuxThread::trickStep(AVPacket *packet) {
+    // 上一个关键帧还在等待队列空位（显示端按倍速取帧，读取随之推进）
+    if (m_pendingPacket) {
+        if (!pushPacket(m_pendingPacket, m_pendingStreamIndex)) {
+            return StepResult::Idle;
+        }
+    }
 
-VideoDecoder::VideoDecoder(FFmpegStream *parent) : QThread(parent), m_parent(parent) {}
+    AVStream *stream = m_formatContext->streams[m_videoStreamIndex];
+    double timeBase = av_q2d(stream->time_base);
+    double step = m_trickStep;
+    bool forward = step > 0;
+
+    // 快进跳到目标之后的第一个关键帧，快退跳到目标之前的最后一个关键帧；
+    // 有索引的格式（MP4/MKV）直接定位，其余格式由FFmpeg按时间戳二分查找
+    if (!m_trickSought) {
+        int64_t target = std::llround(m_trickTarget / timeBase);
+        int flags = forward ? 0 : AVSEEK_FLAG_BACKWARD;
+        if (av_seek_frame(m_formatContext, m_videoStreamIndex, target, flags) < 0) {
+            return finishReading(AVERROR_EOF);
+        }
+        m_trickSought = true;
+        return StepResult::Progress;
+    }
+
+    // 跳转后读到第一个视频关键帧为止，其余数据包直接丢弃
+    int ret = av_read_frame(m_formatContext, packet);
+    if (ret < 0) {
+        return finishReading(ret);
+    }
+    if (packet->stream_index != m_videoStreamIndex || !(packet->flags & AV_PKT_FLAG_KEY)) {
+        av_packet_unref(packet);
+        return StepResult::Progress;
+    }
+    int64_t timestamp = packet->pts != AV_NOPTS_VALUE ? packet->pts : packet->dts;
+    double pts = timestamp != AV_NOPTS_VALUE ? timestamp * timeBase : m_trickTarget;
+    m_trickSought = false;
+
+    // 关键帧间隔大于步长或格式不支持按方向跳转时会回到同一个关键帧：
+    // 沿播放方向加倍移动目标，快退越过文件开头后结束
+    bool advanced = !m_hasLastKey || (forward ? pts > m_lastKeyPts : pts < m_lastKeyPts);
+    if (!advanced) {
+        av_packet_unref(packet);
+        double startTime = stream->start_time != AV_NOPTS_VALUE ? stream->start_time * timeBase : 0;
+        if (!forward && m_trickTarget < startTime) {
+            return finishReading(AVERROR_EOF);
+        }
+        m_trickTarget += step * (1 << std::min(m_trickRetries++, 6));
+        return StepResult::Progress;
+    }
+
+    // 下一目标以实际读到的关键帧为基准，关键帧稀疏时误差不会累积
+    m_lastKeyPts = pts;
+    m_hasLastKey = true;
+    m_trickRetries = 0;
+    m_trickTarget = pts + step;
+
+    AVPacket *queuedPacket = av_packet_alloc();
+    av_packet_move_ref(queuedPacket, packet);
+    auto packetData = std::make_unique<PacketData>(queuedPacket, pts);
+    if (!pushPacket(packetData, m_videoStreamIndex)) {
+        m_pendingPacket = std::move(packetData);
+        m_pendingStreamIndex = m_videoStreamIndex;
+        return StepResult::Idle;
+    }
+    return StepResult::Progress;
+}
+
+void DemuxThread::setReversePlayback(double endPts, int windowFrames) {
+    m_reverse = true;
+    m_reverseWindow = windowFrames;
+    m_reverseEnd = endPts;
+    m_reverseSought = false;
+    m_segmentReady = false;
+    m_segmentPackets.clear();
+}
+
+PipelineTask::StepResult DemuxThread::reverseStep(AVPacket *packet) {
+    // 已读完的一段等解码器取完上一段的数据包后整段送出：解码器最多领先显示一段，
+    // 读取也只领先解码一段
+    if (m_segmentReady) {
+        if (m_videoPacketQueue.size() > 0) {
+            return StepResult::Idle;
+        }
+        auto start = std::make_unique<PacketData>(nullptr, m_segmentStart);
+        start->marker = PacketData::Marker::SegmentStart;
+        start->segmentEnd = m_segmentEnd;
+        m_videoPacketQueue.forcePush(std::move(start));
+        for (auto &segmentPacket : m_segmentPackets) {
+            m_videoPacketQueue.forcePush(std::move(segmentPacket));
+        }
+        m_segmentPackets.clear();
+        auto end = std::make_unique<PacketData>(nullptr, m_segmentEnd);
+        end->marker = PacketData::Marker::SegmentEnd;
+        m_videoPacketQueue.forcePush(std::move(end));
+
+        m_segmentReady = false;
+        DecodeScheduler::instance().wake(m_videoConsumer);
+        return StepResult::Progress;
+    }
+
+    AVStream *stream = m_formatContext->streams[m_videoStreamIndex];
+    double timeBase = av_q2d(stream->time_base);
+
+    // 跳到本段终点之前的最后一个关键帧
+    if (!m_reverseSought) {
+        int64_t target = std::llround(m_reverseEnd / timeBase) - 1;
+        if (av_seek_frame(m_formatContext, m_videoStreamIndex, target, AVSEEK_FLAG_BACKWARD) < 0) {
+            return finishReading(AVERROR_EOF);
+        }
+        m_reverseSought = true;
+        m_reverseHasKey = false;
+        return StepResult::Progress;
+    }
+
+    int ret = av_read_frame(m_formatContext, packet);
+    if (ret == AVERROR_EOF) {
+        return m_reverseHasKey ? completeSegment() : finishReading(ret);
+    }
+    if (ret < 0) {
+        return finishReading(ret);
+    }
+    if (packet->stream_index != m_videoStreamIndex) {
+        av_packet_unref(packet);
+        return StepResult::Progress;
+    }
+
+    int64_t timestamp = packet->pts != AV_NOPTS_VALUE ? packet->pts : packet->dts;
+    double pts = timestamp != AV_NOPTS_VALUE ? timestamp * timeBase : m_reverseEnd;
+    bool key = packet->flags & AV_PKT_FLAG_KEY;
+    if (!m_reverseHasKey) {
+        if (!key) {
+            av_packet_unref(packet);
+            return StepResult::Progress;
+        }
+        // 终点之前已没有关键帧：到达文件开头
+        if (pts >= m_reverseEnd) {
+            av_packet_unref(packet);
+            return finishReading(AVERROR_EOF);
+        }
+        m_reverseHasKey = true;
+        m_segmentStart = pts;
+    } else if (key && pts >= m_reverseEnd) {
+        // 读到了下一个GOP
+        av_packet_unref(packet);
+        return completeSegment();
+    }
+
+    AVPacket *queuedPacket = av_packet_alloc();
+    av_packet_move_ref(queuedPacket, packet);
+    m_segmentPackets.push_back(std::make_unique<PacketData>(queuedPacket, pts));
+    return StepResult::Progress;
+}
+
+PipelineTask::StepResult DemuxThread::completeSegment() {
+    // GOP超过窗口时只输出最后m_reverseWindow帧，之前的部分作为下一段从同一关键帧重新解码
+    std::vector<double> timestamps;
+    for (const auto &segmentPacket : m_segmentPackets) {
+        if (segmentPacket->pts < m_reverseEnd) timestamps.push_back(segmentPacket->pts);
+    }
+    std::sort(timestamps.begin(), timestamps.end());
+    if (timestamps.size() > size_t(m_reverseWindow)) {
+        m_segmentStart = timestamps[timestamps.size() - size_t(m_reverseWindow)];
+    }
+
+    m_segmentEnd = m_reverseEnd;
+    m_reverseEnd = m_segmentStart;
+    m_reverseSought = false;
+    m_segmentReady = true;
+    return StepResult::Progress;
+}
+
+bool DemuxThread::pushPacket(std::unique_ptr<PacketData> &packet, int streamIndex) {
+    if (streamIndex == m_videoStreamIndex) {
+        if (!m_videoPacketQueue.tryPush(packet)) return false;
+        DecodeScheduler::instance().wake(m_videoConsumer);
+    } else if (streamIndex == m_subtitleStreamIndex) {
+        if (!m_subtitlePacketQueue.tryPush(packet)) return false;
+        DecodeScheduler::instance().wake(m_subtitleConsumer);
+    } else {
+        if (!m_audioPacketQueue.tryPush(packet)) return false;
+        DecodeScheduler::instance().wake(m_audioConsumer);
+    }
+    return true;
+}
+
+void DemuxThread::setLoopRange(double start, double end) {
+    m_loopStart = start;
+    m_loopEnd = end;
+}
+
+bool DemuxThread::rewindForLoop(double start) {
+    int64_t target = int64_t(start * AV_TIME_BASE);
+    if (av_seek_frame(m_formatContext, -1, target, AVSEEK_FLAG_BACKWARD) < 0) {
+        qDebug() << "循环播放：无法跳转到" << start << "秒";
+        return false;
+    }
+
+    // 空数据包作为循环标记，解码器收到后冲刷并重置
+    if (m_videoStreamIndex >= 0) {
+        m_videoPacketQueue.forcePush(std::make_unique<PacketData>(nullptr, start));
+    }
+    if (m_audioStreamIndex >= 0) {
+        m_audioPacketQueue.forcePush(std::make_unique<PacketData>(nullptr, start));
+    }
+    DecodeScheduler::instance().wake(m_videoConsumer);
+    DecodeScheduler::instance().wake(m_audioConsumer);
+    return true;
+}
+
+bool DemuxThread::getVideoPacket(std::unique_ptr<PacketData> &packet) {
+    if (!m_videoPacketQueue.tryPop(packet)) {
+        return false;
+    }
+
+    // 队列有了空位，唤醒解封装
+    DecodeScheduler::instance().wake(this);
+    return true;
+}
+
+bool DemuxThread::getAudioPacket(std::unique_ptr<PacketData> &packet) {
+    if (!m_audioPacketQueue.tryPop(packet)) {
+        return false;
+    }
+
+    // 队列有了空位，唤醒解封装
+    DecodeScheduler::instance().wake(this);
+    return true;
+}
+
+bool DemuxThread::getSubtitlePacket(std::unique_ptr<PacketData> &packet) {
+    if (!m_subtitlePacketQueue.tryPop(packet)) {
+        return false;
+    }
+
+    // 队列有了空位，唤醒解封装
+    DecodeScheduler::instance().wake(this);
+    return true;
+}
+
+bool DemuxThread::isVideoQueueFull() const { return m_videoPacketQueue.isFull(); }
+
+bool DemuxThread::isAudioQueueFull() const { return m_audioPacketQueue.isFull(); }
+
+int DemuxThread::videoPacketCount() const { return m_videoPacketQueue.size(); }
+
+int DemuxThread::audioPacketCount() const { return m_audioPacketQueue.size(); }
+
+// ============== VideoDecoder 视频解码任务实现 ==============
+
+VideoDecoder::VideoDecoder(FFmpegStream *parent)
+    : QObject(parent), PipelineTask(Stage::VideoDecode), m_parent(parent) {}
 
 VideoDecoder::~VideoDecoder() {
     requestStop();
-    wait();
+    DecodeScheduler::instance().detach(this);
+
+    if (m_frame) {
+        av_frame_free(&m_frame);
+    }
 }
 
 void VideoDecoder::setCodecContext(AVCodecContext *ctx) { m_codecContext = ctx; }
@@ -401,108 +1265,213 @@ void VideoDecoder::setDemuxThread(DemuxThread *demux) { m_demuxThread = demux; }
 
 void VideoDecoder::requestStop() {
     m_stopRequested = true;
-    m_frameCondition.wakeAll();
+    m_frameQueue.wakeAll();
 }
 
-void VideoDecoder::run() {
+PipelineTask::StepResult VideoDecoder::step() {
+    TRACE_SCOPE("VideoDecoder::step", "pipeline");
+
+    if (m_stopRequested) {
+        return StepResult::Finished;
+    }
+
     if (!m_codecContext || !m_demuxThread) {
         emit errorOccurred("视频解码器初始化失败");
-        return;
+        return StepResult::Finished;
     }
 
-    AVFrame *frame = av_frame_alloc();
-    if (!frame) {
-        emit errorOccurred("分配视频帧失败");
-        return;
+    if (!m_frame) {
+        m_frame = av_frame_alloc();
+        if (!m_frame) {
+            emit errorOccurred("分配视频帧失败");
+            return StepResult::Finished;
+        }
     }
 
-    while (!m_stopRequested) {
-        // 检查帧队列是否已满
-        if (isFrameQueueFull()) {
-            QThread::msleep(10);
-            continue;
+    if (m_reverse) {
+        // 倒放：已解码的一段等正在显示的一段取完后整段放入队列，同时开始解码更早的一段
+        if (m_reverseReady) {
+            if (queuedFrames() > 0) {
+                return StepResult::Idle;
+            }
+            flushReverseFrames();
         }
+    } else if (isFrameQueueFull()) {
+        // 帧队列已满，等待消费
+        return StepResult::Idle;
+    }
 
-        // 获取视频数据包
-        std::unique_ptr<PacketData> packetData;
-        if (!m_demuxThread->getVideoPacket(packetData)) {
-            continue;  // 没有数据包或被请求停止
+    // 获取视频数据包
+    std::unique_ptr<PacketData> packetData;
+    if (!m_demuxThread->getVideoPacket(packetData)) {
+        if (!m_demuxThread->reachedEnd()) {
+            return StepResult::Idle;
         }
 
-        // 发送数据包到解码器
-        int ret = avcodec_send_packet(m_codecContext, packetData->packet);
-        if (ret < 0) {
-            qDebug() << "发送视频包到解码器失败：" << ret;
-            continue;
+        // 结束标志在最后一个数据包入队后才置位，再取一次确认队列确实已空
+        if (!m_demuxThread->getVideoPacket(packetData)) {
+            // 文件末尾：取出解码器中缓存的最后几帧
+            avcodec_send_packet(m_codecContext, nullptr);
+            receiveFrames(m_lastPacketPts);
+            flushReverseFrames();
+            m_finished = true;
+            return StepResult::Finished;
         }
+    }
+    m_lastPacketPts = packetData->pts;
+
+    if (!packetData->packet) {
+        switch (packetData->marker) {
+        case PacketData::Marker::SegmentStart:
+            // 倒放一段的开始：之后只保留窗口内的帧
+            m_windowStart = packetData->pts;
+            m_windowEnd = packetData->segmentEnd;
+            break;
+        case PacketData::Marker::SegmentEnd:
+            // 一段的数据包已全部送入：取出剩余帧，等待倒序输出
+            avcodec_send_packet(m_codecContext, nullptr);
+            receiveFrames(packetData->pts);
+            avcodec_flush_buffers(m_codecContext);
+            m_reverseReady = !m_reverseFrames.empty();
+            break;
+        case PacketData::Marker::Loop:
+            // 循环标记：取出剩余帧，重置解码器，并通知帧缓存一次循环结束；
+            // 之后丢弃循环起点之前的帧
+            avcodec_send_packet(m_codecContext, nullptr);
+            receiveFrames(packetData->pts);
+            avcodec_flush_buffers(m_codecContext);
+            m_discardBefore = packetData->pts;
+            pushFrame(std::make_unique<FrameData>());
+            break;
+        }
+        return StepResult::Progress;
+    }
 
-        // 接收解码后的帧
-        while (ret >= 0 && !m_stopRequested) {
-            ret = avcodec_receive_frame(m_codecContext, frame);
-            if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
-                break;
-            } else if (ret < 0) {
-                qDebug() << "视频解码失败：" << ret;
-                break;
-            }
+    // 解码器上下文只在解码任务中修改
+    AVDiscard discard = m_keyframesOnly      ? AVDISCARD_NONKEY
+                        : m_skipNonReference ? AVDISCARD_NONREF
+                                             : AVDISCARD_DEFAULT;
+    if (m_codecContext->skip_frame != discard) {
+        m_codecContext->skip_frame = discard;
+    }
 
-            // 克隆帧数据
-            AVFrame *clonedFrame = av_frame_clone(frame);
-            if (clonedFrame) {
-                double pts = packetData->pts;
-                if (frame->pts != AV_NOPTS_VALUE) {
-                    pts = frame->pts * av_q2d(m_codecContext->time_base);
-                }
+    // 发送数据包到解码器
+    int ret = avcodec_send_packet(m_codecContext, packetData->packet);
+    if (ret < 0) {
+        qDebug() << "发送视频包到解码器失败：" << ret;
+        return StepResult::Progress;
+    }
 
-                auto frameData = std::make_unique<FrameData>(clonedFrame, pts);
+    // 接收解码后的帧
+    receiveFrames(packetData->pts);
 
-                // 添加到队列
-                QMutexLocker locker(&m_frameMutex);
-                m_frameQueue.push_back(std::move(frameData));
-                m_frameCondition.wakeOne();
-            }
+    // 关键帧之间不连续，每帧解码后立即取出，不等待后续数据包
+    if (m_keyframesOnly) {
+        avcodec_send_packet(m_codecContext, nullptr);
+        receiveFrames(packetData->pts);
+        avcodec_flush_buffers(m_codecContext);
+    }
+    return StepResult::Progress;
+}
 
-            av_frame_unref(frame);
-        }
+void VideoDecoder::flushReverseFrames() {
+    // 按时间戳从后往前放入队列
+    std::sort(m_reverseFrames.begin(), m_reverseFrames.end(),
+              [](const auto &a, const auto &b) { return a->pts > b->pts; });
+    for (auto &frameData : m_reverseFrames) {
+        pushFrame(std::move(frameData));
     }
+    m_reverseFrames.clear();
+    m_reverseReady = false;
+}
 
-    av_frame_free(&frame);
-    qDebug() << "视频解码线程退出";
+bool VideoDecoder::peekPts(double *pts) const {
+    return m_frameQueue.peekFront([pts](const FrameData &data) { *pts = data.pts; });
 }
 
-bool VideoDecoder::getFrame(std::unique_ptr<FrameData> &frame) {
-    QMutexLocker locker(&m_frameMutex);
+void VideoDecoder::receiveFrames(double fallbackPts) {
+    AVFrame *frame = m_frame;
+    while (!m_stopRequested) {
+        int ret = avcodec_receive_frame(m_codecContext, frame);
+        if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
+            break;
+        } else if (ret < 0) {
+            qDebug() << "视频解码失败：" << ret;
+            break;
+        }
+
+        // 克隆帧数据
+        AVFrame *clonedFrame = av_frame_clone(frame);
+        if (clonedFrame) {
+            double pts = fallbackPts;
+            if (frame->pts != AV_NOPTS_VALUE) {
+                pts = frame->pts * av_q2d(m_codecContext->pkt_timebase);
+            }
+
+            // 恢复/跳转时丢弃目标位置之前的帧，A-B循环丢弃B之后的帧；
+            // 倒放时只保留当前段窗口内的帧
+            if (pts < m_discardBefore || pts >= m_discardAfter) {
+                av_frame_free(&clonedFrame);
+            } else if (m_reverse) {
+                if (pts >= m_windowStart && pts < m_windowEnd) {
+                    m_reverseFrames.push_back(std::make_unique<FrameData>(clonedFrame, pts));
+                } else {
+                    av_frame_free(&clonedFrame);
+                }
+            } else {
+                pushFrame(std::make_unique<FrameData>(clonedFrame, pts));
+            }
+        }
 
-    while (m_frameQueue.empty() && !m_stopRequested) {
-        m_frameCondition.wait(&m_frameMutex, 100);
+        av_frame_unref(frame);
     }
+}
 
-    if (!m_frameQueue.empty()) {
-        frame = std::move(m_frameQueue.front());
-        m_frameQueue.pop_front();
-        return true;
+void VideoDecoder::pushFrame(std::unique_ptr<FrameData> frameData) {
+    m_frameQueue.forcePush(std::move(frameData));
+}
+
+bool VideoDecoder::getFrame(std::unique_ptr<FrameData> &frame) {
+    // 在GUI线程调用，不等待解码：队列为空时直接返回，由调用方的定时器稍后再取
+    if (!m_frameQueue.tryPop(frame)) {
+        return false;
     }
 
-    return false;
+    // 队列有了空位，唤醒解码
+    DecodeScheduler::instance().wake(this);
+    return true;
 }
 
-bool VideoDecoder::isFrameQueueFull() const {
-    QMutexLocker locker(&m_frameMutex);
-    return m_frameQueue.size() >= MAX_FRAMES;
+bool VideoDecoder::isFrameQueueFull() const { return m_frameQueue.isFull(); }
+
+int VideoDecoder::queuedFrames() const { return m_frameQueue.size(); }
+
+int VideoDecoder::dropFramesBefore(double pts) {
+    // 循环标记（空帧）不丢弃
+    int dropped = m_frameQueue.dropFront(
+        [pts](const FrameData &data) { return data.frame && data.pts < pts; });
+    if (dropped > 0) {
+        DecodeScheduler::instance().wake(this);
+    }
+    return dropped;
 }
 
-// ============== AudioDecoder 音频解码器实现 ==============
+// ============== AudioDecoder 音频解码任务实现 ==============
 
 AudioDecoder::AudioDecoder(FFmpegStream *parent)
-    : QThread(parent), m_parent(parent), m_swrContext(nullptr) {}
+    : QObject(parent), PipelineTask(Stage::AudioDecode), m_parent(parent), m_swrContext(nullptr) {}
 
 AudioDecoder::~AudioDecoder() {
     requestStop();
-    wait();
+    DecodeScheduler::instance().detach(this);
 
     if (m_swrContext) {
         swr_free(&m_swrContext);
     }
+
+    if (m_frame) {
+        av_frame_free(&m_frame);
+    }
 }
 
 void AudioDecoder::setCodecContext(AVCodecContext *ctx) { m_codecContext = ctx; }
@@ -511,98 +1480,384 @@ void AudioDecoder::setDemuxThread(DemuxThread *demux) { m_demuxThread = demux; }
 
 void AudioDecoder::requestStop() {
     m_stopRequested = true;
-    m_frameCondition.wakeAll();
+    m_frameQueue.wakeAll();
 }
 
-void AudioDecoder::run() {
+PipelineTask::StepResult AudioDecoder::step() {
+    TRACE_SCOPE("AudioDecoder::step", "pipeline");
+
+    if (m_stopRequested) {
+        return StepResult::Finished;
+    }
+
     if (!m_codecContext || !m_demuxThread) {
         emit errorOccurred("音频解码器初始化失败");
-        return;
+        return StepResult::Finished;
     }
 
-    AVFrame *frame = av_frame_alloc();
-    if (!frame) {
-        emit errorOccurred("分配音频帧失败");
-        return;
+    if (!m_frame) {
+        m_frame = av_frame_alloc();
+        if (!m_frame) {
+            emit errorOccurred("分配音频帧失败");
+            return StepResult::Finished;
+        }
     }
 
-    while (!m_stopRequested) {
-        // 检查帧队列是否已满
-        if (isFrameQueueFull()) {
-            QThread::msleep(10);
-            continue;
+    // 帧队列已满，等待消费
+    if (isFrameQueueFull()) {
+        return StepResult::Idle;
+    }
+
+    // 获取音频数据包
+    std::unique_ptr<PacketData> packetData;
+    if (!m_demuxThread->getAudioPacket(packetData)) {
+        if (!m_demuxThread->reachedEnd()) {
+            return StepResult::Idle;
         }
 
-        // 获取音频数据包
-        std::unique_ptr<PacketData> packetData;
+        // 结束标志在最后一个数据包入队后才置位，再取一次确认队列确实已空
         if (!m_demuxThread->getAudioPacket(packetData)) {
-            continue;  // 没有数据包或被请求停止
+            // 文件末尾：取出解码器中缓存的最后几帧
+            avcodec_send_packet(m_codecContext, nullptr);
+            receiveFrames(m_lastPacketPts);
+            m_finished = true;
+            return StepResult::Finished;
         }
+    }
+    m_lastPacketPts = packetData->pts;
+
+    // 循环标记：取出剩余帧，重置解码器，通知帧缓存一次循环结束
+    if (!packetData->packet) {
+        avcodec_send_packet(m_codecContext, nullptr);
+        receiveFrames(packetData->pts);
+        avcodec_flush_buffers(m_codecContext);
+        m_discardBefore = packetData->pts;
+        m_frameQueue.forcePush(std::make_unique<FrameData>());
+        return StepResult::Progress;
+    }
 
-        // 发送数据包到解码器
-        int ret = avcodec_send_packet(m_codecContext, packetData->packet);
-        if (ret < 0) {
-            qDebug() << "发送音频包到解码器失败：" << ret;
-            continue;
+    // 发送数据包到解码器
+    int ret = avcodec_send_packet(m_codecContext, packetData->packet);
+    if (ret < 0) {
+        qDebug() << "发送音频包到解码器失败：" << ret;
+        return StepResult::Progress;
+    }
+
+    // 接收解码后的帧
+    receiveFrames(packetData->pts);
+    return StepResult::Progress;
+}
+
+void AudioDecoder::receiveFrames(double fallbackPts) {
+    AVFrame *frame = m_frame;
+    while (!m_stopRequested) {
+        int ret = avcodec_receive_frame(m_codecContext, frame);
+        if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
+            break;
+        } else if (ret < 0) {
+            qDebug() << "音频解码失败：" << ret;
+            break;
         }
 
-        // 接收解码后的帧
-        while (ret >= 0 && !m_stopRequested) {
-            ret = avcodec_receive_frame(m_codecContext, frame);
-            if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
-                break;
-            } else if (ret < 0) {
-                qDebug() << "音频解码失败：" << ret;
-                break;
+        // 克隆帧数据
+        AVFrame *clonedFrame = av_frame_clone(frame);
+        if (clonedFrame) {
+            double pts = fallbackPts;
+            if (frame->pts != AV_NOPTS_VALUE) {
+                pts = frame->pts * av_q2d(m_codecContext->pkt_timebase);
             }
 
-            // 克隆帧数据
-            AVFrame *clonedFrame = av_frame_clone(frame);
-            if (clonedFrame) {
-                double pts = packetData->pts;
-                if (frame->pts != AV_NOPTS_VALUE) {
-                    pts = frame->pts * av_q2d(m_codecContext->time_base);
-                }
+            // 恢复/跳转时丢弃目标位置之前的帧，A-B循环丢弃B之后的帧
+            if (pts < m_discardBefore || pts >= m_discardAfter) {
+                av_frame_free(&clonedFrame);
+                av_frame_unref(frame);
+                continue;
+            }
 
-                auto frameData = std::make_unique<FrameData>(clonedFrame, pts);
+            auto frameData = std::make_unique<FrameData>(clonedFrame, pts);
 
-                // 添加到队列
-                QMutexLocker locker(&m_frameMutex);
-                m_frameQueue.push_back(std::move(frameData));
-                m_frameCondition.wakeOne();
-            }
+            // 添加到队列
+            m_frameQueue.forcePush(std::move(frameData));
+        }
 
-            av_frame_unref(frame);
+        av_frame_unref(frame);
+    }
+}
+
+bool AudioDecoder::getFrame(std::unique_ptr<FrameData> &frame) {
+    // 在GUI线程调用，不等待解码：队列为空时直接返回，由调用方的定时器稍后再取
+    if (!m_frameQueue.tryPop(frame)) {
+        return false;
+    }
+
+    // 队列有了空位，唤醒解码
+    DecodeScheduler::instance().wake(this);
+    return true;
+}
+
+bool AudioDecoder::isFrameQueueFull() const { return m_frameQueue.isFull(); }
+
+int AudioDecoder::queuedFrames() const { return m_frameQueue.size(); }
+
+int AudioDecoder::dropFramesBefore(double pts) {
+    int dropped = m_frameQueue.dropFront(
+        [pts](const FrameData &data) { return data.frame && data.pts < pts; });
+    if (dropped > 0) {
+        DecodeScheduler::instance().wake(this);
+    }
+    return dropped;
+}
+
+// ============== SubtitleDecoder 字幕解码任务实现 ==============
+
+namespace {
+
+// 位图字幕为调色板图像（调色板为0xAARRGGBB），转换为RGBA字节序
+SubtitleData::Bitmap toRgbaBitmap(const AVSubtitleRect *rect) {
+    SubtitleData::Bitmap bitmap;
+    bitmap.x = rect->x;
+    bitmap.y = rect->y;
+    bitmap.width = rect->w;
+    bitmap.height = rect->h;
+    bitmap.rgba.resize(rect->w * rect->h * 4);
+
+    const uint32_t *palette = reinterpret_cast<const uint32_t *>(rect->data[1]);
+    uchar *out = reinterpret_cast<uchar *>(bitmap.rgba.data());
+    for (int y = 0; y < rect->h; ++y) {
+        const uint8_t *row = rect->data[0] + y * rect->linesize[0];
+        for (int x = 0; x < rect->w; ++x) {
+            uint32_t argb = palette[row[x]];
+            out[0] = uchar(argb >> 16);
+            out[1] = uchar(argb >> 8);
+            out[2] = uchar(argb);
+            out[3] = uchar(argb >> 24);
+            out += 4;
         }
     }
+    return bitmap;
+}
+
+}  // namespace
+
+SubtitleDecoder::SubtitleDecoder(FFmpegStream *parent)
+    : QObject(parent), PipelineTask(Stage::SubtitleDecode), m_parent(parent) {}
 
-    av_frame_free(&frame);
-    qDebug() << "音频解码线程退出";
+SubtitleDecoder::~SubtitleDecoder() {
+    requestStop();
+    DecodeScheduler::instance().detach(this);
 }
 
-bool AudioDecoder::getFrame(std::unique_ptr<FrameData> &frame) {
-    QMutexLocker locker(&m_frameMutex);
+void SubtitleDecoder::setCodecContext(AVCodecContext *ctx) { m_codecContext = ctx; }
+
+void SubtitleDecoder::setDemuxThread(DemuxThread *demux) { m_demuxThread = demux; }
+
+void SubtitleDecoder::setCanvasSize(int width, int height) {
+    m_canvasWidth = width;
+    m_canvasHeight = height;
+}
+
+void SubtitleDecoder::requestStop() { m_stopRequested = true; }
 
-    while (m_frameQueue.empty() && !m_stopRequested) {
-        m_frameCondition.wait(&m_frameMutex, 100);
+PipelineTask::StepResult SubtitleDecoder::step() {
+    TRACE_SCOPE("SubtitleDecoder::step", "pipeline");
+
+    if (m_stopRequested) {
+        return StepResult::Finished;
     }
 
-    if (!m_frameQueue.empty()) {
-        frame = std::move(m_frameQueue.front());
-        m_frameQueue.pop_front();
-        return true;
+    if (!m_codecContext || !m_demuxThread || !m_track) {
+        qDebug() << "字幕解码器初始化失败";
+        return StepResult::Finished;
     }
 
-    return false;
+    std::unique_ptr<PacketData> packetData;
+    if (!m_demuxThread->getSubtitlePacket(packetData)) {
+        if (!m_demuxThread->reachedEnd()) {
+            return StepResult::Idle;
+        }
+        // 结束标志在最后一个数据包入队后才置位，再取一次确认队列确实已空
+        if (!m_demuxThread->getSubtitlePacket(packetData)) {
+            return StepResult::Finished;
+        }
+    }
+
+    if (packetData->packet) {
+        decodePacket(*packetData);
+    }
+    return StepResult::Progress;
+}
+
+void SubtitleDecoder::decodePacket(const PacketData &packetData) {
+    AVSubtitle subtitle;
+    int gotSubtitle = 0;
+    int ret = avcodec_decode_subtitle2(m_codecContext, &subtitle, &gotSubtitle, packetData.packet);
+    if (ret < 0) {
+        qDebug() << "字幕解码失败：" << ret;
+        return;
+    }
+    if (!gotSubtitle) {
+        return;
+    }
+
+    double pts = packetData.pts;
+    if (subtitle.pts != AV_NOPTS_VALUE) {
+        pts = double(subtitle.pts) / AV_TIME_BASE;
+    }
+
+    auto data = std::make_shared<SubtitleData>();
+    data->start = pts + subtitle.start_display_time / 1000.0;
+    // 结束时间未知时用数据包时长，仍未知则保持显示到下一个事件开始
+    data->end = std::numeric_limits<double>::infinity();
+    if (subtitle.end_display_time > subtitle.start_display_time &&
+        subtitle.end_display_time != UINT32_MAX) {
+        data->end = pts + subtitle.end_display_time / 1000.0;
+    } else if (packetData.packet->duration > 0) {
+        double duration = packetData.packet->duration * av_q2d(m_codecContext->pkt_timebase);
+        data->end = data->start + duration;
+    }
+    data->canvasWidth = m_codecContext->width > 0 ? m_codecContext->width : m_canvasWidth;
+    data->canvasHeight = m_codecContext->height > 0 ? m_codecContext->height : m_canvasHeight;
+
+    for (unsigned int i = 0; i < subtitle.num_rects; ++i) {
+        const AVSubtitleRect *rect = subtitle.rects[i];
+        QString text;
+        if (rect->type == SUBTITLE_BITMAP && rect->w > 0 && rect->h > 0) {
+            data->bitmaps.push_back(toRgbaBitmap(rect));
+        } else if (rect->type == SUBTITLE_ASS && rect->ass) {
+            text = assToText(rect->ass);
+        } else if (rect->type == SUBTITLE_TEXT && rect->text) {
+            text = QString::fromUtf8(rect->text).trimmed();
+        }
+        if (!text.isEmpty()) {
+            if (!data->text.isEmpty()) data->text += '\n';
+            data->text += text;
+        }
+    }
+    avsubtitle_free(&subtitle);
+
+    // 新事件开始时结束之前未给出结束时间的事件；空事件（位图字幕的清屏）只起这个作用
+    m_track->closeOpen(data->start);
+    if (!data->text.isEmpty() || !data->bitmaps.empty()) {
+        m_track->add(std::move(data));
+    }
 }
 
-bool AudioDecoder::isFrameQueueFull() const {
-    QMutexLocker locker(&m_frameMutex);
-    return m_frameQueue.size() >= MAX_FRAMES;
+QString SubtitleDecoder::assToText(const char *ass) {
+    // 解码器输出的ASS事件：ReadOrder,Layer,Style,Name,MarginL,MarginR,MarginV,Effect,Text；
+    // 旧格式以"Dialogue:"开头，Text之前多一个字段
+    QString line = QString::fromUtf8(ass);
+    int fields = line.startsWith("Dialogue:") ? 9 : 8;
+    int pos = 0;
+    for (int i = 0; i < fields; ++i) {
+        int comma = line.indexOf(',', pos);
+        if (comma < 0) return QString();
+        pos = comma + 1;
+    }
+
+    // 去掉{...}样式标签，转换换行和硬空格
+    QString text;
+    bool inTag = false;
+    for (int i = pos; i < line.size(); ++i) {
+        QChar c = line[i];
+        if (inTag) {
+            if (c == '}') inTag = false;
+            continue;
+        }
+        if (c == '{') {
+            inTag = true;
+            continue;
+        }
+        if (c == '\\' && i + 1 < line.size()) {
+            QChar next = line[i + 1];
+            if (next == 'N' || next == 'n') {
+                text += '\n';
+                ++i;
+                continue;
+            }
+            if (next == 'h') {
+                text += ' ';
+                ++i;
+                continue;
+            }
+        }
+        text += c;
+    }
+    return text.trimmed();
+}
+
+// ============== SubtitleTrack 字幕事件实现 ==============
+
+void SubtitleTrack::add(std::shared_ptr<SubtitleData> subtitle) {
+    QMutexLocker locker(&m_mutex);
+    auto byStart = [](double start, const std::shared_ptr<SubtitleData> &item) {
+        return start < item->start;
+    };
+    auto pos = std::upper_bound(m_subtitles.begin(), m_subtitles.end(), subtitle->start, byStart);
+
+    // 跳转或循环后重新解码到的同一事件，保留原对象
+    for (auto it = pos; it != m_subtitles.begin();) {
+        --it;
+        if ((*it)->start != subtitle->start) break;
+        if ((*it)->text == subtitle->text && (*it)->bitmaps.size() == subtitle->bitmaps.size()) {
+            return;
+        }
+    }
+    m_subtitles.insert(pos, std::move(subtitle));
+
+    // 超出上限时淘汰显示位置之前已结束的事件
+    if (m_subtitles.size() > size_t(MAX_SUBTITLES)) {
+        double now = m_lastQueryPts;
+        m_subtitles.erase(std::remove_if(m_subtitles.begin(), m_subtitles.end(),
+                                         [now](const std::shared_ptr<SubtitleData> &item) {
+                                             return item->end < now;
+                                         }),
+                          m_subtitles.end());
+    }
+}
+
+void SubtitleTrack::closeOpen(double pts) {
+    QMutexLocker locker(&m_mutex);
+    for (auto &item : m_subtitles) {
+        if (std::isinf(item->end) && item->start < pts) item->end = pts;
+    }
+}
+
+std::shared_ptr<const SubtitleData> SubtitleTrack::at(double pts) const {
+    QMutexLocker locker(&m_mutex);
+    m_lastQueryPts = pts;
+
+    // 开始时间不晚于pts的事件中，取最后开始且仍在显示的一个
+    auto byStart = [](double time, const std::shared_ptr<SubtitleData> &item) {
+        return time < item->start;
+    };
+    auto it = std::upper_bound(m_subtitles.begin(), m_subtitles.end(), pts, byStart);
+    while (it != m_subtitles.begin()) {
+        --it;
+        if (pts < (*it)->end) return *it;
+    }
+    return nullptr;
+}
+
+void SubtitleTrack::clear() {
+    QMutexLocker locker(&m_mutex);
+    m_subtitles.clear();
+    m_lastQueryPts = 0.0;
 }
 
 // ============== FrameCache 帧缓存管理器实现 ==============
 
+namespace {
+
+int frameBytes(const AVFrame *frame) {
+    if (frame->nb_samples > 0) {
+        return av_samples_get_buffer_size(nullptr, AudioResampler::channelCount(frame),
+                                          frame->nb_samples, AVSampleFormat(frame->format), 1);
+    }
+    return av_image_get_buffer_size(AVPixelFormat(frame->format), frame->width, frame->height, 1);
+}
+
+}  // namespace
+
 FrameCache::FrameCache(QObject *parent) : QObject(parent) {}
 
 FrameCache::~FrameCache() { clear(); }
@@ -613,10 +1868,32 @@ void FrameCache::setDecoders(VideoDecoder *video, AudioDecoder *audio) {
 }
 
 AVFrame *FrameCache::getNextVideoFrame(double *pts) {
+    if (m_loopState == LoopState::Replaying) return nextLoopFrame(m_videoLoop, pts);
+
+    // 逐帧后退过的帧按顺序从缓存取出
+    if (m_stepIndex < m_stepFrames.size()) {
+        const FrameData &cached = *m_stepFrames[m_stepIndex++];
+        if (pts) *pts = cached.pts;
+        return av_frame_clone(cached.frame);
+    }
     if (!m_videoDecoder) return nullptr;
 
     std::unique_ptr<FrameData> frameData;
-    if (m_videoDecoder->getFrame(frameData)) {
+    while (m_videoDecoder->getFrame(frameData)) {
+        if (!frameData->frame) {
+            // 循环结束标记：两路都完整记录后切换为缓存重放
+            finishLoopPass(m_videoLoop);
+            if (m_loopState == LoopState::Replaying) return nextLoopFrame(m_videoLoop, pts);
+            continue;
+        }
+
+        if (m_loopState == LoopState::Recording) {
+            recordLoopFrame(m_videoLoop, frameData->frame, frameData->pts);
+        }
+        if (m_stepCacheEnabled) {
+            recordStepFrame(frameData->frame, frameData->pts);
+        }
+
         if (pts) *pts = frameData->pts;
 
         // 移动帧所有权给调用方
@@ -629,10 +1906,21 @@ AVFrame *FrameCache::getNextVideoFrame(double *pts) {
 }
 
 AVFrame *FrameCache::getNextAudioFrame(double *pts) {
+    if (m_loopState == LoopState::Replaying) return nextLoopFrame(m_audioLoop, pts);
     if (!m_audioDecoder) return nullptr;
 
     std::unique_ptr<FrameData> frameData;
-    if (m_audioDecoder->getFrame(frameData)) {
+    while (m_audioDecoder->getFrame(frameData)) {
+        if (!frameData->frame) {
+            finishLoopPass(m_audioLoop);
+            if (m_loopState == LoopState::Replaying) return nextLoopFrame(m_audioLoop, pts);
+            continue;
+        }
+
+        if (m_loopState == LoopState::Recording) {
+            recordLoopFrame(m_audioLoop, frameData->frame, frameData->pts);
+        }
+
         if (pts) *pts = frameData->pts;
 
         // 移动帧所有权给调用方
@@ -645,19 +1933,156 @@ AVFrame *FrameCache::getNextAudioFrame(double *pts) {
 }
 
 int FrameCache::getVideoFrameCount() const {
-    // 这里需要从VideoDecoder获取队列大小
-    // 为了简化，暂时返回0
-    return 0;
+    if (m_loopState == LoopState::Replaying) return int(m_videoLoop.frames.size());
+    int stepped = int(m_stepFrames.size() - m_stepIndex);
+    return stepped + (m_videoDecoder ? m_videoDecoder->queuedFrames() : 0);
 }
 
 int FrameCache::getAudioFrameCount() const {
-    // 这里需要从AudioDecoder获取队列大小
-    // 为了简化，暂时返回0
-    return 0;
+    if (m_loopState == LoopState::Replaying) return int(m_audioLoop.frames.size());
+    return m_audioDecoder ? m_audioDecoder->queuedFrames() : 0;
+}
+
+void FrameCache::setLoopCacheEnabled(bool enabled) {
+    clearLoopFrames();
+    m_videoLoop.loops = 0;
+    m_audioLoop.loops = 0;
+    m_loopState = enabled ? LoopState::Recording : LoopState::Disabled;
+}
+
+bool FrameCache::seekLoop(double seconds) {
+    m_videoLoop.loops = 0;
+    m_audioLoop.loops = 0;
+    if (m_loopState == LoopState::Recording) {
+        // 记录中途跳转，无法保证缓存包含完整循环
+        clearLoopFrames();
+        m_loopState = LoopState::Streaming;
+        return false;
+    }
+    if (m_loopState != LoopState::Replaying) {
+        return false;
+    }
+
+    for (LoopTrack *track : {&m_videoLoop, &m_audioLoop}) {
+        track->index = 0;
+        while (track->index + 1 < track->frames.size() &&
+               track->frames[track->index + 1]->pts <= seconds) {
+            ++track->index;
+        }
+    }
+    return true;
+}
+
+void FrameCache::recordLoopFrame(LoopTrack &track, const AVFrame *frame, double pts) {
+    // 这一路已记录完整，正在等待另一路：第二遍取出的帧与缓存相同，只推进位置
+    if (track.complete) {
+        ++track.index;
+        return;
+    }
+
+    int bytes = frameBytes(frame);
+    if (bytes < 0 || m_loopCacheBytes + bytes > m_loopCacheLimit) {
+        // 循环过长，放弃缓存，之后每次循环流式解码
+        qDebug() << "循环超出缓存上限，改为流式解码";
+        clearLoopFrames();
+        m_loopState = LoopState::Streaming;
+        return;
+    }
+
+    // 引用计数克隆，不复制像素数据
+    AVFrame *ref = av_frame_clone(frame);
+    if (!ref) return;
+    track.frames.push_back(std::make_unique<FrameData>(ref, pts));
+    m_loopCacheBytes += bytes;
+}
+
+void FrameCache::finishLoopPass(LoopTrack &track) {
+    ++track.loops;
+    if (m_loopState != LoopState::Recording || track.frames.empty()) return;
+
+    // 另一路落后超过一遍时，第二遍也已取完
+    track.index = 0;
+    if (track.complete) return;
+    track.complete = true;
+
+    bool videoDone = m_videoLoop.complete || !m_videoDecoder;
+    bool audioDone = m_audioLoop.complete || !m_audioDecoder;
+    if (videoDone && audioDone) {
+        qDebug() << "循环缓存完成，视频帧数:" << m_videoLoop.frames.size()
+                 << "音频帧数:" << m_audioLoop.frames.size()
+                 << "大小:" << m_loopCacheBytes / 1024 << "KB";
+        m_loopState = LoopState::Replaying;
+    }
+}
+
+AVFrame *FrameCache::nextLoopFrame(LoopTrack &track, double *pts) {
+    if (track.frames.empty()) return nullptr;
+    if (track.index >= track.frames.size()) {
+        track.index = 0;
+        ++track.loops;
+    }
+
+    const FrameData &cached = *track.frames[track.index++];
+    if (pts) *pts = cached.pts;
+    return av_frame_clone(cached.frame);
+}
+
+void FrameCache::clearLoopFrames() {
+    m_videoLoop.frames.clear();
+    m_videoLoop.index = 0;
+    m_videoLoop.complete = false;
+    m_audioLoop.frames.clear();
+    m_audioLoop.index = 0;
+    m_audioLoop.complete = false;
+    m_loopCacheBytes = 0;
+}
+
+void FrameCache::setStepCacheEnabled(bool enabled) {
+    clearStepFrames();
+    m_stepCacheEnabled = enabled;
+}
+
+bool FrameCache::stepBack() {
+    // 当前画面在m_stepIndex - 1，上一帧在m_stepIndex - 2
+    if (m_stepIndex < 2) return false;
+    m_stepIndex -= 2;
+    return true;
+}
+
+void FrameCache::recordStepFrame(const AVFrame *frame, double pts) {
+    int bytes = frameBytes(frame);
+    AVFrame *ref = bytes >= 0 ? av_frame_clone(frame) : nullptr;
+    if (!ref) {
+        // 缓存中的帧必须连续
+        clearStepFrames();
+        return;
+    }
+    m_stepFrames.push_back(std::make_unique<FrameData>(ref, pts));
+    m_stepCacheBytes += bytes;
+
+    // 超出上限时淘汰最早的帧，至少保留当前帧和上一帧
+    while (m_stepFrames.size() > 2 && m_stepCacheBytes > m_stepCacheLimit) {
+        m_stepCacheBytes -= frameBytes(m_stepFrames.front()->frame);
+        m_stepFrames.pop_front();
+    }
+    m_stepIndex = m_stepFrames.size();
+}
+
+void FrameCache::clearStepFrames() {
+    m_stepFrames.clear();
+    m_stepIndex = 0;
+    m_stepCacheBytes = 0;
 }
 
 void FrameCache::clear() {
-    // 清理缓存（由各个解码器自己管理队列清理）
+    // 解码队列由各个解码器自己管理，这里只清理循环缓存和逐帧缓存
+    clearLoopFrames();
+    clearStepFrames();
+    m_videoLoop.loops = 0;
+    m_audioLoop.loops = 0;
+    if (m_loopState != LoopState::Disabled) {
+        m_loopState = LoopState::Recording;
+    }
 }
 
 #include "media/FFmpegStream.moc"
\ No newline at end of file
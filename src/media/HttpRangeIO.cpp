@@ -0,0 +1,460 @@
+#include "media/HttpRangeIO.h"
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDebug>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QHash>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <algorithm>
+#include <chrono>
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavformat/avio.h>
+#include <libavutil/dict.h>
+#include <libavutil/error.h>
+}
+
+namespace {
+
+// 单个请求的读写超时（微秒）
+const char *const RW_TIMEOUT_US = "10000000";
+
+// 同一个块最多尝试的次数
+constexpr int MAX_ATTEMPTS = 3;
+
+// 本进程中正在使用的缓存（键 -> 打开次数），淘汰时跳过
+struct CacheUsers {
+    QMutex mutex;
+    QHash<QString, int> keys;
+};
+
+CacheUsers &cacheUsers() {
+    static CacheUsers instance;
+    return instance;
+}
+
+// FFmpeg的http协议不导出ETag/Last-Modified，另外发送一次HEAD请求读取（不跟随重定向）。
+// 返回"ETag\nLast-Modified"，请求失败、非200响应或服务器都不提供时为空
+QByteArray fetchValidator(const QString &url, AVIOInterruptCB interrupt) {
+    char scheme[16];
+    char auth[256];
+    char host[256];
+    char path[4096];
+    int port = -1;
+    av_url_split(scheme, sizeof(scheme), auth, sizeof(auth), host, sizeof(host), &port, path,
+                 sizeof(path), url.toUtf8().constData());
+    const bool tls = qstrcmp(scheme, "https") == 0;
+    if (!tls && qstrcmp(scheme, "http") != 0) return QByteArray();
+    const int defaultPort = tls ? 443 : 80;
+    if (port < 0) port = defaultPort;
+
+    // av_url_split去掉了IPv6地址的方括号
+    QByteArray hostName(host);
+    if (hostName.contains(':')) hostName = '[' + hostName + ']';
+    const QByteArray address =
+        QByteArray(tls ? "tls://" : "tcp://") + hostName + ':' + QByteArray::number(port);
+
+    AVIOContext *context = nullptr;
+    AVDictionary *options = nullptr;
+    av_dict_set(&options, "rw_timeout", RW_TIMEOUT_US, 0);
+    int ret = avio_open2(&context, address.constData(), AVIO_FLAG_READ_WRITE, &interrupt,
+                         &options);
+    av_dict_free(&options);
+    if (ret < 0) return QByteArray();
+
+    QByteArray request = "HEAD " + QByteArray(path[0] ? path : "/") + " HTTP/1.1\r\n";
+    request += "Host: " + hostName;
+    if (port != defaultPort) request += ':' + QByteArray::number(port);
+    request += "\r\n";
+    if (auth[0]) request += "Authorization: Basic " + QByteArray(auth).toBase64() + "\r\n";
+    request += "User-Agent: " LIBAVFORMAT_IDENT "\r\nAccept: */*\r\nConnection: close\r\n\r\n";
+    avio_write(context, reinterpret_cast<const unsigned char *>(request.constData()),
+               request.size());
+    avio_flush(context);
+
+    // HEAD响应没有正文，读到空行为止
+    QByteArray response;
+    unsigned char buffer[4096];
+    while (!response.contains("\r\n\r\n") && response.size() < 64 * 1024) {
+        int n = avio_read_partial(context, buffer, sizeof(buffer));
+        if (n <= 0) break;
+        response.append(reinterpret_cast<const char *>(buffer), n);
+    }
+    avio_closep(&context);
+
+    const QList<QByteArray> lines = response.left(response.indexOf("\r\n\r\n")).split('\n');
+    if (lines.isEmpty() || lines[0].split(' ').value(1) != "200") return QByteArray();
+    QByteArray etag;
+    QByteArray lastModified;
+    for (const QByteArray &line : lines) {
+        const int colon = line.indexOf(':');
+        if (colon <= 0) continue;
+        const QByteArray name = line.left(colon).trimmed().toLower();
+        if (name == "etag") {
+            etag = line.mid(colon + 1).trimmed();
+        } else if (name == "last-modified") {
+            lastModified = line.mid(colon + 1).trimmed();
+        }
+    }
+    if (etag.isEmpty() && lastModified.isEmpty()) return QByteArray();
+    return etag + '\n' + lastModified;
+}
+
+}  // namespace
+
+HttpRangeIO::~HttpRangeIO() {
+    abort();
+    m_pool.waitForDone();
+    saveIndex();
+
+    if (!m_cacheKey.isEmpty()) {
+        QMutexLocker locker(&cacheUsers().mutex);
+        if (--cacheUsers().keys[m_cacheKey] <= 0) cacheUsers().keys.remove(m_cacheKey);
+    }
+}
+
+std::unique_ptr<HttpRangeIO> HttpRangeIO::open(const QString &url) {
+    std::unique_ptr<HttpRangeIO> io(new HttpRangeIO());
+    io->m_url = url;
+
+    // 先连接一次获取长度，并确认服务器支持Range请求
+    AVIOContext *probe = nullptr;
+    AVDictionary *options = nullptr;
+    av_dict_set(&options, "rw_timeout", RW_TIMEOUT_US, 0);
+    AVIOInterruptCB interrupt{&HttpRangeIO::interruptCallback, io.get()};
+    int ret = avio_open2(&probe, url.toUtf8().constData(), AVIO_FLAG_READ, &interrupt, &options);
+    av_dict_free(&options);
+    if (ret < 0) {
+        qDebug() << "HTTP连接失败:" << url << "错误码:" << ret;
+        return nullptr;
+    }
+    io->m_size = avio_size(probe);
+    bool seekable = probe->seekable & AVIO_SEEKABLE_NORMAL;
+    avio_closep(&probe);
+
+    if (io->m_size <= 0 || !seekable) {
+        qDebug() << "服务器不支持Range请求，使用默认HTTP输入:" << url;
+        return nullptr;
+    }
+    io->m_validator = fetchValidator(url, interrupt);
+
+    io->m_chunkCount = int((io->m_size + CHUNK_SIZE - 1) / CHUNK_SIZE);
+    io->m_chunks.assign(size_t(io->m_chunkCount), Missing);
+    io->m_failures.assign(size_t(io->m_chunkCount), 0);
+    io->m_pool.setMaxThreadCount(CONNECTIONS);
+
+    if (!io->openCache()) {
+        return nullptr;
+    }
+
+    io->schedule(0, 1 + PREFETCH_CHUNKS);
+    return io;
+}
+
+bool HttpRangeIO::openCache() {
+    QString cacheDir =
+        QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/http";
+    if (!QDir().mkpath(cacheDir)) {
+        qDebug() << "无法创建HTTP缓存目录:" << cacheDir;
+        return false;
+    }
+
+    m_cacheKey = QCryptographicHash::hash(m_url.toUtf8(), QCryptographicHash::Sha1).toHex();
+    {
+        QMutexLocker locker(&cacheUsers().mutex);
+        ++cacheUsers().keys[m_cacheKey];
+    }
+    pruneCache(cacheDir);
+
+    m_cacheFile.setFileName(cacheDir + "/" + m_cacheKey + ".data");
+    m_indexPath = cacheDir + "/" + m_cacheKey + ".index";
+
+    // 读取上次播放留下的块索引，文件长度或校验值（ETag/Last-Modified）变化、
+    // 数据文件丢失时视为新文件
+    QFile indexFile(m_indexPath);
+    if (QFileInfo(m_cacheFile.fileName()).size() == m_size &&
+        indexFile.open(QIODevice::ReadOnly)) {
+        QDataStream stream(&indexFile);
+        qint64 size = 0;
+        qint64 chunkSize = 0;
+        QByteArray validator;
+        QByteArray states;
+        stream >> size >> chunkSize >> validator >> states;
+        bool valid = stream.status() == QDataStream::Ok && size == m_size &&
+                     chunkSize == CHUNK_SIZE && states.size() == m_chunkCount;
+        if (valid && validator != m_validator) {
+            qDebug() << "服务器上的文件已修改，丢弃HTTP缓存:" << m_url;
+        } else if (valid) {
+            int cached = 0;
+            for (int i = 0; i < m_chunkCount; ++i) {
+                if (states[i] == char(Cached)) {
+                    m_chunks[size_t(i)] = Cached;
+                    ++cached;
+                }
+            }
+            qDebug() << "HTTP缓存命中" << cached << "/" << m_chunkCount << "块:" << m_url;
+        }
+    }
+
+    if (!m_cacheFile.open(QIODevice::ReadWrite)) {
+        qDebug() << "无法打开HTTP缓存文件:" << m_cacheFile.fileName();
+        return false;
+    }
+    // 预设长度（稀疏文件，不占用未写入部分的磁盘空间）
+    if (m_cacheFile.size() != m_size && !m_cacheFile.resize(m_size)) {
+        return false;
+    }
+
+    // 立即写出索引：数据文件不会没有索引，修改时间也作为淘汰时的最近使用时间
+    saveIndex();
+    return true;
+}
+
+void HttpRangeIO::pruneCache(const QString &cacheDir) {
+    struct Item {
+        QString key;
+        int64_t bytes;
+        QDateTime used;
+    };
+
+    QDir dir(cacheDir);
+    QMutexLocker locker(&cacheUsers().mutex);
+    std::vector<Item> items;
+    const QFileInfoList files = dir.entryInfoList({"*.data", "*.index"}, QDir::Files);
+    for (const QFileInfo &info : files) {
+        const QString key = info.completeBaseName();
+        if (cacheUsers().keys.contains(key)) continue;
+        const QString dataPath = dir.filePath(key + ".data");
+        const QString indexPath = dir.filePath(key + ".index");
+        if (info.suffix() == "index") {
+            if (!QFile::exists(dataPath)) QFile::remove(indexPath);
+            continue;
+        }
+
+        // 按索引中已缓存的块计算占用（数据文件是稀疏文件，长度不代表占用）
+        QFile indexFile(indexPath);
+        qint64 size = 0;
+        qint64 chunkSize = 0;
+        QByteArray validator;
+        QByteArray states;
+        if (indexFile.open(QIODevice::ReadOnly)) {
+            QDataStream stream(&indexFile);
+            stream >> size >> chunkSize >> validator >> states;
+            if (stream.status() != QDataStream::Ok) chunkSize = 0;
+        }
+        if (chunkSize <= 0) {
+            QFile::remove(dataPath);
+            QFile::remove(indexPath);
+            continue;
+        }
+        int64_t bytes = std::min<int64_t>(states.count(char(Cached)) * chunkSize, size);
+        items.push_back({key, bytes, QFileInfo(indexPath).lastModified()});
+    }
+
+    std::sort(items.begin(), items.end(),
+              [](const Item &a, const Item &b) { return a.used > b.used; });
+    int64_t total = 0;
+    for (const Item &item : items) {
+        total += item.bytes;
+        if (total <= CACHE_LIMIT) continue;
+        QFile::remove(dir.filePath(item.key + ".data"));
+        QFile::remove(dir.filePath(item.key + ".index"));
+        qDebug() << "淘汰HTTP缓存:" << item.key << item.bytes / (1024 * 1024) << "MB";
+    }
+}
+
+void HttpRangeIO::saveIndex() {
+    if (m_indexPath.isEmpty()) return;
+
+    QByteArray states(m_chunkCount, char(Missing));
+    {
+        QMutexLocker locker(&m_mutex);
+        for (int i = 0; i < m_chunkCount; ++i) {
+            if (m_chunks[size_t(i)] == Cached) states[i] = char(Cached);
+        }
+    }
+
+    // 写入临时文件后替换，中途崩溃时保留上一次的索引
+    QMutexLocker locker(&m_indexMutex);
+    QSaveFile indexFile(m_indexPath);
+    if (!indexFile.open(QIODevice::WriteOnly)) return;
+    QDataStream stream(&indexFile);
+    stream << qint64(m_size) << qint64(CHUNK_SIZE) << m_validator << states;
+    if (!indexFile.commit()) {
+        qDebug() << "无法写入HTTP缓存索引:" << m_indexPath;
+    }
+}
+
+void HttpRangeIO::schedule(int first, int count) {
+    QMutexLocker locker(&m_mutex);
+    int last = std::min(first + count, m_chunkCount);
+    for (int index = std::max(first, 0); index < last; ++index) {
+        if (m_chunks[size_t(index)] != Missing) continue;
+        m_chunks[size_t(index)] = Fetching;
+        m_inFlight.fetch_add(1, std::memory_order_relaxed);
+        m_pool.start([this, index] { fetchChunk(index); });
+    }
+}
+
+void HttpRangeIO::fetchChunk(int index) {
+    auto finish = [this, index](ChunkState state) {
+        QMutexLocker locker(&m_mutex);
+        m_chunks[size_t(index)] = state;
+        m_inFlight.fetch_sub(1, std::memory_order_relaxed);
+        m_chunkReady.wakeAll();
+    };
+
+    // 跳转后已不在预取范围内的请求直接放弃
+    int wanted = m_wantedChunk.load(std::memory_order_relaxed);
+    if (m_aborted || index < wanted || index > wanted + PREFETCH_CHUNKS) {
+        finish(Missing);
+        return;
+    }
+
+    const int64_t begin = index * CHUNK_SIZE;
+    const int64_t end = std::min(begin + CHUNK_SIZE, m_size);
+    QByteArray data(int(end - begin), Qt::Uninitialized);
+
+    AVIOContext *context = nullptr;
+    AVDictionary *options = nullptr;
+    av_dict_set_int(&options, "offset", begin, 0);
+    av_dict_set_int(&options, "end_offset", end, 0);
+    av_dict_set(&options, "rw_timeout", RW_TIMEOUT_US, 0);
+    AVIOInterruptCB interrupt{&HttpRangeIO::interruptCallback, this};
+    int ret = avio_open2(&context, m_url.toUtf8().constData(), AVIO_FLAG_READ, &interrupt,
+                         &options);
+    av_dict_free(&options);
+
+    int received = 0;
+    if (ret >= 0) {
+        while (received < data.size()) {
+            int n = avio_read(context, reinterpret_cast<unsigned char *>(data.data()) + received,
+                              data.size() - received);
+            if (n <= 0) break;
+            received += n;
+        }
+        avio_closep(&context);
+    }
+
+    if (received != data.size()) {
+        if (!m_aborted) {
+            qDebug() << "HTTP块下载失败:" << index << "已接收" << received << "/" << data.size();
+        }
+        QMutexLocker locker(&m_mutex);
+        bool giveUp = ++m_failures[size_t(index)] >= MAX_ATTEMPTS;
+        locker.unlock();
+        finish(giveUp ? Failed : Missing);
+        return;
+    }
+
+    {
+        QMutexLocker locker(&m_fileMutex);
+        // 写出到系统后才在索引中标记为已缓存
+        if (!m_cacheFile.seek(begin) || m_cacheFile.write(data) != data.size() ||
+            !m_cacheFile.flush()) {
+            locker.unlock();
+            finish(Failed);
+            return;
+        }
+    }
+    finish(Cached);
+    saveIndex();
+}
+
+int HttpRangeIO::interruptCallback(void *opaque) {
+    return static_cast<HttpRangeIO *>(opaque)->m_aborted.load() ? 1 : 0;
+}
+
+void HttpRangeIO::abort() {
+    m_aborted = true;
+    QMutexLocker locker(&m_mutex);
+    m_chunkReady.wakeAll();
+}
+
+int HttpRangeIO::read(uint8_t *buffer, int size) {
+    if (m_position >= m_size) {
+        return AVERROR_EOF;
+    }
+
+    const int index = int(m_position / CHUNK_SIZE);
+    m_wantedChunk.store(index, std::memory_order_relaxed);
+    schedule(index, 1 + PREFETCH_CHUNKS);
+
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_chunks[size_t(index)] != Cached) {
+            auto start = std::chrono::steady_clock::now();
+            while (m_chunks[size_t(index)] != Cached) {
+                if (m_aborted) return AVERROR_EXIT;
+                if (m_chunks[size_t(index)] == Failed) return AVERROR(EIO);
+                if (m_chunks[size_t(index)] == Missing) {
+                    // 下载失败后重试，或请求在跳转时被放弃
+                    locker.unlock();
+                    schedule(index, 1);
+                    locker.relock();
+                    continue;
+                }
+                m_chunkReady.wait(&m_mutex, 100);
+            }
+
+            int64_t waitNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                 std::chrono::steady_clock::now() - start)
+                                 .count();
+            m_waits.fetch_add(1, std::memory_order_relaxed);
+            m_waitNs.fetch_add(waitNs, std::memory_order_relaxed);
+            if (waitNs > m_maxWaitNs.load(std::memory_order_relaxed)) {
+                m_maxWaitNs.store(waitNs, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    const int64_t chunkEnd = std::min((index + 1) * CHUNK_SIZE, m_size);
+    const int64_t bytes = std::min<int64_t>(size, chunkEnd - m_position);
+
+    qint64 n;
+    {
+        QMutexLocker locker(&m_fileMutex);
+        if (!m_cacheFile.seek(m_position)) {
+            return AVERROR(EIO);
+        }
+        n = m_cacheFile.read(reinterpret_cast<char *>(buffer), bytes);
+    }
+    if (n <= 0) {
+        return AVERROR(EIO);
+    }
+
+    m_position += n;
+    m_bytesRead.fetch_add(n, std::memory_order_relaxed);
+    return int(n);
+}
+
+int64_t HttpRangeIO::seek(int64_t offset) {
+    if (offset < 0 || offset > m_size) {
+        return AVERROR(EINVAL);
+    }
+
+    // 立即开始获取目标位置的块，未开始的旧预取请求会被放弃
+    m_position = offset;
+    if (offset < m_size) {
+        const int index = int(offset / CHUNK_SIZE);
+        m_wantedChunk.store(index, std::memory_order_relaxed);
+        schedule(index, 1 + PREFETCH_CHUNKS);
+    }
+    return m_position;
+}
+
+MediaIO::Stats HttpRangeIO::stats() const {
+    Stats stats;
+    stats.backend = "http";
+    stats.readAheadDepth = PREFETCH_CHUNKS;
+    stats.readAheadQueued = m_inFlight.load(std::memory_order_relaxed);
+    stats.bytesRead = m_bytesRead.load(std::memory_order_relaxed);
+    stats.waits = m_waits.load(std::memory_order_relaxed);
+    stats.waitMs = m_waitNs.load(std::memory_order_relaxed) / 1e6;
+    stats.maxWaitMs = m_maxWaitNs.load(std::memory_order_relaxed) / 1e6;
+    return stats;
+}
@@ -0,0 +1,83 @@
+#include "media/LatencyController.h"
+#include <QStringList>
+#include <algorithm>
+#include <cmath>
+
+extern "C" {
+#include <libavutil/mathematics.h>
+#include <libavutil/time.h>
+}
+
+namespace {
+
+// MPEG-TS时间戳：90kHz，33位回绕
+constexpr int64_t TS_CLOCK = 90000;
+constexpr int64_t TS_WRAP = int64_t(1) << 33;
+
+int64_t wallClockTicks() { return av_rescale(av_gettime(), TS_CLOCK, 1000000) % TS_WRAP; }
+
+}  // namespace
+
+LatencyController::Decision LatencyController::update(double latencySeconds) {
+    Decision decision;
+
+    // 时间戳不连续（推流端重启、回绕处理失败）时重新开始测量
+    if (latencySeconds < -1.0 || latencySeconds > 60.0) {
+        reset();
+        return decision;
+    }
+
+    ++m_stats.updates;
+    m_stats.sumLatency += latencySeconds;
+    m_stats.maxLatency = std::max(m_stats.maxLatency, latencySeconds);
+
+    // 积压太多，加速追赶需要太久
+    if (latencySeconds > m_target + DROP_THRESHOLD) {
+        ++m_stats.drops;
+        m_smoothed = -1.0;
+        m_rate = 1.0;
+        m_stats.rate = m_rate;
+        decision.dropToLive = true;
+        return decision;
+    }
+
+    // 单次测量受帧间隔和网络抖动影响，按平滑后的值调整
+    m_smoothed = m_smoothed < 0 ? latencySeconds
+                                : m_smoothed + SMOOTHING * (latencySeconds - m_smoothed);
+    double error = m_smoothed - m_target;
+
+    // 加速与目标误差成正比；开始加速或减速后回到目标附近才恢复原速，避免在阈值处来回切换
+    if (error > SPEEDUP_THRESHOLD || (m_rate > 1.0 && error > 0)) {
+        m_rate = 1.0 + std::clamp(error * 0.2, 0.01, MAX_SPEEDUP);
+    } else if (error < -SLOWDOWN_THRESHOLD || (m_rate < 1.0 && error < 0)) {
+        m_rate = 1.0 - SLOWDOWN;
+    } else {
+        m_rate = 1.0;
+    }
+
+    m_stats.latency = m_smoothed;
+    m_stats.rate = m_rate;
+    decision.rate = m_rate;
+    return decision;
+}
+
+void LatencyController::reset() {
+    m_smoothed = -1.0;
+    m_rate = 1.0;
+    m_stats.rate = m_rate;
+}
+
+bool LatencyController::isLiveUrl(const QString &url) {
+    static const QStringList schemes{"udp", "rtp", "srt", "rist", "rtsp", "rtmp"};
+    int colon = url.indexOf("://");
+    return colon > 0 && schemes.contains(url.left(colon).toLower());
+}
+
+double LatencyController::senderClockLatency(double ptsSeconds) {
+    int64_t pts = std::llround(ptsSeconds * TS_CLOCK) % TS_WRAP;
+    int64_t elapsed = ((wallClockTicks() - pts) % TS_WRAP + TS_WRAP) % TS_WRAP;
+    if (elapsed > TS_WRAP / 2) elapsed -= TS_WRAP;
+    return double(elapsed) / TS_CLOCK;
+}
+
+int64_t LatencyController::senderClockOffset() { return wallClockTicks() * 1000000 / TS_CLOCK; }
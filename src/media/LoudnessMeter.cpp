@@ -0,0 +1,274 @@
+#include "media/LoudnessMeter.h"
+#include "core/Trace.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define LOUDNESS_SSE2
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define LOUDNESS_NEON
+#endif
+
+namespace {
+
+constexpr double PI = 3.14159265358979323846;
+constexpr double NONE = -std::numeric_limits<double>::infinity();
+
+double toLufs(double meanSquare) {
+    return meanSquare > 0.0 ? -0.691 + 10.0 * std::log10(meanSquare) : NONE;
+}
+
+// 绝对值最大的样本
+float absoluteMax(const float *samples, int count) {
+    int i = 0;
+    float peak = 0.0f;
+#if defined(LOUDNESS_SSE2)
+    const __m128 mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    __m128 vmax = _mm_setzero_ps();
+    for (; i + 4 <= count; i += 4) {
+        vmax = _mm_max_ps(vmax, _mm_and_ps(_mm_loadu_ps(samples + i), mask));
+    }
+    alignas(16) float lanes[4];
+    _mm_store_ps(lanes, vmax);
+    peak = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+#elif defined(LOUDNESS_NEON)
+    float32x4_t vmax = vdupq_n_f32(0.0f);
+    for (; i + 4 <= count; i += 4) {
+        vmax = vmaxq_f32(vmax, vabsq_f32(vld1q_f32(samples + i)));
+    }
+    peak = vmaxvq_f32(vmax);
+#endif
+    for (; i < count; ++i) {
+        peak = std::max(peak, std::fabs(samples[i]));
+    }
+    return peak;
+}
+
+}  // namespace
+
+LoudnessMeter::LoudnessMeter(int channels, int sampleRate)
+    : m_channels(std::max(channels, 1)),
+      m_sampleRate(std::max(sampleRate, 1)),
+      m_subBlockFrames(std::max(1, m_sampleRate / 10)),
+      m_pairs((m_channels + 1) / 2) {
+    // BS.1770的K加权：约1.7kHz的+4dB高频搁架和约38Hz的高通，按实际采样率重新推导
+    double k = std::tan(PI * 1681.974450955533 / m_sampleRate);
+    double q = 0.7071752369554196;
+    double vh = std::pow(10.0, 3.999843853973347 / 20.0);
+    double vb = std::pow(vh, 0.4996667741545416);
+    double a0 = 1.0 + k / q + k * k;
+    m_shelfB[0] = (vh + vb * k / q + k * k) / a0;
+    m_shelfB[1] = 2.0 * (k * k - vh) / a0;
+    m_shelfB[2] = (vh - vb * k / q + k * k) / a0;
+    m_shelfA[0] = 2.0 * (k * k - 1.0) / a0;
+    m_shelfA[1] = (1.0 - k / q + k * k) / a0;
+
+    k = std::tan(PI * 38.13547087602444 / m_sampleRate);
+    q = 0.5003270373238773;
+    a0 = 1.0 + k / q + k * k;
+    m_highpassB[0] = 1.0;
+    m_highpassB[1] = -2.0;
+    m_highpassB[2] = 1.0;
+    m_highpassA[0] = 2.0 * (k * k - 1.0) / a0;
+    m_highpassA[1] = (1.0 - k / q + k * k) / a0;
+
+    // 5.1/7.1按FFmpeg声道顺序：FL FR FC LFE 环绕...
+    m_weights.assign(size_t(m_channels), 1.0);
+    if (m_channels == 6 || m_channels == 8) {
+        m_weights[3] = 0.0;
+        for (int c = 4; c < m_channels; ++c) {
+            m_weights[size_t(c)] = 1.41;
+        }
+    }
+
+    m_state.resize(size_t(m_pairs));
+    m_energy.assign(size_t(m_pairs) * 2, 0.0);
+    m_recent.assign(SHORT_TERM_BLOCKS, 0.0);
+    m_binEnergy.assign(HISTOGRAM_BINS, 0.0);
+    m_binCount.assign(HISTOGRAM_BINS, 0);
+}
+
+void LoudnessMeter::reset() {
+    std::fill(m_state.begin(), m_state.end(), PairState());
+    std::fill(m_energy.begin(), m_energy.end(), 0.0);
+    std::fill(m_binEnergy.begin(), m_binEnergy.end(), 0.0);
+    std::fill(m_binCount.begin(), m_binCount.end(), 0);
+    m_subBlockPos = 0;
+    m_recentPos = 0;
+    m_recentCount = 0;
+    m_frames = 0;
+    m_peak = 0.0f;
+}
+
+void LoudnessMeter::process(const float *samples, int frames) {
+    TRACE_SCOPE("LoudnessMeter::process", "audio");
+
+    m_peak = std::max(m_peak, absoluteMax(samples, frames * m_channels));
+
+    // 按子块边界分段，每段内逐个声道对滤波，状态在整段内留在寄存器中
+    int done = 0;
+    while (done < frames) {
+        int count = std::min(frames - done, m_subBlockFrames - m_subBlockPos);
+        for (int pair = 0; pair < m_pairs; ++pair) {
+            filterPair(samples + size_t(done) * size_t(m_channels), count, pair);
+        }
+        m_subBlockPos += count;
+        done += count;
+        if (m_subBlockPos == m_subBlockFrames) {
+            finishSubBlock();
+        }
+    }
+    m_frames += frames;
+}
+
+void LoudnessMeter::filterPair(const float *samples, int frames, int pair) {
+    const int first = pair * 2;
+    const bool two = first + 1 < m_channels;
+    const float *input = samples + first;
+    double(&z)[4][2] = m_state[size_t(pair)].z;
+
+#if defined(LOUDNESS_SSE2)
+    const __m128d sb0 = _mm_set1_pd(m_shelfB[0]), sb1 = _mm_set1_pd(m_shelfB[1]);
+    const __m128d sb2 = _mm_set1_pd(m_shelfB[2]);
+    const __m128d sa1 = _mm_set1_pd(m_shelfA[0]), sa2 = _mm_set1_pd(m_shelfA[1]);
+    const __m128d ha1 = _mm_set1_pd(m_highpassA[0]), ha2 = _mm_set1_pd(m_highpassA[1]);
+    __m128d s0 = _mm_loadu_pd(z[0]), s1 = _mm_loadu_pd(z[1]);
+    __m128d h0 = _mm_loadu_pd(z[2]), h1 = _mm_loadu_pd(z[3]);
+    __m128d sum = _mm_setzero_pd();
+    for (int i = 0; i < frames; ++i, input += m_channels) {
+        // 两个相邻声道的float一次载入并转换为double；奇数声道数的最后一对只有一个声道
+        __m128 pairSamples =
+            two ? _mm_castpd_ps(_mm_load_sd(reinterpret_cast<const double *>(input)))
+                : _mm_load_ss(input);
+        __m128d x = _mm_cvtps_pd(pairSamples);
+        __m128d y = _mm_add_pd(_mm_mul_pd(sb0, x), s0);
+        s0 = _mm_add_pd(_mm_sub_pd(_mm_mul_pd(sb1, x), _mm_mul_pd(sa1, y)), s1);
+        s1 = _mm_sub_pd(_mm_mul_pd(sb2, x), _mm_mul_pd(sa2, y));
+        // 高通的分子为1, -2, 1
+        __m128d out = _mm_add_pd(y, h0);
+        h0 = _mm_sub_pd(_mm_sub_pd(h1, _mm_add_pd(y, y)), _mm_mul_pd(ha1, out));
+        h1 = _mm_sub_pd(y, _mm_mul_pd(ha2, out));
+        sum = _mm_add_pd(sum, _mm_mul_pd(out, out));
+    }
+    _mm_storeu_pd(z[0], s0);
+    _mm_storeu_pd(z[1], s1);
+    _mm_storeu_pd(z[2], h0);
+    _mm_storeu_pd(z[3], h1);
+    double sums[2];
+    _mm_storeu_pd(sums, sum);
+#elif defined(LOUDNESS_NEON)
+    const float64x2_t sb0 = vdupq_n_f64(m_shelfB[0]), sb1 = vdupq_n_f64(m_shelfB[1]);
+    const float64x2_t sb2 = vdupq_n_f64(m_shelfB[2]);
+    const float64x2_t sa1 = vdupq_n_f64(m_shelfA[0]), sa2 = vdupq_n_f64(m_shelfA[1]);
+    const float64x2_t ha1 = vdupq_n_f64(m_highpassA[0]), ha2 = vdupq_n_f64(m_highpassA[1]);
+    float64x2_t s0 = vld1q_f64(z[0]), s1 = vld1q_f64(z[1]);
+    float64x2_t h0 = vld1q_f64(z[2]), h1 = vld1q_f64(z[3]);
+    float64x2_t sum = vdupq_n_f64(0.0);
+    for (int i = 0; i < frames; ++i, input += m_channels) {
+        float32x2_t pairSamples =
+            two ? vld1_f32(input) : vset_lane_f32(input[0], vdup_n_f32(0.0f), 0);
+        float64x2_t x = vcvt_f64_f32(pairSamples);
+        float64x2_t y = vfmaq_f64(s0, sb0, x);
+        s0 = vaddq_f64(vfmsq_f64(vmulq_f64(sb1, x), sa1, y), s1);
+        s1 = vfmsq_f64(vmulq_f64(sb2, x), sa2, y);
+        float64x2_t out = vaddq_f64(y, h0);
+        h0 = vaddq_f64(vfmsq_f64(vmulq_n_f64(y, -2.0), ha1, out), h1);
+        h1 = vfmsq_f64(y, ha2, out);
+        sum = vfmaq_f64(sum, out, out);
+    }
+    vst1q_f64(z[0], s0);
+    vst1q_f64(z[1], s1);
+    vst1q_f64(z[2], h0);
+    vst1q_f64(z[3], h1);
+    double sums[2];
+    vst1q_f64(sums, sum);
+#else
+    double sums[2] = {0.0, 0.0};
+    const int lanes = two ? 2 : 1;
+    for (int i = 0; i < frames; ++i, input += m_channels) {
+        for (int lane = 0; lane < lanes; ++lane) {
+            double x = input[lane];
+            double y = m_shelfB[0] * x + z[0][lane];
+            z[0][lane] = m_shelfB[1] * x - m_shelfA[0] * y + z[1][lane];
+            z[1][lane] = m_shelfB[2] * x - m_shelfA[1] * y;
+            double out = y + z[2][lane];
+            z[2][lane] = -2.0 * y - m_highpassA[0] * out + z[3][lane];
+            z[3][lane] = y - m_highpassA[1] * out;
+            sums[lane] += out * out;
+        }
+    }
+#endif
+
+    // 长时间静音后状态衰减到非规格化数会大幅拖慢运算，提前归零
+    for (auto &stage : z) {
+        for (double &value : stage) {
+            if (std::fabs(value) < 1e-30) value = 0.0;
+        }
+    }
+    m_energy[size_t(first)] += sums[0];
+    m_energy[size_t(first) + 1] += sums[1];
+}
+
+void LoudnessMeter::finishSubBlock() {
+    double weighted = 0.0;
+    for (int c = 0; c < m_channels; ++c) {
+        weighted += m_weights[size_t(c)] * m_energy[size_t(c)];
+    }
+    std::fill(m_energy.begin(), m_energy.end(), 0.0);
+    m_subBlockPos = 0;
+
+    m_recent[size_t(m_recentPos)] = weighted / m_subBlockFrames;
+    m_recentPos = (m_recentPos + 1) % SHORT_TERM_BLOCKS;
+    m_recentCount = std::min(m_recentCount + 1, SHORT_TERM_BLOCKS);
+
+    // 每个子块结束时得到一个新的400ms门限块，低于绝对门限的直接丢弃
+    if (m_recentCount < MOMENTARY_BLOCKS) return;
+    double block = recentEnergy(MOMENTARY_BLOCKS);
+    double loudness = toLufs(block);
+    if (loudness < HISTOGRAM_MIN) return;
+    int bin = int((loudness - HISTOGRAM_MIN) * HISTOGRAM_BINS / (HISTOGRAM_MAX - HISTOGRAM_MIN));
+    bin = std::min(bin, HISTOGRAM_BINS - 1);
+    m_binEnergy[size_t(bin)] += block;
+    ++m_binCount[size_t(bin)];
+}
+
+double LoudnessMeter::recentEnergy(int blocks) const {
+    double sum = 0.0;
+    for (int i = 1; i <= blocks; ++i) {
+        sum += m_recent[size_t((m_recentPos - i + SHORT_TERM_BLOCKS) % SHORT_TERM_BLOCKS)];
+    }
+    return sum / blocks;
+}
+
+double LoudnessMeter::momentary() const {
+    return m_recentCount < MOMENTARY_BLOCKS ? NONE : toLufs(recentEnergy(MOMENTARY_BLOCKS));
+}
+
+double LoudnessMeter::shortTerm() const {
+    return m_recentCount < SHORT_TERM_BLOCKS ? NONE : toLufs(recentEnergy(SHORT_TERM_BLOCKS));
+}
+
+double LoudnessMeter::integrated() const {
+    double total = 0.0;
+    uint64_t count = 0;
+    for (int i = 0; i < HISTOGRAM_BINS; ++i) {
+        total += m_binEnergy[size_t(i)];
+        count += m_binCount[size_t(i)];
+    }
+    if (count == 0) return NONE;
+
+    // 相对门限：通过绝对门限的块的平均响度 - 10 LU，精度为一个桶宽
+    double gate = toLufs(total / double(count)) - 10.0;
+    int first = int(std::floor((gate - HISTOGRAM_MIN) * HISTOGRAM_BINS /
+                               (HISTOGRAM_MAX - HISTOGRAM_MIN)));
+    total = 0.0;
+    count = 0;
+    for (int i = std::max(first, 0); i < HISTOGRAM_BINS; ++i) {
+        total += m_binEnergy[size_t(i)];
+        count += m_binCount[size_t(i)];
+    }
+    return count == 0 ? NONE : toLufs(total / double(count));
+}
@@ -0,0 +1,106 @@
+#include "media/MappedFileIO.h"
+#include <QDebug>
+#include <algorithm>
+#include <cstring>
+
+#ifdef Q_OS_UNIX
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+extern "C" {
+#include <libavutil/error.h>
+}
+
+namespace {
+
+#ifdef Q_OS_UNIX
+// 对映射区的一段调用madvise，起点向下对齐到页
+void advise(const uint8_t *base, int64_t size, int64_t offset, int64_t length, int advice) {
+    static const int64_t pageSize = sysconf(_SC_PAGESIZE);
+    int64_t begin = offset - offset % pageSize;
+    int64_t end = std::min(offset + length, size);
+    if (end <= begin) return;
+    madvise(const_cast<uint8_t *>(base) + begin, size_t(end - begin), advice);
+}
+#endif
+
+}  // namespace
+
+MappedFileIO::~MappedFileIO() {
+    if (m_data) {
+        m_file.unmap(const_cast<uint8_t *>(m_data));
+    }
+}
+
+std::unique_ptr<MappedFileIO> MappedFileIO::open(const QString &path) {
+    std::unique_ptr<MappedFileIO> io(new MappedFileIO());
+    io->m_file.setFileName(path);
+    if (!io->m_file.open(QIODevice::ReadOnly)) {
+        return nullptr;
+    }
+
+    io->m_size = io->m_file.size();
+    if (io->m_size <= 0) {
+        return nullptr;
+    }
+
+    io->m_data = io->m_file.map(0, io->m_size);
+    if (!io->m_data) {
+        qDebug() << "内存映射失败，使用默认I/O:" << path << io->m_file.errorString();
+        return nullptr;
+    }
+
+#ifdef Q_OS_UNIX
+    // 解封装基本是顺序读取：让内核加大预读并尽早回收已读过的页
+    advise(io->m_data, io->m_size, 0, io->m_size, MADV_SEQUENTIAL);
+#endif
+    io->adviseWindow(0);
+    return io;
+}
+
+int MappedFileIO::read(uint8_t *buffer, int size) {
+    if (m_position >= m_size) {
+        return AVERROR_EOF;
+    }
+
+    // 读到预读窗口后半段时提前提示下一个窗口
+    if (m_adviseEnd < m_size && m_position + WINDOW / 2 > m_adviseEnd) {
+        adviseWindow(m_position);
+    }
+
+    int bytes = int(std::min<int64_t>(size, m_size - m_position));
+    memcpy(buffer, m_data + m_position, size_t(bytes));
+    m_position += bytes;
+    m_bytesRead.fetch_add(bytes, std::memory_order_relaxed);
+    return bytes;
+}
+
+int64_t MappedFileIO::seek(int64_t offset) {
+    if (offset < 0 || offset > m_size) {
+        return AVERROR(EINVAL);
+    }
+
+    // 跳转目标不在已提示的范围内时，立即为目标位置发起预读
+    if (offset < m_adviseBegin || (m_adviseEnd < m_size && offset + WINDOW / 2 > m_adviseEnd)) {
+        adviseWindow(offset);
+    }
+
+    m_position = offset;
+    return m_position;
+}
+
+MediaIO::Stats MappedFileIO::stats() const {
+    Stats stats;
+    stats.backend = "mmap";
+    stats.bytesRead = m_bytesRead.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void MappedFileIO::adviseWindow(int64_t offset) {
+#ifdef Q_OS_UNIX
+    advise(m_data, m_size, offset, WINDOW, MADV_WILLNEED);
+#endif
+    m_adviseBegin = offset;
+    m_adviseEnd = std::min(offset + WINDOW, m_size);
+}
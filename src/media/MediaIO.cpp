@@ -0,0 +1,111 @@
+#include "media/MediaIO.h"
+#include "media/HttpRangeIO.h"
+#include "media/MappedFileIO.h"
+#include "media/ReadAheadIO.h"
+#include <QDebug>
+#include <QFileInfo>
+#include <QStorageInfo>
+#include <cstdio>
+
+extern "C" {
+#include <libavutil/mem.h>
+}
+
+MediaIO::~MediaIO() {
+    if (m_avioContext) {
+        av_freep(&m_avioContext->buffer);
+        avio_context_free(&m_avioContext);
+    }
+}
+
+AVIOContext *MediaIO::avioContext() {
+    if (m_avioContext) {
+        return m_avioContext;
+    }
+
+    int bufferBytes = bufferSize();
+    auto *buffer = static_cast<unsigned char *>(av_malloc(bufferBytes));
+    if (!buffer) {
+        return nullptr;
+    }
+
+    m_avioContext = avio_alloc_context(buffer, bufferBytes, 0, this, &MediaIO::readCallback,
+                                       nullptr, &MediaIO::seekCallback);
+    if (!m_avioContext) {
+        av_free(buffer);
+        return nullptr;
+    }
+    m_avioContext->seekable = size() >= 0 ? AVIO_SEEKABLE_NORMAL : 0;
+    return m_avioContext;
+}
+
+int MediaIO::readCallback(void *opaque, uint8_t *buffer, int size) {
+    return static_cast<MediaIO *>(opaque)->read(buffer, size);
+}
+
+int64_t MediaIO::seekCallback(void *opaque, int64_t offset, int whence) {
+    auto *io = static_cast<MediaIO *>(opaque);
+
+    if (whence & AVSEEK_SIZE) {
+        return io->size() >= 0 ? io->size() : AVERROR(ENOSYS);
+    }
+
+    switch (whence & ~AVSEEK_FORCE) {
+    case SEEK_SET: break;
+    case SEEK_CUR: offset += io->position(); break;
+    case SEEK_END:
+        if (io->size() < 0) return AVERROR(ENOSYS);
+        offset += io->size();
+        break;
+    default: return AVERROR(EINVAL);
+    }
+    return io->seek(offset);
+}
+
+namespace {
+
+// 网络文件系统上每次读取都有往返延迟，适合用异步预读
+bool isNetworkFileSystem(const QString &path) {
+    const QByteArray type = QStorageInfo(path).fileSystemType().toLower();
+    static const char *const networkTypes[] = {"nfs", "cifs", "smb", "fuse.sshfs", "9p",
+                                               "afs", "ceph", "glusterfs", "davfs"};
+    for (const char *prefix : networkTypes) {
+        if (type.startsWith(prefix)) return true;
+    }
+    return false;
+}
+
+}  // namespace
+
+std::unique_ptr<MediaIO> MediaIO::create(const QString &path) {
+    const QByteArray mode = qgetenv("PLAYER_IO");
+    if (mode == "ffmpeg") {
+        return nullptr;
+    }
+
+    // HTTP(S)使用分块缓存输入，服务器不支持Range时交给FFmpeg
+    if (path.startsWith("http://", Qt::CaseInsensitive) ||
+        path.startsWith("https://", Qt::CaseInsensitive)) {
+        return HttpRangeIO::open(path);
+    }
+
+    // 其他带协议的URL（rtmp://、udp://等）交给FFmpeg处理
+    if (path.contains("://") && !path.startsWith("file://")) {
+        return nullptr;
+    }
+
+    QString localPath = path.startsWith("file://") ? path.mid(7) : path;
+    if (!QFileInfo(localPath).isFile()) {
+        return nullptr;
+    }
+
+    if (mode == "readahead" || (mode.isEmpty() && isNetworkFileSystem(localPath))) {
+        if (auto readAhead = ReadAheadIO::open(localPath)) {
+            return readAhead;
+        }
+    }
+    if (auto mapped = MappedFileIO::open(localPath)) {
+        return mapped;
+    }
+    return nullptr;
+}
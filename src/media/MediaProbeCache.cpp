@@ -0,0 +1,130 @@
+#include "media/MediaProbeCache.h"
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+namespace {
+
+// 文件格式版本，结构变化时递增，旧缓存整体丢弃
+constexpr quint32 FORMAT_VERSION = 1;
+
+struct Entry {
+    qint64 size = 0;
+    qint64 modified = 0;  // 毫秒
+    LoudnessInfo loudness;
+};
+
+struct Store {
+    QMutex mutex;
+    QHash<QString, Entry> entries;
+    QString path;
+    bool loaded = false;
+};
+
+Store &store() {
+    static Store instance;
+    return instance;
+}
+
+QString entryKey(const QString &filePath, int streamIndex) {
+    return QFileInfo(filePath).absoluteFilePath() + '#' + QString::number(streamIndex);
+}
+
+void load(Store &s) {
+    if (s.loaded) return;
+    s.loaded = true;
+
+    QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    if (!QDir().mkpath(cacheDir)) {
+        qDebug() << "无法创建探测缓存目录:" << cacheDir;
+        return;
+    }
+    s.path = cacheDir + "/probe.dat";
+
+    QFile file(s.path);
+    if (!file.open(QIODevice::ReadOnly)) return;
+    QDataStream stream(&file);
+    quint32 version = 0;
+    quint32 count = 0;
+    stream >> version >> count;
+    if (version != FORMAT_VERSION) return;
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        QString key;
+        Entry entry;
+        stream >> key >> entry.size >> entry.modified >> entry.loudness.integrated >>
+            entry.loudness.peak >> entry.loudness.seconds;
+        if (stream.status() == QDataStream::Ok) {
+            s.entries.insert(key, entry);
+        }
+    }
+
+    // 源文件已删除的条目不再有用，下次保存时一并去掉
+    for (auto it = s.entries.begin(); it != s.entries.end();) {
+        if (QFileInfo::exists(it.key().left(it.key().lastIndexOf('#')))) {
+            ++it;
+        } else {
+            it = s.entries.erase(it);
+        }
+    }
+}
+
+void save(const Store &s) {
+    if (s.path.isEmpty()) return;
+    // 写入临时文件后替换，中途崩溃时保留上一次的缓存
+    QSaveFile file(s.path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qDebug() << "无法写入探测缓存:" << s.path;
+        return;
+    }
+    QDataStream stream(&file);
+    stream << FORMAT_VERSION << quint32(s.entries.size());
+    for (auto it = s.entries.cbegin(); it != s.entries.cend(); ++it) {
+        const Entry &entry = it.value();
+        stream << it.key() << entry.size << entry.modified << entry.loudness.integrated
+               << entry.loudness.peak << entry.loudness.seconds;
+    }
+    if (!file.commit()) {
+        qDebug() << "无法写入探测缓存:" << s.path;
+    }
+}
+
+}  // namespace
+
+bool MediaProbeCache::loudness(const QString &filePath, int streamIndex, LoudnessInfo *info) {
+    QFileInfo fileInfo(filePath);
+    if (!fileInfo.isFile()) return false;
+
+    Store &s = store();
+    QMutexLocker locker(&s.mutex);
+    load(s);
+    auto it = s.entries.constFind(entryKey(filePath, streamIndex));
+    if (it == s.entries.cend() || it->size != fileInfo.size() ||
+        it->modified != fileInfo.lastModified().toMSecsSinceEpoch()) {
+        return false;
+    }
+    *info = it->loudness;
+    return true;
+}
+
+void MediaProbeCache::storeLoudness(const QString &filePath, int streamIndex,
+                                    const LoudnessInfo &info) {
+    QFileInfo fileInfo(filePath);
+    if (!fileInfo.isFile()) return;
+
+    Store &s = store();
+    QMutexLocker locker(&s.mutex);
+    load(s);
+    Entry entry;
+    entry.size = fileInfo.size();
+    entry.modified = fileInfo.lastModified().toMSecsSinceEpoch();
+    entry.loudness = info;
+    s.entries.insert(entryKey(filePath, streamIndex), entry);
+    save(s);
+}
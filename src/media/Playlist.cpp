@@ -0,0 +1,65 @@
+#include "media/Playlist.h"
+
+void Playlist::setItems(const QStringList &items) {
+    m_items = items;
+    m_currentIndex = m_items.isEmpty() ? -1 : 0;
+    emit itemsChanged();
+    emit currentIndexChanged(m_currentIndex);
+}
+
+void Playlist::append(const QString &filePath) {
+    m_items << filePath;
+    emit itemsChanged();
+    if (m_currentIndex < 0) {
+        setCurrentIndex(0);
+    }
+}
+
+void Playlist::clear() {
+    m_items.clear();
+    m_currentIndex = -1;
+    emit itemsChanged();
+    emit currentIndexChanged(m_currentIndex);
+}
+
+void Playlist::removeAt(int index) {
+    if (index < 0 || index >= m_items.size()) return;
+    m_items.removeAt(index);
+    emit itemsChanged();
+
+    if (index < m_currentIndex) {
+        --m_currentIndex;
+    } else if (index == m_currentIndex) {
+        m_currentIndex = qMin(m_currentIndex, int(m_items.size()) - 1);
+        emit currentIndexChanged(m_currentIndex);
+    }
+}
+
+void Playlist::setCurrentIndex(int index) {
+    if (index < 0 || index >= m_items.size() || index == m_currentIndex) return;
+    m_currentIndex = index;
+    emit currentIndexChanged(m_currentIndex);
+}
+
+int Playlist::nextIndex() const {
+    if (m_items.isEmpty()) return -1;
+    if (m_currentIndex + 1 < m_items.size()) return m_currentIndex + 1;
+    return m_repeat ? 0 : -1;
+}
+
+bool Playlist::advance() {
+    int next = nextIndex();
+    if (next < 0) return false;
+
+    // 单项循环时索引不变，仍需通知
+    if (next == m_currentIndex) {
+        emit currentIndexChanged(m_currentIndex);
+        return true;
+    }
+    setCurrentIndex(next);
+    return true;
+}
+
+QString Playlist::itemAt(int index) const {
+    return (index >= 0 && index < m_items.size()) ? m_items[index] : QString();
+}
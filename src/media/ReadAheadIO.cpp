@@ -0,0 +1,344 @@
+#include "media/ReadAheadIO.h"
+#include <QDebug>
+#include <QFile>
+#include <QMutex>
+#include <QThreadPool>
+#include <QWaitCondition>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <unordered_map>
+
+#ifdef Q_OS_UNIX
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef HAVE_LIBURING
+#include <liburing.h>
+#endif
+
+extern "C" {
+#include <libavutil/error.h>
+}
+
+#ifdef Q_OS_UNIX
+namespace {
+
+using Block = ReadAheadIO::Block;
+
+// 读满整个块（pread可能返回部分数据）
+int readFully(int fd, Block &block) {
+    size_t total = 0;
+    while (total < block.data.size()) {
+        ssize_t n = pread(fd, block.data.data() + total, block.data.size() - total,
+                          off_t(block.offset + int64_t(total)));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return total > 0 ? int(total) : -errno;
+        }
+        if (n == 0) break;
+        total += size_t(n);
+    }
+    return int(total);
+}
+
+// 通用后端：线程池中执行阻塞的pread
+class PreadBackend : public ReadAheadIO::Backend {
+public:
+    explicit PreadBackend(int fd, int threads) : m_fd(fd) { m_pool.setMaxThreadCount(threads); }
+    ~PreadBackend() override { m_pool.waitForDone(); }
+
+    const char *name() const override { return "pread"; }
+
+    bool submit(const std::shared_ptr<Block> &block) override {
+        m_pool.start([this, block] {
+            int result = readFully(m_fd, *block);
+            QMutexLocker locker(&m_mutex);
+            block->result = result;
+            block->done = true;
+            m_condition.wakeAll();
+        });
+        return true;
+    }
+
+    void wait(const std::shared_ptr<Block> &block) override {
+        QMutexLocker locker(&m_mutex);
+        while (!block->done) {
+            m_condition.wait(&m_mutex);
+        }
+    }
+
+    bool isDone(const std::shared_ptr<Block> &block) override {
+        QMutexLocker locker(&m_mutex);
+        return block->done;
+    }
+
+private:
+    int m_fd;
+    QThreadPool m_pool;
+    QMutex m_mutex;
+    QWaitCondition m_condition;
+};
+
+#ifdef HAVE_LIBURING
+// io_uring后端：提交和收割都在解封装线程中进行，不需要额外线程
+class UringBackend : public ReadAheadIO::Backend {
+public:
+    static std::unique_ptr<UringBackend> create(int fd, unsigned entries) {
+        std::unique_ptr<UringBackend> backend(new UringBackend(fd));
+        int ret = io_uring_queue_init(entries, &backend->m_ring, 0);
+        if (ret < 0) {
+            qDebug() << "io_uring不可用:" << strerror(-ret);
+            return nullptr;
+        }
+        backend->m_initialized = true;
+
+        // IORING_OP_READ需要5.6以上内核
+        io_uring_probe *probe = io_uring_get_probe_ring(&backend->m_ring);
+        bool supported = probe && io_uring_opcode_supported(probe, IORING_OP_READ);
+        if (probe) io_uring_free_probe(probe);
+        if (!supported) {
+            qDebug() << "io_uring不支持IORING_OP_READ";
+            return nullptr;
+        }
+        return backend;
+    }
+
+    ~UringBackend() override {
+        if (!m_initialized) return;
+        // 等待在途请求完成后才能释放缓冲区
+        while (!m_inflight.empty() && reap(true)) {
+        }
+        io_uring_queue_exit(&m_ring);
+    }
+
+    const char *name() const override { return "io_uring"; }
+
+    bool submit(const std::shared_ptr<Block> &block) override {
+        io_uring_sqe *sqe = io_uring_get_sqe(&m_ring);
+        if (!sqe) {
+            io_uring_submit(&m_ring);
+            sqe = io_uring_get_sqe(&m_ring);
+            if (!sqe) return false;
+        }
+        io_uring_prep_read(sqe, m_fd, block->data.data(), unsigned(block->data.size()),
+                           uint64_t(block->offset));
+        io_uring_sqe_set_data(sqe, block.get());
+        m_inflight[block.get()] = block;
+        io_uring_submit(&m_ring);
+        return true;
+    }
+
+    void wait(const std::shared_ptr<Block> &block) override {
+        while (!block->done) {
+            if (!reap(true)) {
+                block->result = AVERROR(EIO);
+                block->done = true;
+            }
+        }
+    }
+
+    bool isDone(const std::shared_ptr<Block> &block) override {
+        while (reap(false)) {
+        }
+        return block->done;
+    }
+
+private:
+    explicit UringBackend(int fd) : m_fd(fd) {}
+
+    // 处理一个完成事件，没有事件（非阻塞）或出错时返回false
+    bool reap(bool blocking) {
+        io_uring_cqe *cqe = nullptr;
+        int ret;
+        do {
+            ret = blocking ? io_uring_wait_cqe(&m_ring, &cqe) : io_uring_peek_cqe(&m_ring, &cqe);
+        } while (ret == -EINTR);
+        if (ret < 0 || !cqe) return false;
+
+        auto *block = static_cast<Block *>(io_uring_cqe_get_data(cqe));
+        block->result = cqe->res;
+        block->done = true;
+        io_uring_cqe_seen(&m_ring, cqe);
+        m_inflight.erase(block);
+        return true;
+    }
+
+    int m_fd;
+    io_uring m_ring{};
+    bool m_initialized{false};
+    // 在途请求持有块的引用，窗口被丢弃（跳转）后缓冲区仍然有效
+    std::unordered_map<Block *, std::shared_ptr<Block>> m_inflight;
+};
+#endif
+
+}  // namespace
+#endif
+
+ReadAheadIO::~ReadAheadIO() {
+    clearWindow();
+    m_backend.reset();
+#ifdef Q_OS_UNIX
+    if (m_fd >= 0) {
+        ::close(m_fd);
+    }
+#endif
+}
+
+std::unique_ptr<ReadAheadIO> ReadAheadIO::open(const QString &path, int depth, int blockSize) {
+#ifdef Q_OS_UNIX
+    int fd = ::open(QFile::encodeName(path).constData(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return nullptr;
+    }
+
+    std::unique_ptr<ReadAheadIO> io(new ReadAheadIO());
+    io->m_fd = fd;
+    io->m_depth = std::max(depth, 1);
+    io->m_blockSize = std::max(blockSize, 64 * 1024);
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        return nullptr;
+    }
+    io->m_size = st.st_size;
+
+#ifdef HAVE_LIBURING
+    io->m_backend = UringBackend::create(fd, unsigned(io->m_depth * 2));
+#endif
+    if (!io->m_backend) {
+        io->m_backend = std::make_unique<PreadBackend>(fd, std::min(io->m_depth, 4));
+    }
+
+    qDebug() << "异步预读I/O:" << io->m_backend->name() << "深度" << io->m_depth << "块大小"
+             << io->m_blockSize;
+    io->fillWindow();
+    return io;
+#else
+    Q_UNUSED(path)
+    Q_UNUSED(depth)
+    Q_UNUSED(blockSize)
+    return nullptr;
+#endif
+}
+
+void ReadAheadIO::fillWindow() {
+    // 丢弃已读过的块，已完成且没有其他引用的块留作复用
+    while (!m_window.empty() && m_window.front()->offset + m_blockSize <= m_position) {
+        std::shared_ptr<Block> block = std::move(m_window.front());
+        m_window.pop_front();
+        if (block.use_count() == 1 && block->done && int(m_spareBlocks.size()) < m_depth) {
+            m_spareBlocks.push_back(std::move(block));
+        }
+    }
+
+    // 窗口必须从当前位置开始
+    if (!m_window.empty() && m_window.front()->offset > m_position) {
+        clearWindow();
+    }
+
+    int64_t next = m_window.empty() ? m_position : m_window.back()->offset + m_blockSize;
+    while (int(m_window.size()) < m_depth && next < m_size) {
+        std::shared_ptr<Block> block;
+        if (!m_spareBlocks.empty()) {
+            block = std::move(m_spareBlocks.back());
+            m_spareBlocks.pop_back();
+        } else {
+            block = std::make_shared<Block>();
+        }
+        block->offset = next;
+        block->data.resize(size_t(std::min<int64_t>(m_blockSize, m_size - next)));
+        block->result = 0;
+        block->done = false;
+
+        if (!m_backend->submit(block)) break;
+        m_window.push_back(std::move(block));
+        next += m_blockSize;
+    }
+    m_queued.store(int(m_window.size()), std::memory_order_relaxed);
+}
+
+void ReadAheadIO::clearWindow() {
+    // 在途的块由后端持有引用，读取完成后释放
+    m_window.clear();
+    m_queued.store(0, std::memory_order_relaxed);
+}
+
+int ReadAheadIO::read(uint8_t *buffer, int size) {
+    // 短读时重新从当前位置提交一次
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        if (m_position >= m_size) {
+            return AVERROR_EOF;
+        }
+
+        fillWindow();
+        if (m_window.empty()) {
+            return AVERROR(EIO);
+        }
+
+        std::shared_ptr<Block> block = m_window.front();
+        if (!m_backend->isDone(block)) {
+            auto start = std::chrono::steady_clock::now();
+            m_backend->wait(block);
+            int64_t waitNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                 std::chrono::steady_clock::now() - start)
+                                 .count();
+            m_waits.fetch_add(1, std::memory_order_relaxed);
+            m_waitNs.fetch_add(waitNs, std::memory_order_relaxed);
+            if (waitNs > m_maxWaitNs.load(std::memory_order_relaxed)) {
+                m_maxWaitNs.store(waitNs, std::memory_order_relaxed);
+            }
+        }
+
+        if (block->result < 0) {
+            qDebug() << "预读失败，偏移" << block->offset << "错误码" << block->result;
+            clearWindow();
+            return block->result;
+        }
+
+        int64_t blockEnd = block->offset + block->result;
+        if (m_position >= blockEnd) {
+            if (block->result == 0) {
+                return AVERROR_EOF;  // 文件在播放期间被截断
+            }
+            clearWindow();
+            continue;
+        }
+
+        int bytes = int(std::min<int64_t>(size, blockEnd - m_position));
+        memcpy(buffer, block->data.data() + (m_position - block->offset), size_t(bytes));
+        m_position += bytes;
+        m_bytesRead.fetch_add(bytes, std::memory_order_relaxed);
+        return bytes;
+    }
+    return AVERROR(EIO);
+}
+
+int64_t ReadAheadIO::seek(int64_t offset) {
+    if (offset < 0 || offset > m_size) {
+        return AVERROR(EINVAL);
+    }
+
+    // 目标在窗口内时保留后面的块，否则丢弃整个窗口并立即为目标位置提交读取
+    if (!m_window.empty() &&
+        (offset < m_window.front()->offset || offset >= m_window.back()->offset + m_blockSize)) {
+        clearWindow();
+    }
+    m_position = offset;
+    fillWindow();
+    return m_position;
+}
+
+MediaIO::Stats ReadAheadIO::stats() const {
+    Stats stats;
+    stats.backend = m_backend ? m_backend->name() : "readahead";
+    stats.readAheadDepth = m_depth;
+    stats.readAheadQueued = m_queued.load(std::memory_order_relaxed);
+    stats.bytesRead = m_bytesRead.load(std::memory_order_relaxed);
+    stats.waits = m_waits.load(std::memory_order_relaxed);
+    stats.waitMs = m_waitNs.load(std::memory_order_relaxed) / 1e6;
+    stats.maxWaitMs = m_maxWaitNs.load(std::memory_order_relaxed) / 1e6;
+    return stats;
+}
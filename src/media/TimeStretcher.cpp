@@ -0,0 +1,228 @@
+#include "media/TimeStretcher.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TIME_STRETCH_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define TIME_STRETCH_NEON
+#endif
+
+namespace {
+
+constexpr double PI = 3.14159265358979323846;
+
+// 相似度搜索的热点：目标片段与候选片段的点积，以及候选片段的能量
+void correlate(const float *target, const float *candidate, int n, float *dot, float *energy) {
+    int i = 0;
+    float d = 0.0f;
+    float e = 0.0f;
+#if defined(TIME_STRETCH_SSE2)
+    __m128 vd = _mm_setzero_ps();
+    __m128 ve = _mm_setzero_ps();
+    for (; i + 4 <= n; i += 4) {
+        __m128 a = _mm_loadu_ps(target + i);
+        __m128 b = _mm_loadu_ps(candidate + i);
+        vd = _mm_add_ps(vd, _mm_mul_ps(a, b));
+        ve = _mm_add_ps(ve, _mm_mul_ps(b, b));
+    }
+    alignas(16) float sums[8];
+    _mm_store_ps(sums, vd);
+    _mm_store_ps(sums + 4, ve);
+    d = sums[0] + sums[1] + sums[2] + sums[3];
+    e = sums[4] + sums[5] + sums[6] + sums[7];
+#elif defined(TIME_STRETCH_NEON)
+    float32x4_t vd = vdupq_n_f32(0.0f);
+    float32x4_t ve = vdupq_n_f32(0.0f);
+    for (; i + 4 <= n; i += 4) {
+        float32x4_t a = vld1q_f32(target + i);
+        float32x4_t b = vld1q_f32(candidate + i);
+        vd = vmlaq_f32(vd, a, b);
+        ve = vmlaq_f32(ve, b, b);
+    }
+    float sums[8];
+    vst1q_f32(sums, vd);
+    vst1q_f32(sums + 4, ve);
+    d = sums[0] + sums[1] + sums[2] + sums[3];
+    e = sums[4] + sums[5] + sums[6] + sums[7];
+#endif
+    for (; i < n; ++i) {
+        d += target[i] * candidate[i];
+        e += candidate[i] * candidate[i];
+    }
+    *dot = d;
+    *energy = e;
+}
+
+}  // namespace
+
+TimeStretcher::TimeStretcher(int channels, int sampleRate)
+    : m_channels(std::max(channels, 1)),
+      m_sampleRate(std::max(sampleRate, 1)),
+      m_overlap(std::max(64, sampleRate * 12 / 1000)),  // 12ms
+      m_window(2 * m_overlap),
+      m_search(std::max(16, sampleRate * 8 / 1000)) {  // ±8ms
+    m_hann.resize(size_t(m_window));
+    for (int i = 0; i < m_window; ++i) {
+        m_hann[size_t(i)] = float(0.5 - 0.5 * std::cos(2.0 * PI * i / m_window));
+    }
+    m_tail.resize(size_t(m_overlap * m_channels));
+}
+
+void TimeStretcher::setRate(double rate) { m_rate = std::clamp(rate, MIN_RATE, MAX_RATE); }
+
+void TimeStretcher::reset() {
+    m_input.clear();
+    m_mono.clear();
+    m_active = false;
+    m_started = false;
+    m_nominal = 0.0;
+    m_previous = 0;
+}
+
+double TimeStretcher::pendingSeconds() const {
+    if (!m_active) return 0.0;
+    double frames = double(m_mono.size()) - (m_started ? m_nominal : 0.0);
+    return std::max(frames, 0.0) / m_sampleRate;
+}
+
+QByteArray TimeStretcher::process(const QByteArray &input) {
+    if (!m_active) {
+        if (m_rate == 1.0) return input;
+        m_active = true;
+        m_started = false;
+    }
+    appendInput(input);
+    // 恢复原速：输出剩余数据后回到透传
+    if (m_rate == 1.0) return drain();
+
+    QByteArray output;
+    const int frames = int(m_mono.size());
+    const size_t channels = size_t(m_channels);
+
+    // 第一段直接输出前半窗，后半窗加窗后留给下一段
+    if (!m_started) {
+        if (frames < m_window + m_search) return output;
+        output += toBytes(m_input.data(), m_overlap);
+        for (int i = 0; i < m_overlap; ++i) {
+            for (size_t c = 0; c < channels; ++c) {
+                m_tail[i * channels + c] = m_input[(m_overlap + i) * channels + c] *
+                                           m_hann[size_t(m_overlap + i)];
+            }
+        }
+        m_previous = 0;
+        m_nominal = m_rate * m_overlap;
+        m_started = true;
+    }
+
+    std::vector<float> segment(size_t(m_overlap) * channels);
+    while (true) {
+        int nominal = int(std::lround(m_nominal));
+        if (nominal + m_search + m_window > frames) break;
+
+        // 选中片段的前半窗与上一段的后半窗相加后输出
+        int best = findBestOffset(nominal);
+        for (int i = 0; i < m_overlap; ++i) {
+            const float *in = &m_input[(best + i) * channels];
+            const float *next = &m_input[(best + m_overlap + i) * channels];
+            float rise = m_hann[size_t(i)];
+            float fall = m_hann[size_t(m_overlap + i)];
+            for (size_t c = 0; c < channels; ++c) {
+                segment[i * channels + c] = m_tail[i * channels + c] + in[c] * rise;
+                m_tail[i * channels + c] = next[c] * fall;
+            }
+        }
+        output += toBytes(segment.data(), m_overlap);
+        m_previous = best;
+        m_nominal += m_rate * m_overlap;
+    }
+
+    discardConsumed();
+    return output;
+}
+
+QByteArray TimeStretcher::drain() {
+    // 上一段的后半窗与其自然延续相加即为原始样本，因此从后半窗起点开始原样输出
+    int from = m_started ? m_previous + m_overlap : 0;
+    int frames = int(m_mono.size());
+    QByteArray output;
+    if (from < frames) {
+        output = toBytes(&m_input[size_t(from) * size_t(m_channels)], frames - from);
+    }
+    reset();
+    return output;
+}
+
+void TimeStretcher::appendInput(const QByteArray &input) {
+    const float *samples = reinterpret_cast<const float *>(input.constData());
+    int frames = int(input.size() / (int(sizeof(float)) * m_channels));
+
+    size_t inputOffset = m_input.size();
+    size_t monoOffset = m_mono.size();
+    m_input.insert(m_input.end(), samples, samples + size_t(frames * m_channels));
+    m_mono.resize(monoOffset + size_t(frames));
+
+    const float scale = 1.0f / float(m_channels);
+    for (int i = 0; i < frames; ++i) {
+        const float *frame = &m_input[inputOffset + size_t(i * m_channels)];
+        float sum = 0.0f;
+        for (int c = 0; c < m_channels; ++c) {
+            sum += frame[c];
+        }
+        m_mono[monoOffset + size_t(i)] = sum * scale;
+    }
+}
+
+int TimeStretcher::findBestOffset(int nominal) const {
+    // 目标：上一段的自然延续（上一段起点之后半窗处开始的半窗）
+    const float *target = &m_mono[size_t(m_previous + m_overlap)];
+    int first = std::max(0, nominal - m_search);
+    int last = nominal + m_search;
+
+    auto score = [&](int offset) {
+        float dot = 0.0f;
+        float energy = 0.0f;
+        correlate(target, &m_mono[size_t(offset)], m_overlap, &dot, &energy);
+        return energy > 1e-9f ? dot / std::sqrt(energy) : 0.0f;
+    };
+
+    // 先按4帧步长粗搜，再在最佳位置附近逐帧细搜
+    int best = nominal;
+    float bestScore = score(nominal);
+    for (int offset = first; offset <= last; offset += 4) {
+        float value = score(offset);
+        if (value > bestScore) {
+            bestScore = value;
+            best = offset;
+        }
+    }
+    int center = best;
+    for (int offset = std::max(first, center - 3); offset <= std::min(last, center + 3); ++offset) {
+        float value = score(offset);
+        if (value > bestScore) {
+            bestScore = value;
+            best = offset;
+        }
+    }
+    return best;
+}
+
+void TimeStretcher::discardConsumed() {
+    // 之后还需要：下一次搜索的目标片段和候选范围
+    int consumed = std::min(m_previous + m_overlap, int(m_nominal) - m_search);
+    if (consumed <= 0) return;
+
+    m_input.erase(m_input.begin(), m_input.begin() + std::ptrdiff_t(consumed) * m_channels);
+    m_mono.erase(m_mono.begin(), m_mono.begin() + consumed);
+    m_previous -= consumed;
+    m_nominal -= consumed;
+}
+
+QByteArray TimeStretcher::toBytes(const float *samples, int frames) const {
+    return QByteArray(reinterpret_cast<const char *>(samples),
+                      frames * m_channels * int(sizeof(float)));
+}
@@ -0,0 +1,410 @@
+#include "media/WaveformPeaks.h"
+#include "core/Trace.h"
+#include "media/AudioResampler.h"
+#include "media/MediaIO.h"
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+}
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define WAVEFORM_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define WAVEFORM_NEON
+#endif
+
+namespace {
+
+constexpr char MAGIC[4] = {'W', 'P', 'K', 'S'};
+constexpr uint32_t FORMAT_VERSION = 1;
+constexpr int MAX_LEVELS = 32;
+
+// 文件头和级别表按本机字节序直接写入，映射后原样读取
+struct FileHeader {
+    char magic[4];
+    uint32_t version;
+    int64_t sourceSize;
+    int64_t sourceModified;  // 毫秒
+    int64_t frames;
+    int32_t sampleRate;
+    int32_t levelCount;
+};
+
+struct LevelEntry {
+    int64_t offset;  // PeakBucket数组在文件中的位置
+    int64_t count;
+    int64_t framesPerBucket;
+};
+
+int16_t toPeak(float value) {
+    return int16_t(std::clamp(std::lrint(value * 32767.0f), -32768L, 32767L));
+}
+
+// 热点：一个桶内的最小值、最大值和平方和，累加到已有结果上
+void accumulate(const float *samples, int count, float *min, float *max, double *sumSquares) {
+    int i = 0;
+    float lo = *min;
+    float hi = *max;
+    float squares = 0.0f;
+#if defined(WAVEFORM_SSE2)
+    __m128 vlo = _mm_set1_ps(lo);
+    __m128 vhi = _mm_set1_ps(hi);
+    __m128 vsq = _mm_setzero_ps();
+    for (; i + 4 <= count; i += 4) {
+        __m128 x = _mm_loadu_ps(samples + i);
+        vlo = _mm_min_ps(vlo, x);
+        vhi = _mm_max_ps(vhi, x);
+        vsq = _mm_add_ps(vsq, _mm_mul_ps(x, x));
+    }
+    alignas(16) float lanes[12];
+    _mm_store_ps(lanes, vlo);
+    _mm_store_ps(lanes + 4, vhi);
+    _mm_store_ps(lanes + 8, vsq);
+    lo = std::min(std::min(lanes[0], lanes[1]), std::min(lanes[2], lanes[3]));
+    hi = std::max(std::max(lanes[4], lanes[5]), std::max(lanes[6], lanes[7]));
+    squares = lanes[8] + lanes[9] + lanes[10] + lanes[11];
+#elif defined(WAVEFORM_NEON)
+    float32x4_t vlo = vdupq_n_f32(lo);
+    float32x4_t vhi = vdupq_n_f32(hi);
+    float32x4_t vsq = vdupq_n_f32(0.0f);
+    for (; i + 4 <= count; i += 4) {
+        float32x4_t x = vld1q_f32(samples + i);
+        vlo = vminq_f32(vlo, x);
+        vhi = vmaxq_f32(vhi, x);
+        vsq = vmlaq_f32(vsq, x, x);
+    }
+    float lanes[12];
+    vst1q_f32(lanes, vlo);
+    vst1q_f32(lanes + 4, vhi);
+    vst1q_f32(lanes + 8, vsq);
+    lo = std::min(std::min(lanes[0], lanes[1]), std::min(lanes[2], lanes[3]));
+    hi = std::max(std::max(lanes[4], lanes[5]), std::max(lanes[6], lanes[7]));
+    squares = lanes[8] + lanes[9] + lanes[10] + lanes[11];
+#endif
+    for (; i < count; ++i) {
+        lo = std::min(lo, samples[i]);
+        hi = std::max(hi, samples[i]);
+        squares += samples[i] * samples[i];
+    }
+    *min = lo;
+    *max = hi;
+    *sumSquares += squares;
+}
+
+// 把交错float按BASE_FRAMES帧一桶累计为第0级
+class PeakBuilder {
+public:
+    explicit PeakBuilder(int channels) : m_channels(channels) { resetBucket(); }
+
+    void add(const float *samples, int frames) {
+        while (frames > 0) {
+            int count = std::min(frames, WaveformPeaks::BASE_FRAMES - m_pending);
+            accumulate(samples, count * m_channels, &m_min, &m_max, &m_sumSquares);
+            m_pending += count;
+            m_frames += count;
+            samples += size_t(count) * size_t(m_channels);
+            frames -= count;
+            if (m_pending == WaveformPeaks::BASE_FRAMES) {
+                finishBucket();
+            }
+        }
+    }
+
+    void finish() {
+        if (m_pending > 0) finishBucket();
+    }
+
+    int64_t frames() const { return m_frames; }
+    std::vector<PeakBucket> &buckets() { return m_buckets; }
+
+private:
+    void finishBucket() {
+        double meanSquare = m_sumSquares / (double(m_pending) * m_channels);
+        m_buckets.push_back({toPeak(m_min), toPeak(m_max), toPeak(float(std::sqrt(meanSquare)))});
+        resetBucket();
+    }
+
+    void resetBucket() {
+        m_min = std::numeric_limits<float>::max();
+        m_max = std::numeric_limits<float>::lowest();
+        m_sumSquares = 0.0;
+        m_pending = 0;
+    }
+
+    const int m_channels;
+    std::vector<PeakBucket> m_buckets;
+    float m_min;
+    float m_max;
+    double m_sumSquares;
+    int m_pending;  // 当前桶已累计的帧数
+    int64_t m_frames{0};
+};
+
+// 每LEVEL_FACTOR个桶合并为上一级的一个桶
+std::vector<PeakBucket> mergeLevel(const std::vector<PeakBucket> &source) {
+    std::vector<PeakBucket> merged;
+    merged.reserve((source.size() + WaveformPeaks::LEVEL_FACTOR - 1) /
+                   WaveformPeaks::LEVEL_FACTOR);
+    for (size_t i = 0; i < source.size(); i += WaveformPeaks::LEVEL_FACTOR) {
+        size_t end = std::min(source.size(), i + WaveformPeaks::LEVEL_FACTOR);
+        PeakBucket bucket = source[i];
+        double squares = double(bucket.rms) * bucket.rms;
+        for (size_t j = i + 1; j < end; ++j) {
+            bucket.min = std::min(bucket.min, source[j].min);
+            bucket.max = std::max(bucket.max, source[j].max);
+            squares += double(source[j].rms) * source[j].rms;
+        }
+        bucket.rms = int16_t(std::lround(std::sqrt(squares / double(end - i))));
+        merged.push_back(bucket);
+    }
+    return merged;
+}
+
+// 解码所需的FFmpeg对象，析构时统一释放
+struct AudioSource {
+    ~AudioSource() {
+        av_frame_free(&frame);
+        av_packet_free(&packet);
+        avcodec_free_context(&codecContext);
+        avformat_close_input(&formatContext);
+    }
+
+    std::unique_ptr<MediaIO> io;
+    AVFormatContext *formatContext{nullptr};
+    AVCodecContext *codecContext{nullptr};
+    AVPacket *packet{nullptr};
+    AVFrame *frame{nullptr};
+    int streamIndex{-1};
+};
+
+bool openSource(const QString &mediaPath, AudioSource *source) {
+    source->formatContext = avformat_alloc_context();
+    if (!source->formatContext) return false;
+
+    source->io = MediaIO::create(mediaPath);
+    if (source->io) {
+        if (AVIOContext *avio = source->io->avioContext()) {
+            source->formatContext->pb = avio;
+            source->formatContext->flags |= AVFMT_FLAG_CUSTOM_IO;
+        }
+    }
+
+    QByteArray path = mediaPath.toUtf8();
+    if (avformat_open_input(&source->formatContext, path.constData(), nullptr, nullptr) != 0 ||
+        avformat_find_stream_info(source->formatContext, nullptr) < 0) {
+        return false;
+    }
+
+    source->streamIndex =
+        av_find_best_stream(source->formatContext, AVMEDIA_TYPE_AUDIO, -1, -1, nullptr, 0);
+    if (source->streamIndex < 0) return false;
+
+    // 其余流在解封装时直接丢弃
+    for (unsigned i = 0; i < source->formatContext->nb_streams; ++i) {
+        if (int(i) != source->streamIndex) {
+            source->formatContext->streams[i]->discard = AVDISCARD_ALL;
+        }
+    }
+
+    AVStream *stream = source->formatContext->streams[source->streamIndex];
+    const AVCodec *codec = avcodec_find_decoder(stream->codecpar->codec_id);
+    if (!codec) return false;
+    source->codecContext = avcodec_alloc_context3(codec);
+    avcodec_parameters_to_context(source->codecContext, stream->codecpar);
+    source->codecContext->pkt_timebase = stream->time_base;
+    source->codecContext->thread_count = 0;  // 自动
+    if (avcodec_open2(source->codecContext, codec, nullptr) < 0) {
+        qDebug() << "打开解码器失败:" << codec->name;
+        return false;
+    }
+
+    source->packet = av_packet_alloc();
+    source->frame = av_frame_alloc();
+    return source->packet && source->frame;
+}
+
+}  // namespace
+
+WaveformPeaks::~WaveformPeaks() = default;
+
+QString WaveformPeaks::peakPath(const QString &mediaPath) {
+    QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/peaks";
+    const QString key = QCryptographicHash::hash(
+                            QFileInfo(mediaPath).absoluteFilePath().toUtf8(),
+                            QCryptographicHash::Sha1)
+                            .toHex();
+    return cacheDir + "/" + key + ".peaks";
+}
+
+std::unique_ptr<WaveformPeaks> WaveformPeaks::open(const QString &mediaPath) {
+    QFileInfo source(mediaPath);
+    if (!source.isFile()) return nullptr;
+
+    std::unique_ptr<WaveformPeaks> peaks(new WaveformPeaks());
+    peaks->m_file.setFileName(peakPath(mediaPath));
+    if (!peaks->m_file.open(QIODevice::ReadOnly)) return nullptr;
+
+    const qint64 size = peaks->m_file.size();
+    if (size < qint64(sizeof(FileHeader))) return nullptr;
+    const uchar *data = peaks->m_file.map(0, size);
+    if (!data) return nullptr;
+
+    FileHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 ||
+        header.version != FORMAT_VERSION || header.sourceSize != source.size() ||
+        header.sourceModified != source.lastModified().toMSecsSinceEpoch() ||
+        header.sampleRate <= 0 || header.levelCount <= 0 || header.levelCount > MAX_LEVELS ||
+        size < qint64(sizeof(FileHeader) + sizeof(LevelEntry) * size_t(header.levelCount))) {
+        return nullptr;
+    }
+
+    for (int i = 0; i < header.levelCount; ++i) {
+        LevelEntry entry;
+        std::memcpy(&entry, data + sizeof(FileHeader) + sizeof(LevelEntry) * size_t(i),
+                    sizeof(entry));
+        if (entry.offset < 0 || entry.count <= 0 || entry.framesPerBucket <= 0 ||
+            entry.offset % qint64(alignof(PeakBucket)) != 0 ||
+            entry.offset + entry.count * qint64(sizeof(PeakBucket)) > size) {
+            return nullptr;
+        }
+        peaks->m_levels.push_back({reinterpret_cast<const PeakBucket *>(data + entry.offset),
+                                   entry.count, entry.framesPerBucket});
+    }
+    peaks->m_sampleRate = header.sampleRate;
+    peaks->m_frames = header.frames;
+    return peaks;
+}
+
+bool WaveformPeaks::generate(const QString &mediaPath, const std::atomic<bool> *cancel,
+                             const std::function<void(double)> &progress) {
+    TRACE_SCOPE("WaveformPeaks::generate", "decode");
+
+    QFileInfo sourceInfo(mediaPath);
+    if (!sourceInfo.isFile()) return false;
+
+    AudioSource source;
+    if (!openSource(mediaPath, &source)) {
+        qDebug() << "无法生成波形，打开音频流失败:" << mediaPath;
+        return false;
+    }
+
+    // 只转换为交错float，保持原声道数和采样率
+    AVCodecContext *codecContext = source.codecContext;
+    const int channels = AudioResampler::channelCount(codecContext);
+    const int sampleRate = codecContext->sample_rate;
+    AudioResampler resampler;
+    if (channels <= 0 || sampleRate <= 0 ||
+        !resampler.open(codecContext, channels, sampleRate, AV_SAMPLE_FMT_FLT)) {
+        return false;
+    }
+
+    PeakBuilder builder(channels);
+    auto addSamples = [&](const QByteArray &pcm) {
+        builder.add(reinterpret_cast<const float *>(pcm.constData()),
+                    pcm.size() / int(sizeof(float) * channels));
+    };
+    auto receiveFrames = [&]() {
+        while (avcodec_receive_frame(codecContext, source.frame) == 0) {
+            addSamples(resampler.convert(source.frame));
+            av_frame_unref(source.frame);
+        }
+    };
+
+    const double duration = source.formatContext->duration != AV_NOPTS_VALUE
+                                ? double(source.formatContext->duration) / AV_TIME_BASE
+                                : 0.0;
+    int reported = -1;
+    while (av_read_frame(source.formatContext, source.packet) >= 0) {
+        if (cancel && cancel->load(std::memory_order_relaxed)) {
+            av_packet_unref(source.packet);
+            return false;
+        }
+        if (source.packet->stream_index == source.streamIndex) {
+            if (avcodec_send_packet(codecContext, source.packet) == 0) {
+                receiveFrames();
+            }
+        }
+        av_packet_unref(source.packet);
+
+        // 进度按已解码的时长估算，每1%通知一次
+        if (progress && duration > 0.0) {
+            int percent = int(100.0 * double(builder.frames()) / sampleRate / duration);
+            if (percent != reported) {
+                reported = percent;
+                progress(std::min(percent, 100) / 100.0);
+            }
+        }
+    }
+    avcodec_send_packet(codecContext, nullptr);
+    receiveFrames();
+    addSamples(resampler.flush());
+    builder.finish();
+
+    if (builder.buckets().empty()) return false;
+
+    // 逐级合并，最粗一级不少于MIN_BUCKETS个桶（很短的文件只有第0级）
+    std::vector<std::vector<PeakBucket>> levels;
+    levels.push_back(std::move(builder.buckets()));
+    while (levels.size() < size_t(MAX_LEVELS) &&
+           levels.back().size() >= size_t(MIN_BUCKETS) * LEVEL_FACTOR) {
+        levels.push_back(mergeLevel(levels.back()));
+    }
+
+    const QString path = peakPath(mediaPath);
+    if (!QDir().mkpath(QFileInfo(path).absolutePath())) {
+        qDebug() << "无法创建波形缓存目录:" << QFileInfo(path).absolutePath();
+        return false;
+    }
+
+    FileHeader header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = FORMAT_VERSION;
+    header.sourceSize = sourceInfo.size();
+    header.sourceModified = sourceInfo.lastModified().toMSecsSinceEpoch();
+    header.frames = builder.frames();
+    header.sampleRate = sampleRate;
+    header.levelCount = int32_t(levels.size());
+
+    std::vector<LevelEntry> entries;
+    int64_t offset = int64_t(sizeof(FileHeader) + sizeof(LevelEntry) * levels.size());
+    int64_t framesPerBucket = BASE_FRAMES;
+    for (const auto &level : levels) {
+        entries.push_back({offset, int64_t(level.size()), framesPerBucket});
+        offset += int64_t(level.size() * sizeof(PeakBucket));
+        framesPerBucket *= LEVEL_FACTOR;
+    }
+
+    // 写入临时文件后整体替换，读者不会看到写了一半的文件
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) return false;
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(entries.data()),
+               qint64(entries.size() * sizeof(LevelEntry)));
+    for (const auto &level : levels) {
+        file.write(reinterpret_cast<const char *>(level.data()),
+                   qint64(level.size() * sizeof(PeakBucket)));
+    }
+    if (!file.commit()) {
+        qDebug() << "写入波形缓存失败:" << path;
+        return false;
+    }
+
+    if (progress) progress(1.0);
+    qDebug() << "波形已生成:" << mediaPath << levels.size() << "级," << levels[0].size() << "桶";
+    return true;
+}
@@ -1,72 +1,17 @@
 #include "AudioPlayer.h"
+#include "core/Trace.h"
+#include "media/MediaProbeCache.h"
+#include <QAudioDevice>
 #include <QDebug>
+#include <QMediaDevices>
 #include <QThread>
+#include <algorithm>
+#include <cmath>
 
-// AudioBuffer implementation
-AudioBuffer::AudioBuffer(QObject *parent) : QIODevice(parent), m_currentPos(0) {
-    open(QIODevice::ReadWrite);
-}
-
-void AudioBuffer::writeData(const QByteArray &data) {
-    QMutexLocker locker(&m_mutex);
-    m_bufferQueue.push(data);
-}
-
-void AudioBuffer::clear() {
-    QMutexLocker locker(&m_mutex);
-    while (!m_bufferQueue.empty()) {
-        m_bufferQueue.pop();
-    }
-    m_currentBuffer.clear();
-    m_currentPos = 0;
-}
-
-bool AudioBuffer::isEmpty() const {
-    QMutexLocker locker(&m_mutex);
-    return m_bufferQueue.empty() && (m_currentPos >= m_currentBuffer.size());
-}
-
-qint64 AudioBuffer::readData(char *data, qint64 maxlen) {
-    QMutexLocker locker(&m_mutex);
-
-    qint64 totalRead = 0;
-
-    while (totalRead < maxlen) {
-        // If current buffer is exhausted, get next one from queue
-        if (m_currentPos >= m_currentBuffer.size()) {
-            if (m_bufferQueue.empty()) {
-                break;  // No more data available
-            }
-            m_currentBuffer = m_bufferQueue.front();
-            m_bufferQueue.pop();
-            m_currentPos = 0;
-        }
-
-        // Calculate how much we can read from current buffer
-        qint64 remainingInBuffer = m_currentBuffer.size() - m_currentPos;
-        qint64 toRead = qMin(maxlen - totalRead, remainingInBuffer);
-
-        // Copy data
-        memcpy(data + totalRead, m_currentBuffer.constData() + m_currentPos, toRead);
-        m_currentPos += toRead;
-        totalRead += toRead;
-    }
-
-    return totalRead;
-}
-
-qint64 AudioBuffer::writeData(const char *data, qint64 len) {
-    Q_UNUSED(data)
-    Q_UNUSED(len)
-    return 0;  // We handle writing through writeData(const QByteArray&)
-}
-
-// AudioPlayer implementation
 AudioPlayer::AudioPlayer(QObject *parent)
     : QObject(parent),
       m_audioSink(nullptr),
       m_audioBuffer(nullptr),
-      m_swrContext(nullptr),
       m_currentTime(0.0),
       m_sampleRate(44100),
       m_channels(2),
@@ -83,9 +28,6 @@ AudioPlayer::AudioPlayer(QObject *parent)
 
 AudioPlayer::~AudioPlayer() {
     stop();
-    if (m_swrContext) {
-        swr_free(&m_swrContext);
-    }
     if (m_audioSink) {
         m_audioSink->deleteLater();
     }
@@ -97,8 +39,7 @@ bool AudioPlayer::initialize(AVCodecContext *audioCodecContext) {
         return false;
     }
 
-    // FFmpeg 4.4 compatibility - use channels instead of ch_layout
-    int channels = audioCodecContext->channels;
+    int channels = AudioResampler::channelCount(audioCodecContext);
     qDebug() << "AudioPlayer: Initializing with sample rate:" << audioCodecContext->sample_rate
              << "channels:" << channels
              << "format:" << av_get_sample_fmt_name(audioCodecContext->sample_fmt);
@@ -119,41 +60,133 @@ bool AudioPlayer::initialize(AVCodecContext *audioCodecContext) {
 
     connect(m_audioSink, QOverload<QAudio::State>::of(&QAudioSink::stateChanged), this,
             &AudioPlayer::onAudioStateChanged);
+    // 音量由AudioProcessor在浮点级处理
     m_audioSink->setVolume(1.0);
+    m_processor =
+        std::make_unique<AudioProcessor>(m_audioFormat.channelCount(), m_audioFormat.sampleRate());
+    m_meter =
+        std::make_unique<LoudnessMeter>(m_audioFormat.channelCount(), m_audioFormat.sampleRate());
 
     // Setup resampler for format conversion
-    m_swrContext = swr_alloc();
-    if (!m_swrContext) {
-        qDebug() << "AudioPlayer: Failed to allocate resampler";
+    m_resampler = createResampler(audioCodecContext);
+    if (!m_resampler) {
         return false;
     }
 
-    // FFmpeg 4.4 compatibility - use legacy channel layout API
-    // Configure input parameters
-    swr_alloc_set_opts(m_swrContext,
-                       m_channels == 1 ? AV_CH_LAYOUT_MONO : AV_CH_LAYOUT_STEREO,  // out_ch_layout
-                       AV_SAMPLE_FMT_S16,                                          // out_sample_fmt
-                       m_sampleRate,                       // out_sample_rate
-                       audioCodecContext->channel_layout,  // in_ch_layout
-                       audioCodecContext->sample_fmt,      // in_sample_fmt
-                       audioCodecContext->sample_rate,     // in_sample_rate
-                       0, nullptr);                        // Initialize the resampler
-    if (swr_init(m_swrContext) < 0) {
-        qDebug() << "AudioPlayer: Failed to initialize resampler";
-        swr_free(&m_swrContext);
+    m_initialized = true;
+    qDebug() << "AudioPlayer: Successfully initialized";
+    return true;
+}
+
+std::unique_ptr<AudioResampler> AudioPlayer::createResampler(AVCodecContext *audioCodecContext) {
+    // 输出为设备的声道数和采样率、交错float，S16由AudioProcessor最后转换；输入格式随文件变化
+    auto resampler = std::make_unique<AudioResampler>();
+    if (!resampler->open(audioCodecContext, m_audioFormat.channelCount(),
+                         m_audioFormat.sampleRate(), AV_SAMPLE_FMT_FLT)) {
+        qDebug() << "AudioPlayer: Failed to create resampler";
+        return nullptr;
+    }
+    return resampler;
+}
+
+void AudioPlayer::setSource(const QString &filePath, int streamIndex) {
+    if (!m_meter) return;
+
+    storeLoudness();
+    m_meter->reset();
+    m_sourcePath = filePath;
+    m_sourceStream = streamIndex;
+
+    // 以节目响度对齐到目标响度，提升幅度受上限和采样峰值限制，避免削波
+    float normalization = 1.0f;
+    LoudnessInfo info;
+    if (MediaProbeCache::loudness(filePath, streamIndex, &info)) {
+        double gainDb = std::min(TARGET_LOUDNESS - info.integrated, MAX_BOOST_DB);
+        double gain = std::pow(10.0, gainDb / 20.0);
+        if (info.peak > 0.0f) {
+            gain = std::min(gain, 1.0 / info.peak);
+        }
+        normalization = float(gain);
+        qDebug() << "AudioPlayer: Loudness" << info.integrated << "LUFS, normalization"
+                 << gainDb << "dB";
+    }
+    m_processor->setNormalization(normalization);
+}
+
+void AudioPlayer::storeLoudness() {
+    if (!m_meter || m_sourcePath.isEmpty() || m_meter->measuredSeconds() < MIN_MEASURE_SECONDS) {
+        return;
+    }
+    double integrated = m_meter->integrated();
+    if (!std::isfinite(integrated)) return;
+
+    // 只保存覆盖时长更长的测量
+    LoudnessInfo info;
+    if (MediaProbeCache::loudness(m_sourcePath, m_sourceStream, &info) &&
+        info.seconds >= m_meter->measuredSeconds()) {
+        return;
+    }
+    info.integrated = integrated;
+    info.peak = m_meter->peak();
+    info.seconds = m_meter->measuredSeconds();
+    MediaProbeCache::storeLoudness(m_sourcePath, m_sourceStream, info);
+}
+
+bool AudioPlayer::prepareNext(AVCodecContext *audioCodecContext, const QString &filePath,
+                              int streamIndex) {
+    if (!m_initialized || !audioCodecContext) {
         return false;
     }
 
-    m_initialized = true;
-    qDebug() << "AudioPlayer: Successfully initialized";
+    // 下一项重采样到当前设备格式，无需重建QAudioSink，衔接处没有间隙
+    m_nextResampler = createResampler(audioCodecContext);
+    m_nextSourcePath = filePath;
+    m_nextSourceStream = streamIndex;
+    return m_nextResampler != nullptr;
+}
+
+void AudioPlayer::cancelPrepared() { m_nextResampler.reset(); }
+
+bool AudioPlayer::switchToPrepared() {
+    if (!m_nextResampler) {
+        return false;
+    }
+
+    // 取出当前重采样器内部缓存的尾部样本，保证上一项完整播完
+    if (m_resampler) {
+        QByteArray tail = m_resampler->flush();
+        if (!tail.isEmpty()) {
+            writeOutput(tail);
+        }
+    }
+
+    m_resampler = std::move(m_nextResampler);
+    setSource(m_nextSourcePath, m_nextSourceStream);
     return true;
 }
 
 bool AudioPlayer::setupAudioFormat(AVCodecContext *codecContext) {
     m_audioFormat.setSampleRate(codecContext->sample_rate);
-    m_audioFormat.setChannelCount(qMin(codecContext->channels, 2));  // Max stereo
     m_audioFormat.setSampleFormat(QAudioFormat::Int16);
 
+    // 5.1/7.1在设备支持时原样输出（Qt的声道顺序与FFmpeg声道掩码的位序一致），
+    // 否则输出立体声，由重采样器下混
+    int channels = AudioResampler::channelCount(codecContext);
+    uint64_t layout = AudioResampler::channelLayout(codecContext);
+    bool surround = (channels == 6 && (layout == AV_CH_LAYOUT_5POINT1 ||
+                                       layout == AV_CH_LAYOUT_5POINT1_BACK)) ||
+                    (channels == 8 && layout == AV_CH_LAYOUT_7POINT1);
+    m_audioFormat.setChannelCount(qMin(channels, 2));
+    if (surround) {
+        QAudioFormat native = m_audioFormat;
+        native.setChannelCount(channels);
+        native.setChannelConfig(QAudioFormat::defaultChannelConfigForChannelCount(channels));
+        QAudioDevice device = QMediaDevices::defaultAudioOutput();
+        if (device.maximumChannelCount() >= channels && device.isFormatSupported(native)) {
+            m_audioFormat = native;
+        }
+    }
+
     qDebug() << "AudioPlayer: Audio format - Rate:" << m_audioFormat.sampleRate()
              << "Channels:" << m_audioFormat.channelCount()
              << "Format:" << m_audioFormat.sampleFormat();
@@ -161,18 +194,26 @@ bool AudioPlayer::setupAudioFormat(AVCodecContext *codecContext) {
     return true;
 }
 
-void AudioPlayer::playAudioFrame(AVFrame *frame) {
-    if (!frame || !m_swrContext || !m_initialized) {
+void AudioPlayer::playAudioFrame(AVFrame *frame, double pts) {
+    TRACE_SCOPE("AudioPlayer::playAudioFrame", "audio");
+
+    if (!frame || !m_resampler || !m_initialized) {
         return;
     }
 
     // Update timing information
     updateTimeFromFrame(frame);
+    if (frame->sample_rate > 0) {
+        m_clockEnd = pts + double(frame->nb_samples) / frame->sample_rate;
+        m_hasClock = true;
+    }
 
     // Convert audio frame to Qt-compatible format
-    QByteArray audioData = convertAudioFrame(frame);
+    QByteArray audioData = m_resampler->convert(frame);
     if (!audioData.isEmpty()) {
-        m_audioBuffer->writeData(audioData);
+        m_meter->process(reinterpret_cast<const float *>(audioData.constData()),
+                         audioData.size() / int(sizeof(float) * m_audioFormat.channelCount()));
+        writeOutput(audioData);
 
         // Emit buffer level changed signal
         // This is a rough estimate - you might want to implement more sophisticated buffering
@@ -180,46 +221,17 @@ void AudioPlayer::playAudioFrame(AVFrame *frame) {
     }
 }
 
-QByteArray AudioPlayer::convertAudioFrame(AVFrame *frame) {
-    if (!m_swrContext) {
-        return QByteArray();
-    }
-
-    // Calculate output samples
-    int out_samples = swr_get_out_samples(m_swrContext, frame->nb_samples);
-    if (out_samples < 0) {
-        qDebug() << "AudioPlayer: Error getting output samples count";
-        return QByteArray();
-    }
-
-    int out_channels = m_audioFormat.channelCount();
-
-    // Allocate output buffer
-    uint8_t *out_buffer = nullptr;
-    int out_linesize;
-    int ret = av_samples_alloc(&out_buffer, &out_linesize, out_channels, out_samples,
-                               AV_SAMPLE_FMT_S16, 0);
-    if (ret < 0) {
-        qDebug() << "AudioPlayer: Failed to allocate output buffer";
-        return QByteArray();
-    }
-
-    // Convert audio samples
-    int converted_samples = swr_convert(m_swrContext, &out_buffer, out_samples,
-                                        (const uint8_t **)frame->data, frame->nb_samples);
-
-    if (converted_samples < 0) {
-        qDebug() << "AudioPlayer: Error converting audio samples";
-        av_freep(&out_buffer);
-        return QByteArray();
+void AudioPlayer::writeOutput(const QByteArray &data) {
+    // 变速在重采样之后进行，只需处理设备的声道数和采样率（float，设备支持时为多声道），
+    // 最后经AudioProcessor加音量、淡化并转换为S16
+    QByteArray output = m_stretcher ? m_stretcher->process(data) : data;
+    if (output.isEmpty()) return;
+    // 暂停期间（包括渐出段尚未播完时）送入的数据保留到恢复时
+    if (m_paused) {
+        m_held.append(m_processor->process(output));
+    } else {
+        m_audioBuffer->writeData(m_processor->process(output));
     }
-
-    // Create QByteArray from converted data
-    int data_size = converted_samples * out_channels * sizeof(int16_t);
-    QByteArray result((const char *)out_buffer, data_size);
-
-    av_freep(&out_buffer);
-    return result;
 }
 
 void AudioPlayer::updateTimeFromFrame(AVFrame *frame) {
@@ -235,23 +247,52 @@ void AudioPlayer::start() {
         return;
     }
 
+    restoreHeld();
     m_audioSink->start(m_audioBuffer);
     m_positionTimer->start();
 }
 
 void AudioPlayer::pause() {
-    if (m_audioSink) {
-        qDebug() << "AudioPlayer: Pausing playback";
+    if (!m_audioSink || m_paused) return;
+
+    qDebug() << "AudioPlayer: Pausing playback";
+    m_paused = true;
+    m_positionTimer->stop();
+
+    // 设备接下来要播放的一小段渐出到静音，其余数据保留到恢复时；
+    // 设备空闲或没有可渐出的数据时直接挂起，否则等渐出段播完（进入Idle）再挂起
+    QByteArray head = m_audioBuffer->take(m_processor ? m_processor->fadeBytes() : 0);
+    m_held = m_audioBuffer->take();
+    if (head.isEmpty() || m_audioSink->state() != QAudio::ActiveState) {
+        m_held.prepend(head);
         m_audioSink->suspend();
-        m_positionTimer->stop();
+        return;
     }
+    m_audioBuffer->writeData(m_processor->fadeOut(head));
+    m_suspendPending = true;
 }
 
 void AudioPlayer::resume() {
-    if (m_audioSink) {
-        qDebug() << "AudioPlayer: Resuming playback";
+    if (!m_audioSink) return;
+
+    qDebug() << "AudioPlayer: Resuming playback";
+    bool suspended = !m_suspendPending;
+    restoreHeld();
+    if (suspended) {
         m_audioSink->resume();
-        m_positionTimer->start();
+    }
+    m_positionTimer->start();
+}
+
+void AudioPlayer::restoreHeld() {
+    // 缓冲区开头渐入，避免从暂停或跳转后的非零样本直接起播；
+    // 渐出段尚未播完时排在保留数据之前
+    QByteArray pending = m_audioBuffer->take() + m_held;
+    m_held.clear();
+    m_paused = false;
+    m_suspendPending = false;
+    if (!pending.isEmpty()) {
+        m_audioBuffer->writeData(m_processor ? m_processor->fadeIn(pending) : pending);
     }
 }
 
@@ -265,13 +306,24 @@ void AudioPlayer::stop() {
     if (m_audioBuffer) {
         m_audioBuffer->clear();
     }
+    m_held.clear();
+    m_paused = false;
+    m_suspendPending = false;
+    if (m_stretcher) {
+        m_stretcher->reset();
+    }
+    if (m_processor) {
+        m_processor->reset();
+    }
+    storeLoudness();
 
     m_currentTime = 0.0;
+    m_hasClock = false;
 }
 
 void AudioPlayer::setVolume(qreal volume) {
-    if (m_audioSink) {
-        m_audioSink->setVolume(qBound(0.0, volume, 1.0));
+    if (m_processor) {
+        m_processor->setGain(float(qBound(0.0, volume, 1.0)));
         qDebug() << "AudioPlayer: Volume set to" << volume;
     }
 }
@@ -280,14 +332,55 @@ bool AudioPlayer::isPlaying() const {
     return m_audioSink && (m_audioSink->state() == QAudio::ActiveState);
 }
 
-qreal AudioPlayer::getVolume() const { return m_audioSink ? m_audioSink->volume() : 0.0; }
+qreal AudioPlayer::getVolume() const { return m_processor ? m_processor->gain() : 0.0; }
 
-bool AudioPlayer::hasBufferedData() const { return m_audioBuffer && !m_audioBuffer->isEmpty(); }
+bool AudioPlayer::hasBufferedData() const {
+    return (m_audioBuffer && !m_audioBuffer->isEmpty()) || !m_held.isEmpty();
+}
 
 void AudioPlayer::clearBuffer() {
     if (m_audioBuffer) {
+        // 设备接下来要播放的一小段与新数据交叉淡化，其余丢弃
+        QByteArray tail = m_audioBuffer->take(m_processor ? m_processor->fadeBytes() : 0);
         m_audioBuffer->clear();
+        if (m_processor) {
+            m_processor->crossfadeFrom(tail);
+        }
+    }
+    m_held.clear();
+    if (m_stretcher) {
+        m_stretcher->reset();
     }
+    m_hasClock = false;
+}
+
+double AudioPlayer::bufferedSeconds() const {
+    qint64 bytes = (m_audioBuffer ? m_audioBuffer->bufferedBytes() : 0) + m_held.size();
+    if (m_audioSink && m_audioSink->state() != QAudio::StoppedState) {
+        bytes += m_audioSink->bufferSize() - m_audioSink->bytesFree();
+    }
+    int bytesPerSecond = m_audioFormat.bytesForDuration(1000000);
+    return bytesPerSecond > 0 ? double(bytes) / bytesPerSecond : 0.0;
+}
+
+void AudioPlayer::setPlaybackRate(double rate) {
+    if (m_resampler) m_resampler->setSpeed(rate);
+    if (m_nextResampler) m_nextResampler->setSpeed(rate);
+}
+
+void AudioPlayer::setTempo(double tempo) {
+    if (!m_stretcher) {
+        if (tempo == 1.0) return;
+        m_stretcher = std::make_unique<TimeStretcher>(m_audioFormat.channelCount(),
+                                                      m_audioFormat.sampleRate());
+    }
+    m_stretcher->setRate(tempo);
+}
+
+double AudioPlayer::clock() const {
+    // 已送入的媒体时间 - 变速器中尚未输出的部分 - 缓冲中尚未播放的部分（输出时长按速度折算）
+    double pending = m_stretcher ? m_stretcher->pendingSeconds() : 0.0;
+    return m_clockEnd - pending - bufferedSeconds() * tempo();
 }
 
 void AudioPlayer::updatePosition() {
@@ -310,9 +403,15 @@ void AudioPlayer::onAudioStateChanged() {
             qDebug() << "AudioPlayer: Error occurred:" << m_audioSink->error();
         }
         break;
+    case QAudio::IdleState:
+        // 暂停前的渐出段已播完
+        if (m_suspendPending) {
+            m_suspendPending = false;
+            m_audioSink->suspend();
+        }
+        break;
         // case QAudio::ActiveState: qDebug() << "AudioPlayer: Playback active"; break;
         // case QAudio::SuspendedState: qDebug() << "AudioPlayer: Playback suspended"; break;
-        // case QAudio::IdleState: qDebug() << "AudioPlayer: Playback idle"; break;
     }
 }
 
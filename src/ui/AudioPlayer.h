@@ -1,42 +1,22 @@
 #pragma once
 
+#include "media/AudioBuffer.h"
+#include "media/AudioProcessor.h"
+#include "media/AudioResampler.h"
+#include "media/LoudnessMeter.h"
+#include "media/TimeStretcher.h"
 #include <QAudio>
 #include <QAudioFormat>
 #include <QAudioSink>
-#include <QBuffer>
-#include <QIODevice>
-#include <QMutex>
 #include <QObject>
 #include <QTimer>
-#include <queue>
+#include <memory>
 
 extern "C" {
 #include <libavcodec/avcodec.h>
 #include <libavformat/avformat.h>
-#include <libswresample/swresample.h>
 }
 
-class AudioBuffer : public QIODevice {
-    Q_OBJECT
-
-public:
-    explicit AudioBuffer(QObject *parent = nullptr);
-
-    void writeData(const QByteArray &data);
-    void clear();
-    bool isEmpty() const;
-
-protected:
-    qint64 readData(char *data, qint64 maxlen) override;
-    qint64 writeData(const char *data, qint64 len) override;
-
-private:
-    std::queue<QByteArray> m_bufferQueue;
-    mutable QMutex m_mutex;
-    QByteArray m_currentBuffer;
-    int m_currentPos;
-};
-
 class AudioPlayer : public QObject {
     Q_OBJECT
 
@@ -47,8 +27,20 @@ public:
     // 初始化音频播放器
     bool initialize(AVCodecContext *audioCodecContext);
 
-    // 播放音频帧
-    void playAudioFrame(AVFrame *frame);
+    // 播放音频帧，pts为帧的起始时间戳（秒）
+    void playAudioFrame(AVFrame *frame, double pts);
+
+    // 响度测量和归一化所属的文件和音频流：按缓存中上次测得的综合响度设置归一化增益，
+    // 并把本次测得的结果在切换或停止时写回缓存
+    void setSource(const QString &filePath, int streamIndex);
+    const LoudnessMeter *loudnessMeter() const { return m_meter.get(); }
+
+    // 无缝切换：提前为下一项创建重采样器，当前项播完后切换
+    bool prepareNext(AVCodecContext *audioCodecContext, const QString &filePath = QString(),
+                     int streamIndex = -1);
+    bool hasPrepared() const { return m_nextResampler != nullptr; }
+    bool switchToPrepared();
+    void cancelPrepared();
 
     // 播放控制
     void start();
@@ -65,6 +57,19 @@ public:
     // 缓冲区状态
     bool hasBufferedData() const;
     void clearBuffer();
+    // 已转换但尚未播放的时长（缓冲区 + 设备缓冲）
+    double bufferedSeconds() const;
+
+    // 播放速度微调（直播延迟控制）
+    void setPlaybackRate(double rate);
+
+    // 变速播放：重采样后经TimeStretcher变速，音调不变
+    void setTempo(double tempo);
+    double tempo() const { return m_stretcher ? m_stretcher->rate() : 1.0; }
+
+    // 音频时钟：扬声器正在播放的媒体时间（秒），作为音画同步的主时钟
+    bool hasClock() const { return m_hasClock; }
+    double clock() const;
 
 signals:
     void positionChanged(qint64 position);
@@ -78,19 +83,39 @@ private slots:
 private:
     // 私有方法
     bool setupAudioFormat(AVCodecContext *codecContext);
-    QByteArray convertAudioFrame(AVFrame *frame);
+    std::unique_ptr<AudioResampler> createResampler(AVCodecContext *audioCodecContext);
     void updateTimeFromFrame(AVFrame *frame);
+    void writeOutput(const QByteArray &data);
+    void restoreHeld();
+    void storeLoudness();
 
 private:
     QAudioFormat m_audioFormat;
     QAudioSink *m_audioSink;
     AudioBuffer *m_audioBuffer;
-    SwrContext *m_swrContext;
+    std::unique_ptr<AudioResampler> m_resampler;
+    std::unique_ptr<AudioResampler> m_nextResampler;  // 下一项的重采样器
+    std::unique_ptr<TimeStretcher> m_stretcher;       // 首次变速时创建
+    std::unique_ptr<AudioProcessor> m_processor;      // 音量、淡化和S16转换
+    std::unique_ptr<LoudnessMeter> m_meter;           // 重采样后、变速前测量
+    QString m_sourcePath;
+    int m_sourceStream{-1};
+    QString m_nextSourcePath;
+    int m_nextSourceStream{-1};
     QTimer *m_positionTimer;
+    QByteArray m_held;             // 暂停期间保留的未播放数据，恢复时渐入后写回
+    bool m_paused{false};
+    bool m_suspendPending{false};  // 渐出段播完后再挂起设备
 
     double m_currentTime;
+    double m_clockEnd{0.0};  // 已送入的最后一帧的结束时间戳
+    bool m_hasClock{false};
     int m_sampleRate;
     int m_channels;
     AVRational m_timeBase;
     bool m_initialized;
+
+    static constexpr double TARGET_LOUDNESS = -18.0;     // LUFS
+    static constexpr double MAX_BOOST_DB = 12.0;
+    static constexpr double MIN_MEASURE_SECONDS = 10.0;  // 测量时长不足时不写入缓存
 };
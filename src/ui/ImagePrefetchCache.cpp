@@ -0,0 +1,197 @@
+#include "ImagePrefetchCache.h"
+#include <QDebug>
+#include <QImageReader>
+#include <QRunnable>
+#include <QThread>
+#include <functional>
+
+namespace {
+
+enum TaskState { Queued, Started, Cancelled };
+
+// 后台解码任务
+class ImageDecodeTask : public QRunnable {
+public:
+    ImageDecodeTask(const QString &filePath, const QSize &targetSize,
+                    std::shared_ptr<std::atomic<int>> state,
+                    std::function<void(const QString &, const QImage &)> done)
+        : m_filePath(filePath),
+          m_targetSize(targetSize),
+          m_state(std::move(state)),
+          m_done(std::move(done)) {}
+
+    void run() override {
+        // 已被取消的任务不再解码；标记开始后取消不再影响该任务
+        int expected = Queued;
+        if (!m_state->compare_exchange_strong(expected, Started)) {
+            return;
+        }
+
+        QImageReader reader(m_filePath);
+        reader.setAutoTransform(true);
+
+        // 按显示尺寸缩小解码，避免缓存整张原图
+        QSize size = reader.size();
+        if (size.isValid() && m_targetSize.isValid() &&
+            (size.width() > m_targetSize.width() || size.height() > m_targetSize.height())) {
+            reader.setScaledSize(size.scaled(m_targetSize, Qt::KeepAspectRatio));
+        }
+
+        QImage image = reader.read();
+        if (image.isNull()) {
+            qDebug() << "图片解码失败:" << m_filePath << reader.errorString();
+        } else if (image.format() != QImage::Format_ARGB32_Premultiplied &&
+                   image.format() != QImage::Format_RGB32) {
+            // 转换为QPixmap可直接使用的格式，减少GUI线程的转换开销
+            image = image.convertToFormat(image.hasAlphaChannel()
+                                              ? QImage::Format_ARGB32_Premultiplied
+                                              : QImage::Format_RGB32);
+        }
+
+        m_done(m_filePath, image);
+    }
+
+private:
+    QString m_filePath;
+    QSize m_targetSize;
+    std::shared_ptr<std::atomic<int>> m_state;
+    std::function<void(const QString &, const QImage &)> m_done;
+};
+
+}  // namespace
+
+ImagePrefetchCache::ImagePrefetchCache(QObject *parent) : QObject(parent) {
+    // 解码任务不应占满所有核心，留给播放线程
+    m_pool.setMaxThreadCount(qMax(1, QThread::idealThreadCount() / 2));
+}
+
+ImagePrefetchCache::~ImagePrefetchCache() {
+    m_pool.clear();
+    m_pool.waitForDone();
+}
+
+void ImagePrefetchCache::setMemoryLimit(qint64 bytes) {
+    m_memoryLimit = qMax<qint64>(bytes, 0);
+    evict();
+}
+
+QPixmap ImagePrefetchCache::pixmap(const QString &filePath) {
+    auto it = m_entries.find(filePath);
+    if (it == m_entries.end()) {
+        return QPixmap();
+    }
+    touch(*it, filePath);
+    return it->pixmap;
+}
+
+void ImagePrefetchCache::request(const QString &filePath, int priority) {
+    auto it = m_entries.find(filePath);
+    if (it != m_entries.end()) {
+        // 预取窗口内的图片保持为最近使用
+        touch(*it, filePath);
+        return;
+    }
+    if (m_pending.contains(filePath)) {
+        return;
+    }
+    auto state = std::make_shared<std::atomic<int>>(Queued);
+    m_pending.insert(filePath, state);
+
+    // 析构时会等待线程池结束，任务运行期间this始终有效
+    auto done = [this, state](const QString &path, const QImage &image) {
+        // 回到GUI线程插入缓存（QPixmap只能在GUI线程创建）
+        QMetaObject::invokeMethod(
+            this, [this, path, image, state]() { onDecoded(path, image, state); },
+            Qt::QueuedConnection);
+    };
+
+    m_pool.start(new ImageDecodeTask(filePath, m_targetSize, state, std::move(done)), priority);
+}
+
+void ImagePrefetchCache::setPinned(const QString &filePath) {
+    m_pinned = filePath;
+    auto it = m_entries.find(filePath);
+    if (it != m_entries.end()) {
+        touch(*it, filePath);
+    }
+}
+
+void ImagePrefetchCache::cancelPending() {
+    // 只移除取消成功（尚未开始）的任务，正在解码的保留在m_pending中，避免重复请求
+    for (auto it = m_pending.begin(); it != m_pending.end();) {
+        int expected = Queued;
+        if (it.value()->compare_exchange_strong(expected, Cancelled)) {
+            it = m_pending.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    m_pool.clear();
+}
+
+void ImagePrefetchCache::clear() {
+    // 正在运行的任务与m_pending脱离，完成时按过期结果丢弃
+    cancelPending();
+    m_pending.clear();
+    m_entries.clear();
+    m_lru.clear();
+    m_memoryUsage = 0;
+}
+
+void ImagePrefetchCache::onDecoded(const QString &filePath, const QImage &image,
+                                   const TaskStatePtr &state) {
+    // clear()之前发起的任务
+    if (m_pending.value(filePath) != state) {
+        return;
+    }
+    m_pending.remove(filePath);
+
+    if (image.isNull()) {
+        emit imageFailed(filePath);
+        return;
+    }
+
+    if (m_entries.contains(filePath)) {
+        emit imageReady(filePath);
+        return;
+    }
+
+    Entry entry;
+    entry.pixmap = QPixmap::fromImage(image);
+    entry.cost = qint64(image.sizeInBytes());
+    m_lru.push_front(filePath);
+    entry.lruPos = m_lru.begin();
+
+    m_memoryUsage += entry.cost;
+    m_entries.insert(filePath, entry);
+
+    evict();
+
+    if (m_entries.contains(filePath)) {
+        emit imageReady(filePath);
+    }
+}
+
+void ImagePrefetchCache::touch(Entry &entry, const QString &filePath) {
+    m_lru.erase(entry.lruPos);
+    m_lru.push_front(filePath);
+    entry.lruPos = m_lru.begin();
+}
+
+void ImagePrefetchCache::evict() {
+    // 从最久未使用的一端淘汰，跳过当前显示的图片
+    auto it = m_lru.end();
+    while (m_memoryUsage > m_memoryLimit && it != m_lru.begin()) {
+        --it;
+        if (*it == m_pinned) {
+            continue;
+        }
+
+        auto entry = m_entries.find(*it);
+        if (entry != m_entries.end()) {
+            m_memoryUsage -= entry->cost;
+            m_entries.erase(entry);
+        }
+        it = m_lru.erase(it);
+    }
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <QHash>
+#include <QObject>
+#include <QPixmap>
+#include <QSize>
+#include <QString>
+#include <QThreadPool>
+#include <atomic>
+#include <list>
+#include <memory>
+
+// 图片预取缓存
+// 后台线程池解码图片（按显示尺寸缩放），GUI线程转换为QPixmap后放入LRU缓存，
+// 缓存总字节数不超过设定上限
+class ImagePrefetchCache : public QObject {
+    Q_OBJECT
+
+public:
+    explicit ImagePrefetchCache(QObject *parent = nullptr);
+    ~ImagePrefetchCache() override;
+
+    // 缓存内存上限（字节）
+    void setMemoryLimit(qint64 bytes);
+    qint64 memoryLimit() const { return m_memoryLimit; }
+    qint64 memoryUsage() const { return m_memoryUsage; }
+
+    // 解码目标尺寸，超过该尺寸的图片在解码时缩小
+    void setTargetSize(const QSize &size) { m_targetSize = size; }
+
+    // 查询缓存，命中时刷新LRU位置
+    bool contains(const QString &filePath) const { return m_entries.contains(filePath); }
+    QPixmap pixmap(const QString &filePath);
+
+    // 请求后台解码，priority越大越先解码
+    void request(const QString &filePath, int priority = 0);
+
+    // 当前显示的图片不会被淘汰
+    void setPinned(const QString &filePath);
+
+    // 丢弃尚未开始的解码任务，已在运行的任务继续完成，结果仍进入缓存
+    void cancelPending();
+
+    // 清空缓存；正在运行的任务的结果视为过期，不再放入缓存
+    void clear();
+
+signals:
+    void imageReady(const QString &filePath);
+    void imageFailed(const QString &filePath);
+
+private:
+    struct Entry {
+        QPixmap pixmap;
+        qint64 cost{0};
+        std::list<QString>::iterator lruPos;
+    };
+
+    // 解码任务的状态（排队/开始/取消），由GUI线程（取消）和工作线程（开始）竞争修改
+    using TaskStatePtr = std::shared_ptr<std::atomic<int>>;
+
+    void onDecoded(const QString &filePath, const QImage &image, const TaskStatePtr &state);
+    void touch(Entry &entry, const QString &filePath);
+    void evict();
+
+    QThreadPool m_pool;
+    QHash<QString, Entry> m_entries;
+    std::list<QString> m_lru;  // 头部为最近使用
+    QHash<QString, TaskStatePtr> m_pending;  // 已排队或正在解码的任务
+    QString m_pinned;
+
+    QSize m_targetSize;
+    qint64 m_memoryLimit{256 * 1024 * 1024};  // 默认256MB
+    qint64 m_memoryUsage{0};
+};
@@ -1,6 +1,149 @@
 #include "ui/ImageWidget.h"
+#include "ImagePrefetchCache.h"
 #include "QLabelImageWidget.h"
+#include <QCollator>
+#include <QDir>
+#include <QFileInfo>
+#include <QGuiApplication>
+#include <QImageReader>
+#include <QKeyEvent>
+#include <QScreen>
+#include <algorithm>
+#include <climits>
 
 ImageWidget* ImageWidget::createImageWidget(QWidget* parent) {
     return new QLabelImageWidget(parent);
-}
\ No newline at end of file
+}
+
+ImageWidget::ImageWidget(QWidget *parent) : QWidget(parent) {
+    setFocusPolicy(Qt::StrongFocus);
+
+    m_cache = new ImagePrefetchCache(this);
+    if (QScreen *screen = QGuiApplication::primaryScreen()) {
+        // 解码到屏幕分辨率即可，超出部分不会被显示
+        m_cache->setTargetSize(screen->size() * screen->devicePixelRatio());
+    }
+    QObject::connect(m_cache, &ImagePrefetchCache::imageReady, this,
+                     [this](const QString &filePath) { onImageReady(filePath); });
+    QObject::connect(m_cache, &ImagePrefetchCache::imageFailed, this,
+                     [this](const QString &filePath) { onImageFailed(filePath); });
+}
+
+void ImageWidget::loadImage(const QString &filePath) {
+    scanFolder(filePath);
+
+    int index = m_files.indexOf(QFileInfo(filePath).absoluteFilePath());
+    if (index < 0) {
+        // 扩展名不在支持列表中，只显示该文件
+        m_files = QStringList{QFileInfo(filePath).absoluteFilePath()};
+        index = 0;
+    }
+    showImageAt(index);
+}
+
+void ImageWidget::showNextImage() {
+    if (m_currentIndex + 1 < m_files.size()) {
+        showImageAt(m_currentIndex + 1);
+    }
+}
+
+void ImageWidget::showPreviousImage() {
+    if (m_currentIndex > 0) {
+        showImageAt(m_currentIndex - 1);
+    }
+}
+
+QString ImageWidget::currentImage() const {
+    return (m_currentIndex >= 0 && m_currentIndex < m_files.size()) ? m_files[m_currentIndex]
+                                                                    : QString();
+}
+
+void ImageWidget::setCacheMemoryLimit(qint64 bytes) { m_cache->setMemoryLimit(bytes); }
+
+void ImageWidget::keyPressEvent(QKeyEvent *event) {
+    switch (event->key()) {
+    case Qt::Key_Right:
+    case Qt::Key_PageDown:
+    case Qt::Key_Space: showNextImage(); return;
+    case Qt::Key_Left:
+    case Qt::Key_PageUp:
+    case Qt::Key_Backspace: showPreviousImage(); return;
+    case Qt::Key_Home:
+        if (!m_files.isEmpty()) showImageAt(0);
+        return;
+    case Qt::Key_End:
+        if (!m_files.isEmpty()) showImageAt(m_files.size() - 1);
+        return;
+    default: break;
+    }
+    QWidget::keyPressEvent(event);
+}
+
+void ImageWidget::scanFolder(const QString &filePath) {
+    QStringList nameFilters;
+    for (const QByteArray &format : QImageReader::supportedImageFormats()) {
+        nameFilters << QString("*.%1").arg(QString::fromLatin1(format));
+    }
+
+    QDir dir = QFileInfo(filePath).absoluteDir();
+    QStringList names = dir.entryList(nameFilters, QDir::Files | QDir::Readable);
+
+    // 按自然顺序排序（img2 在 img10 之前）
+    QCollator collator;
+    collator.setNumericMode(true);
+    std::sort(names.begin(), names.end(), collator);
+
+    m_files.clear();
+    for (const QString &name : names) {
+        m_files << dir.absoluteFilePath(name);
+    }
+}
+
+void ImageWidget::showImageAt(int index) {
+    if (index < 0 || index >= m_files.size()) {
+        return;
+    }
+
+    m_currentIndex = index;
+    const QString &filePath = m_files[index];
+    m_cache->setPinned(filePath);
+
+    // 未命中时保持上一张图片，解码完成后由onImageReady显示，失败时由onImageFailed提示
+    if (m_cache->contains(filePath)) {
+        setPixmap(m_cache->pixmap(filePath));
+    }
+    setWindowFilePath(filePath);
+
+    prefetchNeighbors();
+}
+
+void ImageWidget::prefetchNeighbors() {
+    // 旧窗口内尚未开始的任务已无意义
+    m_cache->cancelPending();
+
+    const QString &current = m_files[m_currentIndex];
+    if (!m_cache->contains(current)) {
+        m_cache->request(current, INT_MAX);
+    }
+
+    // 由近及远预取，前进方向优先
+    for (int distance = 1; distance <= m_prefetchRadius; ++distance) {
+        int priority = m_prefetchRadius - distance;
+        int next = m_currentIndex + distance;
+        int previous = m_currentIndex - distance;
+        if (next < m_files.size()) m_cache->request(m_files[next], priority * 2 + 1);
+        if (previous >= 0) m_cache->request(m_files[previous], priority * 2);
+    }
+}
+
+void ImageWidget::onImageReady(const QString &filePath) {
+    if (filePath == currentImage()) {
+        setPixmap(m_cache->pixmap(filePath));
+    }
+}
+
+void ImageWidget::onImageFailed(const QString &filePath) {
+    if (filePath == currentImage()) {
+        showError(QString("无法加载图片: %1").arg(QFileInfo(filePath).fileName()));
+    }
+}
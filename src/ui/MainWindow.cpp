@@ -1,13 +1,17 @@
 #include "ui/MainWindow.h"
 
+#include "core/Trace.h"
+#include "media/AdaptiveManifest.h"
 #include "media/FFmpegMediaDetector.h"
 #include "ui/ImageWidget.h"
 #include "ui/VideoWidget.h"
 #include <QApplication>
 #include <QFileDialog>
+#include <QInputDialog>
 #include <QLabel>
 #include <QMenuBar>
 #include <QStatusBar>
+#include <QUrl>
 #include <QVBoxLayout>
 
 MainWindow::MainWindow(QWidget *parent)
@@ -26,6 +30,7 @@ void MainWindow::setupUI() {
     m_centralWidget = new QTabWidget(this);
     m_centralWidget->setTabsClosable(true);
     connect(m_centralWidget, &QTabWidget::tabCloseRequested, this, &MainWindow::closeTab);
+    connect(m_centralWidget, &QTabWidget::currentChanged, this, &MainWindow::onCurrentTabChanged);
     setCentralWidget(m_centralWidget);
 
     // 创建菜单栏
@@ -42,31 +47,129 @@ void MainWindow::setupMenus() {
     openAction->setShortcut(QKeySequence::Open);
     connect(openAction, &QAction::triggered, this, [this]() { openFile(); });
 
+    QAction *openUrlAction = fileMenu->addAction("打开网络地址(&U)...");
+    openUrlAction->setShortcut(QKeySequence("Ctrl+U"));
+    connect(openUrlAction, &QAction::triggered, this, [this]() { openUrl(); });
+
     fileMenu->addSeparator();
 
     QAction *exitAction = fileMenu->addAction("退出(&X)");
     exitAction->setShortcut(QKeySequence::Quit);
     connect(exitAction, &QAction::triggered, this, &QWidget::close);
 
+    // 播放速度作用于当前标签页，切换标签页时显示该页的速度
+    auto playMenu = menuBar()->addMenu("播放(&P)");
+    auto speedMenu = playMenu->addMenu("播放速度(&S)");
+    m_speedGroup = new QActionGroup(this);
+    for (double rate : {0.5, 0.75, 1.0, 1.25, 1.5, 2.0, 3.0}) {
+        QAction *action = speedMenu->addAction(QString("%1x").arg(rate));
+        action->setCheckable(true);
+        action->setChecked(rate == 1.0);
+        action->setData(rate);
+        m_speedGroup->addAction(action);
+        connect(action, &QAction::triggered, this, [this, rate]() { setPlaybackRate(rate); });
+    }
+
+    // 快进/快退：同方向重复按下时倍速加倍
+    playMenu->addSeparator();
+    QAction *forwardAction = playMenu->addAction("快进(&F)");
+    forwardAction->setShortcut(QKeySequence("Ctrl+Right"));
+    connect(forwardAction, &QAction::triggered, this, [this]() { stepTrickPlay(1); });
+
+    QAction *rewindAction = playMenu->addAction("快退(&R)");
+    rewindAction->setShortcut(QKeySequence("Ctrl+Left"));
+    connect(rewindAction, &QAction::triggered, this, [this]() { stepTrickPlay(-1); });
+
+    QAction *reverseAction = playMenu->addAction("倒放(&B)");
+    reverseAction->setShortcut(QKeySequence("Ctrl+Up"));
+    connect(reverseAction, &QAction::triggered, this, [this]() {
+        if (auto videoWidget = qobject_cast<VideoWidget *>(m_centralWidget->currentWidget())) {
+            videoWidget->setReversePlayback(!videoWidget->isReversePlayback());
+        }
+    });
+
+    QAction *normalAction = playMenu->addAction("恢复正常播放(&N)");
+    normalAction->setShortcut(QKeySequence("Ctrl+Down"));
+    connect(normalAction, &QAction::triggered, this, [this]() { stepTrickPlay(0); });
+
+    // 逐帧：暂停后按帧前进/后退，最近显示过的帧从缓存中取
+    playMenu->addSeparator();
+    QAction *nextFrameAction = playMenu->addAction("下一帧");
+    nextFrameAction->setShortcut(QKeySequence("."));
+    connect(nextFrameAction, &QAction::triggered, this, [this]() { stepFrame(1); });
+
+    QAction *previousFrameAction = playMenu->addAction("上一帧");
+    previousFrameAction->setShortcut(QKeySequence(","));
+    connect(previousFrameAction, &QAction::triggered, this, [this]() { stepFrame(-1); });
+
+    // A-B循环：依次设置A点、B点，再按一次取消
+    QAction *abLoopAction = playMenu->addAction("A-B循环(&L)");
+    abLoopAction->setShortcut(QKeySequence("Ctrl+L"));
+    connect(abLoopAction, &QAction::triggered, this, [this]() { cycleABLoop(); });
+
+    // 轨道选择：多语言音轨、多角度视频和字幕，切换后从当前位置继续
+    playMenu->addSeparator();
+    const std::pair<const char *, AVMediaType> trackMenus[] = {
+        {"音轨(&A)", AVMEDIA_TYPE_AUDIO},
+        {"视频轨(&V)", AVMEDIA_TYPE_VIDEO},
+        {"字幕(&T)", AVMEDIA_TYPE_SUBTITLE},
+    };
+    for (const auto &[title, type] : trackMenus) {
+        QMenu *trackMenu = playMenu->addMenu(title);
+        connect(trackMenu, &QMenu::aboutToShow, this,
+                [this, trackMenu, type = type]() { updateTrackMenu(trackMenu, type); });
+    }
+
+    // 性能跟踪：记录解码/渲染/音频各线程的耗时，导出后用chrome://tracing查看
+    auto debugMenu = menuBar()->addMenu("调试(&D)");
+    QAction *traceAction = debugMenu->addAction("记录性能跟踪(&T)");
+    traceAction->setCheckable(true);
+    traceAction->setChecked(Trace::isEnabled());
+    connect(traceAction, &QAction::toggled, this,
+            [](bool checked) { Trace::setEnabled(checked); });
+
+    QAction *exportTraceAction = debugMenu->addAction("导出性能跟踪(&E)...");
+    connect(exportTraceAction, &QAction::triggered, this, [this]() { exportTrace(); });
+
     auto helpMenu = menuBar()->addMenu("帮助(&H)");
     QAction *aboutAction = helpMenu->addAction("关于(&A)");
     connect(aboutAction, &QAction::triggered, this, [this]() { showAbout(); });
 }
 
 void MainWindow::openFile() {
-    QString fileName = QFileDialog::getOpenFileName(
+    QStringList fileNames = QFileDialog::getOpenFileNames(
         this, "打开媒体文件", "",
-        "所有支持的文件 (*.mp4 *.avi *.mkv *.mov *.mp3 *.wav *.jpg *.png *.bmp);;所有文件 (*.*)");
+        "所有支持的文件 (*.mp4 *.avi *.mkv *.mov *.mp3 *.wav *.flac *.m4a *.ogg *.opus *.jpg "
+        "*.png *.apng *.bmp *.gif *.webp *.m3u8 *.mpd);;所有文件 (*.*)");
+
+    // 选择多个文件时，其中的音视频文件作为播放列表在同一标签页中连续播放
+    if (fileNames.size() > 1) {
+        openPlaylist(fileNames);
+        return;
+    }
 
+    QString fileName = fileNames.value(0);
     if (!fileName.isEmpty()) {
         auto fileBaseName = QFileInfo(fileName).baseName();
-        auto fileType = FFmpegMediaDetector::detectMediaType(fileName);
-        if (fileType == MediaType::Image) {
+        // 自适应流清单由VideoWidget自行解析
+        auto fileType = AdaptiveManifest::isManifestUrl(fileName)
+                            ? MediaType::Video
+                            : FFmpegMediaDetector::detectMediaType(fileName);
+        if (fileType == MediaType::Image && FFmpegMediaDetector::isAnimatedImage(fileName)) {
+            // 动图走视频管线循环播放
+            auto widget = VideoWidget::createVideoWidget(nullptr);
+            widget->setLoopPlayback(true);
+            widget->loadVideo(fileName);
+            widget->togglePlayback();
+            auto index = m_centralWidget->addTab((QWidget *)widget, fileBaseName);
+            m_centralWidget->setCurrentIndex(index);
+        } else if (fileType == MediaType::Image) {
             auto widget = ImageWidget::createImageWidget(nullptr);
             widget->loadImage(fileName);
             auto index = m_centralWidget->addTab((QWidget *)widget, fileBaseName);
             m_centralWidget->setCurrentIndex(index);
-        } else if (fileType == MediaType::Video) {
+        } else if (fileType == MediaType::Video || fileType == MediaType::Audio) {
+            // 纯音频文件同样走视频管线播放，画面区域显示波形
             auto widget = VideoWidget::createVideoWidget(nullptr);
             widget->loadVideo(fileName);
             auto index = m_centralWidget->addTab((QWidget *)widget, fileBaseName);
@@ -76,6 +179,60 @@ void MainWindow::openFile() {
     }
 }
 
+void MainWindow::openUrl() {
+    bool ok = false;
+    QString url = QInputDialog::getText(this, "打开网络地址", "地址 (http://, https://, ...):",
+                                        QLineEdit::Normal, QString(), &ok)
+                      .trimmed();
+    if (!ok || url.isEmpty()) {
+        return;
+    }
+
+    // 网络地址不做类型探测，直接交给视频管线（纯音频流同样可以播放）
+    auto widget = VideoWidget::createVideoWidget(nullptr);
+    widget->loadVideo(url);
+    QString title = QUrl(url).fileName();
+    auto index = m_centralWidget->addTab((QWidget *)widget, title.isEmpty() ? url : title);
+    m_centralWidget->setCurrentIndex(index);
+    statusBar()->showMessage(QString("打开网络地址: %1").arg(url));
+}
+
+void MainWindow::openPlaylist(const QStringList &fileNames) {
+    QStringList mediaFiles;
+    for (const QString &fileName : fileNames) {
+        // 自适应流清单由VideoWidget自行解析
+        auto fileType = AdaptiveManifest::isManifestUrl(fileName)
+                            ? MediaType::Video
+                            : FFmpegMediaDetector::detectMediaType(fileName);
+        if (fileType == MediaType::Video || fileType == MediaType::Audio) {
+            mediaFiles << fileName;
+        }
+    }
+    if (mediaFiles.isEmpty()) {
+        statusBar()->showMessage("所选文件中没有可播放的音视频文件", 2000);
+        return;
+    }
+
+    auto widget = VideoWidget::createVideoWidget(nullptr);
+    widget->loadPlaylist(mediaFiles);
+    auto title = QString("播放列表 (%1)").arg(mediaFiles.size());
+    auto index = m_centralWidget->addTab((QWidget *)widget, title);
+    m_centralWidget->setCurrentIndex(index);
+    statusBar()->showMessage(QString("打开播放列表: %1 个文件").arg(mediaFiles.size()));
+}
+
+void MainWindow::exportTrace() {
+    QString fileName = QFileDialog::getSaveFileName(this, "导出性能跟踪", "trace.json",
+                                                    "Chrome Trace (*.json)");
+    if (fileName.isEmpty()) return;
+
+    if (Trace::writeChromeTrace(fileName)) {
+        statusBar()->showMessage(QString("性能跟踪已导出: %1").arg(fileName), 3000);
+    } else {
+        statusBar()->showMessage("导出性能跟踪失败", 3000);
+    }
+}
+
 void MainWindow::showAbout() {
     QMessageBox::about(this, "关于",
                        "多媒体播放器 v1.0\n\n"
@@ -108,6 +265,111 @@ void MainWindow::closeTab(int index) {
     statusBar()->showMessage(QString("已关闭: %1").arg(tabText), 2000);
 }
 
+void MainWindow::onCurrentTabChanged(int index) {
+    // 只有当前标签页保持解码，其余标签页挂起
+    for (int i = 0; i < m_centralWidget->count(); ++i) {
+        if (auto videoWidget = qobject_cast<VideoWidget *>(m_centralWidget->widget(i))) {
+            videoWidget->setSuspended(i != index);
+        }
+    }
+
+    auto videoWidget = qobject_cast<VideoWidget *>(m_centralWidget->widget(index));
+    double rate = videoWidget ? videoWidget->playbackRate() : 1.0;
+    for (QAction *action : m_speedGroup->actions()) {
+        action->setChecked(action->data().toDouble() == rate);
+    }
+}
+
+void MainWindow::setPlaybackRate(double rate) {
+    if (auto videoWidget = qobject_cast<VideoWidget *>(m_centralWidget->currentWidget())) {
+        videoWidget->setPlaybackRate(rate);
+        statusBar()->showMessage(QString("播放速度: %1x").arg(videoWidget->playbackRate()), 2000);
+    }
+}
+
+void MainWindow::stepTrickPlay(int direction) {
+    auto videoWidget = qobject_cast<VideoWidget *>(m_centralWidget->currentWidget());
+    if (!videoWidget) return;
+
+    // 8x → 16x → 32x → 64x，换向时从8x开始
+    double speed = videoWidget->trickSpeed();
+    if (direction == 0) {
+        speed = 0.0;
+        videoWidget->setReversePlayback(false);
+    } else if (speed * direction > 0) {
+        speed = qMin(qAbs(speed) * 2, MAX_TRICK_SPEED) * direction;
+    } else {
+        speed = MIN_TRICK_SPEED * direction;
+    }
+    videoWidget->setTrickPlay(speed);
+
+    double applied = videoWidget->trickSpeed();
+    QString label = applied > 0 ? "快进" : "快退";
+    statusBar()->showMessage(
+        applied == 0.0 ? QString("正常播放") : QString("%1 %2x").arg(label).arg(qAbs(applied)),
+        2000);
+}
+
+void MainWindow::stepFrame(int direction) {
+    if (auto videoWidget = qobject_cast<VideoWidget *>(m_centralWidget->currentWidget())) {
+        videoWidget->stepFrame(direction);
+    }
+}
+
+void MainWindow::cycleABLoop() {
+    auto videoWidget = qobject_cast<VideoWidget *>(m_centralWidget->currentWidget());
+    if (!videoWidget) return;
+
+    videoWidget->cycleABLoop();
+    QString message = "已取消A-B循环";
+    if (videoWidget->hasABLoop()) {
+        message = QString("A-B循环: %1 - %2 秒")
+                      .arg(videoWidget->abLoopStart(), 0, 'f', 2)
+                      .arg(videoWidget->abLoopEnd(), 0, 'f', 2);
+    } else if (videoWidget->hasLoopStart()) {
+        message = "已设置A点，再按一次设置B点";
+    }
+    statusBar()->showMessage(message, 2000);
+}
+
+void MainWindow::updateTrackMenu(QMenu *menu, int mediaType) {
+    qDeleteAll(menu->findChildren<QActionGroup *>());
+    menu->clear();
+
+    auto videoWidget = qobject_cast<VideoWidget *>(m_centralWidget->currentWidget());
+    std::vector<TrackInfo> tracks;
+    if (videoWidget) tracks = videoWidget->tracks(AVMediaType(mediaType));
+    if (tracks.empty()) {
+        menu->addAction("（无）")->setEnabled(false);
+        return;
+    }
+
+    auto group = new QActionGroup(menu);
+    int current = videoWidget->currentTrack(AVMediaType(mediaType));
+    for (size_t i = 0; i < tracks.size(); ++i) {
+        const TrackInfo &track = tracks[i];
+        QString name = track.title.isEmpty() ? track.codec : track.title;
+        QString label = QString("%1. %2").arg(i + 1).arg(name);
+        if (!track.language.isEmpty()) label += QString(" [%1]").arg(track.language);
+
+        QAction *action = menu->addAction(label);
+        action->setCheckable(true);
+        action->setChecked(track.streamIndex == current);
+        group->addAction(action);
+        int streamIndex = track.streamIndex;
+        connect(action, &QAction::triggered, this,
+                [this, mediaType, streamIndex]() { selectTrack(mediaType, streamIndex); });
+    }
+}
+
+void MainWindow::selectTrack(int mediaType, int streamIndex) {
+    auto videoWidget = qobject_cast<VideoWidget *>(m_centralWidget->currentWidget());
+    if (!videoWidget) return;
+
+    bool switched = videoWidget->selectTrack(AVMediaType(mediaType), streamIndex);
+    statusBar()->showMessage(switched ? "已切换轨道" : "切换轨道失败", 2000);
+}
+
 void MainWindow::closeEvent(QCloseEvent *event) {
     // 保存设置等清理工作
     QMainWindow::closeEvent(event);
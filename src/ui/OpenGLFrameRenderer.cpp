@@ -1,5 +1,10 @@
 #include "OpenGLFrameRenderer.h"
+#include "core/Trace.h"
+#include "media/FFmpegStream.h"
 #include <QDebug>
+#include <QFontMetrics>
+#include <QPainter>
+#include <QPainterPath>
 #include <qopenglext.h>
 
 // 🎨 YUV到RGB的顶点着色器
@@ -73,6 +78,78 @@ void main() {
 }
 )";
 
+namespace {
+
+// 把字幕事件光栅化为一张RGBA图像（非预乘），rect/canvas返回其在画布中的位置和画布尺寸
+QImage rasterizeSubtitle(const SubtitleData &subtitle, const QSize &frameSize, QRectF *rect,
+                         QSizeF *canvas) {
+    // 位图字幕：按原坐标合成到所有位图的外接矩形
+    if (!subtitle.bitmaps.empty()) {
+        QSize size = subtitle.canvasWidth > 0 && subtitle.canvasHeight > 0
+                         ? QSize(subtitle.canvasWidth, subtitle.canvasHeight)
+                         : frameSize;
+        QRect bounds;
+        for (const SubtitleData::Bitmap &bitmap : subtitle.bitmaps) {
+            bounds |= QRect(bitmap.x, bitmap.y, bitmap.width, bitmap.height);
+        }
+        if (size.isEmpty() || bounds.isEmpty()) return QImage();
+
+        QImage image(bounds.size(), QImage::Format_RGBA8888);
+        image.fill(Qt::transparent);
+        QPainter painter(&image);
+        for (const SubtitleData::Bitmap &bitmap : subtitle.bitmaps) {
+            QImage source(reinterpret_cast<const uchar *>(bitmap.rgba.constData()), bitmap.width,
+                          bitmap.height, bitmap.width * 4, QImage::Format_RGBA8888);
+            painter.drawImage(bitmap.x - bounds.x(), bitmap.y - bounds.y(), source);
+        }
+        painter.end();
+
+        *rect = bounds;
+        *canvas = size;
+        return image;
+    }
+
+    // 文本字幕：白字黑边，底部居中，字号随画面高度缩放
+    if (frameSize.isEmpty() || subtitle.text.isEmpty()) return QImage();
+    QFont font;
+    font.setPixelSize(qMax(12, int(frameSize.height() * 0.055)));
+    font.setBold(true);
+    QFontMetrics metrics(font);
+    int outline = qMax(2, font.pixelSize() / 12);
+
+    QStringList lines = subtitle.text.split('\n');
+    int textWidth = 0;
+    for (const QString &line : lines) {
+        textWidth = qMax(textWidth, metrics.horizontalAdvance(line));
+    }
+    QPainterPath path;
+    for (int i = 0; i < lines.size(); ++i) {
+        int x = outline + (textWidth - metrics.horizontalAdvance(lines[i])) / 2;
+        int y = outline + i * metrics.lineSpacing() + metrics.ascent();
+        path.addText(x, y, font, lines[i]);
+    }
+
+    QSize imageSize(textWidth + 2 * outline,
+                    int(lines.size()) * metrics.lineSpacing() + 2 * outline);
+    QImage image(imageSize, QImage::Format_RGBA8888);
+    image.fill(Qt::transparent);
+    QPainter painter(&image);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.strokePath(path,
+                       QPen(Qt::black, outline * 2, Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin));
+    painter.fillPath(path, Qt::white);
+    painter.end();
+
+    double margin = frameSize.height() * 0.05;
+    *rect = QRectF((frameSize.width() - imageSize.width()) / 2.0,
+                   frameSize.height() - margin - imageSize.height(), imageSize.width(),
+                   imageSize.height());
+    *canvas = frameSize;
+    return image;
+}
+
+}  // namespace
+
 OpenGLFrameRenderer::OpenGLFrameRenderer(QWidget *parent)
     : QOpenGLWidget(parent),
       m_yuvShader(nullptr),
@@ -216,6 +293,8 @@ void OpenGLFrameRenderer::setupBuffers() {
 }
 
 void OpenGLFrameRenderer::renderFrame(AVFrame *frame) {
+    TRACE_SCOPE("OpenGLFrameRenderer::renderFrame", "render");
+
     if (!frame || !frame->data[0]) {
         qDebug() << "无效的帧";
         return;
@@ -239,16 +318,16 @@ void OpenGLFrameRenderer::renderFrame(AVFrame *frame) {
     case AV_PIX_FMT_RGB24:
     case AV_PIX_FMT_RGBA:
     case AV_PIX_FMT_BGRA:
-        qDebug() << "render AV_PIX_FMT_BGRA";
         m_currentShader = m_rgbShader;
         updateRGBTexture(frame);
         break;
 
     default:
-        // 转换为YUV420P
-        // qDebug() << "不支持的格式，转换为YUV420P:"
-        //          << av_get_pix_fmt_name((AVPixelFormat)frame->format);
-        // TODO: 实现格式转换
+        // 其他格式（PAL8、RGB48、YUV444等，常见于GIF/APNG）转换为RGBA
+        if (AVFrame *converted = convertToRGBA(frame)) {
+            m_currentShader = m_rgbShader;
+            updateRGBTexture(converted);
+        }
         break;
     }
 
@@ -289,10 +368,6 @@ void OpenGLFrameRenderer::updateYUVTextures(AVFrame *frame) {
 }
 
 void OpenGLFrameRenderer::updateRGBTexture(AVFrame *frame) {
-    qDebug() << "render updateRGBTexture";
-    qDebug() << "Frame size:" << frame->width << "x" << frame->height;
-    qDebug() << "Linesize:" << frame->linesize[0];
-
     if (m_textureRGB == 0) {
         glGenTextures(1, &m_textureRGB);
     }
@@ -336,7 +411,40 @@ void OpenGLFrameRenderer::updateRGBTexture(AVFrame *frame) {
     glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
 }
 
+AVFrame *OpenGLFrameRenderer::convertToRGBA(AVFrame *frame) {
+    m_swsContext = sws_getCachedContext(m_swsContext, frame->width, frame->height,
+                                        AVPixelFormat(frame->format), frame->width, frame->height,
+                                        AV_PIX_FMT_RGBA, SWS_BILINEAR, nullptr, nullptr, nullptr);
+    if (!m_swsContext) {
+        qDebug() << "无法创建格式转换上下文:"
+                 << av_get_pix_fmt_name(AVPixelFormat(frame->format));
+        return nullptr;
+    }
+
+    // 尺寸变化时重新分配转换缓冲区
+    if (!m_convertedFrame || m_convertedFrame->width != frame->width ||
+        m_convertedFrame->height != frame->height) {
+        if (m_convertedFrame) {
+            av_frame_free(&m_convertedFrame);
+        }
+        m_convertedFrame = av_frame_alloc();
+        m_convertedFrame->format = AV_PIX_FMT_RGBA;
+        m_convertedFrame->width = frame->width;
+        m_convertedFrame->height = frame->height;
+        if (av_frame_get_buffer(m_convertedFrame, 0) < 0) {
+            av_frame_free(&m_convertedFrame);
+            return nullptr;
+        }
+    }
+
+    sws_scale(m_swsContext, frame->data, frame->linesize, 0, frame->height,
+              m_convertedFrame->data, m_convertedFrame->linesize);
+    return m_convertedFrame;
+}
+
 void OpenGLFrameRenderer::paintGL() {
+    TRACE_SCOPE("OpenGLFrameRenderer::paintGL", "render");
+
     glClear(GL_COLOR_BUFFER_BIT);
 
     if (!m_hasFrame || !m_currentShader) {
@@ -374,6 +482,81 @@ void OpenGLFrameRenderer::paintGL() {
     glBindVertexArray(0);
 
     m_currentShader->release();
+
+    drawSubtitle();
+}
+
+void OpenGLFrameRenderer::setSubtitle(std::shared_ptr<const SubtitleData> subtitle) {
+    if (subtitle == m_subtitle) return;
+    m_subtitle = std::move(subtitle);
+
+    if (m_subtitle && !findSubtitleTexture(m_subtitle.get())) {
+        makeCurrent();
+        uploadSubtitle(m_subtitle);
+        doneCurrent();
+    }
+    update();
+}
+
+const OpenGLFrameRenderer::SubtitleTexture *
+OpenGLFrameRenderer::findSubtitleTexture(const SubtitleData *subtitle) const {
+    for (const SubtitleTexture &entry : m_subtitleTextures) {
+        if (entry.subtitle.get() == subtitle) return &entry;
+    }
+    return nullptr;
+}
+
+void OpenGLFrameRenderer::uploadSubtitle(const std::shared_ptr<const SubtitleData> &subtitle) {
+    TRACE_SCOPE("OpenGLFrameRenderer::uploadSubtitle", "render");
+
+    SubtitleTexture entry;
+    entry.subtitle = subtitle;
+    QImage image = rasterizeSubtitle(*subtitle, m_frameSize, &entry.rect, &entry.canvas);
+    if (image.isNull()) return;
+
+    if (m_subtitleTextures.size() >= size_t(MAX_SUBTITLE_TEXTURES)) {
+        glDeleteTextures(1, &m_subtitleTextures.front().texture);
+        m_subtitleTextures.erase(m_subtitleTextures.begin());
+    }
+
+    // RGBA每行4字节对齐，可直接上传
+    glGenTextures(1, &entry.texture);
+    glBindTexture(GL_TEXTURE_2D, entry.texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image.width(), image.height(), 0, GL_RGBA,
+                 GL_UNSIGNED_BYTE, image.constBits());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    m_subtitleTextures.push_back(std::move(entry));
+}
+
+void OpenGLFrameRenderer::drawSubtitle() {
+    if (!m_subtitle || !m_rgbShader) return;
+    const SubtitleTexture *entry = findSubtitleTexture(m_subtitle.get());
+    if (!entry) return;
+
+    // 画布坐标（左上角为原点）映射到视频四边形[-1, 1]，随画面一起缩放
+    const QRectF &rect = entry->rect;
+    const QSizeF &canvas = entry->canvas;
+    QMatrix4x4 model = m_modelMatrix;
+    model.translate(float(-1.0 + (2.0 * rect.x() + rect.width()) / canvas.width()),
+                    float(1.0 - (2.0 * rect.y() + rect.height()) / canvas.height()));
+    model.scale(float(rect.width() / canvas.width()), float(rect.height() / canvas.height()));
+
+    m_rgbShader->bind();
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, entry->texture);
+    m_rgbShader->setUniformValue("textureRGB", 0);
+    m_rgbShader->setUniformValue("model", model);
+
+    glBindVertexArray(m_VAO);
+    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+    glBindVertexArray(0);
+
+    m_rgbShader->release();
 }
 
 void OpenGLFrameRenderer::calculateTransform() {
@@ -423,6 +606,10 @@ void OpenGLFrameRenderer::cleanupGL() {
     if (m_textureU) glDeleteTextures(1, &m_textureU);
     if (m_textureV) glDeleteTextures(1, &m_textureV);
     if (m_textureRGB) glDeleteTextures(1, &m_textureRGB);
+    for (SubtitleTexture &entry : m_subtitleTextures) {
+        glDeleteTextures(1, &entry.texture);
+    }
+    m_subtitleTextures.clear();
     // if (m_VAO) glDeleteVertexArrays(1, &m_VAO);
 
     delete m_yuvShader;
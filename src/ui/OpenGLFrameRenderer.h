@@ -5,12 +5,17 @@
 #include <QOpenGLFunctions_3_3_Core>
 #include <QOpenGLShaderProgram>
 #include <QOpenGLWidget>
+#include <memory>
+#include <vector>
 
 extern "C" {
 #include <libavutil/frame.h>
+#include <libavutil/pixdesc.h>
 #include <libswscale/swscale.h>
 }
 
+struct SubtitleData;
+
 class OpenGLFrameRenderer : public QOpenGLWidget, protected QOpenGLFunctions_3_3_Core {
     Q_OBJECT
 
@@ -24,6 +29,10 @@ public:
     // 清空显示
     void clearFrame();
 
+    // 设置叠加在画面上的字幕（空表示不显示）。事件变化时才光栅化并上传纹理，
+    // 最近几个事件的纹理保留复用，之后每次重绘只多画一个混合的四边形
+    void setSubtitle(std::shared_ptr<const SubtitleData> subtitle);
+
     // 设置显示模式
     void setAspectRatioMode(Qt::AspectRatioMode mode);
     void setZoom(float factor);
@@ -50,9 +59,23 @@ private:
     void updateYUVTextures(AVFrame *frame);
     void updateRGBTexture(AVFrame *frame);
 
+    // 将不支持直接上传的像素格式转换为RGBA
+    AVFrame *convertToRGBA(AVFrame *frame);
+
     // 计算变换矩阵
     void calculateTransform();
 
+    // 字幕纹理
+    struct SubtitleTexture {
+        std::shared_ptr<const SubtitleData> subtitle;
+        GLuint texture{0};
+        QRectF rect;    // 在画布中的位置
+        QSizeF canvas;  // 画布尺寸，对应整个视频画面
+    };
+    const SubtitleTexture *findSubtitleTexture(const SubtitleData *subtitle) const;
+    void uploadSubtitle(const std::shared_ptr<const SubtitleData> &subtitle);
+    void drawSubtitle();
+
     // 清理资源
     void cleanupGL();
 
@@ -89,4 +112,9 @@ private:
     // 格式转换上下文（如果需要）
     SwsContext *m_swsContext;
     AVFrame *m_convertedFrame;
+
+    // 字幕叠加
+    std::shared_ptr<const SubtitleData> m_subtitle;
+    std::vector<SubtitleTexture> m_subtitleTextures;  // 按上传先后排列，超出上限时淘汰最早的
+    static const int MAX_SUBTITLE_TEXTURES = 4;
 };
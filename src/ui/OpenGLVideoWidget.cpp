@@ -1,12 +1,34 @@
 #include "OpenGLVideoWidget.h"
 #include "AudioPlayer.h"
 
+OpenGLVideoWidget::~OpenGLVideoWidget() {
+    if (m_lastFrame) {
+        av_frame_free(&m_lastFrame);
+    }
+}
+
 void OpenGLVideoWidget::showPreview() {
-    connect(&m_render, &OpenGLFrameRenderer::glReady,
-            [this]() { m_render.renderFrame(m_videoStream.getPreviewImage()); });
+    connect(&m_render, &OpenGLFrameRenderer::glReady, this, &OpenGLVideoWidget::renderPreview);
     m_render.show();
 }
 
+void OpenGLVideoWidget::renderPreview() {
+    // 取帧不等待解码：首帧尚未解出时稍后重试，开始播放后由updateFrame接管
+    if (isPlaying()) return;
+    AVFrame *frame = m_videoStream->getPreviewImage();
+    if (!frame) {
+        if (!m_videoStream->isVideoFinished()) {
+            QTimer::singleShot(PREVIEW_POLL_MS, this, &OpenGLVideoWidget::renderPreview);
+        }
+        return;
+    }
+    m_render.renderFrame(frame);
+    if (m_lastFrame) {
+        av_frame_free(&m_lastFrame);
+    }
+    m_lastFrame = frame;
+}
+
 void OpenGLVideoWidget::resizeEvent(QResizeEvent *event) {
     m_render.move({0, 0});
     m_render.resize(event->size().width(), event->size().height());
@@ -16,11 +38,20 @@ void OpenGLVideoWidget::resizeEvent(QResizeEvent *event) {
 void OpenGLVideoWidget::updateFrame() {
     // 只处理视频帧渲染
     double videoPts = 0.0;
-    AVFrame *videoFrame = m_videoStream.getNextVideoFrame(&videoPts);
+    AVFrame *videoFrame = m_videoStream->getNextVideoFrame(&videoPts);
     if (videoFrame) {
         m_render.renderFrame(videoFrame);
         m_currentTime = videoPts;
 
+        // 按文件中的时间戳查询字幕，事件不变时渲染器不做任何处理
+        m_render.setSubtitle(m_videoStream->subtitleAt(m_videoStream->position()));
+
+        // 保留最后一帧，替换并释放上一帧
+        if (m_lastFrame) {
+            av_frame_free(&m_lastFrame);
+        }
+        m_lastFrame = videoFrame;
+
         // 通知父组件时间更新（用于音视频同步）
         emit timeUpdated(videoPts);
     }
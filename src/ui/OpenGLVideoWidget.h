@@ -9,6 +9,7 @@ class OpenGLVideoWidget : public VideoWidget {
 
 public:
     explicit OpenGLVideoWidget(QWidget *parent = nullptr) : VideoWidget(parent), m_render(this) {}
+    ~OpenGLVideoWidget() override;
 
     void resizeEvent(QResizeEvent *event) override;
 
@@ -20,5 +21,10 @@ protected:
     void updateFrame() override;
 
 private:
+    void renderPreview();
+
     OpenGLFrameRenderer m_render{};
+    AVFrame *m_lastFrame{nullptr};  // 当前显示的帧，挂起期间保留
+
+    static constexpr int PREVIEW_POLL_MS = 10;
 };
\ No newline at end of file
@@ -10,34 +10,47 @@ public:
         m_label = new QLabel(this);
     }
 
-    void loadImage(const QString &filePath) override {
-        m_pixmap = new QPixmap(filePath);
-        m_label->setPixmap(*m_pixmap);
+    void resizeEvent(QResizeEvent *event) override {
+        layoutLabel(event->size());
+        ImageWidget::resizeEvent(event);
+    }
+
+protected:
+    void setPixmap(const QPixmap &pixmap) override {
+        m_label->setPixmap(pixmap);
         m_label->setScaledContents(true);
         m_label->show();
-        m_picRatio = (1.0 * m_pixmap->height()) / m_pixmap->width();
+        m_picRatio = pixmap.width() > 0 ? (1.0 * pixmap.height()) / pixmap.width() : 0;
+        layoutLabel(size());
     }
 
-    void resizeEvent(QResizeEvent *event) override {
+    void showError(const QString &message) override {
+        m_label->setScaledContents(false);
+        m_label->setAlignment(Qt::AlignCenter);
+        m_label->setText(message);
+        m_label->show();
+        m_picRatio = 0;
+        layoutLabel(size());
+    }
+
+private:
+    void layoutLabel(const QSize &widgetSize) {
         QPoint pos{0, 0};
-        QSize size{event->size().width(), event->size().height()};
-        if (m_pixmap != nullptr && m_picRatio != 0) {
-            auto ratio = (1.0 * event->size().height()) / event->size().width();
+        QSize size{widgetSize.width(), widgetSize.height()};
+        if (m_picRatio != 0 && widgetSize.width() > 0) {
+            auto ratio = (1.0 * widgetSize.height()) / widgetSize.width();
             if (ratio > m_picRatio) {
                 size.setHeight(size.width() * m_picRatio);
-                pos.setY((event->size().height() - size.height()) / 2);
+                pos.setY((widgetSize.height() - size.height()) / 2);
             } else {
                 size.setWidth(size.height() / m_picRatio);
-                pos.setX((event->size().width() - size.width()) / 2);
+                pos.setX((widgetSize.width() - size.width()) / 2);
             }
         }
         m_label->move(pos);
         m_label->resize(size);
-        ImageWidget::resizeEvent(event);
     }
 
-private:
     QLabel *m_label{nullptr};
-    QPixmap *m_pixmap{nullptr};
     double m_picRatio{0};
 };
\ No newline at end of file
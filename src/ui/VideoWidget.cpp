@@ -1,24 +1,568 @@
 #include "ui/VideoWidget.h"
 #include "AudioPlayer.h"
 #include "OpenGLVideoWidget.h"
+#include "WaveformWidget.h"
+#include "core/Trace.h"
+#include "media/AdaptiveSession.h"
 #include "media/FFmpegStream.h"
+#include "media/Playlist.h"
+#include "media/TimeStretcher.h"
 #include <QDebug>
+#include <QFileInfo>
+#include <cmath>
 
 VideoWidget *VideoWidget::createVideoWidget(QWidget *parent) {
     return new OpenGLVideoWidget(parent);
 }
 
+VideoWidget::~VideoWidget() { discardNext(); }
+
 void VideoWidget::loadVideo(const QString &filePath) {
-    m_videoStream.loadVideo(filePath);
-    auto fps = m_videoStream.getFps();
-    if (fps > 0) {
-        m_playTimer.setInterval(1000 / fps);
+    discardNext();
+    m_resumeSeek = false;
+    m_adaptive.reset();
+    if (AdaptiveManifest::isManifestUrl(filePath)) {
+        loadAdaptive(filePath);
+    } else {
+        m_videoStream->loadVideo(filePath);
+        m_duration = m_videoStream->getDuration();
     }
 
     // 初始化音频播放器
+    initializeLiveControl();
     initializeAudioPlayer();
+    updateTimerInterval();
+    m_videoStream->setSkipNonReference(m_rate > SKIP_NONREF_RATE);
+    m_currentTime = 0.0;
+    m_resyncPending = true;
+    m_stepped = false;
+    m_loopStart = -1.0;
 
     showPreview();
+    updateWaveform();
+}
+
+void VideoWidget::updateWaveform() {
+    bool audioOnly = !m_adaptive && m_videoStream->hasAudio() && !m_videoStream->hasVideo() &&
+                     QFileInfo(m_videoStream->filePath()).isFile();
+    if (!audioOnly) {
+        if (m_waveform) m_waveform->hide();
+        return;
+    }
+
+    if (!m_waveform) {
+        m_waveform = new WaveformWidget(this);
+        connect(m_waveform, &WaveformWidget::seekRequested, this,
+                [this](double seconds) { seekToTime(seconds); });
+    }
+    m_waveform->setGeometry(rect());
+    m_waveform->load(m_videoStream->filePath());
+    m_waveform->setPosition(m_currentTime);
+    m_waveform->show();
+    m_waveform->raise();
+}
+
+void VideoWidget::resizeEvent(QResizeEvent *event) {
+    if (m_waveform) {
+        m_waveform->setGeometry(rect());
+    }
+    QWidget::resizeEvent(event);
+}
+
+void VideoWidget::loadPlaylist(const QStringList &files) {
+    if (!m_playlist) {
+        m_playlist = new Playlist(this);
+    }
+    discardNext();
+    m_playlist->setItems(files);
+    if (!m_playlist->isEmpty()) {
+        loadVideo(m_playlist->currentItem());
+    }
+}
+
+void VideoWidget::onPlayTick() {
+    TRACE_SCOPE("VideoWidget::onPlayTick", "gui");
+
+    // 自适应流跳转中：保持上一帧，直到新的run打开
+    if (m_seekStream) return;
+
+    // 快进到结尾或快退到开头后恢复正常播放；倒放到开头后暂停在第一帧
+    if (m_videoStream->isVideoFinished()) {
+        if (m_videoStream->isTrickPlay()) {
+            setTrickPlay(0.0);
+        } else if (m_videoStream->isReversePlayback()) {
+            setReversePlayback(false);
+            if (m_isPlaying) togglePlayback();
+            return;
+        }
+    }
+
+    // 当前项的音视频帧全部取完后切换到已预加载的下一项
+    if (m_nextReady && m_videoStream->atEnd()) {
+        switchToNext();
+    }
+
+    // 定时器按两倍帧率触发，到了显示时刻才取下一帧，定时器误差不会累积
+    bool resync = m_resyncPending;
+    if (!resync && (m_videoStream->isTrickPlay() || m_videoStream->isReversePlayback())) {
+        // 快进/快退的关键帧间隔不均匀，倒放的帧时间戳递减：
+        // 按下一帧的时间戳在时钟到达时显示（快退和倒放时时钟倒退）
+        double next = 0.0;
+        if (!m_videoStream->peekVideoPts(&next)) {
+            return;
+        }
+        double wait = (next - masterClock()) / clockRate();
+        if (std::abs(wait) > RESYNC_THRESHOLD) {
+            resync = true;
+        } else if (wait > 0) {
+            return;
+        }
+    } else if (!resync && m_videoStream->hasVideo()) {
+        auto fps = m_videoStream->getFps();
+        double frameDuration = fps > 0 ? 1.0 / fps : 1.0 / 30;
+        double clock = masterClock();
+        double diff = m_currentTime + frameDuration - clock;
+        if (std::abs(diff) > RESYNC_THRESHOLD) {
+            resync = true;
+        } else if (diff > frameDuration / 2) {
+            preloadNext();
+            return;
+        } else if (diff < -frameDuration) {
+            // 画面落后于时钟超过一帧（高倍速或解码跟不上）：丢弃过期的帧，保持音画同步
+            m_videoStream->dropVideoFramesBefore(clock - frameDuration);
+        }
+    }
+
+    double presentedPts = m_currentTime;
+    updateFrame();
+    if (m_currentTime != presentedPts) {
+        if (resync) {
+            resyncClock(m_currentTime);
+            m_resyncPending = false;
+        }
+        if (m_videoStream->isLive() && m_videoStream->hasVideo()) {
+            updateLatency(m_currentTime);
+        }
+    }
+    if (m_waveform && m_waveform->isVisible()) {
+        m_waveform->setPosition(masterClock());
+    }
+    preloadNext();
+}
+
+double VideoWidget::masterClock() {
+    // 当前项的音频仍在播放时以音频为准；音频已切换到下一项或已播完时按墙上时钟推进
+    bool audioPlaying = m_audioPlayer && m_audioPlayer->hasClock() && !m_audioOnNext &&
+                        (!m_videoStream->isAudioFinished() || m_audioPlayer->hasBufferedData());
+    if (audioPlaying) {
+        double clock = m_audioPlayer->clock();
+        resyncClock(clock);
+        return clock;
+    }
+    return m_clockBase + m_clockTimer.elapsed() / 1000.0 * clockRate();
+}
+
+double VideoWidget::clockRate() const {
+    if (m_videoStream->isTrickPlay()) return m_videoStream->trickSpeed();
+    if (m_videoStream->isReversePlayback()) return -m_rate;
+    return m_rate * m_liveRate;
+}
+
+void VideoWidget::resyncClock(double pts) {
+    m_clockBase = pts;
+    m_clockTimer.restart();
+}
+
+void VideoWidget::updateTimerInterval() {
+    if (m_videoStream->isTrickPlay()) {
+        m_playTimer.setInterval(TRICK_TICK_MS);
+        return;
+    }
+    auto fps = m_videoStream->getFps();
+    double rate = m_rate * m_liveRate;
+    m_playTimer.setInterval(fps > 0 ? qMax(2, qRound(500 / (fps * rate))) : 15);
+}
+
+void VideoWidget::setPlaybackRate(double rate) {
+    if (m_videoStream->isLive()) return;
+
+    rate = qBound(TimeStretcher::MIN_RATE, rate, TimeStretcher::MAX_RATE);
+    if (rate == m_rate) return;
+
+    // 速度变化前先把墙上时钟对齐到当前位置
+    resyncClock(masterClock());
+    m_rate = rate;
+    updateTimerInterval();
+    m_videoStream->setSkipNonReference(m_rate > SKIP_NONREF_RATE);
+    if (m_nextStream) {
+        m_nextStream->setSkipNonReference(m_rate > SKIP_NONREF_RATE);
+    }
+    if (m_audioPlayer) {
+        m_audioPlayer->setTempo(m_rate);
+    }
+    qDebug() << "播放速度:" << m_rate;
+}
+
+void VideoWidget::setTrickPlay(double speed) {
+    // 直播和自适应流（每段run单独打开）不支持
+    if (m_videoStream->isLive() || m_adaptive || speed == m_videoStream->trickSpeed()) return;
+
+    bool sameDirection = speed * m_videoStream->trickSpeed() > 0;
+    double clock = masterClock();
+    m_videoStream->setTrickPlay(speed);
+    if (m_videoStream->trickSpeed() != speed) return;
+
+    if (sameDirection) {
+        // 只改变倍速：时钟从当前位置按新倍速继续
+        resyncClock(clock);
+    } else {
+        // 进入、退出或换向：流水线从当前画面位置重建，已缓冲的音频作废
+        if (m_audioPlayer) {
+            m_audioPlayer->clearBuffer();
+        }
+        m_resyncPending = true;
+    }
+    updateTimerInterval();
+}
+
+void VideoWidget::setReversePlayback(bool reverse) {
+    if (m_videoStream->isLive() || m_adaptive || reverse == m_videoStream->isReversePlayback()) {
+        return;
+    }
+
+    m_videoStream->setReversePlayback(reverse);
+    if (m_videoStream->isReversePlayback() != reverse) return;
+
+    // 流水线从当前画面位置重建，已缓冲的音频作废
+    if (m_audioPlayer) {
+        m_audioPlayer->clearBuffer();
+    }
+    m_resyncPending = true;
+    updateTimerInterval();
+}
+
+void VideoWidget::stepFrame(int direction) {
+    if (m_videoStream->isLive() || m_adaptive || !m_videoStream->hasVideo()) return;
+
+    if (m_isPlaying) togglePlayback();
+    if (m_videoStream->isTrickPlay()) setTrickPlay(0.0);
+    setReversePlayback(false);
+
+    // 上一次后退仍在等待解码时忽略
+    if (m_videoStream->isStepPending()) return;
+    if (direction < 0 && !m_videoStream->stepBackward()) {
+        // 缓存未命中：流水线已从关键帧重建，解码到当前画面后由onStepTick显示上一帧
+        if (m_videoStream->isStepPending()) {
+            m_stepped = true;
+            m_stepTimer.start();
+        }
+        return;
+    }
+    updateFrame();
+    m_stepped = true;
+}
+
+void VideoWidget::onStepTick() {
+    if (m_videoStream->pollStepBackward()) {
+        updateFrame();
+    }
+    if (!m_videoStream->isStepPending()) {
+        m_stepTimer.stop();
+    }
+}
+
+void VideoWidget::cycleABLoop() {
+    if (m_videoStream->isLive() || m_adaptive) return;
+
+    double position = m_videoStream->position();
+    if (m_videoStream->hasABLoop()) {
+        m_videoStream->clearABLoop();
+    } else if (m_loopStart < 0.0) {
+        m_loopStart = position;
+        return;
+    } else {
+        if (m_videoStream->isTrickPlay()) setTrickPlay(0.0);
+        setReversePlayback(false);
+        double start = qMin(m_loopStart, position);
+        double end = qMax(m_loopStart, position);
+        m_loopStart = -1.0;
+        if (!m_videoStream->setABLoop(start, end)) return;
+        position = start;
+    }
+
+    // 流水线已从新位置重建，时间戳不再累加循环次数
+    if (m_audioPlayer) {
+        m_audioPlayer->clearBuffer();
+    }
+    m_currentTime = position;
+    m_stepped = false;
+    m_resyncPending = true;
+}
+
+bool VideoWidget::selectTrack(AVMediaType type, int streamIndex) {
+    // 自适应流每段run单独打开，轨道随档位确定
+    if (m_adaptive || !m_videoStream->selectTrack(type, streamIndex)) return false;
+
+    if (type == AVMEDIA_TYPE_AUDIO && m_audioPlayer) {
+        // 新轨道重采样到当前设备格式，不重建音频输出
+        if (!m_audioPlayer->prepareNext(m_videoStream->getAudioCodecContext(),
+                                        m_videoStream->filePath(), streamIndex) ||
+            !m_audioPlayer->switchToPrepared()) {
+            initializeAudioPlayer();
+            if (m_audioPlayer && m_isPlaying) {
+                m_audioPlayer->start();
+            }
+        }
+        // 为播放列表下一项准备的重采样器已被替换，重新准备
+        if (m_audioPlayer && m_nextReady && m_nextStream->hasAudio()) {
+            prepareNextAudio();
+        }
+    }
+
+    // 流水线已从当前位置重建，丢弃按旧流水线送出的音频
+    if (m_audioPlayer) {
+        m_audioPlayer->clearBuffer();
+    }
+    m_stepped = false;
+    m_resyncPending = true;
+    return true;
+}
+
+void VideoWidget::preloadNext() {
+    if (m_nextStream || m_seekStream || m_videoStream->isSuspended()) return;
+    if (m_adaptive) {
+        preloadNextRun();
+        return;
+    }
+    if (!m_playlist) return;
+
+    int index = m_playlist->nextIndex();
+    if (index < 0) return;
+
+    // 探测和打开解码器耗时较长，放到后台线程，完成后回到GUI线程启动解码
+    m_nextIndex = index;
+    m_nextStream = std::make_unique<FFmpegStream>();
+    FFmpegStream *stream = m_nextStream.get();
+    QString filePath = m_playlist->items()[index];
+    int generation = ++m_preloadGeneration;
+
+    m_preloadPool.start([this, stream, filePath, generation]() {
+        bool ok = stream->open(filePath);
+        QMetaObject::invokeMethod(
+            this, [this, generation, ok]() { onNextOpened(generation, ok); },
+            Qt::QueuedConnection);
+    });
+}
+
+void VideoWidget::onNextOpened(int generation, bool ok) {
+    if (generation != m_preloadGeneration || !m_nextStream) return;
+
+    if (!ok) {
+        // 无法打开的项从列表中移除，下次定时器触发时预加载其后一项
+        qDebug() << "预加载失败，跳过:" << m_nextStream->filePath();
+        m_nextStream.reset();
+        if (m_adaptive) {
+            m_runSegment = m_nextRunSegment + 1;
+        } else {
+            m_playlist->removeAt(m_nextIndex);
+        }
+        m_nextIndex = -1;
+        return;
+    }
+
+    // 以后台优先级解码首个GOP，填满帧队列后自动挂起
+    m_nextStream->setForeground(false);
+    m_nextStream->setSkipNonReference(m_rate > SKIP_NONREF_RATE);
+    m_nextStream->start();
+    m_nextReady = true;
+
+    // 提前创建重采样器，音频衔接时无需重建设备
+    if (m_audioPlayer && m_nextStream->hasAudio()) {
+        prepareNextAudio();
+    }
+    qDebug() << "下一项已预加载:" << m_nextStream->filePath();
+}
+
+void VideoWidget::prepareNextAudio() {
+    m_audioPlayer->prepareNext(m_nextStream->getAudioCodecContext(), m_nextStream->filePath(),
+                               m_nextStream->currentTrack(AVMEDIA_TYPE_AUDIO));
+}
+
+void VideoWidget::switchToNext() {
+    bool audioSwitched = m_audioOnNext;
+
+    m_videoStream = std::move(m_nextStream);
+    m_videoStream->setForeground(true);
+    if (m_isPlaying) {
+        m_videoStream->play();
+    }
+    if (m_adaptive) {
+        // 分片时间戳是连续的，时长与当前时间沿用整个节目的
+        m_runRendition = m_nextRunRendition;
+        m_runSegment = m_nextRunSegment;
+    } else {
+        m_playlist->setCurrentIndex(m_nextIndex);
+        m_currentTime = 0.0;
+        m_duration = m_videoStream->getDuration();
+    }
+    m_nextIndex = -1;
+    m_nextReady = false;
+    m_audioOnNext = false;
+    m_resyncPending = true;
+    updateTimerInterval();
+    updateWaveform();
+
+    // 音频尚未切换（下一项预加载晚于当前项音频结束，或当前项没有音频）
+    if (!audioSwitched && m_videoStream->hasAudio()) {
+        if (!m_audioPlayer || !m_audioPlayer->switchToPrepared()) {
+            initializeAudioPlayer();
+            if (m_audioPlayer && m_isPlaying) {
+                m_audioPlayer->start();
+            }
+        }
+    }
+    qDebug() << "切换到播放列表下一项:" << m_videoStream->filePath();
+}
+
+void VideoWidget::loadAdaptive(const QString &url) {
+    QString error;
+    m_adaptive = AdaptiveSession::open(url, &error);
+    if (!m_adaptive) {
+        qDebug() << "打开自适应流失败:" << url << error;
+        return;
+    }
+
+    m_runSegment = 0;
+    m_runRendition = m_adaptive->restartAt(0);
+    if (openAdaptiveRun(m_videoStream.get(), m_runRendition, 0)) {
+        m_videoStream->start();
+    }
+    m_duration = m_adaptive->duration();
+}
+
+bool VideoWidget::openAdaptiveRun(FFmpegStream *stream, int rendition, int segment) {
+    return stream->open(m_adaptive->runName(rendition, segment),
+                        m_adaptive->createIO(rendition, segment));
+}
+
+void VideoWidget::preloadNextRun() {
+    // 码率控制已为后续分片选定了其他档位时，提前打开从该分片开始的run
+    int rendition = 0;
+    int segment = 0;
+    if (!m_adaptive->findSwitch(m_runRendition, m_runSegment, &rendition, &segment)) return;
+
+    m_nextRunRendition = rendition;
+    m_nextRunSegment = segment;
+    m_nextStream = std::make_unique<FFmpegStream>();
+    FFmpegStream *stream = m_nextStream.get();
+    int generation = ++m_preloadGeneration;
+
+    m_preloadPool.start([this, stream, rendition, segment, generation]() {
+        bool ok = openAdaptiveRun(stream, rendition, segment);
+        QMetaObject::invokeMethod(
+            this, [this, generation, ok]() { onNextOpened(generation, ok); },
+            Qt::QueuedConnection);
+    });
+}
+
+void VideoWidget::openSeekRun() {
+    m_seekSegment = m_adaptive->segmentAt(m_seekTarget);
+    m_seekRendition = m_adaptive->restartAt(m_seekSegment);
+    m_seekStream = std::make_unique<FFmpegStream>();
+    FFmpegStream *stream = m_seekStream.get();
+    int rendition = m_seekRendition;
+    int segment = m_seekSegment;
+    // 尚未完成的预加载随之作废，其任务在同一线程中先于本任务结束
+    int generation = ++m_preloadGeneration;
+
+    m_preloadPool.start([this, stream, rendition, segment, generation]() {
+        bool ok = openAdaptiveRun(stream, rendition, segment);
+        QMetaObject::invokeMethod(
+            this, [this, generation, ok]() { onSeekOpened(generation, ok); },
+            Qt::QueuedConnection);
+    });
+}
+
+void VideoWidget::onSeekOpened(int generation, bool ok) {
+    if (generation != m_preloadGeneration || !m_seekStream) return;
+
+    std::unique_ptr<FFmpegStream> stream = std::move(m_seekStream);
+    if (m_adaptive->segmentAt(m_seekTarget) != m_seekSegment) {
+        openSeekRun();
+        return;
+    }
+    if (!ok) {
+        qDebug() << "自适应流跳转失败:" << m_seekTarget << "秒";
+        return;
+    }
+
+    // 预加载线程此时空闲，丢弃旧run的预加载不会阻塞
+    discardNext();
+    m_videoStream = std::move(stream);
+    m_runRendition = m_seekRendition;
+    m_runSegment = m_seekSegment;
+    m_videoStream->start();
+    if (m_isPlaying) {
+        m_videoStream->play();
+    }
+    m_resyncPending = true;
+    if (m_audioPlayer) {
+        m_audioPlayer->clearBuffer();
+    }
+}
+
+void VideoWidget::discardNext() {
+    m_preloadPool.waitForDone();
+    ++m_preloadGeneration;
+    m_nextStream.reset();
+    m_seekStream.reset();
+    m_nextIndex = -1;
+    m_nextReady = false;
+    m_audioOnNext = false;
+    if (m_audioPlayer) {
+        m_audioPlayer->cancelPrepared();
+    }
+}
+
+void VideoWidget::initializeLiveControl() {
+    m_liveRate = 1.0;
+    if (!m_videoStream->isLive()) return;
+    m_rate = 1.0;
+
+    // PLAYER_LIVE_LATENCY：目标延迟（秒）；
+    // PLAYER_LIVE_CLOCK=sender：推流端按墙上时钟打时间戳（如LiveSender），测量端到端延迟
+    bool ok = false;
+    double target = qEnvironmentVariable("PLAYER_LIVE_LATENCY").toDouble(&ok);
+    m_latency = LatencyController(ok && target > 0 ? target : LatencyController::DEFAULT_TARGET);
+    m_senderClock = qEnvironmentVariable("PLAYER_LIVE_CLOCK") == "sender";
+    qDebug() << "直播模式，目标延迟" << m_latency.target() << "秒"
+             << (m_senderClock ? "（端到端）" : "（缓冲）");
+}
+
+void VideoWidget::updateLatency(double presentedPts) {
+    double latency = m_senderClock ? LatencyController::senderClockLatency(presentedPts)
+                                   : m_videoStream->liveEdgePts() - presentedPts;
+    LatencyController::Decision decision = m_latency.update(latency);
+
+    if (decision.dropToLive) {
+        // 只保留目标延迟以内的帧；已送入音频设备的数据同样作废
+        int dropped = m_videoStream->dropFramesBefore(m_videoStream->liveEdgePts() -
+                                                      m_latency.target());
+        if (m_audioPlayer) {
+            m_audioPlayer->clearBuffer();
+        }
+        m_resyncPending = true;
+        qDebug() << "直播延迟" << latency << "秒，丢弃" << dropped << "帧追到直播点";
+    }
+
+    if (decision.rate != m_liveRate) {
+        resyncClock(masterClock());
+        m_liveRate = decision.rate;
+        updateTimerInterval();
+        if (m_audioPlayer) {
+            m_audioPlayer->setPlaybackRate(m_liveRate);
+        }
+    }
 }
 
 void VideoWidget::initializeAudioPlayer() {
@@ -30,13 +574,13 @@ void VideoWidget::initializeAudioPlayer() {
     }
 
     // 检查是否有音频流
-    if (!m_videoStream.hasAudio()) {
+    if (!m_videoStream->hasAudio()) {
         qDebug() << "视频文件不包含音频流";
         return;
     }
 
     // 获取音频编解码器上下文
-    AVCodecContext *audioCodecContext = m_videoStream.getAudioCodecContext();
+    AVCodecContext *audioCodecContext = m_videoStream->getAudioCodecContext();
     if (!audioCodecContext) {
         qDebug() << "无法获取音频编解码器上下文";
         return;
@@ -45,6 +589,9 @@ void VideoWidget::initializeAudioPlayer() {
     // 创建并初始化音频播放器
     m_audioPlayer = new AudioPlayer(this);
     if (m_audioPlayer->initialize(audioCodecContext)) {
+        m_audioPlayer->setTempo(m_rate);
+        m_audioPlayer->setSource(m_videoStream->filePath(),
+                                 m_videoStream->currentTrack(AVMEDIA_TYPE_AUDIO));
         qDebug() << "音频播放器初始化完成";
     } else {
         qDebug() << "音频播放器初始化失败";
@@ -54,13 +601,23 @@ void VideoWidget::initializeAudioPlayer() {
 }
 
 void VideoWidget::play() {
-    // 启动视频定时器 (通常25-30fps)
-    m_playTimer.start(33);  // ~30fps
+    // 逐帧后从当前画面位置重新解码音频，逐帧缓存随之释放；
+    // 后退仍在等待解码时流水线停在关键帧处，同样需要回到当前画面
+    if (m_stepped) {
+        m_stepped = false;
+        if (m_videoStream->hasAudio() || m_videoStream->isStepPending()) {
+            seekToTime(m_currentTime);
+        }
+    }
+
+    // 启动视频定时器，间隔由updateTimerInterval根据帧率和速度设置；暂停期间墙上时钟不走
+    resyncClock(m_currentTime);
+    m_playTimer.start();
 
     // 启动音频定时器 (更高频率处理音频帧)
     m_audioTimer.start(10);  // 100Hz，确保音频连续
 
-    m_videoStream.play();
+    m_videoStream->play();
 
     if (m_audioPlayer) {
         m_audioPlayer->start();
@@ -71,7 +628,7 @@ void VideoWidget::play() {
 void VideoWidget::pause() {
     m_playTimer.stop();
     m_audioTimer.stop();  // 同时停止音频定时器
-    m_videoStream.pause();
+    m_videoStream->pause();
 
     if (m_audioPlayer) {
         m_audioPlayer->pause();
@@ -83,7 +640,7 @@ void VideoWidget::stop() {
     m_playTimer.stop();
     m_audioTimer.stop();  // 同时停止音频定时器
     m_isPlaying = false;
-    m_videoStream.stop();
+    m_videoStream->stop();
 
     if (m_audioPlayer) {
         m_audioPlayer->stop();
@@ -91,9 +648,62 @@ void VideoWidget::stop() {
     }
 }
 
+void VideoWidget::setSuspended(bool suspended) {
+    if (suspended == m_videoStream->isSuspended()) return;
+
+    if (suspended) {
+        // 音频已切换到下一项时先完成切换，再释放预加载的流
+        if (m_audioOnNext) {
+            switchToNext();
+        }
+        // 未完成的自适应流跳转在恢复时重新发起
+        m_resumeSeek = m_seekStream != nullptr;
+        discardNext();
+
+        m_resumePlaying = m_isPlaying;
+        if (m_isPlaying) {
+            m_isPlaying = false;
+            pause();
+        }
+        m_videoStream->setForeground(false);
+        m_videoStream->suspend();
+
+        // 已缓冲的音频属于挂起前的位置，恢复后不应再播放
+        if (m_audioPlayer) {
+            m_audioPlayer->clearBuffer();
+        }
+    } else {
+        m_videoStream->setForeground(true);
+        m_videoStream->resume();
+        if (m_resumeSeek) {
+            m_resumeSeek = false;
+            seekToTime(m_seekTarget);
+        }
+        if (m_resumePlaying) {
+            m_isPlaying = true;
+            play();
+        }
+    }
+}
+
 void VideoWidget::seekToTime(double seconds) {
-    m_videoStream.seek(seconds);
+    if (m_videoStream->isLive()) return;
+
+    if (m_adaptive) {
+        // 分片流不可随机访问：从目标所在分片重新下载并打开新的run，定位精度为分片边界。
+        // 正在打开时只记录目标，打开完成后若目标已换到其他分片再重新打开
+        m_seekTarget = seconds;
+        if (!m_seekStream) {
+            openSeekRun();
+        }
+    } else {
+        m_videoStream->seek(seconds);
+    }
     m_currentTime = seconds;
+    m_resyncPending = true;
+    if (m_waveform) {
+        m_waveform->setPosition(seconds);
+    }
 
     if (m_audioPlayer) {
         // 音频播放器需要清空缓冲区重新开始
@@ -102,13 +712,31 @@ void VideoWidget::seekToTime(double seconds) {
 }
 
 void VideoWidget::updateAudio() {
-    // 专门处理音频帧
-    if (m_audioPlayer && m_isPlaying) {
-        double audioPts = 0.0;
-        AVFrame *audioFrame = m_videoStream.getNextAudioFrame(&audioPts);
-        if (audioFrame) {
-            m_audioPlayer->playAudioFrame(audioFrame);
+    // 专门处理音频帧；自适应流跳转中旧run的音频不再送入
+    if (m_audioPlayer && m_isPlaying && !m_seekStream) {
+        // 当前项音频先播完时立即接上下一项的音频，不等视频切换
+        if (!m_audioOnNext && m_nextReady && m_nextStream->hasAudio() &&
+            m_videoStream->isAudioFinished() && m_audioPlayer->switchToPrepared()) {
+            m_audioOnNext = true;
+            m_nextStream->setForeground(true);
+        }
+
+        // 按缓冲时长而不是按帧数送入：变速后每帧输出的时长随速度变化，
+        // 提前量保持较小，速度变化能很快生效
+        FFmpegStream *source = m_audioOnNext ? m_nextStream.get() : m_videoStream.get();
+        bool fed = false;
+        while (m_audioPlayer->bufferedSeconds() < AUDIO_BUFFER_TARGET) {
+            double audioPts = 0.0;
+            AVFrame *audioFrame = source->getNextAudioFrame(&audioPts);
+            if (!audioFrame) break;
+            m_audioPlayer->playAudioFrame(audioFrame, audioPts);
             av_frame_free(&audioFrame);
+            fed = true;
+        }
+
+        // 纯音频直播按设备实际播放到的位置测量延迟
+        if (fed && source->isLive() && !source->hasVideo()) {
+            updateLatency(m_audioPlayer->clock());
         }
     }
 }
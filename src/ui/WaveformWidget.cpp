@@ -0,0 +1,152 @@
+#include "WaveformWidget.h"
+#include <QMouseEvent>
+#include <QPaintEvent>
+#include <QPainter>
+#include <algorithm>
+#include <vector>
+
+WaveformWidget::WaveformWidget(QWidget *parent) : QWidget(parent) {
+    // 生成时解码器自身会使用多线程，同时只生成一个文件
+    m_pool.setMaxThreadCount(1);
+    setAttribute(Qt::WA_OpaquePaintEvent);
+}
+
+WaveformWidget::~WaveformWidget() {
+    cancelGeneration();
+    m_pool.waitForDone();
+}
+
+void WaveformWidget::cancelGeneration() {
+    if (m_cancel) {
+        m_cancel->store(true);
+        m_cancel.reset();
+    }
+    ++m_generation;
+}
+
+void WaveformWidget::load(const QString &filePath) {
+    if (filePath == m_filePath && (m_peaks || m_cancel)) return;
+
+    cancelGeneration();
+    m_filePath = filePath;
+    m_peaks = WaveformPeaks::open(filePath);
+    m_progress = 0;
+    m_failed = false;
+    m_position = 0.0;
+    update();
+    if (m_peaks) return;
+
+    // 没有缓存：后台解码生成峰值文件，完成后映射
+    auto cancel = std::make_shared<std::atomic<bool>>(false);
+    m_cancel = cancel;
+    int generation = m_generation;
+    m_pool.start([this, filePath, cancel, generation]() {
+        auto progress = [this, generation](double value) {
+            int percent = int(value * 100.0);
+            QMetaObject::invokeMethod(
+                this,
+                [this, generation, percent]() {
+                    if (generation != m_generation) return;
+                    m_progress = percent;
+                    update();
+                },
+                Qt::QueuedConnection);
+        };
+        WaveformPeaks::generate(filePath, cancel.get(), progress);
+        QMetaObject::invokeMethod(
+            this, [this, generation]() { onGenerated(generation); }, Qt::QueuedConnection);
+    });
+}
+
+void WaveformWidget::onGenerated(int generation) {
+    if (generation != m_generation) return;
+    m_cancel.reset();
+    m_peaks = WaveformPeaks::open(m_filePath);
+    m_failed = !m_peaks;
+    update();
+}
+
+int WaveformWidget::positionX(double seconds) const {
+    double duration = m_peaks ? m_peaks->duration() : 0.0;
+    return duration > 0.0 ? int(seconds / duration * width()) : 0;
+}
+
+void WaveformWidget::setPosition(double seconds) {
+    int previous = positionX(m_position);
+    m_position = seconds;
+    int current = positionX(m_position);
+    if (current != previous) {
+        update(previous - 1, 0, 3, height());
+        update(current - 1, 0, 3, height());
+    }
+}
+
+void WaveformWidget::paintEvent(QPaintEvent *event) {
+    QPainter painter(this);
+    painter.fillRect(event->rect(), QColor(30, 30, 30));
+
+    if (!m_peaks) {
+        QString text = m_failed ? "无法生成波形" : QString("正在生成波形... %1%").arg(m_progress);
+        painter.setPen(QColor(160, 160, 160));
+        painter.drawText(rect(), Qt::AlignCenter, text);
+        return;
+    }
+
+    const int w = std::max(width(), 1);
+    const double mid = height() / 2.0;
+    const double scale = (height() / 2.0 - 2.0) / 32768.0;
+    const double framesPerPixel = m_peaks->duration() * m_peaks->sampleRate() / w;
+
+    // 桶宽不超过每列帧数的最粗一级，每列只需合并少数几个桶
+    int level = 0;
+    while (level + 1 < m_peaks->levelCount() &&
+           m_peaks->framesPerBucket(level + 1) <= framesPerPixel) {
+        ++level;
+    }
+    const PeakBucket *buckets = m_peaks->buckets(level);
+    const int64_t count = m_peaks->bucketCount(level);
+    const double bucketsPerPixel = framesPerPixel / double(m_peaks->framesPerBucket(level));
+
+    std::vector<QLineF> peaks;
+    std::vector<QLineF> rms;
+    const int left = std::max(event->rect().left(), 0);
+    const int right = std::min(event->rect().right(), w - 1);
+    for (int x = left; x <= right; ++x) {
+        int64_t first = int64_t(x * bucketsPerPixel);
+        int64_t last = std::max(first + 1, int64_t((x + 1) * bucketsPerPixel));
+        if (first >= count) break;
+        last = std::min(last, count);
+
+        int lo = buckets[first].min;
+        int hi = buckets[first].max;
+        int energy = buckets[first].rms;
+        for (int64_t i = first + 1; i < last; ++i) {
+            lo = std::min(lo, int(buckets[i].min));
+            hi = std::max(hi, int(buckets[i].max));
+            energy = std::max(energy, int(buckets[i].rms));
+        }
+        peaks.emplace_back(x, mid - hi * scale, x, mid - lo * scale);
+        rms.emplace_back(x, mid - energy * scale, x, mid + energy * scale);
+    }
+    painter.setPen(QColor(70, 130, 180));
+    painter.drawLines(peaks.data(), int(peaks.size()));
+    painter.setPen(QColor(135, 190, 235));
+    painter.drawLines(rms.data(), int(rms.size()));
+
+    // 播放头
+    int position = positionX(m_position);
+    if (position >= left - 1 && position <= right + 1) {
+        painter.setPen(QColor(230, 80, 60));
+        painter.drawLine(position, 0, position, height());
+    }
+}
+
+void WaveformWidget::mousePressEvent(QMouseEvent *event) {
+    if (event->button() != Qt::LeftButton || !m_peaks || width() <= 0) {
+        // 交给父组件（切换播放/暂停）
+        QWidget::mousePressEvent(event);
+        return;
+    }
+    double ratio = std::clamp(event->position().x() / width(), 0.0, 1.0);
+    emit seekRequested(ratio * m_peaks->duration());
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "media/WaveformPeaks.h"
+#include <QThreadPool>
+#include <QWidget>
+#include <atomic>
+#include <memory>
+
+// 音频文件的波形
+// 峰值文件已缓存时打开即显示；否则在后台线程生成，期间显示进度。
+// 每列像素选用桶宽不超过该列时长的最粗一级，合并该列内的桶绘制峰值范围和均方根
+class WaveformWidget : public QWidget {
+    Q_OBJECT
+
+public:
+    explicit WaveformWidget(QWidget *parent = nullptr);
+    ~WaveformWidget() override;
+
+    void load(const QString &filePath);
+
+    // 播放位置（秒），只重绘播放头经过的列
+    void setPosition(double seconds);
+
+signals:
+    // 左键点击波形时请求跳转（秒）
+    void seekRequested(double seconds);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+
+private:
+    void onGenerated(int generation);
+    void cancelGeneration();
+    int positionX(double seconds) const;
+
+    QThreadPool m_pool;
+    std::shared_ptr<std::atomic<bool>> m_cancel;
+    int m_generation{0};  // 重新加载后使过期的回调失效
+
+    QString m_filePath;
+    std::unique_ptr<WaveformPeaks> m_peaks;
+    int m_progress{0};  // 生成进度（百分比）
+    bool m_failed{false};
+    double m_position{0.0};
+};